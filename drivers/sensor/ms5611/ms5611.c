@@ -12,59 +12,23 @@
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/sys/__assert.h>
 
+#include <drivers/sensor/baro_altitude.h>
+#include <drivers/sensor/ms5611.h>
 #include "ms5611.h"
 
 #define LOG_LEVEL CONFIG_SENSOR_LOG_LEVEL
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(ms5611);
 
-static void ms5611_compensate(struct ms5611_data *data, const int32_t adc_temperature,
-                              const int32_t adc_pressure)
+static void ms5611_compensate(struct ms5611_data *data, const uint32_t adc_temperature,
+                              const uint32_t adc_pressure)
 {
-    int64_t dT;
-    int64_t OFF;
-    int64_t SENS;
-    int64_t temp_sq;
-    int64_t Ti;
-    int64_t OFFi;
-    int64_t SENSi;
-
-    /* first order compensation as per datasheet
-     * (https://www.te.com/usa-en/product-CAT-BLPS0035.html) section
-     * PRESSURE AND TEMPERATURE CALCULATION
+    /* First and second order compensation as per datasheet
+     * (https://www.te.com/usa-en/product-CAT-BLPS0035.html), with shifts in
+     * place of the divisions
      */
-
-    dT = adc_temperature - ((int32_t)(data->t_ref) << 8);
-    data->temperature = 2000 + (dT * data->tempsens) / (1ll << 23);
-    OFF = ((int64_t)(data->off_t1) << 16) + (dT * data->tco) / (1ll << 7);
-    SENS = ((int64_t)(data->sens_t1) << 15) + (dT * data->tcs) / (1ll << 8);
-
-    /* Second order compensation as per datasheet
-     * (https://www.te.com/usa-en/product-CAT-BLPS0035.html) section
-     * SECOND ORDER TEMPERATURE COMPENSATION
-     */
-
-    temp_sq = (int64_t)(data->temperature - 2000) * (int64_t)(data->temperature - 2000);
-    if (data->temperature < 2000) {
-        Ti = (dT * dT) / (1ll << 31);
-        OFFi = (5ll * temp_sq) / (1ll << 1);
-        SENSi = (5ll * temp_sq) / (1ll << 2);
-        if (data->temperature < -1500) {
-            temp_sq = (int64_t)(data->temperature + 1500) * (int64_t)(data->temperature + 1500);
-            OFFi += 7ll * temp_sq;
-            SENSi += (11ll * temp_sq) / (1ll << 1);
-        }
-    } else {
-        SENSi = 0;
-        OFFi = 0;
-        Ti = 0;
-    }
-
-    OFF -= OFFi;
-    SENS -= SENSi;
-
-    data->temperature -= Ti;
-    data->pressure = (SENS * (int64_t)adc_pressure / (1ll << 21) - OFF) / (1ll << 15);
+    ms5611_compensate_int(&data->prom, adc_temperature, adc_pressure, &data->temperature,
+                          &data->pressure);
 }
 
 static int ms5611_read_prom(const struct ms5611_config *config, uint8_t cmd, uint16_t *val)
@@ -111,6 +75,10 @@ static int ms5611_sample_fetch(const struct device *dev, enum sensor_channel cha
 
     __ASSERT_NO_MSG(channel == SENSOR_CHAN_ALL);
 
+    if (data->measure_step != MS5611_MEASURE_IDLE) {
+        return -EBUSY;
+    }
+
     err = ms5611_get_measurement(config, &adc_pressure, data->pressure_conv_cmd,
                                  data->pressure_conv_delay);
     if (err < 0) {
@@ -141,6 +109,12 @@ static int ms5611_channel_get(const struct device *dev, enum sensor_channel chan
         val->val1 = data->pressure / 100;
         val->val2 = data->pressure % 100 * 10000;
         break;
+    case SENSOR_CHAN_ALTITUDE:
+        if (data->pressure <= 0) {
+            return -ENODATA;
+        }
+        return sensor_value_from_float(
+            val, baro_altitude_m((float)data->pressure, (float)data->temperature / 100.0f));
     default:
         return -ENOTSUP;
     }
@@ -225,6 +199,7 @@ static int ms5611_init(const struct device *dev)
 
     data->pressure = 0;
     data->temperature = 0;
+    data->measure_step = MS5611_MEASURE_IDLE;
 
     val.val1 = MS5611_PRES_OVER_DEFAULT;
     err = ms5611_attr_set(dev, SENSOR_CHAN_PRESS, SENSOR_ATTR_OVERSAMPLING, &val);
@@ -245,47 +220,47 @@ static int ms5611_init(const struct device *dev)
 
     k_sleep(K_MSEC(2));
 
-    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_OFF_T1, &data->off_t1);
+    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_OFF_T1, &data->prom.off_t1);
     if (err < 0) {
         return err;
     }
 
-    LOG_DBG("OFF_T1: %d", data->off_t1);
+    LOG_DBG("OFF_T1: %d", data->prom.off_t1);
 
-    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_SENSE_T1, &data->sens_t1);
+    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_SENSE_T1, &data->prom.sens_t1);
     if (err < 0) {
         return err;
     }
 
-    LOG_DBG("SENSE_T1: %d", data->sens_t1);
+    LOG_DBG("SENSE_T1: %d", data->prom.sens_t1);
 
-    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_T_REF, &data->t_ref);
+    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_T_REF, &data->prom.t_ref);
     if (err < 0) {
         return err;
     }
 
-    LOG_DBG("T_REF: %d", data->t_ref);
+    LOG_DBG("T_REF: %d", data->prom.t_ref);
 
-    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_TCO, &data->tco);
+    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_TCO, &data->prom.tco);
     if (err < 0) {
         return err;
     }
 
-    LOG_DBG("TCO: %d", data->tco);
+    LOG_DBG("TCO: %d", data->prom.tco);
 
-    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_TCS, &data->tcs);
+    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_TCS, &data->prom.tcs);
     if (err < 0) {
         return err;
     }
 
-    LOG_DBG("TCS: %d", data->tcs);
+    LOG_DBG("TCS: %d", data->prom.tcs);
 
-    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_TEMPSENS, &data->tempsens);
+    err = ms5611_read_prom(config, MS5611_CMD_CONV_READ_TEMPSENS, &data->prom.tempsens);
     if (err < 0) {
         return err;
     }
 
-    LOG_DBG("TEMPSENS: %d", data->tempsens);
+    LOG_DBG("TEMPSENS: %d", data->prom.tempsens);
 
     return 0;
 }
@@ -296,6 +271,95 @@ static DEVICE_API(sensor, ms5611_api_funcs) = {
     .channel_get = ms5611_channel_get,
 };
 
+/* Start a conversion that is done delay_ms from now */
+static int ms5611_measure_convert(const struct ms5611_config *config, struct ms5611_data *data,
+                                  uint8_t cmd, uint8_t delay_ms, uint8_t next_step)
+{
+    int err = config->tf->start_conversion(config, cmd);
+
+    if (err < 0) {
+        data->measure_step = MS5611_MEASURE_IDLE;
+        return err;
+    }
+
+    data->measure_ready_ticks = k_uptime_ticks() + k_ms_to_ticks_ceil64(delay_ms);
+    data->measure_step = next_step;
+    return 0;
+}
+
+int ms5611_measure_start(const struct device *dev, bool temperature)
+{
+    const struct ms5611_config *config = dev->config;
+    struct ms5611_data *data = dev->data;
+
+    if (dev->api != &ms5611_api_funcs) {
+        return -ENOTSUP;
+    }
+
+    if (data->measure_step != MS5611_MEASURE_IDLE) {
+        return -EBUSY;
+    }
+
+    data->measure_temperature = temperature || !data->measure_have_temperature;
+    return ms5611_measure_convert(config, data, data->pressure_conv_cmd,
+                                  data->pressure_conv_delay, MS5611_MEASURE_PRESSURE);
+}
+
+int ms5611_measure_poll(const struct device *dev, int32_t *pressure_pa, int32_t *temperature_cdeg,
+                        uint32_t *wait_us)
+{
+    const struct ms5611_config *config = dev->config;
+    struct ms5611_data *data = dev->data;
+    int64_t now = k_uptime_ticks();
+    int err;
+
+    if (dev->api != &ms5611_api_funcs) {
+        return -ENOTSUP;
+    }
+
+    if (data->measure_step == MS5611_MEASURE_IDLE) {
+        return -EINVAL;
+    }
+
+    if (now < data->measure_ready_ticks) {
+        *wait_us = k_ticks_to_us_ceil32(data->measure_ready_ticks - now);
+        return -EINPROGRESS;
+    }
+
+    if (data->measure_step == MS5611_MEASURE_PRESSURE) {
+        err = config->tf->read_adc(config, &data->measure_adc_pressure);
+        if (err < 0) {
+            data->measure_step = MS5611_MEASURE_IDLE;
+            return err;
+        }
+
+        if (data->measure_temperature) {
+            err = ms5611_measure_convert(config, data, data->temperature_conv_cmd,
+                                         data->temperature_conv_delay,
+                                         MS5611_MEASURE_TEMPERATURE);
+            if (err < 0) {
+                return err;
+            }
+
+            *wait_us = data->temperature_conv_delay * USEC_PER_MSEC;
+            return -EINPROGRESS;
+        }
+    } else {
+        err = config->tf->read_adc(config, &data->measure_adc_temperature);
+        data->measure_have_temperature = (err == 0);
+        if (err < 0) {
+            data->measure_step = MS5611_MEASURE_IDLE;
+            return err;
+        }
+    }
+
+    data->measure_step = MS5611_MEASURE_IDLE;
+    ms5611_compensate(data, data->measure_adc_temperature, data->measure_adc_pressure);
+    *pressure_pa = data->pressure;
+    *temperature_cdeg = data->temperature;
+    return 0;
+}
+
 #define MS5611_SPI_OPERATION \
     (SPI_OP_MODE_MASTER | SPI_WORD_SET(8) | SPI_MODE_CPOL | SPI_MODE_CPHA | SPI_TRANSFER_MSB)
 
@@ -9,6 +9,7 @@
 
 #include <zephyr/types.h>
 #include <zephyr/device.h>
+#include <drivers/sensor/ms5611_compensate.h>
 
 #if DT_ANY_INST_ON_BUS_STATUS_OKAY(i2c)
 #include <zephyr/drivers/i2c.h>
@@ -68,6 +69,12 @@
 #define MS5611_TEMP_OVER_DEFAULT 2048
 #endif
 
+enum ms5611_measure_step {
+    MS5611_MEASURE_IDLE,
+    MS5611_MEASURE_PRESSURE,    /* D1 conversion running */
+    MS5611_MEASURE_TEMPERATURE, /* D2 conversion running */
+};
+
 /* Forward declaration */
 struct ms5611_config;
 
@@ -101,12 +108,7 @@ struct ms5611_config {
 
 struct ms5611_data {
     /* Calibration values */
-    uint16_t sens_t1;
-    uint16_t off_t1;
-    uint16_t tcs;
-    uint16_t tco;
-    uint16_t t_ref;
-    uint16_t tempsens;
+    struct ms5611_prom prom;
 
     /* Measured values */
     int32_t pressure;
@@ -118,6 +120,14 @@ struct ms5611_data {
 
     uint8_t pressure_conv_delay;
     uint8_t temperature_conv_delay;
+
+    /* Non-blocking measurement, see include/drivers/sensor/ms5611.h */
+    uint8_t measure_step;
+    bool measure_temperature;         /* Convert temperature in this measurement */
+    bool measure_have_temperature;    /* measure_adc_temperature is valid */
+    uint32_t measure_adc_pressure;
+    uint32_t measure_adc_temperature; /* Last temperature conversion */
+    int64_t measure_ready_ticks;
 };
 
 #endif /* __SENSOR_MS607_H__*/
@@ -4,25 +4,100 @@
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/kernel.h>
 #include <zephyr/random/random.h>
+#include <drivers/sensor/imu_fifo.h>
+#ifdef CONFIG_SIM_BARO
+#include <drivers/sensor/sim_baro.h>
+#endif
+
+/* BMI088 accel FIFO: 1024 bytes of 7-byte frames */
+#define SIM_ACCEL_FIFO_DEPTH 146
+#define SIM_ACCEL_DEFAULT_ODR_HZ 400
 
 struct sim_accel_data {
+    const struct device *dev;
     float accel_x;
     float accel_y;
     float accel_z;
+
+    /* Simulated FIFO: frames are produced at odr_hz from fifo_start_us on,
+     * and consumed one per fetch while watermark is non-zero */
+    uint32_t odr_hz;
+    uint32_t watermark;
+    int64_t fifo_start_us;
+    uint64_t consumed;
+    uint32_t overruns;
+    struct k_timer fifo_timer;
+    sensor_trigger_handler_t fifo_handler;
+    const struct sensor_trigger *fifo_trigger;
 };
 
+static uint32_t sim_accel_fifo_level(struct sim_accel_data *data)
+{
+    int64_t elapsed_us = k_ticks_to_us_floor64(k_uptime_ticks()) - data->fifo_start_us;
+    uint64_t produced = (uint64_t)elapsed_us * data->odr_hz / USEC_PER_SEC;
+    uint64_t level = produced - data->consumed;
+
+    /* Full: like the real part in stream mode, the oldest frames are lost */
+    if (level > SIM_ACCEL_FIFO_DEPTH) {
+        data->overruns += level - SIM_ACCEL_FIFO_DEPTH;
+        data->consumed = produced - SIM_ACCEL_FIFO_DEPTH;
+        level = SIM_ACCEL_FIFO_DEPTH;
+    }
+
+    return (uint32_t)level;
+}
+
+static void sim_accel_fifo_reset(struct sim_accel_data *data)
+{
+    data->fifo_start_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    data->consumed = 0;
+    data->overruns = 0;
+
+    k_timer_stop(&data->fifo_timer);
+    if (data->watermark > 0 && data->fifo_handler) {
+        k_timeout_t period = K_USEC((uint64_t)data->watermark * USEC_PER_SEC / data->odr_hz);
+
+        k_timer_start(&data->fifo_timer, period, period);
+    }
+}
+
+static void sim_accel_fifo_timer_fn(struct k_timer *timer)
+{
+    struct sim_accel_data *data = CONTAINER_OF(timer, struct sim_accel_data, fifo_timer);
+
+    if (data->fifo_handler) {
+        data->fifo_handler(data->dev, data->fifo_trigger);
+    }
+}
+
 static int sim_accel_sample_fetch(const struct device *dev, enum sensor_channel chan)
 {
     struct sim_accel_data *data = dev->data;
 
+    if (data->watermark > 0) {
+        if (sim_accel_fifo_level(data) == 0) {
+            return -ENODATA;
+        }
+        data->consumed++;
+    }
+
     /* Simulate gravity + small noise */
     float noise_x = ((int32_t)sys_rand32_get() % 1000) / 10000.0f - 0.05f;
     float noise_y = ((int32_t)sys_rand32_get() % 1000) / 10000.0f - 0.05f;
     float noise_z = ((int32_t)sys_rand32_get() % 1000) / 10000.0f - 0.05f;
 
+    /* Mounted with -z up, so the flight's acceleration adds to gravity there */
+    float vertical_accel = 0.0f;
+
+#ifdef CONFIG_SIM_BARO
+    if (sim_baro_vertical_accel(&vertical_accel) < 0) {
+        vertical_accel = 0.0f;
+    }
+#endif
+
     data->accel_x = 0.0f + noise_x;
     data->accel_y = 0.0f + noise_y;
-    data->accel_z = -9.81f + noise_z; // Gravity
+    data->accel_z = -(9.81f + vertical_accel) + noise_z; // Gravity
 
     return 0;
 }
@@ -52,14 +127,95 @@ static int sim_accel_channel_get(const struct device *dev, enum sensor_channel c
     }
 }
 
+static int sim_accel_attr_set(const struct device *dev, enum sensor_channel chan,
+                              enum sensor_attribute attr, const struct sensor_value *val)
+{
+    struct sim_accel_data *data = dev->data;
+
+    switch ((int)attr) {
+    case SENSOR_ATTR_SAMPLING_FREQUENCY:
+        if (val->val1 <= 0) {
+            return -EINVAL;
+        }
+        data->odr_hz = val->val1;
+        sim_accel_fifo_reset(data);
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_WATERMARK:
+        if (val->val1 < 0 || val->val1 > SIM_ACCEL_FIFO_DEPTH) {
+            return -EINVAL;
+        }
+        data->watermark = val->val1;
+        sim_accel_fifo_reset(data);
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int sim_accel_attr_get(const struct device *dev, enum sensor_channel chan,
+                              enum sensor_attribute attr, struct sensor_value *val)
+{
+    struct sim_accel_data *data = dev->data;
+
+    val->val2 = 0;
+
+    switch ((int)attr) {
+    case SENSOR_ATTR_SAMPLING_FREQUENCY:
+        val->val1 = data->odr_hz;
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_WATERMARK:
+        val->val1 = data->watermark;
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_LEVEL:
+        val->val1 = (data->watermark > 0) ? sim_accel_fifo_level(data) : 0;
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_OVERRUNS:
+        if (data->watermark > 0) {
+            sim_accel_fifo_level(data);
+        }
+        val->val1 = data->overruns;
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int sim_accel_trigger_set(const struct device *dev, const struct sensor_trigger *trig,
+                                 sensor_trigger_handler_t handler)
+{
+    struct sim_accel_data *data = dev->data;
+
+    if (trig->type != SENSOR_TRIG_FIFO_WATERMARK) {
+        return -ENOTSUP;
+    }
+
+    data->fifo_handler = handler;
+    data->fifo_trigger = trig;
+    sim_accel_fifo_reset(data);
+    return 0;
+}
+
+static int sim_accel_init(const struct device *dev)
+{
+    struct sim_accel_data *data = dev->data;
+
+    data->dev = dev;
+    data->odr_hz = SIM_ACCEL_DEFAULT_ODR_HZ;
+    k_timer_init(&data->fifo_timer, sim_accel_fifo_timer_fn, NULL);
+    return 0;
+}
+
 static const struct sensor_driver_api sim_accel_api = {
     .sample_fetch = sim_accel_sample_fetch,
     .channel_get = sim_accel_channel_get,
+    .attr_set = sim_accel_attr_set,
+    .attr_get = sim_accel_attr_get,
+    .trigger_set = sim_accel_trigger_set,
 };
 
-#define SIM_ACCEL_INIT(inst)                                                           \
-    static struct sim_accel_data sim_accel_data_##inst;                                \
-    DEVICE_DT_INST_DEFINE(inst, NULL, NULL, &sim_accel_data_##inst, NULL, POST_KERNEL, \
-                          CONFIG_SENSOR_INIT_PRIORITY, &sim_accel_api);
+#define SIM_ACCEL_INIT(inst)                                                                  \
+    static struct sim_accel_data sim_accel_data_##inst;                                       \
+    DEVICE_DT_INST_DEFINE(inst, sim_accel_init, NULL, &sim_accel_data_##inst, NULL,           \
+                          POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY, &sim_accel_api);
 
 DT_INST_FOREACH_STATUS_OKAY(SIM_ACCEL_INIT)
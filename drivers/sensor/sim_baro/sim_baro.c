@@ -9,6 +9,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <drivers/sensor/sim_baro.h>
 
 #ifdef CONFIG_ARCH_POSIX
 #include <soc.h>
@@ -121,6 +122,7 @@ struct csv_row {
     float pressure_mbar; // mbar = hPa
     float temperature_c;
     float altitude_m;
+    float vertical_accel; // m/s^2
 };
 
 struct sim_baro_data {
@@ -142,6 +144,9 @@ struct sim_baro_data {
     uint32_t sample_count;
 };
 
+// Instance whose flight sim_baro_vertical_accel() reports
+static struct sim_baro_data *flight;
+
 // Helper to get Nth field from CSV line
 static const char *get_csv_field(const char *line, int field_index, char *buffer, size_t buf_size)
 {
@@ -199,18 +204,20 @@ static const char *get_csv_field(const char *line, int field_index, char *buffer
 
 static int parse_csv_line(const char *line, struct csv_row *row)
 {
-    float pressure_raw, temp_raw, timestamp_raw, altitude_raw;
+    float pressure_raw, temp_raw, timestamp_raw, altitude_raw, accel_raw;
 
     GET_CSV_FLOAT(line, CSV_COL_TIMESTAMP, timestamp_raw);
     GET_CSV_FLOAT(line, CSV_COL_ALTITUDE, altitude_raw);
     GET_CSV_FLOAT(line, CSV_COL_AIR_PRESSURE, pressure_raw);
     GET_CSV_FLOAT(line, CSV_COL_AIR_TEMP, temp_raw);
+    GET_CSV_FLOAT(line, CSV_COL_VERTICAL_ACCEL, accel_raw);
 
     // Apply unit conversions
     row->timestamp_ms = timestamp_raw * 1000.0f; // Convert from seconds to milliseconds
     row->altitude_m = altitude_raw;
     row->pressure_mbar = pressure_raw; // mbar = hPa
     row->temperature_c = temp_raw;
+    row->vertical_accel = accel_raw;
 
     return 0;
 }
@@ -403,6 +410,11 @@ static int sim_baro_sample_fetch(const struct device *dev, enum sensor_channel c
         LOG_INF("  SIM_BARO INITIALIZATION");
         LOG_INF("═══════════════════════════════════════════════");
 
+        // The first barometer to start is the one the simulated IMU follows
+        if (flight == NULL) {
+            flight = data;
+        }
+
         // Load CSV data if data file is specified
         const char *data_file_path = get_data_file_path();
         if (strlen(data_file_path) > 0) {
@@ -470,6 +482,43 @@ static int sim_baro_sample_fetch(const struct device *dev, enum sensor_channel c
     return 0;
 }
 
+int sim_baro_vertical_accel(float *accel_mps2)
+{
+    const struct sim_baro_data *data = flight;
+
+    if (data == NULL) {
+        return -ENODATA;
+    }
+
+    if (!data->csv_loaded) {
+        // The synthetic climb in sim_baro_sample_fetch()
+        *accel_mps2 = 0.1f;
+        return 0;
+    }
+
+    int64_t target_timestamp =
+        data->csv_first_timestamp + (k_uptime_get() - data->csv_start_time_ms);
+    size_t i = data->csv_current_index;
+
+    // The baro may not have fetched for a while; look ahead from where it was
+    while (i < data->csv_row_count - 1 && data->csv_data[i + 1].timestamp_ms <= target_timestamp) {
+        i++;
+    }
+
+    if (i >= data->csv_row_count - 1 || target_timestamp < data->csv_data[i].timestamp_ms) {
+        *accel_mps2 = data->csv_data[i].vertical_accel;
+        return 0;
+    }
+
+    const struct csv_row *curr = &data->csv_data[i];
+    const struct csv_row *next = &data->csv_data[i + 1];
+    int64_t dt = MAX(next->timestamp_ms - curr->timestamp_ms, 1);
+    float alpha = CLAMP((float)(target_timestamp - curr->timestamp_ms) / (float)dt, 0.0f, 1.0f);
+
+    *accel_mps2 = curr->vertical_accel + alpha * (next->vertical_accel - curr->vertical_accel);
+    return 0;
+}
+
 static int sim_baro_channel_get(const struct device *dev, enum sensor_channel chan,
                                 struct sensor_value *val)
 {
@@ -4,17 +4,80 @@
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/kernel.h>
 #include <zephyr/random/random.h>
+#include <drivers/sensor/imu_fifo.h>
+
+/* BMI088 gyro FIFO: 100 frames */
+#define SIM_GYRO_FIFO_DEPTH 100
+#define SIM_GYRO_DEFAULT_ODR_HZ 400
 
 struct sim_gyro_data {
+    const struct device *dev;
     float gyro_x;
     float gyro_y;
     float gyro_z;
+
+    /* Simulated FIFO: frames are produced at odr_hz from fifo_start_us on,
+     * and consumed one per fetch while watermark is non-zero */
+    uint32_t odr_hz;
+    uint32_t watermark;
+    int64_t fifo_start_us;
+    uint64_t consumed;
+    uint32_t overruns;
+    struct k_timer fifo_timer;
+    sensor_trigger_handler_t fifo_handler;
+    const struct sensor_trigger *fifo_trigger;
 };
 
+static uint32_t sim_gyro_fifo_level(struct sim_gyro_data *data)
+{
+    int64_t elapsed_us = k_ticks_to_us_floor64(k_uptime_ticks()) - data->fifo_start_us;
+    uint64_t produced = (uint64_t)elapsed_us * data->odr_hz / USEC_PER_SEC;
+    uint64_t level = produced - data->consumed;
+
+    /* Full: like the real part in stream mode, the oldest frames are lost */
+    if (level > SIM_GYRO_FIFO_DEPTH) {
+        data->overruns += level - SIM_GYRO_FIFO_DEPTH;
+        data->consumed = produced - SIM_GYRO_FIFO_DEPTH;
+        level = SIM_GYRO_FIFO_DEPTH;
+    }
+
+    return (uint32_t)level;
+}
+
+static void sim_gyro_fifo_reset(struct sim_gyro_data *data)
+{
+    data->fifo_start_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    data->consumed = 0;
+    data->overruns = 0;
+
+    k_timer_stop(&data->fifo_timer);
+    if (data->watermark > 0 && data->fifo_handler) {
+        k_timeout_t period = K_USEC((uint64_t)data->watermark * USEC_PER_SEC / data->odr_hz);
+
+        k_timer_start(&data->fifo_timer, period, period);
+    }
+}
+
+static void sim_gyro_fifo_timer_fn(struct k_timer *timer)
+{
+    struct sim_gyro_data *data = CONTAINER_OF(timer, struct sim_gyro_data, fifo_timer);
+
+    if (data->fifo_handler) {
+        data->fifo_handler(data->dev, data->fifo_trigger);
+    }
+}
+
 static int sim_gyro_sample_fetch(const struct device *dev, enum sensor_channel chan)
 {
     struct sim_gyro_data *data = dev->data;
 
+    if (data->watermark > 0) {
+        if (sim_gyro_fifo_level(data) == 0) {
+            return -ENODATA;
+        }
+        data->consumed++;
+    }
+
     /* Simulate small random rotation rates */
     float noise_x = ((int32_t)sys_rand32_get() % 1000) / 50000.0f - 0.01f;
     float noise_y = ((int32_t)sys_rand32_get() % 1000) / 50000.0f - 0.01f;
@@ -52,14 +115,95 @@ static int sim_gyro_channel_get(const struct device *dev, enum sensor_channel ch
     }
 }
 
+static int sim_gyro_attr_set(const struct device *dev, enum sensor_channel chan,
+                              enum sensor_attribute attr, const struct sensor_value *val)
+{
+    struct sim_gyro_data *data = dev->data;
+
+    switch ((int)attr) {
+    case SENSOR_ATTR_SAMPLING_FREQUENCY:
+        if (val->val1 <= 0) {
+            return -EINVAL;
+        }
+        data->odr_hz = val->val1;
+        sim_gyro_fifo_reset(data);
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_WATERMARK:
+        if (val->val1 < 0 || val->val1 > SIM_GYRO_FIFO_DEPTH) {
+            return -EINVAL;
+        }
+        data->watermark = val->val1;
+        sim_gyro_fifo_reset(data);
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int sim_gyro_attr_get(const struct device *dev, enum sensor_channel chan,
+                              enum sensor_attribute attr, struct sensor_value *val)
+{
+    struct sim_gyro_data *data = dev->data;
+
+    val->val2 = 0;
+
+    switch ((int)attr) {
+    case SENSOR_ATTR_SAMPLING_FREQUENCY:
+        val->val1 = data->odr_hz;
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_WATERMARK:
+        val->val1 = data->watermark;
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_LEVEL:
+        val->val1 = (data->watermark > 0) ? sim_gyro_fifo_level(data) : 0;
+        return 0;
+    case SENSOR_ATTR_IMU_FIFO_OVERRUNS:
+        if (data->watermark > 0) {
+            sim_gyro_fifo_level(data);
+        }
+        val->val1 = data->overruns;
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int sim_gyro_trigger_set(const struct device *dev, const struct sensor_trigger *trig,
+                                 sensor_trigger_handler_t handler)
+{
+    struct sim_gyro_data *data = dev->data;
+
+    if (trig->type != SENSOR_TRIG_FIFO_WATERMARK) {
+        return -ENOTSUP;
+    }
+
+    data->fifo_handler = handler;
+    data->fifo_trigger = trig;
+    sim_gyro_fifo_reset(data);
+    return 0;
+}
+
+static int sim_gyro_init(const struct device *dev)
+{
+    struct sim_gyro_data *data = dev->data;
+
+    data->dev = dev;
+    data->odr_hz = SIM_GYRO_DEFAULT_ODR_HZ;
+    k_timer_init(&data->fifo_timer, sim_gyro_fifo_timer_fn, NULL);
+    return 0;
+}
+
 static const struct sensor_driver_api sim_gyro_api = {
     .sample_fetch = sim_gyro_sample_fetch,
     .channel_get = sim_gyro_channel_get,
+    .attr_set = sim_gyro_attr_set,
+    .attr_get = sim_gyro_attr_get,
+    .trigger_set = sim_gyro_trigger_set,
 };
 
-#define SIM_GYRO_INIT(inst)                                                           \
-    static struct sim_gyro_data sim_gyro_data_##inst;                                 \
-    DEVICE_DT_INST_DEFINE(inst, NULL, NULL, &sim_gyro_data_##inst, NULL, POST_KERNEL, \
-                          CONFIG_SENSOR_INIT_PRIORITY, &sim_gyro_api);
+#define SIM_GYRO_INIT(inst)                                                                 \
+    static struct sim_gyro_data sim_gyro_data_##inst;                                       \
+    DEVICE_DT_INST_DEFINE(inst, sim_gyro_init, NULL, &sim_gyro_data_##inst, NULL,           \
+                          POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY, &sim_gyro_api);
 
 DT_INST_FOREACH_STATUS_OKAY(SIM_GYRO_INIT)
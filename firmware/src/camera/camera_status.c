@@ -0,0 +1,47 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include "camera_status.h"
+#include "data.h"
+
+#define CAMERA_STATUS_POWER BIT(0)
+#define CAMERA_STATUS_RECORDING BIT(1)
+
+static atomic_t camera_status;
+
+/**
+ * @brief Publish the latest recorded camera state (system workqueue only).
+ */
+static void camera_status_publish(struct k_work *work)
+{
+    atomic_val_t status = atomic_get(&camera_status);
+    struct camera_data cam = {
+        .vtx_power_on = (status & CAMERA_STATUS_POWER) != 0,
+        .recording = (status & CAMERA_STATUS_RECORDING) != 0,
+        .timestamp_us = data_timestamp_us(),
+    };
+
+    cam.timestamp = cam.timestamp_us / USEC_PER_MSEC;
+    set_camera_data(&cam);
+}
+
+static K_WORK_DEFINE(camera_status_work, camera_status_publish);
+
+void camera_status_set_power(bool on)
+{
+    if (on) {
+        atomic_or(&camera_status, CAMERA_STATUS_POWER);
+    } else {
+        atomic_and(&camera_status, ~(CAMERA_STATUS_POWER | CAMERA_STATUS_RECORDING));
+    }
+    k_work_submit(&camera_status_work);
+}
+
+void camera_status_set_recording(bool recording)
+{
+    if (recording) {
+        atomic_or(&camera_status, CAMERA_STATUS_RECORDING);
+    } else {
+        atomic_and(&camera_status, ~CAMERA_STATUS_RECORDING);
+    }
+    k_work_submit(&camera_status_work);
+}
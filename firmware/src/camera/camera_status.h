@@ -0,0 +1,25 @@
+#ifndef CAMERA_STATUS_H
+#define CAMERA_STATUS_H
+
+#include <stdbool.h>
+
+/*
+ * The camera topic has two writers in the firmware: the command executor
+ * (uplinked power and recording changes) and the state machine (landed
+ * shutdown). These calls record the change and leave the publish to the
+ * system workqueue, which is the topic's only writer, so neither caller
+ * waits on the other.
+ */
+
+/**
+ * @brief Record the VTX/RunCam power state. Cutting power also stops any
+ * recording in progress.
+ */
+void camera_status_set_power(bool on);
+
+/**
+ * @brief Record the RunCam recording state
+ */
+void camera_status_set_recording(bool recording);
+
+#endif /* CAMERA_STATUS_H */
@@ -6,23 +6,10 @@
 #include <zephyr/sys/crc.h>
 #include "runcam.h"
 #include "uplink_config.h"
-#include "data.h"
+#include "camera_status.h"
 
 LOG_MODULE_REGISTER(runcam, LOG_LEVEL_INF);
 
-/**
- * @brief Update the shared camera status with the new recording state
- */
-static void update_shared_recording(bool recording)
-{
-    struct camera_data cam;
-
-    get_camera_data(&cam);
-    cam.recording = recording;
-    cam.timestamp = k_uptime_get();
-    set_camera_data(&cam);
-}
-
 #if DT_NODE_EXISTS(DT_ALIAS(runcam_uart))
 
 static const struct device *const runcam_uart = DEVICE_DT_GET(DT_ALIAS(runcam_uart));
@@ -78,7 +65,7 @@ int runcam_start_recording(void)
     }
 
     /* Optimistic: CAMERA_CONTROL has no ack (see runcam_send_action) */
-    update_shared_recording(true);
+    camera_status_set_recording(true);
     LOG_INF("RunCam recording start sent");
     return 0;
 }
@@ -90,7 +77,7 @@ int runcam_stop_recording(void)
         return ret;
     }
 
-    update_shared_recording(false);
+    camera_status_set_recording(false);
     LOG_INF("RunCam recording stop sent");
     return 0;
 }
@@ -106,14 +93,14 @@ int runcam_init(void)
 int runcam_start_recording(void)
 {
     LOG_INF("(sim) RunCam recording start");
-    update_shared_recording(true);
+    camera_status_set_recording(true);
     return 0;
 }
 
 int runcam_stop_recording(void)
 {
     LOG_INF("(sim) RunCam recording stop");
-    update_shared_recording(false);
+    camera_status_set_recording(false);
     return 0;
 }
 
@@ -3,27 +3,10 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/logging/log.h>
 #include "vtx_power.h"
-#include "data.h"
+#include "camera_status.h"
 
 LOG_MODULE_REGISTER(vtx_power, LOG_LEVEL_INF);
 
-/**
- * @brief Update the shared camera status with the new power state.
- * Cutting power also stops any recording in progress.
- */
-static void update_shared_power(bool on)
-{
-    struct camera_data cam;
-
-    get_camera_data(&cam);
-    cam.vtx_power_on = on;
-    if (!on) {
-        cam.recording = false;
-    }
-    cam.timestamp = k_uptime_get();
-    set_camera_data(&cam);
-}
-
 #if DT_NODE_EXISTS(DT_ALIAS(vtx_pwr))
 
 static const struct gpio_dt_spec vtx_pwr_gpio = GPIO_DT_SPEC_GET(DT_ALIAS(vtx_pwr), gpios);
@@ -45,7 +28,7 @@ int vtx_power_init(void)
     }
 
     initialized = true;
-    update_shared_power(true);
+    camera_status_set_power(true);
     LOG_INF("VTX/RunCam power on");
     return 0;
 }
@@ -75,7 +58,7 @@ int vtx_power_set(bool on)
         return ret;
     }
 
-    update_shared_power(on);
+    camera_status_set_power(on);
     LOG_INF("VTX/RunCam power %s", on ? "on" : "off");
     return 0;
 }
@@ -85,14 +68,14 @@ int vtx_power_set(bool on)
 int vtx_power_init(void)
 {
     LOG_WRN("No vtx-pwr devicetree alias; simulating VTX power switch");
-    update_shared_power(true);
+    camera_status_set_power(true);
     return 0;
 }
 
 int vtx_power_set(bool on)
 {
     LOG_INF("(sim) VTX/RunCam power %s", on ? "on" : "off");
-    update_shared_power(on);
+    camera_status_set_power(on);
     return 0;
 }
 
@@ -0,0 +1,76 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "cyclic_executive.h"
+#include "data.h"
+#include "periodic_task.h"
+#include "pyro/pyro_thread.h"
+#include "sensors/baro_thread.h"
+#include "state_machine/state_machine.h"
+
+LOG_MODULE_REGISTER(cyclic_executive, LOG_LEVEL_INF);
+
+#define CYCLIC_THREAD_STACK_SIZE 3072
+#define CYCLIC_THREAD_PRIORITY 0
+
+// Resend an unacknowledged fire command for about as long as the pyro thread would
+#define CYCLIC_PYRO_RETRY_MS 1000
+
+K_THREAD_STACK_DEFINE(cyclic_stack, CYCLIC_THREAD_STACK_SIZE);
+static struct k_thread cyclic_thread;
+static struct periodic_task cyclic_task;
+
+/*
+ * One frame runs acquire -> KF -> state machine -> pyro back to back, so a
+ * baro sample that triggers a deployment reaches the pyro SPI bus in the
+ * same frame, with no queueing or wakeup between stages. The frame follows
+ * baro_period_ms(), as the baro thread's period does.
+ */
+static void cyclic_thread_fn(void *p1, void *p2, void *p3)
+{
+    struct baro_data baro;
+
+    if (!baro_init()) {
+        LOG_ERR("Cyclic executive has no barometer to run from");
+        return;
+    }
+
+    bool pyro_ok = pyro_init();
+
+    state_machine_init();
+
+    uint32_t frame_ms = baro_period_ms();
+
+    LOG_INF("Cyclic executive running, %u ms frame", (unsigned int)frame_ms);
+
+    periodic_task_init(&cyclic_task, "cyclic", frame_ms);
+
+    while (1) {
+        periodic_task_wait(&cyclic_task);
+
+        baro_step();
+
+        get_baro_data(&baro);
+        state_machine_step(&baro);
+
+        if (pyro_ok) {
+            pyro_step((int)DIV_ROUND_UP(CYCLIC_PYRO_RETRY_MS, frame_ms));
+        }
+
+        if (baro_period_ms() != frame_ms) {
+            frame_ms = baro_period_ms();
+            periodic_task_set_period(&cyclic_task, frame_ms);
+        }
+    }
+}
+
+void start_cyclic_executive(void)
+{
+    k_thread_create(&cyclic_thread, cyclic_stack, K_THREAD_STACK_SIZEOF(cyclic_stack),
+                    cyclic_thread_fn, NULL, NULL, NULL, CYCLIC_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&cyclic_thread, "cyclic");
+}
+
+uint32_t cyclic_executive_overruns(void)
+{
+    return cyclic_task.stats.overruns;
+}
@@ -0,0 +1,25 @@
+#ifndef CYCLIC_EXECUTIVE_H
+#define CYCLIC_EXECUTIVE_H
+
+#include <stdint.h>
+
+#ifdef CONFIG_FALCON_CYCLIC_EXECUTIVE
+/**
+ * @brief Start the cyclic executive, which replaces the baro, state machine
+ * and pyro threads: every baro_period_ms() it runs baro acquisition and KF,
+ * smf_run_state and the pyro command slot, in that order.
+ */
+void start_cyclic_executive(void);
+
+/**
+ * @brief Number of frames whose work ran past the next release time.
+ */
+uint32_t cyclic_executive_overruns(void);
+#else
+static inline uint32_t cyclic_executive_overruns(void)
+{
+    return 0;
+}
+#endif
+
+#endif
@@ -1,148 +1,548 @@
+#include <stddef.h>
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
 #include "data.h"
+#include "event_journal.h"
 
 LOG_MODULE_REGISTER(data, LOG_LEVEL_INF);
 
-// Global instances
-struct imu_data g_imu_data;
-struct baro_data g_baro_data;
-struct state_data g_state_data;
-struct pyro_data g_pyro_data;
-struct gps_data g_gps_data;
-struct camera_data g_camera_data;
-
-// Mutexes for thread safety
-K_MUTEX_DEFINE(imu_mutex);
-K_MUTEX_DEFINE(baro_mutex);
-K_MUTEX_DEFINE(state_mutex);
-K_MUTEX_DEFINE(pyro_data_mutex);
-K_MUTEX_DEFINE(gps_mutex);
-K_MUTEX_DEFINE(camera_mutex);
+/*
+ * Every topic is a ring of samples: sample n lives in ring[n % depth] and
+ * head is the next n, so the latest value is sample head - 1. A writer
+ * fills slot head % depth, which holds the oldest sample and which no
+ * reader looks at, then publishes it by bumping head. Readers copy without
+ * taking any lock and retry only if writers lapped the slot they were
+ * copying, which takes depth - 1 publishes of that topic mid-copy.
+ *
+ * Each topic has exactly one writer thread, so a setter never waits for
+ * another and the copies run with interrupts on. data_lock is held only to
+ * move head and the global generation together, so the priority-0 pyro
+ * thread and priority-1 baro thread never wait behind a large sample such
+ * as health being copied, and a writer preempted mid-copy never holds up a
+ * reader. A topic that ever needs several writers has to claim its slot
+ * with an atomic, as journal_record() does.
+ */
+struct topic {
+    size_t size;
+    size_t seq_offset; // Where the sample's own seq field lives
+    enum data_topic id;
+
+    // One slot more than the configured history, reserved for the writer
+    void *ring;
+    uint32_t depth;
+    atomic_t head;
+};
+
+#define TOPIC_DEFINE(name, type, topic_id, history)                                               \
+    static type name##_ring[(history) + 1];                                                       \
+    static struct topic name = {.size = sizeof(type),                                             \
+                                .seq_offset = offsetof(type, seq),                                \
+                                .id = topic_id,                                                   \
+                                .ring = name##_ring,                                              \
+                                .depth = (history) + 1,                                           \
+                                .head = ATOMIC_INIT(0)}
+
+TOPIC_DEFINE(imu_topic, struct imu_data, DATA_TOPIC_IMU, CONFIG_FALCON_HISTORY_IMU);
+TOPIC_DEFINE(imu_filtered_topic, struct imu_data, DATA_TOPIC_IMU_FILTERED,
+             CONFIG_FALCON_HISTORY_IMU_FILTERED);
+TOPIC_DEFINE(attitude_topic, struct attitude_data, DATA_TOPIC_ATTITUDE,
+             CONFIG_FALCON_HISTORY_ATTITUDE);
+TOPIC_DEFINE(baro_topic, struct baro_data, DATA_TOPIC_BARO, CONFIG_FALCON_HISTORY_BARO);
+TOPIC_DEFINE(state_topic, struct state_data, DATA_TOPIC_STATE, CONFIG_FALCON_HISTORY_STATE);
+TOPIC_DEFINE(apogee_topic, struct apogee_data, DATA_TOPIC_APOGEE,
+             CONFIG_FALCON_HISTORY_APOGEE);
+TOPIC_DEFINE(nav_topic, struct nav_data, DATA_TOPIC_NAV, CONFIG_FALCON_HISTORY_NAV);
+TOPIC_DEFINE(pyro_topic, struct pyro_data, DATA_TOPIC_PYRO, CONFIG_FALCON_HISTORY_PYRO);
+TOPIC_DEFINE(gps_topic, struct gps_data, DATA_TOPIC_GPS, CONFIG_FALCON_HISTORY_GPS);
+TOPIC_DEFINE(camera_topic, struct camera_data, DATA_TOPIC_CAMERA,
+             CONFIG_FALCON_HISTORY_CAMERA);
+TOPIC_DEFINE(health_topic, struct health_data, DATA_TOPIC_HEALTH,
+             CONFIG_FALCON_HISTORY_HEALTH);
+TOPIC_DEFINE(imu_calib_topic, struct imu_calib_data, DATA_TOPIC_IMU_CALIB,
+             CONFIG_FALCON_HISTORY_IMU_CALIB);
+TOPIC_DEFINE(vibration_topic, struct vibration_data, DATA_TOPIC_VIBRATION,
+             CONFIG_FALCON_HISTORY_VIBRATION);
+
+static struct topic *const topics[DATA_TOPIC_COUNT] = {
+    [DATA_TOPIC_IMU] = &imu_topic,   [DATA_TOPIC_BARO] = &baro_topic,
+    [DATA_TOPIC_STATE] = &state_topic, [DATA_TOPIC_PYRO] = &pyro_topic,
+    [DATA_TOPIC_GPS] = &gps_topic,   [DATA_TOPIC_CAMERA] = &camera_topic,
+    [DATA_TOPIC_HEALTH] = &health_topic, [DATA_TOPIC_IMU_CALIB] = &imu_calib_topic,
+    [DATA_TOPIC_IMU_FILTERED] = &imu_filtered_topic, [DATA_TOPIC_VIBRATION] = &vibration_topic,
+    [DATA_TOPIC_APOGEE] = &apogee_topic, [DATA_TOPIC_ATTITUDE] = &attitude_topic,
+    [DATA_TOPIC_NAV] = &nav_topic,
+};
+
+static struct k_spinlock data_lock;
+
+/*
+ * Global seqlock over all topics, bumped to odd and back to even around
+ * every move of a topic's head. get_data_snapshot() uses it to copy every
+ * topic from a single epoch; half its value is the number of publishes so
+ * far.
+ */
+static atomic_t data_generation;
+
+// New-sample notification: one k_event per subscriber, posted after each publish
+#define DATA_MAX_SUBSCRIBERS 8
+
+static struct data_subscriber *subscribers[DATA_MAX_SUBSCRIBERS];
+static atomic_t subscriber_count;
+
+int data_subscribe(struct data_subscriber *sub, uint32_t topics)
+{
+    k_event_init(&sub->events);
+    sub->topics = topics;
+
+    k_spinlock_key_t key = k_spin_lock(&data_lock);
+    atomic_val_t idx = atomic_get(&subscriber_count);
+
+    if (idx >= DATA_MAX_SUBSCRIBERS) {
+        k_spin_unlock(&data_lock, key);
+        LOG_ERR("Subscriber table full (%d)", DATA_MAX_SUBSCRIBERS);
+        return -ENOMEM;
+    }
+
+    // Fill the slot before publishing the new count to lock-free notifiers
+    subscribers[idx] = sub;
+    atomic_inc(&subscriber_count);
+    k_spin_unlock(&data_lock, key);
+    return 0;
+}
+
+uint32_t data_wait(struct data_subscriber *sub, uint32_t topics, k_timeout_t timeout)
+{
+    uint32_t ready = k_event_wait(&sub->events, topics, false, timeout) & topics;
+
+    /* Consume before the caller reads the topic: a publish that lands
+     * between here and the read re-arms the bit, so nothing is missed */
+    if (ready) {
+        k_event_clear(&sub->events, ready);
+    }
+
+    return ready;
+}
+
+/**
+ * @brief Wake every subscriber interested in a topic (never blocks the publisher).
+ */
+static void topic_notify(const struct topic *t)
+{
+    uint32_t bit = DATA_TOPIC_BIT(t->id);
+    atomic_val_t count = atomic_get(&subscriber_count);
+
+    for (atomic_val_t i = 0; i < count; i++) {
+        if (subscribers[i]->topics & bit) {
+            k_event_post(&subscribers[i]->events, bit);
+        }
+    }
+}
+
+static inline uint8_t *topic_slot(const struct topic *t, uint32_t n)
+{
+    return (uint8_t *)t->ring + (n % t->depth) * t->size;
+}
+
+/**
+ * @brief Copy the latest value of a topic once, all zeros if there is none.
+ * @return head at the time of the copy, for the caller's retry check
+ */
+static uint32_t topic_copy_latest(const struct topic *t, void *dst)
+{
+    uint32_t head = (uint32_t)atomic_get(&t->head);
+
+    barrier_dmem_fence_full();
+    if (head == 0) {
+        memset(dst, 0, t->size);
+    } else {
+        memcpy(dst, topic_slot(t, head - 1), t->size);
+    }
+
+    return head;
+}
+
+/**
+ * @brief Publish a new value for a topic, then wake its subscribers.
+ * @param prev If not NULL, receives the value being replaced
+ */
+static void topic_write(struct topic *t, const void *src, void *prev)
+{
+    // Only this writer moves head, so the latest slot is stable here
+    uint32_t head = (uint32_t)atomic_get(&t->head);
+
+    if (prev) {
+        topic_copy_latest(t, prev);
+    }
+
+    // Sample n (0-based) is stamped n + 1, so seq 0 means never published
+    uint32_t seq = head + 1;
+    uint8_t *slot = topic_slot(t, head);
+
+    memcpy(slot, src, t->size);
+    memcpy(slot + t->seq_offset, &seq, sizeof(seq));
+    barrier_dmem_fence_full();
+
+    k_spinlock_key_t key = k_spin_lock(&data_lock);
+
+    atomic_inc(&data_generation);
+    atomic_inc(&t->head);
+    atomic_inc(&data_generation);
+
+    k_spin_unlock(&data_lock, key);
+
+    topic_notify(t);
+}
+
+/**
+ * @brief Copy the latest value of a topic, retrying if writers lapped the copy.
+ */
+static void topic_read(const struct topic *t, void *dst)
+{
+    uint32_t head;
+
+    do {
+        head = topic_copy_latest(t, dst);
+        barrier_dmem_fence_full();
+    } while ((uint32_t)atomic_get(&t->head) - head >= t->depth - 1);
+}
+
+/**
+ * @brief Copy up to max samples from a topic's history, oldest first.
+ *
+ * Lock-free like topic_read(): while head is h, a writer may be filling
+ * slot h % depth, which holds sample h - depth. Anything newer than that is
+ * intact, so the copy only has to be redone if the reader fell far enough
+ * behind for the writer to lap its cursor mid-copy.
+ */
+static size_t topic_history_read(const struct topic *t, struct data_cursor *cursor, void *dst,
+                                 size_t max)
+{
+    uint8_t *out = dst;
+    uint32_t count;
+
+    for (;;) {
+        uint32_t head = (uint32_t)atomic_get(&t->head);
+        uint32_t oldest = head - t->depth + 1;
+
+        barrier_dmem_fence_full();
+
+        if ((int32_t)(cursor->next - oldest) < 0) {
+            cursor->dropped += oldest - cursor->next;
+            cursor->next = oldest;
+        }
+
+        count = MIN(head - cursor->next, (uint32_t)max);
+        for (uint32_t i = 0; i < count; i++) {
+            memcpy(out + i * t->size, topic_slot(t, cursor->next + i), t->size);
+        }
+
+        barrier_dmem_fence_full();
+        head = (uint32_t)atomic_get(&t->head);
+        if ((int32_t)(cursor->next - (head - t->depth + 1)) >= 0) {
+            break;
+        }
+    }
+
+    cursor->next += count;
+    return count;
+}
+
+bool data_seq_track(struct data_seq_stats *stats, uint32_t seq)
+{
+    // Nothing published yet
+    if (seq == 0) {
+        return false;
+    }
+
+    if (seq == stats->last) {
+        stats->duplicate++;
+        return false;
+    }
+
+    // Samples published before the first read are not counted as missed
+    if (stats->last != 0) {
+        stats->missed += seq - stats->last - 1;
+    }
+
+    stats->last = seq;
+    return true;
+}
+
+void data_cursor_init(enum data_topic topic, struct data_cursor *cursor)
+{
+    cursor->next = (uint32_t)atomic_get(&topics[topic]->head);
+    cursor->dropped = 0;
+}
+
+void get_data_snapshot(struct data_snapshot *dst)
+{
+    atomic_val_t start;
+
+    do {
+        start = atomic_get(&data_generation);
+        barrier_dmem_fence_full();
+        // A lapped slot would take publishes, which move the generation
+        topic_copy_latest(&imu_topic, &dst->imu);
+        topic_copy_latest(&attitude_topic, &dst->attitude);
+        topic_copy_latest(&baro_topic, &dst->baro);
+        topic_copy_latest(&state_topic, &dst->state);
+        topic_copy_latest(&apogee_topic, &dst->apogee);
+        topic_copy_latest(&nav_topic, &dst->nav);
+        topic_copy_latest(&pyro_topic, &dst->pyro);
+        topic_copy_latest(&gps_topic, &dst->gps);
+        topic_copy_latest(&camera_topic, &dst->camera);
+        barrier_dmem_fence_full();
+    } while ((start & 1) || atomic_get(&data_generation) != start);
+
+    dst->generation = (uint32_t)(start / 2);
+}
+
+/**
+ * @brief Journal a flag if it changed (O(1), safe on the pyro path).
+ */
+static void journal_flag(enum journal_event_id id, bool prev, bool now)
+{
+    if (prev != now) {
+        journal_record(id, now);
+    }
+}
 
 // Setter functions
 void set_imu_data(const struct imu_data *src)
 {
-    k_mutex_lock(&imu_mutex, K_FOREVER);
-    g_imu_data = *src;
-    k_mutex_unlock(&imu_mutex);
+    topic_write(&imu_topic, src, NULL);
 }
 
 void set_baro_data(const struct baro_data *src)
 {
-    k_mutex_lock(&baro_mutex, K_FOREVER);
-    g_baro_data = *src;
-    k_mutex_unlock(&baro_mutex);
+    struct baro_data prev;
+
+    topic_write(&baro_topic, src, &prev);
+
+    journal_flag(JOURNAL_BARO0_HEALTHY, prev.baro0.healthy, src->baro0.healthy);
+    journal_flag(JOURNAL_BARO1_HEALTHY, prev.baro1.healthy, src->baro1.healthy);
 }
 
 // Getter functions
 void get_imu_data(struct imu_data *dst)
 {
-    k_mutex_lock(&imu_mutex, K_FOREVER);
-    *dst = g_imu_data;
-    k_mutex_unlock(&imu_mutex);
+    topic_read(&imu_topic, dst);
+}
+
+size_t get_imu_history(struct data_cursor *cursor, struct imu_data *dst, size_t max)
+{
+    return topic_history_read(&imu_topic, cursor, dst, max);
+}
+
+void set_imu_filtered_data(const struct imu_data *src)
+{
+    topic_write(&imu_filtered_topic, src, NULL);
+}
+
+void get_imu_filtered_data(struct imu_data *dst)
+{
+    topic_read(&imu_filtered_topic, dst);
+}
+
+size_t get_imu_filtered_history(struct data_cursor *cursor, struct imu_data *dst, size_t max)
+{
+    return topic_history_read(&imu_filtered_topic, cursor, dst, max);
+}
+
+void set_attitude_data(const struct attitude_data *src)
+{
+    topic_write(&attitude_topic, src, NULL);
+}
+
+void get_attitude_data(struct attitude_data *dst)
+{
+    topic_read(&attitude_topic, dst);
+}
+
+size_t get_attitude_history(struct data_cursor *cursor, struct attitude_data *dst, size_t max)
+{
+    return topic_history_read(&attitude_topic, cursor, dst, max);
 }
 
 void get_baro_data(struct baro_data *dst)
 {
-    k_mutex_lock(&baro_mutex, K_FOREVER);
-    *dst = g_baro_data;
-    k_mutex_unlock(&baro_mutex);
+    topic_read(&baro_topic, dst);
+}
+
+size_t get_baro_history(struct data_cursor *cursor, struct baro_data *dst, size_t max)
+{
+    return topic_history_read(&baro_topic, cursor, dst, max);
 }
 
 void set_state_data(const struct state_data *src)
 {
-    k_mutex_lock(&state_mutex, K_FOREVER);
-    g_state_data = *src;
-    k_mutex_unlock(&state_mutex);
+    topic_write(&state_topic, src, NULL);
 }
 
 void get_state_data(struct state_data *dst)
 {
-    k_mutex_lock(&state_mutex, K_FOREVER);
-    *dst = g_state_data;
-    k_mutex_unlock(&state_mutex);
+    topic_read(&state_topic, dst);
+}
+
+size_t get_state_history(struct data_cursor *cursor, struct state_data *dst, size_t max)
+{
+    return topic_history_read(&state_topic, cursor, dst, max);
+}
+
+void set_apogee_data(const struct apogee_data *src)
+{
+    struct apogee_data prev;
+
+    topic_write(&apogee_topic, src, &prev);
+
+    journal_flag(JOURNAL_APOGEE_VALID, prev.valid, src->valid);
+}
+
+void get_apogee_data(struct apogee_data *dst)
+{
+    topic_read(&apogee_topic, dst);
+}
+
+size_t get_apogee_history(struct data_cursor *cursor, struct apogee_data *dst, size_t max)
+{
+    return topic_history_read(&apogee_topic, cursor, dst, max);
+}
+
+void set_nav_data(const struct nav_data *src)
+{
+    struct nav_data prev;
+
+    topic_write(&nav_topic, src, &prev);
+
+    journal_flag(JOURNAL_NAV_ORIGIN, prev.origin_valid, src->origin_valid);
+}
+
+void get_nav_data(struct nav_data *dst)
+{
+    topic_read(&nav_topic, dst);
+}
+
+size_t get_nav_history(struct data_cursor *cursor, struct nav_data *dst, size_t max)
+{
+    return topic_history_read(&nav_topic, cursor, dst, max);
 }
 
 void set_pyro_data(const struct pyro_data *src)
 {
-    k_mutex_lock(&pyro_data_mutex, K_FOREVER);
+    struct pyro_data prev;
 
-    // Log changes to pyro flags
-    if (src->drogue_fire_requested != g_pyro_data.drogue_fire_requested) {
-        LOG_INF("Pyro: drogue_fire_requested -> %d", src->drogue_fire_requested);
-    }
-    if (src->main_fire_requested != g_pyro_data.main_fire_requested) {
-        LOG_INF("Pyro: main_fire_requested -> %d", src->main_fire_requested);
-    }
-    if (src->drogue_fire_ack != g_pyro_data.drogue_fire_ack) {
-        LOG_INF("Pyro: drogue_fire_ack -> %d", src->drogue_fire_ack);
-    }
-    if (src->main_fire_ack != g_pyro_data.main_fire_ack) {
-        LOG_INF("Pyro: main_fire_ack -> %d", src->main_fire_ack);
-    }
-    if (src->drogue_fired != g_pyro_data.drogue_fired) {
-        LOG_INF("Pyro: drogue_fired -> %d", src->drogue_fired);
-    }
-    if (src->main_fired != g_pyro_data.main_fired) {
-        LOG_INF("Pyro: main_fired -> %d", src->main_fired);
-    }
-    if (src->drogue_fail != g_pyro_data.drogue_fail) {
-        LOG_ERR("Pyro: drogue_fail -> %d", src->drogue_fail);
-    }
-    if (src->main_fail != g_pyro_data.main_fail) {
-        LOG_ERR("Pyro: main_fail -> %d", src->main_fail);
-    }
-    if (src->drogue_cont_ok != g_pyro_data.drogue_cont_ok) {
-        LOG_INF("Pyro: drogue_cont_ok -> %d", src->drogue_cont_ok);
-    }
-    if (src->main_cont_ok != g_pyro_data.main_cont_ok) {
-        LOG_INF("Pyro: main_cont_ok -> %d", src->main_cont_ok);
-    }
+    topic_write(&pyro_topic, src, &prev);
 
-    g_pyro_data = *src;
-    k_mutex_unlock(&pyro_data_mutex);
+    // Record flag changes in the journal; the journal thread does the printing
+    journal_flag(JOURNAL_PYRO_DROGUE_FIRE_REQUESTED, prev.drogue_fire_requested,
+                 src->drogue_fire_requested);
+    journal_flag(JOURNAL_PYRO_MAIN_FIRE_REQUESTED, prev.main_fire_requested,
+                 src->main_fire_requested);
+    journal_flag(JOURNAL_PYRO_DROGUE_FIRE_ACK, prev.drogue_fire_ack, src->drogue_fire_ack);
+    journal_flag(JOURNAL_PYRO_MAIN_FIRE_ACK, prev.main_fire_ack, src->main_fire_ack);
+    journal_flag(JOURNAL_PYRO_DROGUE_FIRED, prev.drogue_fired, src->drogue_fired);
+    journal_flag(JOURNAL_PYRO_MAIN_FIRED, prev.main_fired, src->main_fired);
+    journal_flag(JOURNAL_PYRO_DROGUE_FAIL, prev.drogue_fail, src->drogue_fail);
+    journal_flag(JOURNAL_PYRO_MAIN_FAIL, prev.main_fail, src->main_fail);
+    journal_flag(JOURNAL_PYRO_DROGUE_CONT_OK, prev.drogue_cont_ok, src->drogue_cont_ok);
+    journal_flag(JOURNAL_PYRO_MAIN_CONT_OK, prev.main_cont_ok, src->main_cont_ok);
 }
 
 void get_pyro_data(struct pyro_data *dst)
 {
-    k_mutex_lock(&pyro_data_mutex, K_FOREVER);
-    *dst = g_pyro_data;
-    k_mutex_unlock(&pyro_data_mutex);
+    topic_read(&pyro_topic, dst);
+}
+
+size_t get_pyro_history(struct data_cursor *cursor, struct pyro_data *dst, size_t max)
+{
+    return topic_history_read(&pyro_topic, cursor, dst, max);
 }
 
 void set_gps_data(const struct gps_data *src)
 {
-    k_mutex_lock(&gps_mutex, K_FOREVER);
-    g_gps_data = *src;
-    k_mutex_unlock(&gps_mutex);
+    topic_write(&gps_topic, src, NULL);
 }
 
 void get_gps_data(struct gps_data *dst)
 {
-    k_mutex_lock(&gps_mutex, K_FOREVER);
-    *dst = g_gps_data;
-    k_mutex_unlock(&gps_mutex);
+    topic_read(&gps_topic, dst);
+}
+
+size_t get_gps_history(struct data_cursor *cursor, struct gps_data *dst, size_t max)
+{
+    return topic_history_read(&gps_topic, cursor, dst, max);
 }
 
 void set_camera_data(const struct camera_data *src)
 {
-    k_mutex_lock(&camera_mutex, K_FOREVER);
+    struct camera_data prev;
 
-    if (src->vtx_power_on != g_camera_data.vtx_power_on) {
-        LOG_INF("Camera: vtx_power_on -> %d", src->vtx_power_on);
-    }
-    if (src->recording != g_camera_data.recording) {
-        LOG_INF("Camera: recording -> %d", src->recording);
-    }
+    topic_write(&camera_topic, src, &prev);
 
-    g_camera_data = *src;
-    k_mutex_unlock(&camera_mutex);
+    journal_flag(JOURNAL_CAMERA_VTX_POWER, prev.vtx_power_on, src->vtx_power_on);
+    journal_flag(JOURNAL_CAMERA_RECORDING, prev.recording, src->recording);
 }
 
 void get_camera_data(struct camera_data *dst)
 {
-    k_mutex_lock(&camera_mutex, K_FOREVER);
-    *dst = g_camera_data;
-    k_mutex_unlock(&camera_mutex);
+    topic_read(&camera_topic, dst);
+}
+
+size_t get_camera_history(struct data_cursor *cursor, struct camera_data *dst, size_t max)
+{
+    return topic_history_read(&camera_topic, cursor, dst, max);
+}
+
+void set_health_data(const struct health_data *src)
+{
+    topic_write(&health_topic, src, NULL);
+}
+
+void get_health_data(struct health_data *dst)
+{
+    topic_read(&health_topic, dst);
+}
+
+size_t get_health_history(struct data_cursor *cursor, struct health_data *dst, size_t max)
+{
+    return topic_history_read(&health_topic, cursor, dst, max);
+}
+
+void set_imu_calib_data(const struct imu_calib_data *src)
+{
+    struct imu_calib_data prev;
+
+    topic_write(&imu_calib_topic, src, &prev);
+
+    journal_flag(JOURNAL_IMU_CALIB_VALID, prev.valid, src->valid);
+}
+
+void get_imu_calib_data(struct imu_calib_data *dst)
+{
+    topic_read(&imu_calib_topic, dst);
+}
+
+size_t get_imu_calib_history(struct data_cursor *cursor, struct imu_calib_data *dst,
+                             size_t max)
+{
+    return topic_history_read(&imu_calib_topic, cursor, dst, max);
+}
+
+void set_vibration_data(const struct vibration_data *src)
+{
+    topic_write(&vibration_topic, src, NULL);
+}
+
+void get_vibration_data(struct vibration_data *dst)
+{
+    topic_read(&vibration_topic, dst);
+}
+
+size_t get_vibration_history(struct data_cursor *cursor, struct vibration_data *dst,
+                             size_t max)
+{
+    return topic_history_read(&vibration_topic, cursor, dst, max);
 }
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <zephyr/kernel.h>
 
 typedef enum {
     FLIGHT_STATE_STANDBY = 0,
@@ -13,11 +14,42 @@ typedef enum {
     FLIGHT_STATE_LANDED,
 } flight_state_id_t;
 
-// Data structures for sensor data
+/**
+ * @brief Microsecond timestamp for a topic sample, taken from the 64-bit
+ * cycle counter when the timer has one. Shares k_uptime_get()'s epoch, so
+ * the millisecond timestamp fields are timestamp_us / 1000.
+ */
+static inline int64_t data_timestamp_us(void)
+{
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+    return (int64_t)k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+    return (int64_t)k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+}
+
+// Data structures for sensor data. The IMU topic carries every sample at the
+// IMU rate, for logging; the filtered IMU topic carries the same struct
+// low-pass filtered and decimated (see sensors/imu_decimate.h), for estimation.
 struct imu_data {
     float accel[3];    // Acceleration in m/s²
     float gyro[3];     // Angular velocity in rad/s
-    int64_t timestamp; // Timestamp in milliseconds
+    int64_t timestamp;    // Timestamp in milliseconds (timestamp_us / 1000)
+    int64_t timestamp_us; // Sample time in microseconds, see data_timestamp_us()
+    uint32_t seq;         // Per-topic sequence number, stamped by data.c
+};
+
+// Attitude, updated from every IMU sample, see sensors/ahrs.h. Earth z is up;
+// heading is unobserved and only follows the gyro.
+struct attitude_data {
+    float q[4];           // Body to earth quaternion, w x y z
+    float tilt;           // Angle between the nose and vertical (rad)
+    float roll_rate;      // Angular rate about the nose, gyro bias removed (rad/s)
+    float gyro_bias[3];   // Gyro bias still left after calibration, as estimated (rad/s)
+    bool aligned;         // Tilt has been taken from the accelerometer
+    int64_t timestamp;    // Timestamp in milliseconds (timestamp_us / 1000)
+    int64_t timestamp_us; // Of the IMU sample
+    uint32_t seq;
 };
 
 // Per-barometer sensor data
@@ -25,9 +57,11 @@ struct baro_sensor_data {
     float pressure;    // Pressure in Pa
     float temperature; // Temperature in °C
     float altitude;    // Altitude in meters (from pressure + temp)
-    float nis;         // Normalized innovation squared
-    uint8_t faults;    // Accumulated fault count
-    bool healthy;      // Health status (accepted/rejected)
+    float nis;         // Normalized innovation squared against the filter's prediction
+    uint8_t faults;    // Fault counter: up per failed or rejected read, down per good one
+    bool healthy;      // Not demoted: readings that pass the NIS gate are fused
+    bool fused;        // This reading updated the filter
+    uint32_t rejected; // Readings that failed the NIS gate since boot
 };
 
 // Combined barometer data (shared with other threads)
@@ -40,8 +74,12 @@ struct baro_data {
     float alt_variance; // Kalman filter variance (P)
     float velocity;     // Vertical velocity estimate (m/s)
     float vel_variance; // Velocity variance (P11)
+    float accel_bias;   // Vertical accelerometer bias estimate (m/s^2), 0 without the IMU
 
-    int64_t timestamp; // Timestamp in milliseconds
+    int64_t timestamp;        // Timestamp in milliseconds (timestamp_us / 1000)
+    int64_t timestamp_us;     // Time of the filtered barometer sample in microseconds
+    uint32_t acquired_cycles; // k_cycle_get_32() when the newest reading was read out
+    uint32_t seq;             // Per-topic sequence number, stamped by data.c
 };
 
 struct state_data {
@@ -49,11 +87,52 @@ struct state_data {
     float ground_altitude;
     bool ground_calibrated;
     int64_t timestamp;
+    int64_t timestamp_us; // Of the baro sample the state machine last ran on
+    uint32_t seq;
+
+    // State machine's view of the baro topic (see struct data_seq_stats)
+    uint32_t baro_missed;
+    uint32_t baro_duplicate;
+};
+
+// Ballistic apogee prediction, made by the state machine from each baro
+// sample in ascent, see state_machine/apogee_predict.h
+struct apogee_data {
+    float time_to_apogee;  // s from the baro sample, negative once past
+    float apogee_altitude; // Predicted apogee in meters (absolute)
+    float apogee_agl;      // The same relative to the ground
+    float velocity;        // Smoothed vertical velocity the prediction starts from (m/s)
+    float drag;            // Drag per unit mass per v^2 fitted over the coast (1/m)
+    float residual;        // RMS scatter of the filter's velocity about the model (m/s)
+    bool valid;            // Coasting, the model fits and the prediction has settled
+    int64_t timestamp;
+    int64_t timestamp_us;  // Of the baro sample the prediction was made from
+    uint32_t seq;
+};
+
+// Navigation solution from the IMU, GPS and barometers, see sensors/nav_ekf.h.
+// North and east are from the first GPS fix, down from the ground datum.
+struct nav_data {
+    float position[3];     // North, east, down (m)
+    float velocity[3];     // North, east, down (m/s)
+    float position_var[3]; // Variances of position (m^2)
+    float velocity_var[3]; // Variances of velocity (m^2/s^2)
+    float pos_vel_cov[3];  // Covariance of each axis' position and velocity (m^2/s)
+    float accel_bias;      // Down acceleration bias estimate (m/s^2)
+    float origin_lat;      // Degrees, of the first GPS fix
+    float origin_lon;
+    bool origin_valid;     // A fix has been taken: north and east are on the ground's map
+    uint32_t gps_fused;    // Fixes applied since boot
+    uint32_t gps_rejected; // Fixes that failed the NIS gate
+    int64_t timestamp;
+    int64_t timestamp_us;  // Of the last IMU sample the filter was predicted to
+    uint32_t seq;
 };
 
 struct pyro_data {
     uint8_t status_byte;
     int64_t timestamp;
+    int64_t timestamp_us;
     bool drogue_fired;
     bool main_fired;
     bool drogue_fail;
@@ -64,6 +143,7 @@ struct pyro_data {
     bool main_fire_ack;
     bool drogue_fire_requested;
     bool main_fire_requested;
+    uint32_t seq;
 };
 
 struct gps_data {
@@ -74,6 +154,8 @@ struct gps_data {
     uint8_t sats;     // Satellites in use
     uint8_t fix;      // Fix quality
     int64_t timestamp;
+    int64_t timestamp_us; // When the fix was parsed
+    uint32_t seq;
 };
 
 // VTX/RunCam status (shared between command executor, state machine and radio)
@@ -81,26 +163,203 @@ struct camera_data {
     bool vtx_power_on; // VTX/RunCam power switch state
     bool recording;    // RunCam recording state (optimistic, no protocol ack)
     int64_t timestamp;
+    int64_t timestamp_us;
+    uint32_t seq;
+};
+
+// Number of orientations the calibration tells apart: +x, -x, +y, -y, +z, -z up
+#define IMU_CALIB_POSE_COUNT 6
+
+// IMU calibration estimated on the pad, see sensors/imu_calib.h. The IMU topic
+// carries samples with it applied: accel = M (raw - offset), gyro = raw - bias.
+struct imu_calib_data {
+    float gyro_bias[3];    // rad/s
+    float accel_offset[3]; // m/s²
+    float accel_matrix[9]; // Row-major scale and misalignment correction M
+    float gyro_noise;      // Gyro standard deviation in the last stationary window, rad/s
+    float accel_noise;     // Accel standard deviation in the last stationary window, m/s²
+    uint32_t windows;      // Stationary windows seen so far
+    uint8_t poses;         // Orientations seen, bit 2 * axis + (1 if pointing down)
+    bool valid;            // Enough stationary data for the gyro bias
+    int64_t timestamp;
+    int64_t timestamp_us; // End of the last stationary window
+    uint32_t seq;
+};
+
+// Vibration spectrum of one IMU axis over one analysis window, see vibration.h
+#define VIBRATION_BANDS 4
+
+struct vibration_axis {
+    float rms;                        // Everything above the lowest band edge, m/s² or rad/s
+    float band_rms[VIBRATION_BANDS];  // Per band, edges in vibration_band_edges_hz
+    float peak_hz;                    // Strongest component
+    float peak_rms;                   // Its amplitude, as an RMS
+};
+
+// Vibration environment, published about once a second by the vibration thread
+struct vibration_data {
+    struct vibration_axis accel[3];
+    struct vibration_axis gyro[3];
+    float sample_rate_hz;      // Measured over the window
+    uint16_t fft_size;         // Samples per window
+    uint32_t analysis_us;      // Time the analysis of this window took
+    uint32_t windows_dropped;  // Windows abandoned because IMU samples were missed
+    int64_t timestamp;
+    int64_t timestamp_us;      // Newest sample in the window
+    uint32_t seq;
+};
+
+// Per-thread health, see health.c
+#define HEALTH_MAX_THREADS CONFIG_FALCON_HEALTH_MAX_THREADS
+#define HEALTH_THREAD_NAME_LEN 16
+
+struct health_thread {
+    char name[HEALTH_THREAD_NAME_LEN];
+    int8_t priority;
+    uint16_t cpu_permille; // Share of CPU time over the last health period, in 0.1 %
+    uint32_t stack_size;   // Bytes
+    uint32_t stack_unused; // Bytes never written since the thread started (high-water mark)
+};
+
+// System health, published at a low rate by the health thread
+struct health_data {
+    struct health_thread threads[HEALTH_MAX_THREADS];
+    uint8_t thread_count;   // Valid entries in threads
+    uint16_t idle_permille; // Time spent idle over the last health period, in 0.1 %
+    int64_t timestamp;
+    int64_t timestamp_us;
+    uint32_t seq;
+};
+
+// Shared topics, used to select which publishes a subscriber is woken for
+enum data_topic {
+    DATA_TOPIC_IMU = 0,
+    DATA_TOPIC_BARO,
+    DATA_TOPIC_STATE,
+    DATA_TOPIC_PYRO,
+    DATA_TOPIC_GPS,
+    DATA_TOPIC_CAMERA,
+    DATA_TOPIC_HEALTH,
+    DATA_TOPIC_IMU_CALIB,
+    DATA_TOPIC_IMU_FILTERED,
+    DATA_TOPIC_VIBRATION,
+    DATA_TOPIC_APOGEE,
+    DATA_TOPIC_ATTITUDE,
+    DATA_TOPIC_NAV,
+    DATA_TOPIC_COUNT,
+};
+
+#define DATA_TOPIC_BIT(topic) BIT(topic)
+
+/*
+ * A consumer that blocks until fresh samples are published. Each
+ * subscriber owns its event bits, so any number of threads can wait on the
+ * same topic without stealing each other's wakeups.
+ */
+struct data_subscriber {
+    struct k_event events;
+    uint32_t topics;
 };
 
-// Global instances
-extern struct imu_data g_imu_data;
-extern struct baro_data g_baro_data;
-extern struct state_data g_state_data;
-extern struct pyro_data g_pyro_data;
-extern struct gps_data g_gps_data;
-extern struct camera_data g_camera_data;
+/**
+ * @brief Register a subscriber for the given DATA_TOPIC_BIT() mask.
+ * Call once before the first data_wait(); subscribers are never removed.
+ * @return 0 on success, -ENOMEM if the subscriber table is full
+ */
+int data_subscribe(struct data_subscriber *sub, uint32_t topics);
+
+/**
+ * @brief Block until one of the topics in the mask has been published since
+ * the last call, then consume those notifications.
+ * @return mask of topics with a new sample, 0 on timeout
+ */
+uint32_t data_wait(struct data_subscriber *sub, uint32_t topics, k_timeout_t timeout);
+
+// Consistent view of every flight-data topic, taken in one operation. Health,
+// IMU calibration and vibration are slow-moving, so they are not part of the
+// snapshot.
+struct data_snapshot {
+    uint32_t generation; // Total publishes across all topics when the snapshot was taken
+    struct imu_data imu;
+    struct attitude_data attitude;
+    struct baro_data baro;
+    struct state_data state;
+    struct apogee_data apogee;
+    struct nav_data nav;
+    struct pyro_data pyro;
+    struct gps_data gps;
+    struct camera_data camera;
+};
+
+/**
+ * @brief Copy all topics from the same epoch: no publish to any topic lands
+ * between the first and last copy. Never blocks a publisher.
+ */
+void get_data_snapshot(struct data_snapshot *dst);
+
+/*
+ * Every publish is stamped with a per-topic sequence number in its seq
+ * field: 1 for the first sample, then counting up with no gaps. Setters
+ * ignore whatever seq the caller passed in. A consumer that polls the
+ * latest value feeds each seq it reads to data_seq_track() to count the
+ * samples it never saw (missed) and the ones it read twice (duplicate).
+ */
+struct data_seq_stats {
+    uint32_t last;      // Last sequence number seen, 0 before the first sample
+    uint32_t missed;    // Samples published but never read
+    uint32_t duplicate; // Samples read more than once
+};
 
-// Getters and setters
+/**
+ * @brief Account for one read of a topic.
+ * @return true if seq is a sample this consumer has not seen before
+ */
+bool data_seq_track(struct data_seq_stats *stats, uint32_t seq);
+
+/*
+ * Reader position in a topic's history ring. Each reader owns its cursor:
+ * zero-initialise it to start from the oldest retained sample, or use
+ * data_cursor_init() to only see samples published from now on.
+ */
+struct data_cursor {
+    uint32_t next;    // Sequence number of the next sample to read
+    uint32_t dropped; // Samples overwritten before this reader got to them
+};
+
+/**
+ * @brief Point a cursor at the next sample to be published on a topic.
+ */
+void data_cursor_init(enum data_topic topic, struct data_cursor *cursor);
+
+/*
+ * Getters and setters. Each topic is published through a ring of samples
+ * (see data.c) by a single writer thread, so setters never wait, and
+ * getters never block a setter; they retry their copy only if publishes
+ * lapped it. The pyro topic is written only by the pyro thread (or the
+ * cyclic executive) and the camera topic only by the system workqueue, see
+ * camera/camera_status.h.
+ */
 void set_imu_data(const struct imu_data *src);
 void get_imu_data(struct imu_data *dst);
 
+void set_imu_filtered_data(const struct imu_data *src);
+void get_imu_filtered_data(struct imu_data *dst);
+
+void set_attitude_data(const struct attitude_data *src);
+void get_attitude_data(struct attitude_data *dst);
+
 void set_baro_data(const struct baro_data *src);
 void get_baro_data(struct baro_data *dst);
 
 void set_state_data(const struct state_data *src);
 void get_state_data(struct state_data *dst);
 
+void set_apogee_data(const struct apogee_data *src);
+void get_apogee_data(struct apogee_data *dst);
+
+void set_nav_data(const struct nav_data *src);
+void get_nav_data(struct nav_data *dst);
+
 void set_pyro_data(const struct pyro_data *src);
 void get_pyro_data(struct pyro_data *dst);
 
@@ -110,4 +369,35 @@ void get_gps_data(struct gps_data *dst);
 void set_camera_data(const struct camera_data *src);
 void get_camera_data(struct camera_data *dst);
 
+void set_health_data(const struct health_data *src);
+void get_health_data(struct health_data *dst);
+
+void set_imu_calib_data(const struct imu_calib_data *src);
+void get_imu_calib_data(struct imu_calib_data *dst);
+
+void set_vibration_data(const struct vibration_data *src);
+void get_vibration_data(struct vibration_data *dst);
+
+/*
+ * History readers. Each topic keeps its last CONFIG_FALCON_HISTORY_<TOPIC>
+ * samples; these copy up to max of them, oldest first, starting at the
+ * cursor and advance it past what was returned. If the producer lapped the
+ * cursor, the lost samples are skipped and added to cursor->dropped.
+ * Never block a setter.
+ * @return number of samples written to dst
+ */
+size_t get_imu_history(struct data_cursor *cursor, struct imu_data *dst, size_t max);
+size_t get_imu_filtered_history(struct data_cursor *cursor, struct imu_data *dst, size_t max);
+size_t get_attitude_history(struct data_cursor *cursor, struct attitude_data *dst, size_t max);
+size_t get_baro_history(struct data_cursor *cursor, struct baro_data *dst, size_t max);
+size_t get_state_history(struct data_cursor *cursor, struct state_data *dst, size_t max);
+size_t get_apogee_history(struct data_cursor *cursor, struct apogee_data *dst, size_t max);
+size_t get_nav_history(struct data_cursor *cursor, struct nav_data *dst, size_t max);
+size_t get_pyro_history(struct data_cursor *cursor, struct pyro_data *dst, size_t max);
+size_t get_gps_history(struct data_cursor *cursor, struct gps_data *dst, size_t max);
+size_t get_camera_history(struct data_cursor *cursor, struct camera_data *dst, size_t max);
+size_t get_health_history(struct data_cursor *cursor, struct health_data *dst, size_t max);
+size_t get_imu_calib_history(struct data_cursor *cursor, struct imu_calib_data *dst, size_t max);
+size_t get_vibration_history(struct data_cursor *cursor, struct vibration_data *dst, size_t max);
+
 #endif
@@ -0,0 +1,127 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <string.h>
+#include "deploy_latency.h"
+
+struct stage_acc {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t histogram[DEPLOY_LATENCY_BUCKETS];
+};
+
+// One deployment being followed from its deciding sample to the ACK
+struct deploy_trace {
+    bool active;
+    uint32_t origin_cycles;
+    uint32_t recorded; // Bit per enum deploy_latency_stage already reached
+};
+
+static atomic_t marked_cycles;
+static struct stage_acc stages[DEPLOY_LATENCY_STAGE_COUNT];
+static struct deploy_trace traces[DEPLOY_LATENCY_CHANNEL_COUNT];
+static struct k_spinlock latency_lock;
+
+static const char *const stage_names[DEPLOY_LATENCY_STAGE_COUNT] = {
+    [DEPLOY_LATENCY_DECISION] = "decision",
+    [DEPLOY_LATENCY_FIRE] = "fire",
+    [DEPLOY_LATENCY_ENQUEUE] = "enqueue",
+    [DEPLOY_LATENCY_PYRO_SPI] = "pyro_spi",
+    [DEPLOY_LATENCY_ACK] = "ack",
+};
+
+static int bucket_index(uint32_t us)
+{
+    if (us < BIT(DEPLOY_LATENCY_BUCKET_SHIFT)) {
+        return 0;
+    }
+
+    int idx = (31 - __builtin_clz(us)) - DEPLOY_LATENCY_BUCKET_SHIFT + 1;
+
+    return MIN(idx, DEPLOY_LATENCY_BUCKETS - 1);
+}
+
+// Caller holds latency_lock
+static void accumulate(enum deploy_latency_stage stage, uint32_t origin_cycles)
+{
+    uint32_t elapsed = k_cycle_get_32() - origin_cycles;
+    uint32_t us = (uint32_t)k_cyc_to_us_floor64(elapsed);
+    struct stage_acc *acc = &stages[stage];
+
+    acc->count++;
+    acc->last_us = us;
+    acc->max_us = MAX(acc->max_us, us);
+    acc->sum_us += us;
+    acc->histogram[bucket_index(us)]++;
+}
+
+void deploy_latency_mark_sample(uint32_t acquired_cycles)
+{
+    atomic_set(&marked_cycles, (atomic_val_t)acquired_cycles);
+}
+
+void deploy_latency_record(enum deploy_latency_stage stage)
+{
+    uint32_t origin = (uint32_t)atomic_get(&marked_cycles);
+    k_spinlock_key_t key = k_spin_lock(&latency_lock);
+
+    accumulate(stage, origin);
+    k_spin_unlock(&latency_lock, key);
+}
+
+void deploy_latency_trace_start(enum deploy_latency_channel channel)
+{
+    uint32_t origin = (uint32_t)atomic_get(&marked_cycles);
+    k_spinlock_key_t key = k_spin_lock(&latency_lock);
+    struct deploy_trace *trace = &traces[channel];
+
+    trace->active = true;
+    trace->origin_cycles = origin;
+    trace->recorded = BIT(DEPLOY_LATENCY_FIRE);
+    accumulate(DEPLOY_LATENCY_FIRE, origin);
+    k_spin_unlock(&latency_lock, key);
+}
+
+void deploy_latency_trace(enum deploy_latency_channel channel, enum deploy_latency_stage stage)
+{
+    k_spinlock_key_t key = k_spin_lock(&latency_lock);
+    struct deploy_trace *trace = &traces[channel];
+
+    if (trace->active && (trace->recorded & BIT(stage)) == 0) {
+        trace->recorded |= BIT(stage);
+        accumulate(stage, trace->origin_cycles);
+
+        if (stage == DEPLOY_LATENCY_ACK) {
+            trace->active = false;
+        }
+    }
+    k_spin_unlock(&latency_lock, key);
+}
+
+void deploy_latency_get(enum deploy_latency_stage stage, struct deploy_latency_stat *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&latency_lock);
+    const struct stage_acc *acc = &stages[stage];
+
+    out->count = acc->count;
+    out->last_us = acc->last_us;
+    out->max_us = acc->max_us;
+    out->mean_us = acc->count ? (uint32_t)(acc->sum_us / acc->count) : 0;
+    memcpy(out->histogram, acc->histogram, sizeof(out->histogram));
+    k_spin_unlock(&latency_lock, key);
+}
+
+const char *deploy_latency_stage_name(enum deploy_latency_stage stage)
+{
+    if (stage >= DEPLOY_LATENCY_STAGE_COUNT) {
+        return "unknown";
+    }
+
+    return stage_names[stage];
+}
+
+uint32_t deploy_latency_bucket_floor_us(int idx)
+{
+    return (idx <= 0) ? 0 : BIT(idx + DEPLOY_LATENCY_BUCKET_SHIFT - 1);
+}
@@ -0,0 +1,86 @@
+#ifndef DEPLOY_LATENCY_H
+#define DEPLOY_LATENCY_H
+
+#include <stdint.h>
+
+/*
+ * Latency from a baro sample to what the flight software does with it,
+ * measured the same way whether the pipeline runs as separate threads or
+ * under the cyclic executive, so the two can be compared from the log.
+ *
+ * DEPLOY_LATENCY_DECISION is recorded for every sample. The remaining stages
+ * trace one deployment each: the sample that made the state machine fire a
+ * charge is carried through the decision, the pyro queue, the SPI bus and
+ * the pyro board's ACK, and every stage is timed from that sample.
+ */
+enum deploy_latency_stage {
+    DEPLOY_LATENCY_DECISION, // Sample acquired -> state machine has evaluated it
+    DEPLOY_LATENCY_FIRE,     // Deciding sample -> state machine fire action
+    DEPLOY_LATENCY_ENQUEUE,  // Deciding sample -> fire command queued for the pyro thread
+    DEPLOY_LATENCY_PYRO_SPI, // Deciding sample -> first fire command on the SPI bus
+    DEPLOY_LATENCY_ACK,      // Deciding sample -> pyro board acknowledged the command
+    DEPLOY_LATENCY_STAGE_COUNT,
+};
+
+enum deploy_latency_channel {
+    DEPLOY_LATENCY_DROGUE,
+    DEPLOY_LATENCY_MAIN,
+    DEPLOY_LATENCY_CHANNEL_COUNT,
+};
+
+/*
+ * Power-of-two histogram buckets: bucket 0 counts latencies below
+ * 2^DEPLOY_LATENCY_BUCKET_SHIFT us, bucket i counts [2^(i+SHIFT-1), 2^(i+SHIFT))
+ * us, and the last bucket counts everything above that.
+ */
+#define DEPLOY_LATENCY_BUCKETS 12
+#define DEPLOY_LATENCY_BUCKET_SHIFT 7
+
+struct deploy_latency_stat {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t mean_us;
+    uint32_t histogram[DEPLOY_LATENCY_BUCKETS];
+};
+
+/**
+ * @brief Note the baro sample the state machine is about to evaluate.
+ * @param acquired_cycles baro_data.acquired_cycles of that sample
+ */
+void deploy_latency_mark_sample(uint32_t acquired_cycles);
+
+/**
+ * @brief Record a stage as complete for the last marked sample.
+ */
+void deploy_latency_record(enum deploy_latency_stage stage);
+
+/**
+ * @brief Start tracing a deployment from the last marked sample and record
+ * DEPLOY_LATENCY_FIRE. Call from the state machine's fire action.
+ */
+void deploy_latency_trace_start(enum deploy_latency_channel channel);
+
+/**
+ * @brief Record a stage of the deployment in progress on a channel. Only the
+ * first time a stage is reached counts, so retries do not skew the result;
+ * DEPLOY_LATENCY_ACK ends the trace. Does nothing if no trace is active.
+ */
+void deploy_latency_trace(enum deploy_latency_channel channel, enum deploy_latency_stage stage);
+
+/**
+ * @brief Copy the statistics for one stage.
+ */
+void deploy_latency_get(enum deploy_latency_stage stage, struct deploy_latency_stat *out);
+
+/**
+ * @brief Short name of a stage, e.g. "ack".
+ */
+const char *deploy_latency_stage_name(enum deploy_latency_stage stage);
+
+/**
+ * @brief Lower bound in microseconds of histogram bucket idx.
+ */
+uint32_t deploy_latency_bucket_floor_us(int idx);
+
+#endif
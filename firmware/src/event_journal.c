@@ -0,0 +1,171 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+#include "event_journal.h"
+#include "periodic_task.h"
+
+LOG_MODULE_REGISTER(journal, LOG_LEVEL_INF);
+
+#define JOURNAL_THREAD_STACK_SIZE 2048
+#define JOURNAL_THREAD_PRIORITY 8
+#define JOURNAL_THREAD_PERIOD_MS 100
+#define JOURNAL_DRAIN_BATCH 8
+
+#define JOURNAL_SIZE CONFIG_FALCON_JOURNAL_SIZE
+
+/*
+ * Multi-producer ring. A producer claims index n with one atomic
+ * increment of journal_head, then fills slot n % JOURNAL_SIZE and stamps
+ * it with n + 1 as the last step. The slot's stamp is 0 while it is being
+ * (re)written, so a reader can tell a finished event from one in progress
+ * or one that has since been overwritten.
+ */
+struct journal_slot {
+    atomic_t seq;
+    struct journal_event event;
+};
+
+static struct journal_slot journal[JOURNAL_SIZE];
+static atomic_t journal_head;
+
+static const char *const event_names[JOURNAL_EVENT_COUNT] = {
+    [JOURNAL_PYRO_DROGUE_FIRE_REQUESTED] = "pyro.drogue_fire_requested",
+    [JOURNAL_PYRO_MAIN_FIRE_REQUESTED] = "pyro.main_fire_requested",
+    [JOURNAL_PYRO_DROGUE_FIRE_ACK] = "pyro.drogue_fire_ack",
+    [JOURNAL_PYRO_MAIN_FIRE_ACK] = "pyro.main_fire_ack",
+    [JOURNAL_PYRO_DROGUE_FIRED] = "pyro.drogue_fired",
+    [JOURNAL_PYRO_MAIN_FIRED] = "pyro.main_fired",
+    [JOURNAL_PYRO_DROGUE_FAIL] = "pyro.drogue_fail",
+    [JOURNAL_PYRO_MAIN_FAIL] = "pyro.main_fail",
+    [JOURNAL_PYRO_DROGUE_CONT_OK] = "pyro.drogue_cont_ok",
+    [JOURNAL_PYRO_MAIN_CONT_OK] = "pyro.main_cont_ok",
+    [JOURNAL_CAMERA_VTX_POWER] = "camera.vtx_power_on",
+    [JOURNAL_CAMERA_RECORDING] = "camera.recording",
+    [JOURNAL_IMU_CALIB_VALID] = "imu.calib_valid",
+    [JOURNAL_BARO0_HEALTHY] = "baro0.healthy",
+    [JOURNAL_BARO1_HEALTHY] = "baro1.healthy",
+    [JOURNAL_APOGEE_VALID] = "apogee.valid",
+    [JOURNAL_NAV_ORIGIN] = "nav.origin",
+};
+
+K_THREAD_STACK_DEFINE(journal_stack, JOURNAL_THREAD_STACK_SIZE);
+static struct k_thread journal_thread;
+static struct periodic_task journal_task;
+
+void journal_record(enum journal_event_id id, int32_t value)
+{
+    uint32_t idx = (uint32_t)atomic_inc(&journal_head);
+    struct journal_slot *slot = &journal[idx % JOURNAL_SIZE];
+
+    atomic_set(&slot->seq, 0);
+    barrier_dmem_fence_full();
+
+    slot->event.timestamp = k_uptime_get();
+    slot->event.seq = idx + 1;
+    slot->event.id = (uint16_t)id;
+    slot->event.value = value;
+
+    barrier_dmem_fence_full();
+    atomic_set(&slot->seq, (atomic_val_t)(idx + 1));
+}
+
+void journal_cursor_init(struct journal_cursor *cursor)
+{
+    cursor->next = (uint32_t)atomic_get(&journal_head);
+    cursor->dropped = 0;
+}
+
+size_t journal_read(struct journal_cursor *cursor, struct journal_event *dst, size_t max)
+{
+    size_t count = 0;
+
+    while (count < max) {
+        uint32_t head = (uint32_t)atomic_get(&journal_head);
+
+        if (cursor->next == head) {
+            break;
+        }
+
+        // Lapped: the oldest events this cursor wanted are gone
+        if (head - cursor->next > JOURNAL_SIZE) {
+            cursor->dropped += head - JOURNAL_SIZE - cursor->next;
+            cursor->next = head - JOURNAL_SIZE;
+        }
+
+        const struct journal_slot *slot = &journal[cursor->next % JOURNAL_SIZE];
+        uint32_t expected = cursor->next + 1;
+        uint32_t before = (uint32_t)atomic_get(&slot->seq);
+
+        barrier_dmem_fence_full();
+        dst[count] = slot->event;
+        barrier_dmem_fence_full();
+
+        uint32_t after = (uint32_t)atomic_get(&slot->seq);
+
+        if (before == expected && after == expected) {
+            cursor->next++;
+            count++;
+        } else if (before == 0 || after == 0 || (int32_t)(before - expected) < 0) {
+            // Claimed but not finished yet: pick it up on the next read
+            break;
+        }
+        // Otherwise a newer producer overwrote the slot; retry from the new head
+    }
+
+    return count;
+}
+
+const char *journal_event_name(enum journal_event_id id)
+{
+    if (id >= JOURNAL_EVENT_COUNT) {
+        return "unknown";
+    }
+
+    return event_names[id];
+}
+
+bool journal_event_is_error(enum journal_event_id id)
+{
+    return id == JOURNAL_PYRO_DROGUE_FAIL || id == JOURNAL_PYRO_MAIN_FAIL;
+}
+
+static void journal_thread_fn(void *p1, void *p2, void *p3)
+{
+    struct journal_cursor cursor = {0};
+    struct journal_event events[JOURNAL_DRAIN_BATCH];
+
+    periodic_task_init(&journal_task, "journal", JOURNAL_THREAD_PERIOD_MS);
+
+    while (1) {
+        periodic_task_wait(&journal_task);
+
+        uint32_t dropped = cursor.dropped;
+        size_t n;
+
+        while ((n = journal_read(&cursor, events, ARRAY_SIZE(events))) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                const struct journal_event *ev = &events[i];
+
+                if (journal_event_is_error(ev->id)) {
+                    LOG_ERR("[%lld ms] %s -> %d", ev->timestamp, journal_event_name(ev->id),
+                            ev->value);
+                } else {
+                    LOG_INF("[%lld ms] %s -> %d", ev->timestamp, journal_event_name(ev->id),
+                            ev->value);
+                }
+            }
+        }
+
+        if (cursor.dropped != dropped) {
+            LOG_WRN("Journal overran: %u events lost", cursor.dropped - dropped);
+        }
+    }
+}
+
+void start_journal_thread(void)
+{
+    k_thread_create(&journal_thread, journal_stack, K_THREAD_STACK_SIZEOF(journal_stack),
+                    journal_thread_fn, NULL, NULL, NULL, JOURNAL_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&journal_thread, "journal");
+}
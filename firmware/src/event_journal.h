@@ -0,0 +1,82 @@
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Event journal: a bounded ring of timestamped field-change events.
+ *
+ * journal_record() is O(1), lock-free and never touches the console, so it
+ * is safe on deployment-critical paths. Readers (the journal thread for the
+ * console, the logger for the SD card) each own a cursor and read at their
+ * own pace; a reader that falls more than CONFIG_FALCON_JOURNAL_SIZE events
+ * behind loses the oldest ones.
+ */
+
+enum journal_event_id {
+    JOURNAL_PYRO_DROGUE_FIRE_REQUESTED = 0,
+    JOURNAL_PYRO_MAIN_FIRE_REQUESTED,
+    JOURNAL_PYRO_DROGUE_FIRE_ACK,
+    JOURNAL_PYRO_MAIN_FIRE_ACK,
+    JOURNAL_PYRO_DROGUE_FIRED,
+    JOURNAL_PYRO_MAIN_FIRED,
+    JOURNAL_PYRO_DROGUE_FAIL,
+    JOURNAL_PYRO_MAIN_FAIL,
+    JOURNAL_PYRO_DROGUE_CONT_OK,
+    JOURNAL_PYRO_MAIN_CONT_OK,
+    JOURNAL_CAMERA_VTX_POWER,
+    JOURNAL_CAMERA_RECORDING,
+    JOURNAL_IMU_CALIB_VALID,
+    JOURNAL_BARO0_HEALTHY,
+    JOURNAL_BARO1_HEALTHY,
+    JOURNAL_APOGEE_VALID,
+    JOURNAL_NAV_ORIGIN,
+    JOURNAL_EVENT_COUNT,
+};
+
+struct journal_event {
+    int64_t timestamp; // Uptime in milliseconds when the event was recorded
+    uint32_t seq;      // 1 for the first event, counting up with no gaps
+    uint16_t id;       // enum journal_event_id
+    int32_t value;     // New value of the field
+};
+
+// Reader position in the journal, owned by one reader
+struct journal_cursor {
+    uint32_t next;    // Index of the next event to read (its seq - 1)
+    uint32_t dropped; // Events overwritten before this reader got to them
+};
+
+/**
+ * @brief Append an event. Never blocks and never logs.
+ */
+void journal_record(enum journal_event_id id, int32_t value);
+
+/**
+ * @brief Point a cursor at the next event to be recorded.
+ */
+void journal_cursor_init(struct journal_cursor *cursor);
+
+/**
+ * @brief Copy up to max events from the cursor on, oldest first, and
+ * advance the cursor past them. Stops early at an event that is still
+ * being written.
+ * @return number of events written to dst
+ */
+size_t journal_read(struct journal_cursor *cursor, struct journal_event *dst, size_t max);
+
+/**
+ * @brief Human-readable name of an event, e.g. "pyro.drogue_fired".
+ */
+const char *journal_event_name(enum journal_event_id id);
+
+/**
+ * @brief True for events that report a failure rather than progress.
+ */
+bool journal_event_is_error(enum journal_event_id id);
+
+void start_journal_thread(void);
+
+#endif
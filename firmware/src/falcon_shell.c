@@ -0,0 +1,297 @@
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include "data.h"
+#include "periodic_task.h"
+#include "radio/radio_thread.h"
+#include "sensors/sensor_bus.h"
+
+#ifdef CONFIG_FALCON_VIBRATION
+#include "vibration.h"
+#endif
+
+/**
+ * @brief Print release, overrun, jitter and execution time statistics for
+ * every periodic task.
+ */
+static int cmd_falcon_tasks(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-10s %10s %8s %10s %10s %10s %10s", "task", "releases", "overruns",
+                "jit_us", "jit_max_us", "exec_us", "wcet_us");
+
+    for (int i = 0; i < periodic_task_count(); i++) {
+        const char *name;
+        struct periodic_task_stats stats;
+
+        if (periodic_task_get(i, &name, &stats) < 0) {
+            continue;
+        }
+
+        shell_print(sh, "%-10s %10u %8u %10u %10u %10u %10u", name,
+                    (unsigned int)stats.releases, (unsigned int)stats.overruns,
+                    (unsigned int)stats.jitter_last_us, (unsigned int)stats.jitter_max_us,
+                    (unsigned int)stats.exec_last_us, (unsigned int)stats.wcet_us);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Print the latest health sample: CPU share and stack use per thread,
+ * and idle time.
+ */
+static int cmd_falcon_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    // Shell commands run one at a time; keep the sample off the shell stack
+    static struct health_data health;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    get_health_data(&health);
+    if (health.seq == 0) {
+        shell_warn(sh, "No health sample yet");
+        return 0;
+    }
+
+    shell_print(sh, "at %lld ms, idle %u.%u %%", health.timestamp,
+                health.idle_permille / 10, health.idle_permille % 10);
+    shell_print(sh, "%-16s %4s %7s %10s %10s %6s", "thread", "prio", "cpu_%", "stack",
+                "stack_used", "used_%");
+
+    for (int i = 0; i < health.thread_count; i++) {
+        const struct health_thread *t = &health.threads[i];
+        uint32_t used = t->stack_size - t->stack_unused;
+
+        shell_print(sh, "%-16s %4d %5u.%u %10u %10u %6u", t->name, t->priority,
+                    t->cpu_permille / 10, t->cpu_permille % 10, (unsigned int)t->stack_size,
+                    (unsigned int)used,
+                    t->stack_size ? (unsigned int)(used * 100 / t->stack_size) : 0);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Print utilization, transfer count and worst lock wait for each
+ * sensor bus.
+ */
+static int cmd_falcon_buses(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-20s %7s %10s %10s %10s %7s", "bus", "util_%", "busy_us", "transfers",
+                "wait_max_us", "devices");
+
+    for (int i = 0; i < sensor_bus_count(); i++) {
+        const char *name;
+        struct sensor_bus_stats stats;
+
+        if (sensor_bus_get(i, &name, &stats) < 0) {
+            continue;
+        }
+
+        shell_print(sh, "%-20s %5u.%u %10u %10u %10u %#7x", name,
+                    stats.utilization_permille / 10, stats.utilization_permille % 10,
+                    (unsigned int)stats.busy_us, (unsigned int)stats.transfers,
+                    (unsigned int)stats.wait_max_us, stats.devices);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Print the IMU calibration: gyro bias, accelerometer offset and
+ * correction matrix, and how much stationary data they came from.
+ */
+static int cmd_falcon_calib(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct imu_calib_data calib;
+
+    get_imu_calib_data(&calib);
+    if (calib.seq == 0) {
+        shell_warn(sh, "No stationary IMU data yet");
+        return 0;
+    }
+
+    const float *m = calib.accel_matrix;
+
+    shell_print(sh, "at %lld ms, %s, %u stationary windows, poses 0x%02x", calib.timestamp,
+                calib.valid ? "valid" : "not valid yet", (unsigned int)calib.windows,
+                calib.poses);
+    shell_print(sh, "gyro bias    %9.6f %9.6f %9.6f rad/s (noise %.6f)",
+                (double)calib.gyro_bias[0], (double)calib.gyro_bias[1],
+                (double)calib.gyro_bias[2], (double)calib.gyro_noise);
+    shell_print(sh, "accel offset %9.4f %9.4f %9.4f m/s2 (noise %.4f)",
+                (double)calib.accel_offset[0], (double)calib.accel_offset[1],
+                (double)calib.accel_offset[2], (double)calib.accel_noise);
+    for (int i = 0; i < 3; i++) {
+        shell_print(sh, "%s %9.5f %9.5f %9.5f", (i == 0) ? "accel matrix" : "            ",
+                    (double)m[i * 3], (double)m[i * 3 + 1], (double)m[i * 3 + 2]);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Print the samples the radio and the state machine missed or read
+ * twice (see data_seq_track()).
+ */
+static int cmd_falcon_loss(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct data_seq_stats radio_imu, radio_baro;
+    struct state_data state;
+
+    radio_get_seq_stats(&radio_imu, &radio_baro);
+    get_state_data(&state);
+
+    shell_print(sh, "%-10s %-5s %8s %9s", "consumer", "topic", "missed", "duplicate");
+    shell_print(sh, "%-10s %-5s %8u %9u", "radio", "imu", (unsigned int)radio_imu.missed,
+                (unsigned int)radio_imu.duplicate);
+    shell_print(sh, "%-10s %-5s %8u %9u", "radio", "baro", (unsigned int)radio_baro.missed,
+                (unsigned int)radio_baro.duplicate);
+    shell_print(sh, "%-10s %-5s %8u %9u", "state", "baro", (unsigned int)state.baro_missed,
+                (unsigned int)state.baro_duplicate);
+
+    return 0;
+}
+
+#ifdef CONFIG_FALCON_AHRS
+/**
+ * @brief Print the latest attitude estimate: quaternion, tilt from vertical,
+ * roll rate and the gyro bias the filter is still taking out.
+ */
+static int cmd_falcon_attitude(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct attitude_data att;
+
+    get_attitude_data(&att);
+    if (!att.aligned) {
+        shell_warn(sh, "Attitude not aligned yet");
+        return 0;
+    }
+
+    shell_print(sh, "at %lld ms, q = %.5f %.5f %.5f %.5f", att.timestamp, (double)att.q[0],
+                (double)att.q[1], (double)att.q[2], (double)att.q[3]);
+    shell_print(sh, "tilt %.2f deg, roll rate %.4f rad/s", (double)(att.tilt * 57.29578f),
+                (double)att.roll_rate);
+    shell_print(sh, "gyro bias %9.6f %9.6f %9.6f rad/s", (double)att.gyro_bias[0],
+                (double)att.gyro_bias[1], (double)att.gyro_bias[2]);
+
+    return 0;
+}
+#endif
+
+#ifdef CONFIG_FALCON_NAV
+/**
+ * @brief Print the latest navigation solution with its standard deviations,
+ * and how many GPS fixes were taken and rejected.
+ */
+static int cmd_falcon_nav(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct nav_data nav;
+
+    get_nav_data(&nav);
+    if (nav.seq == 0) {
+        shell_warn(sh, "Navigation not started: waiting for the ground altitude");
+        return 0;
+    }
+
+    shell_print(sh, "at %lld ms", nav.timestamp);
+    shell_print(sh, "position N %9.1f E %9.1f D %9.1f m (sd %.1f %.1f %.1f)",
+                (double)nav.position[0], (double)nav.position[1], (double)nav.position[2],
+                (double)sqrtf(nav.position_var[0]), (double)sqrtf(nav.position_var[1]),
+                (double)sqrtf(nav.position_var[2]));
+    shell_print(sh, "velocity N %9.2f E %9.2f D %9.2f m/s (sd %.2f %.2f %.2f)",
+                (double)nav.velocity[0], (double)nav.velocity[1], (double)nav.velocity[2],
+                (double)sqrtf(nav.velocity_var[0]), (double)sqrtf(nav.velocity_var[1]),
+                (double)sqrtf(nav.velocity_var[2]));
+    if (nav.origin_valid) {
+        shell_print(sh, "origin %.6f, %.6f, GPS fixes %u taken, %u rejected",
+                    (double)nav.origin_lat, (double)nav.origin_lon, nav.gps_fused,
+                    nav.gps_rejected);
+    } else {
+        shell_print(sh, "no GPS fix yet: north and east are relative to the start");
+    }
+
+    return 0;
+}
+#endif
+
+#ifdef CONFIG_FALCON_VIBRATION
+/**
+ * @brief Print the latest vibration spectrum: RMS per band, overall and of
+ * the strongest component, per IMU axis.
+ */
+static int cmd_falcon_vibration(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static const char *const axis_names[] = {"accel_x", "accel_y", "accel_z",
+                                             "gyro_x",  "gyro_y",  "gyro_z"};
+    struct vibration_data vib;
+
+    get_vibration_data(&vib);
+    if (vib.seq == 0) {
+        shell_warn(sh, "No vibration window analysed yet");
+        return 0;
+    }
+
+    shell_print(sh, "at %lld ms, %u points at %.1f Hz, analysed in %u us, %u windows dropped",
+                vib.timestamp, (unsigned int)vib.fft_size, (double)vib.sample_rate_hz,
+                (unsigned int)vib.analysis_us, (unsigned int)vib.windows_dropped);
+    shell_print(sh, "%-8s %9s %9s %9s   band RMS from %.0f/%.0f/%.0f/%.0f Hz", "axis", "rms",
+                "peak_hz", "peak_rms", (double)vibration_band_edges_hz[0],
+                (double)vibration_band_edges_hz[1], (double)vibration_band_edges_hz[2],
+                (double)vibration_band_edges_hz[3]);
+
+    for (int i = 0; i < ARRAY_SIZE(axis_names); i++) {
+        const struct vibration_axis *a = (i < 3) ? &vib.accel[i] : &vib.gyro[i - 3];
+
+        shell_print(sh, "%-8s %9.4f %9.1f %9.4f   %9.4f %9.4f %9.4f %9.4f", axis_names[i],
+                    (double)a->rms, (double)a->peak_hz, (double)a->peak_rms,
+                    (double)a->band_rms[0], (double)a->band_rms[1], (double)a->band_rms[2],
+                    (double)a->band_rms[3]);
+    }
+
+    return 0;
+}
+#endif
+
+SHELL_STATIC_SUBCMD_SET_CREATE(falcon_cmds,
+#ifdef CONFIG_FALCON_AHRS
+    SHELL_CMD(attitude, NULL, "Attitude estimate: tilt and roll rate", cmd_falcon_attitude),
+#endif
+    SHELL_CMD(buses, NULL, "Sensor bus utilization", cmd_falcon_buses),
+    SHELL_CMD(calib, NULL, "On-pad IMU calibration", cmd_falcon_calib),
+    SHELL_CMD(loss, NULL, "Samples the radio and state machine missed or read twice",
+              cmd_falcon_loss),
+#ifdef CONFIG_FALCON_NAV
+    SHELL_CMD(nav, NULL, "Navigation solution: position and velocity", cmd_falcon_nav),
+#endif
+    SHELL_CMD(stats, NULL, "Per-thread CPU and stack use, idle time", cmd_falcon_stats),
+    SHELL_CMD(tasks, NULL, "Periodic task timing statistics", cmd_falcon_tasks),
+#ifdef CONFIG_FALCON_VIBRATION
+    SHELL_CMD(vibration, NULL, "IMU vibration spectrum per axis", cmd_falcon_vibration),
+#endif
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(falcon, &falcon_cmds, "FALCON flight software commands", NULL);
@@ -3,6 +3,7 @@
 #include <lwgps/lwgps.h>
 #include <string.h>
 #include "data.h"
+#include "periodic_task.h"
 #include "../radio/gnss_spi.h"
 
 LOG_MODULE_REGISTER(gps_thread, LOG_LEVEL_INF);
@@ -15,6 +16,7 @@ LOG_MODULE_REGISTER(gps_thread, LOG_LEVEL_INF);
 
 K_THREAD_STACK_DEFINE(gps_stack, GPS_THREAD_STACK_SIZE);
 static struct k_thread gps_thread;
+static struct periodic_task gps_task;
 
 static lwgps_t gps;
 
@@ -28,13 +30,16 @@ static void gps_thread_fn(void *p1, void *p2, void *p3)
 
 	lwgps_init(&gps);
 
+	periodic_task_init(&gps_task, "gps", GPS_THREAD_PERIOD_MS);
+
 	while (1) {
+		periodic_task_wait(&gps_task);
+
 		uint8_t payload[GPS_PAYLOAD_SIZE];
 
 		int ret = gnss_spi_gps_read(payload);
 		if (ret < 0) {
 			LOG_ERR("GPS SPI read failed: %d", ret);
-			k_sleep(K_MSEC(GPS_THREAD_PERIOD_MS));
 			continue;
 		}
 
@@ -48,7 +53,6 @@ static void gps_thread_fn(void *p1, void *p2, void *p3)
 		}
 		if (payload_empty) {
 			LOG_WRN("GPS SPI payload is empty (all zeros)");
-			k_sleep(K_MSEC(GPS_THREAD_PERIOD_MS));
 			continue;
 		}
 
@@ -59,12 +63,12 @@ static void gps_thread_fn(void *p1, void *p2, void *p3)
 		size_t len = strlen(nmea);
 
 		if (len == 0 || nmea[0] != '$') {
-			k_sleep(K_MSEC(GPS_THREAD_PERIOD_MS));
 			continue;
 		}
 
 		lwgps_process(&gps, nmea, len);
 
+		int64_t now_us = data_timestamp_us();
 		struct gps_data gps_out = {
 			.latitude = gps.latitude,
 			.longitude = gps.longitude,
@@ -72,7 +76,8 @@ static void gps_thread_fn(void *p1, void *p2, void *p3)
 			.speed = gps.speed,
 			.sats = gps.sats_in_use,
 			.fix = gps.fix,
-			.timestamp = k_uptime_get(),
+			.timestamp = now_us / USEC_PER_MSEC,
+			.timestamp_us = now_us,
 		};
 		set_gps_data(&gps_out);
 
@@ -82,8 +87,6 @@ static void gps_thread_fn(void *p1, void *p2, void *p3)
 			(double)gps.latitude, (double)gps.longitude,
 			(double)gps.altitude, gps.sats_in_use, gps.fix,
 			(double)gps.speed);
-
-		k_sleep(K_MSEC(GPS_THREAD_PERIOD_MS));
 	}
 }
 
@@ -91,4 +94,5 @@ void start_gps_thread(void)
 {
 	k_thread_create(&gps_thread, gps_stack, K_THREAD_STACK_SIZEOF(gps_stack),
 			gps_thread_fn, NULL, NULL, NULL, GPS_THREAD_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&gps_thread, "gps");
 }
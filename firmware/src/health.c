@@ -0,0 +1,158 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <stdio.h>
+#include <string.h>
+#include "data.h"
+#include "health.h"
+#include "periodic_task.h"
+
+LOG_MODULE_REGISTER(health, LOG_LEVEL_INF);
+
+#define HEALTH_THREAD_STACK_SIZE 2048
+#define HEALTH_THREAD_PRIORITY 10
+#define HEALTH_THREAD_PERIOD_MS 1000
+
+K_THREAD_STACK_DEFINE(health_stack, HEALTH_THREAD_STACK_SIZE);
+static struct k_thread health_thread;
+static struct periodic_task health_task;
+
+// Execution cycles of each thread at the previous sample, to turn totals into rates
+struct thread_usage {
+    const struct k_thread *thread;
+    uint64_t cycles;
+};
+
+struct health_sampler {
+    struct health_data *out;
+    const struct k_thread *threads[HEALTH_MAX_THREADS]; // Listed by collect_thread()
+    int thread_count;
+    struct thread_usage prev[HEALTH_MAX_THREADS];
+    struct thread_usage now[HEALTH_MAX_THREADS];
+    uint64_t window_cycles;
+    int skipped;
+};
+
+static struct health_sampler sampler;
+
+static uint64_t previous_cycles(const struct health_sampler *hs, const struct k_thread *thread)
+{
+    for (int i = 0; i < HEALTH_MAX_THREADS; i++) {
+        if (hs->prev[i].thread == thread) {
+            return hs->prev[i].cycles;
+        }
+    }
+
+    // New thread: it has run for at most this window
+    return 0;
+}
+
+static uint16_t permille(uint64_t part, uint64_t whole)
+{
+    return whole ? (uint16_t)MIN(part * 1000 / whole, 1000) : 0;
+}
+
+static void collect_thread(const struct k_thread *thread, void *user_data)
+{
+    struct health_sampler *hs = user_data;
+
+    if (hs->thread_count >= HEALTH_MAX_THREADS) {
+        hs->skipped++;
+        return;
+    }
+
+    hs->threads[hs->thread_count++] = thread;
+}
+
+static void sample_thread(struct health_sampler *hs, const struct k_thread *thread)
+{
+    struct health_data *out = hs->out;
+    k_tid_t tid = (k_tid_t)thread;
+    struct health_thread *entry = &out->threads[out->thread_count];
+    k_thread_runtime_stats_t stats;
+    const char *name = k_thread_name_get(tid);
+    size_t unused = 0;
+
+    if (name && name[0] != '\0') {
+        strncpy(entry->name, name, sizeof(entry->name) - 1);
+        entry->name[sizeof(entry->name) - 1] = '\0';
+    } else {
+        snprintf(entry->name, sizeof(entry->name), "%p", (void *)thread);
+    }
+
+    entry->priority = (int8_t)k_thread_priority_get(tid);
+    entry->stack_size = thread->stack_info.size;
+    entry->stack_unused = (k_thread_stack_space_get(thread, &unused) == 0) ? unused : 0;
+
+    k_thread_runtime_stats_get(tid, &stats);
+    entry->cpu_permille = permille(stats.execution_cycles - previous_cycles(hs, thread),
+                                   hs->window_cycles);
+
+    hs->now[out->thread_count].thread = thread;
+    hs->now[out->thread_count].cycles = stats.execution_cycles;
+    out->thread_count++;
+}
+
+/**
+ * @brief Sample every thread and the idle time since the previous call.
+ */
+static void health_sample(struct health_data *out, uint64_t *last_total, uint64_t *last_idle)
+{
+    k_thread_runtime_stats_t all;
+
+    k_thread_runtime_stats_all_get(&all);
+
+    memset(out, 0, sizeof(*out));
+    sampler.out = out;
+    sampler.window_cycles = all.execution_cycles - *last_total;
+    sampler.thread_count = 0;
+    sampler.skipped = 0;
+    memset(sampler.now, 0, sizeof(sampler.now));
+
+    /* Threads do exit (main, and any thread whose device fails its init), so
+     * the list is walked locked, but only to copy it. Scanning stacks for
+     * their high-water mark takes a while and must not hold off the flight
+     * threads, so that runs unlocked. A thread that exits in between is
+     * still safe to sample: thread structs and stacks are static. */
+    k_thread_foreach(collect_thread, &sampler);
+
+    for (int i = 0; i < sampler.thread_count; i++) {
+        sample_thread(&sampler, sampler.threads[i]);
+    }
+
+    memcpy(sampler.prev, sampler.now, sizeof(sampler.prev));
+
+    out->idle_permille = permille(all.idle_cycles - *last_idle, sampler.window_cycles);
+    out->timestamp_us = data_timestamp_us();
+    out->timestamp = out->timestamp_us / USEC_PER_MSEC;
+
+    *last_total = all.execution_cycles;
+    *last_idle = all.idle_cycles;
+
+    if (sampler.skipped > 0) {
+        LOG_WRN("%d threads not reported (HEALTH_MAX_THREADS is %d)", sampler.skipped,
+                HEALTH_MAX_THREADS);
+    }
+}
+
+static void health_thread_fn(void *p1, void *p2, void *p3)
+{
+    static struct health_data health;
+    uint64_t last_total = 0;
+    uint64_t last_idle = 0;
+
+    periodic_task_init(&health_task, "health", HEALTH_THREAD_PERIOD_MS);
+
+    while (1) {
+        periodic_task_wait(&health_task);
+
+        health_sample(&health, &last_total, &last_idle);
+        set_health_data(&health);
+    }
+}
+
+void start_health_thread(void)
+{
+    k_thread_create(&health_thread, health_stack, K_THREAD_STACK_SIZEOF(health_stack),
+                    health_thread_fn, NULL, NULL, NULL, HEALTH_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&health_thread, "health");
+}
@@ -0,0 +1,15 @@
+#ifndef HEALTH_H
+#define HEALTH_H
+
+/*
+ * System health: once per period the health thread samples every thread's
+ * runtime (Zephyr thread runtime stats), stack high-water mark and the idle
+ * share of the CPU, and publishes them as the health topic.
+ */
+
+/**
+ * @brief Start the health sampling thread.
+ */
+void start_health_thread(void);
+
+#endif
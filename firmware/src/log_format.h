@@ -2,16 +2,28 @@
 #define LOG_FORMAT_H
 
 #include "data.h"
+#include "deploy_latency.h"
 #include <stdint.h>
 
 struct log_frame {
     int64_t log_timestamp;
 
-    struct imu_data imu;
-    struct baro_data baro;
-    struct state_data state;
-    struct pyro_data pyro;
-    struct gps_data gps;
+    // All topics from one epoch; data.generation identifies it
+    struct data_snapshot data;
+
+    // Logger's own missed/duplicate counts, indexed by enum data_topic
+    struct data_seq_stats seq[DATA_TOPIC_COUNT];
+
+    // Radio's missed/duplicate counts for the IMU and baro topics
+    struct data_seq_stats radio_imu;
+    struct data_seq_stats radio_baro;
+
+    // Samples the logger's history readers lost, indexed by enum data_topic
+    uint32_t dropped[DATA_TOPIC_COUNT];
+
+    // Baro sample -> decision / pyro SPI latency, and cyclic executive overruns
+    struct deploy_latency_stat latency[DEPLOY_LATENCY_STAGE_COUNT];
+    uint32_t cyclic_overruns;
 };
 
 #endif
@@ -5,7 +5,17 @@
 #include <stdio.h>
 #include <string.h>
 #include "data.h"
+#include "cyclic_executive.h"
+#include "deploy_latency.h"
+#include "event_journal.h"
 #include "log_format.h"
+#include "periodic_task.h"
+#include "radio/radio_thread.h"
+#include "sensors/sensor_bus.h"
+
+#ifdef CONFIG_FALCON_VIBRATION
+#include "vibration.h"
+#endif
 
 #ifndef CONFIG_BOARD_NATIVE_SIM
 #include <zephyr/storage/disk_access.h>
@@ -15,10 +25,11 @@
 
 LOG_MODULE_REGISTER(logger_thread, LOG_LEVEL_INF);
 
-#define LOGGER_THREAD_STACK_SIZE 2048
+#define LOGGER_THREAD_STACK_SIZE 3584
 #define LOGGER_THREAD_PRIORITY 7
 #define LOGGER_THREAD_PERIOD_MS 50
 #define LOGGER_SYNC_PERIOD_MS 500
+#define LOGGER_JOURNAL_BATCH 8
 
 #ifdef CONFIG_BOARD_NATIVE_SIM
 // Use standard POSIX file I/O for native_sim
@@ -45,9 +56,69 @@ static struct fs_file_t log_file;
 
 K_THREAD_STACK_DEFINE(logger_stack, LOGGER_THREAD_STACK_SIZE);
 static struct k_thread logger_thread;
+static struct periodic_task logger_task;
 
 static char log_file_name[128];
 
+#define LOG_FILE_PREFIX "log_"
+#define EVENT_CSV_HEADER "Timestamp(ms),Seq,Event,Value\n"
+#define TASK_CSV_HEADER \
+    "Timestamp(ms),Task,Releases,Overruns,Jitter_Last(us),Jitter_Max(us),Exec_Last(us),WCET(us)\n"
+#define BUS_CSV_HEADER \
+    "Timestamp(ms),Bus,Devices,Transfers,Busy(us),Utilization(permille),Wait_Max(us)\n"
+#define LATENCY_CSV_HEADER "Timestamp(ms),Stage,Count,Last(us),Mean(us),Max(us)"
+#define HEALTH_CSV_HEADER \
+    "Timestamp(ms),Seq,Idle(permille),Thread,Priority,CPU(permille),Stack_Size,Stack_Unused\n"
+#define IMU_CSV_HEADER \
+    "Timestamp(us),Seq,Accel_X(m/s2),Accel_Y(m/s2),Accel_Z(m/s2),Gyro_X(rad/s),Gyro_Y(rad/s)," \
+    "Gyro_Z(rad/s)\n"
+#define ATTITUDE_CSV_HEADER \
+    "Timestamp(us),Seq,Aligned,Q_W,Q_X,Q_Y,Q_Z,Tilt(rad),Roll_Rate(rad/s),Gyro_Bias_X(rad/s)," \
+    "Gyro_Bias_Y(rad/s),Gyro_Bias_Z(rad/s)\n"
+#define NAV_CSV_HEADER \
+    "Timestamp(us),Seq,North(m),East(m),Down(m),Vel_N(m/s),Vel_E(m/s),Vel_D(m/s),Var_N(m2)," \
+    "Var_E(m2),Var_D(m2),Var_Vel_N(m2/s2),Var_Vel_E(m2/s2),Var_Vel_D(m2/s2),Accel_Bias(m/s2)," \
+    "Origin_Valid,Origin_Lat,Origin_Lon,GPS_Fused,GPS_Rejected\n"
+#define CALIB_CSV_HEADER                                                                           \
+    "Timestamp(ms),Seq,Valid,Windows,Poses,Gyro_Bias_X(rad/s),Gyro_Bias_Y(rad/s),"              \
+    "Gyro_Bias_Z(rad/s),Accel_Offset_X(m/s2),Accel_Offset_Y(m/s2),Accel_Offset_Z(m/s2),"         \
+    "M00,M01,M02,M10,M11,M12,M20,M21,M22,Gyro_Noise(rad/s),Accel_Noise(m/s2)\n"
+// RMS values are in m/s2 for accel axes and rad/s for gyro axes
+#define VIBRATION_CSV_HEADER "Timestamp(ms),Seq,Axis,RMS,Peak(Hz),Peak_RMS"
+#define VIBRATION_CSV_TRAILER ",Sample_Rate(Hz),FFT_Size,Analysis(us),Windows_Dropped\n"
+
+// A CSV written next to log_<n>.csv as <prefix><n>.csv
+struct csv_file {
+    const char *prefix;
+    char name[128];
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    FILE *fp;
+#else
+    struct fs_file_t file;
+#endif
+};
+
+// Journal events, periodic task timing, sensor bus use, deployment latency histograms,
+// thread health, IMU calibration, every IMU sample at full rate and filtered, the attitude
+// estimate from each of them, the navigation solution, vibration spectra
+static struct csv_file event_csv = {.prefix = "events_"};
+static struct csv_file task_csv = {.prefix = "tasks_"};
+static struct csv_file bus_csv = {.prefix = "buses_"};
+static struct csv_file latency_csv = {.prefix = "latency_"};
+static struct csv_file health_csv = {.prefix = "health_"};
+static struct csv_file calib_csv = {.prefix = "calib_"};
+static struct csv_file imu_csv = {.prefix = "imu_"};
+static struct csv_file imu_filtered_csv = {.prefix = "imu_filtered_"};
+#ifdef CONFIG_FALCON_AHRS
+static struct csv_file attitude_csv = {.prefix = "attitude_"};
+#endif
+#ifdef CONFIG_FALCON_NAV
+static struct csv_file nav_csv = {.prefix = "nav_"};
+#endif
+#ifdef CONFIG_FALCON_VIBRATION
+static struct csv_file vibration_csv = {.prefix = "vibration_"};
+#endif
+
 static int mount_filesystem(void)
 {
 #ifdef CONFIG_BOARD_NATIVE_SIM
@@ -81,22 +152,37 @@ static int mount_filesystem(void)
 
 static int write_csv_header(void)
 {
-    const char *header = "Log_Timestamp(ms),"
-                         "IMU_Timestamp(ms),Accel_X(m/s^2),Accel_Y(m/s^2),Accel_Z(m/s^2),"
+    const char *header = "Log_Timestamp(ms),Generation,"
+                         "IMU_Timestamp(ms),IMU_Timestamp(us),IMU_Seq,Accel_X(m/s^2),Accel_Y(m/s^2),Accel_Z(m/s^2),"
                          "Gyro_X(rad/s),Gyro_Y(rad/s),Gyro_Z(rad/s),"
-                         "Baro_Timestamp(ms),"
+                         "Baro_Timestamp(ms),Baro_Timestamp(us),Baro_Seq,"
                          "Baro0_Pressure(Pa),Baro0_Temperature(C),Baro0_Altitude(m),Baro0_NIS,"
-                         "Baro0_Faults,Baro0_Healthy,"
+                         "Baro0_Faults,Baro0_Healthy,Baro0_Fused,Baro0_Rejected,"
                          "Baro1_Pressure(Pa),Baro1_Temperature(C),Baro1_Altitude(m),Baro1_NIS,"
-                         "Baro1_Faults,Baro1_Healthy,"
+                         "Baro1_Faults,Baro1_Healthy,Baro1_Fused,Baro1_Rejected,"
                          "KF_Altitude(m),KF_Altitude_AGL(m),KF_AltVar,KF_Velocity(m/s),KF_VelVar,"
-                         "State,State_Ground_Altitude(m),State_Timestamp(ms),"
-                         "Pyro_Status,Pyro_Timestamp(ms),"
+                         "KF_Accel_Bias(m/s^2),"
+                         "State,State_Ground_Altitude(m),State_Timestamp(ms),State_Timestamp(us),State_Seq,"
+                         "Apogee_Valid,Apogee_Time(s),Apogee_Altitude_AGL(m),Apogee_Drag(1/m),"
+                         "Apogee_Residual(m/s),"
+                         "Pyro_Status,Pyro_Timestamp(ms),Pyro_Timestamp(us),Pyro_Seq,"
                          "Drogue_Fired,Main_Fired,Drogue_Fail,Main_Fail,"
                          "Drogue_Cont_OK,Main_Cont_OK,Drogue_Fire_ACK,Main_Fire_ACK,"
                          "Drogue_Fire_Requested,Main_Fire_Requested,"
-                         "GPS_Timestamp(ms),GPS_Lat(deg),GPS_Lon(deg),"
-                         "GPS_Alt(m),GPS_Speed(kn),GPS_Sats,GPS_Fix\n";
+                         "GPS_Timestamp(ms),GPS_Timestamp(us),GPS_Seq,GPS_Lat(deg),GPS_Lon(deg),"
+                         "GPS_Alt(m),GPS_Speed(kn),GPS_Sats,GPS_Fix,"
+                         "Log_IMU_Missed,Log_IMU_Dup,Log_Baro_Missed,Log_Baro_Dup,"
+                         "Log_State_Missed,Log_State_Dup,Log_Pyro_Missed,Log_Pyro_Dup,"
+                         "Log_GPS_Missed,Log_GPS_Dup,SM_Baro_Missed,SM_Baro_Dup,"
+                         "Radio_IMU_Missed,Radio_IMU_Dup,Radio_Baro_Missed,Radio_Baro_Dup,"
+                         "Log_IMU_Dropped,Log_IMU_Filtered_Dropped,Log_Attitude_Dropped,"
+                         "Log_Nav_Dropped,Log_Health_Dropped,Log_Calib_Dropped,"
+                         "Log_Vibration_Dropped,"
+                         "Lat_Decision_Last(us),Lat_Decision_Mean(us),Lat_Decision_Max(us),"
+                         "Lat_Pyro_SPI_Count,Lat_Pyro_SPI_Last(us),Lat_Pyro_SPI_Max(us),"
+                         "Lat_Fire_Last(us),Lat_Enqueue_Last(us),"
+                         "Lat_ACK_Count,Lat_ACK_Last(us),Lat_ACK_Max(us),"
+                         "Cyclic_Overruns\n";
     #ifdef CONFIG_BOARD_NATIVE_SIM
     size_t written = fwrite(header, 1, strlen(header), log_file_ptr);
     if (written != strlen(header)) {
@@ -121,6 +207,66 @@ static int write_csv_header(void)
 #endif
 }
 
+/**
+ * @brief Create a companion CSV for log number file_count and write its header.
+ */
+static int csv_open(struct csv_file *csv, int file_count, const char *header)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    snprintf(csv->name, sizeof(csv->name), "%s/%s%d.csv", MOUNT_POINT, csv->prefix, file_count);
+
+    csv->fp = fopen(csv->name, "w");
+    if (!csv->fp) {
+        LOG_ERR("Failed to open %s", csv->name);
+        return -1;
+    }
+    fputs(header, csv->fp);
+    return 0;
+#else
+    snprintf(csv->name, sizeof(csv->name), MOUNT_POINT "/%s%d.csv", csv->prefix, file_count);
+
+    fs_file_t_init(&csv->file);
+    int ret = fs_open(&csv->file, csv->name, FS_O_CREATE | FS_O_APPEND | FS_O_WRITE);
+    if (ret < 0) {
+        LOG_ERR("Failed to open %s: %d", csv->name, ret);
+        return ret;
+    }
+
+    ret = fs_write(&csv->file, header, strlen(header));
+    if (ret < 0) {
+        LOG_ERR("Failed to write header to %s: %d", csv->name, ret);
+        return ret;
+    }
+    return 0;
+#endif
+}
+
+static void csv_write(struct csv_file *csv, const char *line, int len)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    if (fwrite(line, 1, len, csv->fp) != (size_t)len) {
+        LOG_ERR("Failed to write to %s", csv->name);
+    }
+#else
+    int ret = fs_write(&csv->file, line, len);
+    if (ret < 0) {
+        LOG_ERR("Failed to write to %s: %d", csv->name, ret);
+    }
+#endif
+}
+
+static void csv_sync(struct csv_file *csv)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    fflush(csv->fp);
+#else
+    int ret = fs_sync(&csv->file);
+    if (ret < 0) {
+        LOG_ERR("Failed to sync %s: %d", csv->name, ret);
+    }
+#endif
+}
+
 static int create_new_log_file(void)
 {
     int file_count = 0;
@@ -138,9 +284,10 @@ static int create_new_log_file(void)
                 continue;
             }
 
-            // Build full path and check if it's a regular file
+            // Build full path and check if it's a regular log file
             snprintf(filepath, sizeof(filepath), "%s/%s", MOUNT_POINT, entry->d_name);
-            if (stat(filepath, &st) == 0 && S_ISREG(st.st_mode)) {
+            if (stat(filepath, &st) == 0 && S_ISREG(st.st_mode) &&
+                strncmp(entry->d_name, LOG_FILE_PREFIX, strlen(LOG_FILE_PREFIX)) == 0) {
                 file_count++;
             }
         }
@@ -169,7 +316,8 @@ static int create_new_log_file(void)
     }
 
     while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != '\0') {
-        if (entry.type == FS_DIR_ENTRY_FILE) {
+        if (entry.type == FS_DIR_ENTRY_FILE &&
+            strncmp(entry.name, LOG_FILE_PREFIX, strlen(LOG_FILE_PREFIX)) == 0) {
             file_count++;
         }
     }
@@ -187,6 +335,58 @@ static int create_new_log_file(void)
     LOG_INF("Log file created: %s", log_file_name);
 #endif
 
+    char latency_header[320];
+    int len = snprintf(latency_header, sizeof(latency_header), "%s", LATENCY_CSV_HEADER);
+
+    for (int i = 0; i < DEPLOY_LATENCY_BUCKETS; i++) {
+        len += snprintf(latency_header + len, sizeof(latency_header) - len, ",Bucket_%u(us)",
+                        (unsigned int)deploy_latency_bucket_floor_us(i));
+    }
+    snprintf(latency_header + len, sizeof(latency_header) - len, "\n");
+
+#ifdef CONFIG_FALCON_VIBRATION
+    char vibration_header[256];
+
+    len = snprintf(vibration_header, sizeof(vibration_header), "%s", VIBRATION_CSV_HEADER);
+    for (int i = 0; i < VIBRATION_BANDS; i++) {
+        // The last band is open, it runs to the Nyquist frequency
+        if (i == VIBRATION_BANDS - 1) {
+            len += snprintf(vibration_header + len, sizeof(vibration_header) - len,
+                            ",Band_%u+Hz", (unsigned int)vibration_band_edges_hz[i]);
+        } else {
+            len += snprintf(vibration_header + len, sizeof(vibration_header) - len,
+                            ",Band_%u_%uHz", (unsigned int)vibration_band_edges_hz[i],
+                            (unsigned int)vibration_band_edges_hz[i + 1]);
+        }
+    }
+    snprintf(vibration_header + len, sizeof(vibration_header) - len, VIBRATION_CSV_TRAILER);
+
+    if (csv_open(&vibration_csv, file_count, vibration_header) < 0) {
+        return -1;
+    }
+#endif
+
+    if (csv_open(&event_csv, file_count, EVENT_CSV_HEADER) < 0 ||
+        csv_open(&task_csv, file_count, TASK_CSV_HEADER) < 0 ||
+        csv_open(&bus_csv, file_count, BUS_CSV_HEADER) < 0 ||
+        csv_open(&latency_csv, file_count, latency_header) < 0 ||
+        csv_open(&health_csv, file_count, HEALTH_CSV_HEADER) < 0 ||
+        csv_open(&calib_csv, file_count, CALIB_CSV_HEADER) < 0 ||
+        csv_open(&imu_csv, file_count, IMU_CSV_HEADER) < 0 ||
+        csv_open(&imu_filtered_csv, file_count, IMU_CSV_HEADER) < 0) {
+        return -1;
+    }
+#ifdef CONFIG_FALCON_AHRS
+    if (csv_open(&attitude_csv, file_count, ATTITUDE_CSV_HEADER) < 0) {
+        return -1;
+    }
+#endif
+#ifdef CONFIG_FALCON_NAV
+    if (csv_open(&nav_csv, file_count, NAV_CSV_HEADER) < 0) {
+        return -1;
+    }
+#endif
+
     return write_csv_header();
 }
 
@@ -194,43 +394,96 @@ static int format_log_entry(const struct log_frame *frame, char *buffer, size_t
 {
     return snprintf(
         buffer, buffer_size,
-        "%lld,%lld,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%lld," // Log_Timestamp, IMU_Timestamp, Accel_X/Y/Z, Gyro_X/Y/Z, Baro_Timestamp
-        "%.3f,%.3f,%.3f,%.3f,%u,%d," // Baro0_Pressure, Baro0_Temperature, Baro0_Altitude, Baro0_NIS, Baro0_Faults, Baro0_Healthy
-        "%.3f,%.3f,%.3f,%.3f,%u,%d," // Baro1_Pressure, Baro1_Temperature, Baro1_Altitude, Baro1_NIS, Baro1_Faults, Baro1_Healthy
-        "%.3f,%.3f,%.3f,%.3f,%.3f,%d,%.3f,%lld," // KF_Altitude, KF_Altitude_AGL, KF_AltVar, KF_Velocity, KF_VelVar, State, State_Ground_Altitude, State_Timestamp
-        "%u,%lld,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d," // Pyro_Status, Pyro_Timestamp, Drogue_Fired, Main_Fired, Drogue_Fail, Main_Fail, Drogue_Cont_OK, Main_Cont_OK, Drogue_Fire_ACK, Main_Fire_ACK, Drogue_Fire_Requested, Main_Fire_Requested
-        "%lld,%.6f,%.6f,%.1f,%.1f,%u,%u\n", // GPS_Timestamp, GPS_Lat, GPS_Lon, GPS_Alt, GPS_Speed, GPS_Sats, GPS_Fix
+        "%lld,%u,%lld,%lld,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%lld,%lld,%u," // Log_Timestamp, Generation, IMU_Timestamp(ms/us), IMU_Seq, Accel_X/Y/Z, Gyro_X/Y/Z, Baro_Timestamp(ms/us), Baro_Seq
+        "%.3f,%.3f,%.3f,%.3f,%u,%d,%d,%u," // Baro0_Pressure, Baro0_Temperature, Baro0_Altitude, Baro0_NIS, Baro0_Faults, Baro0_Healthy, Baro0_Fused, Baro0_Rejected
+        "%.3f,%.3f,%.3f,%.3f,%u,%d,%d,%u," // Baro1_Pressure, Baro1_Temperature, Baro1_Altitude, Baro1_NIS, Baro1_Faults, Baro1_Healthy, Baro1_Fused, Baro1_Rejected
+        "%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%d,%.3f,%lld,%lld,%u," // KF_Altitude, KF_Altitude_AGL, KF_AltVar, KF_Velocity, KF_VelVar, KF_Accel_Bias, State, State_Ground_Altitude, State_Timestamp(ms/us), State_Seq
+        "%d,%.3f,%.3f,%.6f,%.3f," // Apogee_Valid, Apogee_Time, Apogee_Altitude_AGL, Apogee_Drag, Apogee_Residual
+        "%u,%lld,%lld,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d," // Pyro_Status, Pyro_Timestamp(ms/us), Pyro_Seq, Drogue_Fired, Main_Fired, Drogue_Fail, Main_Fail, Drogue_Cont_OK, Main_Cont_OK, Drogue_Fire_ACK, Main_Fire_ACK, Drogue_Fire_Requested, Main_Fire_Requested
+        "%lld,%lld,%u,%.6f,%.6f,%.1f,%.1f,%u,%u," // GPS_Timestamp(ms/us), GPS_Seq, GPS_Lat, GPS_Lon, GPS_Alt, GPS_Speed, GPS_Sats, GPS_Fix
+        "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u," // Log_<Topic>_Missed/Dup for IMU, Baro, State, Pyro, GPS, then SM_Baro_Missed/Dup
+        "%u,%u,%u,%u," // Radio_IMU_Missed/Dup, Radio_Baro_Missed/Dup
+        "%u,%u,%u,%u,%u,%u,%u," // Log_<Topic>_Dropped for IMU, IMU_Filtered, Attitude, Nav, Health, Calib, Vibration
+        "%u,%u,%u,%u,%u,%u," // Lat_Decision_Last/Mean/Max, Lat_Pyro_SPI_Count/Last/Max
+        "%u,%u,%u,%u,%u,%u\n", // Lat_Fire_Last, Lat_Enqueue_Last, Lat_ACK_Count/Last/Max, Cyclic_Overruns
         frame->log_timestamp,
-        frame->imu.timestamp,
-        (double)frame->imu.accel[0], (double)frame->imu.accel[1], (double)frame->imu.accel[2],
-        (double)frame->imu.gyro[0], (double)frame->imu.gyro[1], (double)frame->imu.gyro[2],
-        frame->baro.timestamp,
-        (double)frame->baro.baro0.pressure, (double)frame->baro.baro0.temperature,
-        (double)frame->baro.baro0.altitude, (double)frame->baro.baro0.nis,
-        (unsigned int)frame->baro.baro0.faults, frame->baro.baro0.healthy ? 1 : 0,
-        (double)frame->baro.baro1.pressure, (double)frame->baro.baro1.temperature,
-        (double)frame->baro.baro1.altitude, (double)frame->baro.baro1.nis,
-        (unsigned int)frame->baro.baro1.faults, frame->baro.baro1.healthy ? 1 : 0,
-        (double)frame->baro.altitude, (double)frame->baro.altitude_agl,
-        (double)frame->baro.alt_variance,
-        (double)frame->baro.velocity, (double)frame->baro.vel_variance, (int)frame->state.state,
-        (double)frame->state.ground_altitude, frame->state.timestamp,
-        (unsigned int)frame->pyro.status_byte, frame->pyro.timestamp,
-        frame->pyro.drogue_fired ? 1 : 0, frame->pyro.main_fired ? 1 : 0,
-        frame->pyro.drogue_fail ? 1 : 0, frame->pyro.main_fail ? 1 : 0,
-        frame->pyro.drogue_cont_ok ? 1 : 0, frame->pyro.main_cont_ok ? 1 : 0,
-        frame->pyro.drogue_fire_ack ? 1 : 0, frame->pyro.main_fire_ack ? 1 : 0,
-        frame->pyro.drogue_fire_requested ? 1 : 0, frame->pyro.main_fire_requested ? 1 : 0,
-        frame->gps.timestamp,
-        (double)frame->gps.latitude, (double)frame->gps.longitude,
-        (double)frame->gps.altitude, (double)frame->gps.speed,
-        (unsigned int)frame->gps.sats, (unsigned int)frame->gps.fix
+        (unsigned int)frame->data.generation,
+        frame->data.imu.timestamp, frame->data.imu.timestamp_us, (unsigned int)frame->data.imu.seq,
+        (double)frame->data.imu.accel[0], (double)frame->data.imu.accel[1], (double)frame->data.imu.accel[2],
+        (double)frame->data.imu.gyro[0], (double)frame->data.imu.gyro[1], (double)frame->data.imu.gyro[2],
+        frame->data.baro.timestamp, frame->data.baro.timestamp_us, (unsigned int)frame->data.baro.seq,
+        (double)frame->data.baro.baro0.pressure, (double)frame->data.baro.baro0.temperature,
+        (double)frame->data.baro.baro0.altitude, (double)frame->data.baro.baro0.nis,
+        (unsigned int)frame->data.baro.baro0.faults, frame->data.baro.baro0.healthy ? 1 : 0,
+        frame->data.baro.baro0.fused ? 1 : 0, (unsigned int)frame->data.baro.baro0.rejected,
+        (double)frame->data.baro.baro1.pressure, (double)frame->data.baro.baro1.temperature,
+        (double)frame->data.baro.baro1.altitude, (double)frame->data.baro.baro1.nis,
+        (unsigned int)frame->data.baro.baro1.faults, frame->data.baro.baro1.healthy ? 1 : 0,
+        frame->data.baro.baro1.fused ? 1 : 0, (unsigned int)frame->data.baro.baro1.rejected,
+        (double)frame->data.baro.altitude, (double)frame->data.baro.altitude_agl,
+        (double)frame->data.baro.alt_variance,
+        (double)frame->data.baro.velocity, (double)frame->data.baro.vel_variance,
+        (double)frame->data.baro.accel_bias, (int)frame->data.state.state,
+        (double)frame->data.state.ground_altitude, frame->data.state.timestamp,
+        frame->data.state.timestamp_us,
+        (unsigned int)frame->data.state.seq,
+        frame->data.apogee.valid ? 1 : 0, (double)frame->data.apogee.time_to_apogee,
+        (double)frame->data.apogee.apogee_agl, (double)frame->data.apogee.drag,
+        (double)frame->data.apogee.residual,
+        (unsigned int)frame->data.pyro.status_byte, frame->data.pyro.timestamp,
+        frame->data.pyro.timestamp_us,
+        (unsigned int)frame->data.pyro.seq,
+        frame->data.pyro.drogue_fired ? 1 : 0, frame->data.pyro.main_fired ? 1 : 0,
+        frame->data.pyro.drogue_fail ? 1 : 0, frame->data.pyro.main_fail ? 1 : 0,
+        frame->data.pyro.drogue_cont_ok ? 1 : 0, frame->data.pyro.main_cont_ok ? 1 : 0,
+        frame->data.pyro.drogue_fire_ack ? 1 : 0, frame->data.pyro.main_fire_ack ? 1 : 0,
+        frame->data.pyro.drogue_fire_requested ? 1 : 0, frame->data.pyro.main_fire_requested ? 1 : 0,
+        frame->data.gps.timestamp, frame->data.gps.timestamp_us, (unsigned int)frame->data.gps.seq,
+        (double)frame->data.gps.latitude, (double)frame->data.gps.longitude,
+        (double)frame->data.gps.altitude, (double)frame->data.gps.speed,
+        (unsigned int)frame->data.gps.sats, (unsigned int)frame->data.gps.fix,
+        (unsigned int)frame->seq[DATA_TOPIC_IMU].missed,
+        (unsigned int)frame->seq[DATA_TOPIC_IMU].duplicate,
+        (unsigned int)frame->seq[DATA_TOPIC_BARO].missed,
+        (unsigned int)frame->seq[DATA_TOPIC_BARO].duplicate,
+        (unsigned int)frame->seq[DATA_TOPIC_STATE].missed,
+        (unsigned int)frame->seq[DATA_TOPIC_STATE].duplicate,
+        (unsigned int)frame->seq[DATA_TOPIC_PYRO].missed,
+        (unsigned int)frame->seq[DATA_TOPIC_PYRO].duplicate,
+        (unsigned int)frame->seq[DATA_TOPIC_GPS].missed,
+        (unsigned int)frame->seq[DATA_TOPIC_GPS].duplicate,
+        (unsigned int)frame->data.state.baro_missed,
+        (unsigned int)frame->data.state.baro_duplicate,
+        (unsigned int)frame->radio_imu.missed,
+        (unsigned int)frame->radio_imu.duplicate,
+        (unsigned int)frame->radio_baro.missed,
+        (unsigned int)frame->radio_baro.duplicate,
+        (unsigned int)frame->dropped[DATA_TOPIC_IMU],
+        (unsigned int)frame->dropped[DATA_TOPIC_IMU_FILTERED],
+        (unsigned int)frame->dropped[DATA_TOPIC_ATTITUDE],
+        (unsigned int)frame->dropped[DATA_TOPIC_NAV],
+        (unsigned int)frame->dropped[DATA_TOPIC_HEALTH],
+        (unsigned int)frame->dropped[DATA_TOPIC_IMU_CALIB],
+        (unsigned int)frame->dropped[DATA_TOPIC_VIBRATION],
+        (unsigned int)frame->latency[DEPLOY_LATENCY_DECISION].last_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_DECISION].mean_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_DECISION].max_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_PYRO_SPI].count,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_PYRO_SPI].last_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_PYRO_SPI].max_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_FIRE].last_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_ENQUEUE].last_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_ACK].count,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_ACK].last_us,
+        (unsigned int)frame->latency[DEPLOY_LATENCY_ACK].max_us,
+        (unsigned int)frame->cyclic_overruns
     );
 }
 
 static void write_log_frame_to_file(const struct log_frame *frame)
 {
-    char log_entry[512];
+    // Only the logger thread writes rows; static keeps the row off its stack
+    static char log_entry[1024];
     int len = format_log_entry(frame, log_entry, sizeof(log_entry));
 
     if (len >= sizeof(log_entry)) {
@@ -254,9 +507,312 @@ static void write_log_frame_to_file(const struct log_frame *frame)
 #endif
 }
 
+/**
+ * @brief Append every journal event since the last call to the event file.
+ */
+static void write_journal_events(struct journal_cursor *cursor)
+{
+    struct journal_event events[LOGGER_JOURNAL_BATCH];
+    char line[96];
+    size_t n;
+
+    while ((n = journal_read(cursor, events, ARRAY_SIZE(events))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            int len = snprintf(line, sizeof(line), "%lld,%u,%s,%d\n", events[i].timestamp,
+                               (unsigned int)events[i].seq, journal_event_name(events[i].id),
+                               (int)events[i].value);
+
+            if (len < 0 || len >= sizeof(line)) {
+                continue;
+            }
+            csv_write(&event_csv, line, len);
+        }
+    }
+}
+
+/**
+ * @brief Append one row per registered periodic task to the task file.
+ */
+static void write_task_stats(int64_t timestamp)
+{
+    char line[128];
+
+    for (int i = 0; i < periodic_task_count(); i++) {
+        const char *name;
+        struct periodic_task_stats stats;
+
+        if (periodic_task_get(i, &name, &stats) < 0) {
+            continue;
+        }
+
+        int len = snprintf(line, sizeof(line), "%lld,%s,%u,%u,%u,%u,%u,%u\n", timestamp, name,
+                           (unsigned int)stats.releases, (unsigned int)stats.overruns,
+                           (unsigned int)stats.jitter_last_us, (unsigned int)stats.jitter_max_us,
+                           (unsigned int)stats.exec_last_us, (unsigned int)stats.wcet_us);
+
+        if (len < 0 || len >= sizeof(line)) {
+            continue;
+        }
+        csv_write(&task_csv, line, len);
+    }
+}
+
+/**
+ * @brief Append one row per sensor bus to the bus file.
+ */
+static void write_bus_stats(int64_t timestamp)
+{
+    char line[128];
+
+    for (int i = 0; i < sensor_bus_count(); i++) {
+        const char *name;
+        struct sensor_bus_stats stats;
+
+        if (sensor_bus_get(i, &name, &stats) < 0) {
+            continue;
+        }
+
+        int len = snprintf(line, sizeof(line), "%lld,%s,%u,%u,%u,%u,%u\n", timestamp, name,
+                           stats.devices, (unsigned int)stats.transfers,
+                           (unsigned int)stats.busy_us, stats.utilization_permille,
+                           (unsigned int)stats.wait_max_us);
+
+        if (len < 0 || len >= sizeof(line)) {
+            continue;
+        }
+        csv_write(&bus_csv, line, len);
+    }
+}
+
+/**
+ * @brief Append one row per deployment latency stage, with its histogram,
+ * to the latency file.
+ */
+static void write_latency_histograms(const struct log_frame *frame)
+{
+    char line[256];
+
+    for (int i = 0; i < DEPLOY_LATENCY_STAGE_COUNT; i++) {
+        const struct deploy_latency_stat *stat = &frame->latency[i];
+        int len = snprintf(line, sizeof(line), "%lld,%s,%u,%u,%u,%u", frame->log_timestamp,
+                           deploy_latency_stage_name(i), (unsigned int)stat->count,
+                           (unsigned int)stat->last_us, (unsigned int)stat->mean_us,
+                           (unsigned int)stat->max_us);
+
+        for (int b = 0; b < DEPLOY_LATENCY_BUCKETS && len < sizeof(line); b++) {
+            len += snprintf(line + len, sizeof(line) - len, ",%u",
+                            (unsigned int)stat->histogram[b]);
+        }
+
+        if (len + 1 >= sizeof(line)) {
+            continue;
+        }
+        line[len++] = '\n';
+        csv_write(&latency_csv, line, len);
+    }
+}
+
+/**
+ * @brief Append every health sample since the last call to the health file,
+ * one row per thread.
+ */
+static void write_health_samples(struct data_cursor *cursor)
+{
+    // One sample per call keeps this off the logger stack; health is ~1 Hz
+    static struct health_data health;
+    char line[128];
+
+    while (get_health_history(cursor, &health, 1) > 0) {
+        for (int i = 0; i < health.thread_count; i++) {
+            const struct health_thread *t = &health.threads[i];
+            int len = snprintf(line, sizeof(line), "%lld,%u,%u,%s,%d,%u,%u,%u\n",
+                               health.timestamp, (unsigned int)health.seq,
+                               (unsigned int)health.idle_permille, t->name, t->priority,
+                               (unsigned int)t->cpu_permille, (unsigned int)t->stack_size,
+                               (unsigned int)t->stack_unused);
+
+            if (len < 0 || len >= sizeof(line)) {
+                continue;
+            }
+            csv_write(&health_csv, line, len);
+        }
+    }
+}
+
+/**
+ * @brief Append every IMU calibration update since the last call to the
+ * calibration file.
+ */
+static void write_calib_samples(struct data_cursor *cursor)
+{
+    struct imu_calib_data calib;
+    char line[384];
+
+    while (get_imu_calib_history(cursor, &calib, 1) > 0) {
+        const float *m = calib.accel_matrix;
+        int len = snprintf(
+            line, sizeof(line),
+            "%lld,%u,%d,%u,0x%02x,%.6f,%.6f,%.6f,%.4f,%.4f,%.4f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,"
+            "%.5f,%.5f,%.5f,%.6f,%.4f\n",
+            calib.timestamp, (unsigned int)calib.seq, calib.valid ? 1 : 0,
+            (unsigned int)calib.windows, calib.poses, (double)calib.gyro_bias[0],
+            (double)calib.gyro_bias[1], (double)calib.gyro_bias[2], (double)calib.accel_offset[0],
+            (double)calib.accel_offset[1], (double)calib.accel_offset[2], (double)m[0],
+            (double)m[1], (double)m[2], (double)m[3], (double)m[4], (double)m[5], (double)m[6],
+            (double)m[7], (double)m[8], (double)calib.gyro_noise, (double)calib.accel_noise);
+
+        if (len < 0 || len >= sizeof(line)) {
+            continue;
+        }
+        csv_write(&calib_csv, line, len);
+    }
+}
+
+#ifdef CONFIG_FALCON_VIBRATION
+/**
+ * @brief Append every vibration spectrum since the last call to the
+ * vibration file, one row per axis.
+ */
+static void write_vibration_samples(struct data_cursor *cursor)
+{
+    static const char *const axis_names[] = {"accel_x", "accel_y", "accel_z",
+                                             "gyro_x",  "gyro_y",  "gyro_z"};
+    static struct vibration_data vib;
+    char line[192];
+
+    while (get_vibration_history(cursor, &vib, 1) > 0) {
+        for (int i = 0; i < ARRAY_SIZE(axis_names); i++) {
+            const struct vibration_axis *a = (i < 3) ? &vib.accel[i] : &vib.gyro[i - 3];
+            int len = snprintf(line, sizeof(line), "%lld,%u,%s,%.5f,%.2f,%.5f", vib.timestamp,
+                               (unsigned int)vib.seq, axis_names[i], (double)a->rms,
+                               (double)a->peak_hz, (double)a->peak_rms);
+
+            for (int b = 0; b < VIBRATION_BANDS && len > 0 && len < sizeof(line); b++) {
+                len += snprintf(line + len, sizeof(line) - len, ",%.5f", (double)a->band_rms[b]);
+            }
+            if (len > 0 && len < sizeof(line)) {
+                len += snprintf(line + len, sizeof(line) - len, ",%.2f,%u,%u,%u\n",
+                                (double)vib.sample_rate_hz, (unsigned int)vib.fft_size,
+                                (unsigned int)vib.analysis_us,
+                                (unsigned int)vib.windows_dropped);
+            }
+
+            if (len < 0 || len >= sizeof(line)) {
+                continue;
+            }
+            csv_write(&vibration_csv, line, len);
+        }
+    }
+}
+#endif
+
+// write_imu_samples() and write_attitude_samples() drain their history once a period
+BUILD_ASSERT(MIN(CONFIG_FALCON_HISTORY_IMU, CONFIG_FALCON_HISTORY_ATTITUDE) >=
+                 CONFIG_FALCON_IMU_ODR_HZ * LOGGER_THREAD_PERIOD_MS / MSEC_PER_SEC +
+                     CONFIG_FALCON_IMU_FIFO_WATERMARK,
+             "IMU and attitude histories are shorter than a logger period");
+
+/**
+ * @brief Append every IMU sample since the last call to an IMU file. Run
+ * each logger period: see the BUILD_ASSERT above.
+ */
+static void write_imu_samples(struct csv_file *csv, struct data_cursor *cursor,
+                              size_t (*read)(struct data_cursor *, struct imu_data *, size_t))
+{
+    struct imu_data imu;
+    char line[160];
+
+    while (read(cursor, &imu, 1) > 0) {
+        int len = snprintf(line, sizeof(line), "%lld,%u,%.4f,%.4f,%.4f,%.5f,%.5f,%.5f\n",
+                           imu.timestamp_us, (unsigned int)imu.seq, (double)imu.accel[0],
+                           (double)imu.accel[1], (double)imu.accel[2], (double)imu.gyro[0],
+                           (double)imu.gyro[1], (double)imu.gyro[2]);
+
+        if (len < 0 || len >= sizeof(line)) {
+            continue;
+        }
+        csv_write(csv, line, len);
+    }
+}
+
+#ifdef CONFIG_FALCON_AHRS
+/**
+ * @brief Append every attitude estimate since the last call to the attitude
+ * file. Run each logger period, like write_imu_samples().
+ */
+static void write_attitude_samples(struct data_cursor *cursor)
+{
+    struct attitude_data att;
+    char line[192];
+
+    while (get_attitude_history(cursor, &att, 1) > 0) {
+        int len = snprintf(line, sizeof(line),
+                           "%lld,%u,%d,%.6f,%.6f,%.6f,%.6f,%.5f,%.5f,%.6f,%.6f,%.6f\n",
+                           att.timestamp_us, (unsigned int)att.seq, att.aligned ? 1 : 0,
+                           (double)att.q[0], (double)att.q[1], (double)att.q[2],
+                           (double)att.q[3], (double)att.tilt, (double)att.roll_rate,
+                           (double)att.gyro_bias[0], (double)att.gyro_bias[1],
+                           (double)att.gyro_bias[2]);
+
+        if (len < 0 || len >= sizeof(line)) {
+            continue;
+        }
+        csv_write(&attitude_csv, line, len);
+    }
+}
+#endif
+
+#ifdef CONFIG_FALCON_NAV
+/**
+ * @brief Append every navigation solution since the last call to the nav
+ * file.
+ */
+static void write_nav_samples(struct data_cursor *cursor)
+{
+    struct nav_data nav;
+    char line[320];
+
+    while (get_nav_history(cursor, &nav, 1) > 0) {
+        int len = snprintf(line, sizeof(line),
+                           "%lld,%u,%.2f,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%.4f,"
+                           "%.4f,%.4f,%d,%.6f,%.6f,%u,%u\n",
+                           nav.timestamp_us, (unsigned int)nav.seq, (double)nav.position[0],
+                           (double)nav.position[1], (double)nav.position[2],
+                           (double)nav.velocity[0], (double)nav.velocity[1],
+                           (double)nav.velocity[2], (double)nav.position_var[0],
+                           (double)nav.position_var[1], (double)nav.position_var[2],
+                           (double)nav.velocity_var[0], (double)nav.velocity_var[1],
+                           (double)nav.velocity_var[2], (double)nav.accel_bias,
+                           nav.origin_valid ? 1 : 0, (double)nav.origin_lat,
+                           (double)nav.origin_lon, (unsigned int)nav.gps_fused,
+                           (unsigned int)nav.gps_rejected);
+
+        if (len < 0 || len >= sizeof(line)) {
+            continue;
+        }
+        csv_write(&nav_csv, line, len);
+    }
+}
+#endif
+
 static void logger_thread_fn(void *p1, void *p2, void *p3)
 {
-    struct log_frame frame;
+    struct log_frame frame = {0};
+    // From 0 so events recorded before the file was opened are kept
+    struct journal_cursor journal_cursor = {0};
+    struct data_cursor health_cursor = {0};
+    struct data_cursor calib_cursor = {0};
+#ifdef CONFIG_FALCON_VIBRATION
+    struct data_cursor vibration_cursor = {0};
+#endif
+    struct data_cursor imu_cursor;
+    struct data_cursor imu_filtered_cursor;
+#ifdef CONFIG_FALCON_AHRS
+    struct data_cursor attitude_cursor;
+#endif
+#ifdef CONFIG_FALCON_NAV
+    struct data_cursor nav_cursor;
+#endif
 
     if (mount_filesystem() < 0) {
         return;
@@ -266,19 +822,73 @@ static void logger_thread_fn(void *p1, void *p2, void *p3)
         return;
     }
 
+    // The IMU, attitude and nav files start with the samples from now on
+    data_cursor_init(DATA_TOPIC_IMU, &imu_cursor);
+    data_cursor_init(DATA_TOPIC_IMU_FILTERED, &imu_filtered_cursor);
+#ifdef CONFIG_FALCON_AHRS
+    data_cursor_init(DATA_TOPIC_ATTITUDE, &attitude_cursor);
+#endif
+#ifdef CONFIG_FALCON_NAV
+    data_cursor_init(DATA_TOPIC_NAV, &nav_cursor);
+#endif
+
     int64_t last_sync_ms = k_uptime_get();
 
+    periodic_task_init(&logger_task, "logger", LOGGER_THREAD_PERIOD_MS);
+
     while (1) {
+        periodic_task_wait(&logger_task);
+
         frame.log_timestamp = k_uptime_get();
-        get_imu_data(&frame.imu);
-        get_baro_data(&frame.baro);
-        get_state_data(&frame.state);
-        get_pyro_data(&frame.pyro);
-        get_gps_data(&frame.gps);
+        get_data_snapshot(&frame.data);
+
+        data_seq_track(&frame.seq[DATA_TOPIC_IMU], frame.data.imu.seq);
+        data_seq_track(&frame.seq[DATA_TOPIC_BARO], frame.data.baro.seq);
+        data_seq_track(&frame.seq[DATA_TOPIC_STATE], frame.data.state.seq);
+        data_seq_track(&frame.seq[DATA_TOPIC_PYRO], frame.data.pyro.seq);
+        data_seq_track(&frame.seq[DATA_TOPIC_GPS], frame.data.gps.seq);
+        radio_get_seq_stats(&frame.radio_imu, &frame.radio_baro);
+
+        for (int i = 0; i < DEPLOY_LATENCY_STAGE_COUNT; i++) {
+            deploy_latency_get(i, &frame.latency[i]);
+        }
+        frame.cyclic_overruns = cyclic_executive_overruns();
+
+        // As of the previous period: the history files are written after the row
+        frame.dropped[DATA_TOPIC_IMU] = imu_cursor.dropped;
+        frame.dropped[DATA_TOPIC_IMU_FILTERED] = imu_filtered_cursor.dropped;
+#ifdef CONFIG_FALCON_AHRS
+        frame.dropped[DATA_TOPIC_ATTITUDE] = attitude_cursor.dropped;
+#endif
+#ifdef CONFIG_FALCON_NAV
+        frame.dropped[DATA_TOPIC_NAV] = nav_cursor.dropped;
+#endif
+        frame.dropped[DATA_TOPIC_HEALTH] = health_cursor.dropped;
+        frame.dropped[DATA_TOPIC_IMU_CALIB] = calib_cursor.dropped;
+#ifdef CONFIG_FALCON_VIBRATION
+        frame.dropped[DATA_TOPIC_VIBRATION] = vibration_cursor.dropped;
+#endif
 
         write_log_frame_to_file(&frame);
+        write_journal_events(&journal_cursor);
+        write_imu_samples(&imu_csv, &imu_cursor, get_imu_history);
+        write_imu_samples(&imu_filtered_csv, &imu_filtered_cursor, get_imu_filtered_history);
+#ifdef CONFIG_FALCON_AHRS
+        write_attitude_samples(&attitude_cursor);
+#endif
+#ifdef CONFIG_FALCON_NAV
+        write_nav_samples(&nav_cursor);
+#endif
 
         if ((frame.log_timestamp - last_sync_ms) >= LOGGER_SYNC_PERIOD_MS) {
+            write_task_stats(frame.log_timestamp);
+            write_bus_stats(frame.log_timestamp);
+            write_latency_histograms(&frame);
+            write_health_samples(&health_cursor);
+            write_calib_samples(&calib_cursor);
+#ifdef CONFIG_FALCON_VIBRATION
+            write_vibration_samples(&vibration_cursor);
+#endif
 #ifdef CONFIG_BOARD_NATIVE_SIM
             fflush(log_file_ptr);
 #else
@@ -286,11 +896,26 @@ static void logger_thread_fn(void *p1, void *p2, void *p3)
             if (ret < 0) {
                 LOG_ERR("Failed to sync log file: %d", ret);
             }
+#endif
+            csv_sync(&event_csv);
+            csv_sync(&task_csv);
+            csv_sync(&bus_csv);
+            csv_sync(&latency_csv);
+            csv_sync(&health_csv);
+            csv_sync(&calib_csv);
+            csv_sync(&imu_csv);
+            csv_sync(&imu_filtered_csv);
+#ifdef CONFIG_FALCON_AHRS
+            csv_sync(&attitude_csv);
+#endif
+#ifdef CONFIG_FALCON_NAV
+            csv_sync(&nav_csv);
+#endif
+#ifdef CONFIG_FALCON_VIBRATION
+            csv_sync(&vibration_csv);
 #endif
             last_sync_ms = frame.log_timestamp;
         }
-
-        k_sleep(K_MSEC(LOGGER_THREAD_PERIOD_MS));
     }
 }
 
@@ -298,4 +923,5 @@ void start_logger_thread()
 {
     k_thread_create(&logger_thread, logger_stack, K_THREAD_STACK_SIZEOF(logger_stack),
                     logger_thread_fn, NULL, NULL, NULL, LOGGER_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&logger_thread, "logger");
 }
@@ -12,6 +12,15 @@
 #include "radio/command_thread.h"
 #include "gps/gps_thread.h"
 #include "data.h"
+#include "cyclic_executive.h"
+#include "event_journal.h"
+#include "health.h"
+#ifdef CONFIG_FALCON_NAV
+#include "sensors/nav_thread.h"
+#endif
+#ifdef CONFIG_FALCON_VIBRATION
+#include "vibration.h"
+#endif
 
 LOG_MODULE_REGISTER(falcon_main, LOG_LEVEL_INF);
 
@@ -20,14 +29,27 @@ int main(void)
     LOG_INF("Falcon application started");
 
     // Start the threads
+    start_journal_thread();
     start_imu_thread();
     start_logger_thread();
+#ifdef CONFIG_FALCON_CYCLIC_EXECUTIVE
+    // Runs baro, state machine and pyro in one time-triggered loop
+    start_cyclic_executive();
+#else
     start_baro_thread();
     start_pyro_thread();
     start_state_machine_thread();
+#endif
     start_radio_thread();
     start_gps_thread();
     start_command_threads();
+    start_health_thread();
+#ifdef CONFIG_FALCON_NAV
+    start_nav_thread();
+#endif
+#ifdef CONFIG_FALCON_VIBRATION
+    start_vibration_thread();
+#endif
 
     return 0;
 }
@@ -0,0 +1,103 @@
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include "periodic_task.h"
+
+LOG_MODULE_REGISTER(periodic_task, LOG_LEVEL_INF);
+
+#define PERIODIC_TASK_MAX 12
+
+static struct periodic_task *tasks[PERIODIC_TASK_MAX];
+static atomic_t task_count;
+// Guards the registry and every task's stats
+static struct k_spinlock task_lock;
+
+int periodic_task_init(struct periodic_task *task, const char *name, uint32_t period_ms)
+{
+    task->name = name;
+    task->period_ticks = (k_ticks_t)k_ms_to_ticks_ceil64(period_ms);
+    task->next_release = k_uptime_ticks();
+    task->start_cycles = 0;
+    task->stats = (struct periodic_task_stats){0};
+
+    k_spinlock_key_t key = k_spin_lock(&task_lock);
+    atomic_val_t idx = atomic_get(&task_count);
+
+    if (idx >= PERIODIC_TASK_MAX) {
+        k_spin_unlock(&task_lock, key);
+        LOG_ERR("Task registry full, %s not tracked", name);
+        return -ENOMEM;
+    }
+
+    tasks[idx] = task;
+    atomic_inc(&task_count);
+    k_spin_unlock(&task_lock, key);
+    return 0;
+}
+
+void periodic_task_wait(struct periodic_task *task)
+{
+    struct periodic_task_stats *stats = &task->stats;
+    k_spinlock_key_t key;
+
+    // Close out the cycle that just ran (nothing to close on the first call)
+    if (stats->releases > 0) {
+        uint32_t exec_us = (uint32_t)k_cyc_to_us_floor64(k_cycle_get_32() - task->start_cycles);
+
+        key = k_spin_lock(&task_lock);
+        stats->exec_last_us = exec_us;
+        stats->wcet_us = MAX(stats->wcet_us, exec_us);
+        k_spin_unlock(&task_lock, key);
+        task->next_release += task->period_ticks;
+    }
+
+    k_ticks_t now = k_uptime_ticks();
+
+    if (now > task->next_release) {
+        // Run the latest missed release right away and drop the older ones,
+        // so the task stays phase-locked instead of bursting to catch up
+        k_ticks_t behind = now - task->next_release;
+
+        task->next_release += (behind / task->period_ticks) * task->period_ticks;
+        key = k_spin_lock(&task_lock);
+        stats->overruns++;
+        k_spin_unlock(&task_lock, key);
+    }
+
+    k_sleep(K_TIMEOUT_ABS_TICKS(task->next_release));
+
+    uint32_t jitter_us = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks() - task->next_release);
+
+    key = k_spin_lock(&task_lock);
+    stats->jitter_last_us = jitter_us;
+    stats->jitter_max_us = MAX(stats->jitter_max_us, jitter_us);
+    stats->releases++;
+    k_spin_unlock(&task_lock, key);
+    task->start_cycles = k_cycle_get_32();
+}
+
+void periodic_task_set_period(struct periodic_task *task, uint32_t period_ms)
+{
+    task->period_ticks = (k_ticks_t)k_ms_to_ticks_ceil64(period_ms);
+}
+
+int periodic_task_count(void)
+{
+    return (int)atomic_get(&task_count);
+}
+
+int periodic_task_get(int idx, const char **name, struct periodic_task_stats *stats)
+{
+    if (idx < 0 || idx >= periodic_task_count()) {
+        return -EINVAL;
+    }
+
+    // Stats belong to another thread; task_lock keeps the copy from tearing
+    k_spinlock_key_t key = k_spin_lock(&task_lock);
+
+    *name = tasks[idx]->name;
+    *stats = tasks[idx]->stats;
+    k_spin_unlock(&task_lock, key);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef PERIODIC_TASK_H
+#define PERIODIC_TASK_H
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/*
+ * Drift-free periodic execution. Releases are absolute (start + n * period),
+ * so a thread's rate does not stretch with its own execution time or with
+ * preemption. Call periodic_task_wait() at the top of the loop body: it
+ * sleeps until the next release and accounts for the previous cycle.
+ */
+
+struct periodic_task_stats {
+    uint32_t releases;       // Cycles run
+    uint32_t overruns;       // Cycles that finished after the next release was due
+    uint32_t jitter_last_us; // Wakeup lateness relative to the release, last cycle
+    uint32_t jitter_max_us;
+    uint32_t exec_last_us;   // Execution time (release wakeup to next wait), last cycle
+    uint32_t wcet_us;        // Worst-case execution time observed
+};
+
+struct periodic_task {
+    const char *name;
+    k_ticks_t period_ticks;
+    k_ticks_t next_release;
+    uint32_t start_cycles;
+    struct periodic_task_stats stats;
+};
+
+/**
+ * @brief Set up a periodic task and register it for periodic_task_get().
+ * The first release is immediate.
+ * @return 0 on success, -ENOMEM if the task registry is full
+ */
+int periodic_task_init(struct periodic_task *task, const char *name, uint32_t period_ms);
+
+/**
+ * @brief Finish the current cycle and sleep until the next release.
+ * If the cycle overran, the latest missed release runs immediately and
+ * any older ones are dropped (counted once as an overrun), so the task
+ * does not burst to catch up.
+ */
+void periodic_task_wait(struct periodic_task *task);
+
+/**
+ * @brief Change the period. Called during a cycle, the next release is
+ * already the new period after the current one.
+ */
+void periodic_task_set_period(struct periodic_task *task, uint32_t period_ms);
+
+/**
+ * @brief Number of registered tasks.
+ */
+int periodic_task_count(void);
+
+/**
+ * @brief Copy the name and statistics of registered task idx. Safe from any
+ * thread: the copy is taken under the lock the task updates them with.
+ * @return 0 on success, -EINVAL if idx is out of range
+ */
+int periodic_task_get(int idx, const char **name, struct periodic_task_stats *stats);
+
+#endif
@@ -5,6 +5,7 @@
 #include <zephyr/logging/log.h>
 #include "pyro_thread.h"
 #include "data.h"
+#include "deploy_latency.h"
 
 LOG_MODULE_REGISTER(pyro_thread, LOG_LEVEL_INF);
 
@@ -12,6 +13,8 @@ LOG_MODULE_REGISTER(pyro_thread, LOG_LEVEL_INF);
 #define PYRO_THREAD_STACK_SIZE 2048
 #define PYRO_THREAD_PRIORITY 0
 #define PYRO_STATUS_POLL_INTERVAL_MS 100
+#define PYRO_RETRY_INTERVAL_MS 10
+#define PYRO_MAX_RETRIES 100 // Retry for ~1 second
 
 // Thread stack and data
 K_THREAD_STACK_DEFINE(pyro_stack, PYRO_THREAD_STACK_SIZE);
@@ -82,7 +85,8 @@ static int pyro_spi_transact(uint8_t cmd, uint8_t *status_out)
 static void parse_status_byte(uint8_t status_byte, struct pyro_data *status)
 {
     status->status_byte = status_byte;
-    status->timestamp = k_uptime_get();
+    status->timestamp_us = data_timestamp_us();
+    status->timestamp = status->timestamp_us / USEC_PER_MSEC;
     status->drogue_fired = (status_byte & PYRO_STATUS_DROGUE_FIRED) != 0;
     status->main_fired = (status_byte & PYRO_STATUS_MAIN_FIRED) != 0;
     status->drogue_fail = (status_byte & PYRO_STATUS_DROGUE_FAIL) != 0;
@@ -171,6 +175,73 @@ static void log_fire_result(uint8_t cmd, const struct pyro_data *status, int ret
     }
 }
 
+/**
+ * @brief Map a fire command to the deployment it belongs to, for latency tracing
+ */
+static enum deploy_latency_channel pyro_latency_channel(uint8_t cmd)
+{
+    return (cmd == PYRO_CMD_FIRE_MAIN) ? DEPLOY_LATENCY_MAIN : DEPLOY_LATENCY_DROGUE;
+}
+
+/**
+ * @brief Send a pyro command once and publish the status it returns
+ * @param cmd Command to send
+ * @param attempt Zero-based attempt number, for logging
+ * @return true if the pyro board acknowledged the command
+ */
+static bool pyro_command_attempt(uint8_t cmd, int attempt)
+{
+    uint8_t status_byte;
+    int ret = pyro_spi_transact(cmd, &status_byte);
+
+    if (ret != 0) {
+        LOG_ERR("SPI error on pyro command 0x%02x: %d", cmd, ret);
+        return false;
+    }
+
+    deploy_latency_trace(pyro_latency_channel(cmd), DEPLOY_LATENCY_PYRO_SPI);
+
+    struct pyro_data new_status;
+    get_pyro_data(&new_status);
+    parse_status_byte(status_byte, &new_status);
+    set_pyro_data(&new_status);
+
+    // Check if command was acknowledged
+    if (!is_fire_command_acked(cmd, &new_status)) {
+        return false;
+    }
+
+    deploy_latency_trace(pyro_latency_channel(cmd), DEPLOY_LATENCY_ACK);
+
+    LOG_INF("Pyro command 0x%02x acknowledged (attempt %d)", cmd, attempt + 1);
+
+    // Log immediate result if available
+    if (is_fire_command_complete(cmd, &new_status)) {
+        log_fire_result(cmd, &new_status, attempt);
+    }
+    return true;
+}
+
+/**
+ * @brief Publish that a fire command has been taken off the queue. The pyro
+ * thread is the only writer of the pyro topic, so the request flags are set
+ * here rather than by the thread that queued the command.
+ */
+static void mark_fire_requested(uint8_t cmd)
+{
+    struct pyro_data pd;
+
+    get_pyro_data(&pd);
+    if (cmd == PYRO_CMD_FIRE_DROGUE) {
+        pd.drogue_fire_requested = true;
+    } else if (cmd == PYRO_CMD_FIRE_MAIN) {
+        pd.main_fire_requested = true;
+    } else {
+        return;
+    }
+    set_pyro_data(&pd);
+}
+
 /**
  * @brief Execute a pyro command with retry logic
  * @param cmd Command to execute
@@ -178,39 +249,18 @@ static void log_fire_result(uint8_t cmd, const struct pyro_data *status, int ret
 static void execute_pyro_command(uint8_t cmd)
 {
     LOG_INF("Executing pyro command: 0x%02x", cmd);
+    mark_fire_requested(cmd);
 
     bool acked = false;
     int retry_count = 0;
-    const int MAX_RETRIES = 100; // Retry for ~1 second (10ms per attempt)
 
     // Keep sending command until we get an ACK
-    while (!acked && retry_count < MAX_RETRIES) {
-        uint8_t status_byte;
-        int ret = pyro_spi_transact(cmd, &status_byte);
-
-        if (ret == 0) {
-            struct pyro_data new_status;
-            get_pyro_data(&new_status);
-            parse_status_byte(status_byte, &new_status);
-            set_pyro_data(&new_status);
-
-            // Check if command was acknowledged
-            if (is_fire_command_acked(cmd, &new_status)) {
-                LOG_INF("Pyro command 0x%02x acknowledged (attempt %d)", cmd, retry_count + 1);
-                acked = true;
-
-                // Log immediate result if available
-                if (is_fire_command_complete(cmd, &new_status)) {
-                    log_fire_result(cmd, &new_status, retry_count);
-                }
-            }
-        } else {
-            LOG_ERR("SPI error on pyro command 0x%02x: %d", cmd, ret);
-        }
+    while (!acked && retry_count < PYRO_MAX_RETRIES) {
+        acked = pyro_command_attempt(cmd, retry_count);
 
         if (!acked) {
             retry_count++;
-            k_sleep(K_MSEC(10));
+            k_sleep(K_MSEC(PYRO_RETRY_INTERVAL_MS));
         }
     }
 
@@ -253,12 +303,69 @@ static void pyro_thread_fn(void *p1, void *p2, void *p3)
     }
 }
 
+#ifdef CONFIG_FALCON_CYCLIC_EXECUTIVE
+// Command in flight under the cyclic executive, retried once per frame
+static uint8_t cyclic_cmd;
+static int cyclic_attempt;
+static int64_t cyclic_last_poll_ms;
+
+bool pyro_init(void)
+{
+    if (!spi_is_ready_dt(&pyro_spi)) {
+        LOG_ERR("Pyro SPI device not ready");
+        return false;
+    }
+
+    request_pyro_status();
+    cyclic_last_poll_ms = k_uptime_get();
+    return true;
+}
+
+void pyro_step(int retry_limit)
+{
+    if (cyclic_cmd == 0) {
+        if (k_msgq_get(&pyro_cmd_queue, &cyclic_cmd, K_NO_WAIT) != 0) {
+            // Nothing to send: keep the status poll at its usual rate
+            int64_t now_ms = k_uptime_get();
+
+            if (now_ms - cyclic_last_poll_ms >= PYRO_STATUS_POLL_INTERVAL_MS) {
+                request_pyro_status();
+                cyclic_last_poll_ms = now_ms;
+            }
+            return;
+        }
+        mark_fire_requested(cyclic_cmd);
+        cyclic_attempt = 0;
+    }
+
+    if (pyro_command_attempt(cyclic_cmd, cyclic_attempt)) {
+        cyclic_cmd = 0;
+        return;
+    }
+
+    if (++cyclic_attempt >= retry_limit) {
+        LOG_ERR("Pyro command 0x%02x not acknowledged after %d attempts", cyclic_cmd,
+                cyclic_attempt);
+        cyclic_cmd = 0;
+    }
+}
+#endif /* CONFIG_FALCON_CYCLIC_EXECUTIVE */
+
 /**
  * @brief Send a command to the pyro thread
  */
 static int send_pyro_command(uint8_t cmd)
 {
+    // The pyro thread outranks the caller: hold it off until the enqueue is
+    // recorded, or it would reach the SPI stage first
+    k_sched_lock();
+
     int ret = k_msgq_put(&pyro_cmd_queue, &cmd, K_NO_WAIT);
+    if (ret == 0) {
+        deploy_latency_trace(pyro_latency_channel(cmd), DEPLOY_LATENCY_ENQUEUE);
+    }
+    k_sched_unlock();
+
     if (ret != 0) {
         LOG_ERR("Failed to queue pyro command 0x%02x: %d", cmd, ret);
         return ret;
@@ -278,19 +385,11 @@ void start_pyro_thread(void)
 int pyro_fire_drogue(void)
 {
     LOG_INF("Drogue fire command requested");
-    struct pyro_data pd;
-    get_pyro_data(&pd);
-    pd.drogue_fire_requested = true;
-    set_pyro_data(&pd);
     return send_pyro_command(PYRO_CMD_FIRE_DROGUE);
 }
 
 int pyro_fire_main(void)
 {
     LOG_INF("Main fire command requested");
-    struct pyro_data pd;
-    get_pyro_data(&pd);
-    pd.main_fire_requested = true;
-    set_pyro_data(&pd);
     return send_pyro_command(PYRO_CMD_FIRE_MAIN);
 }
@@ -24,14 +24,32 @@
  */
 void start_pyro_thread(void);
 
+#ifdef CONFIG_FALCON_CYCLIC_EXECUTIVE
 /**
- * @brief Fire the drogue parachute
+ * @brief Check the pyro SPI link and read the initial status, in place of
+ * start_pyro_thread() when the cyclic executive owns the pyro board.
+ * @return false if the SPI device is not ready
+ */
+bool pyro_init(void);
+
+/**
+ * @brief One cyclic-executive pyro slot: send (or resend) the pending fire
+ * command once, or poll status if nothing is pending. Never sleeps.
+ * @param retry_limit Attempts before an unacknowledged command is dropped
+ */
+void pyro_step(int retry_limit);
+#endif
+
+/**
+ * @brief Fire the drogue parachute. Only queues the command; the pyro thread
+ * publishes drogue_fire_requested when it takes it off the queue.
  * @return 0 on success, negative errno on failure
  */
 int pyro_fire_drogue(void);
 
 /**
- * @brief Fire the main parachute
+ * @brief Fire the main parachute. Only queues the command; the pyro thread
+ * publishes main_fire_requested when it takes it off the queue.
  * @return 0 on success, negative errno on failure
  */
 int pyro_fire_main(void);
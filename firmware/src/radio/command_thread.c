@@ -7,6 +7,7 @@
 #include <GroundCommand.pb.h>
 #include "command_thread.h"
 #include "gnss_spi.h"
+#include "periodic_task.h"
 #include "camera/vtx_power.h"
 #include "camera/runcam.h"
 #include "rfd900x.h"
@@ -25,6 +26,7 @@ LOG_MODULE_REGISTER(command_thread, LOG_LEVEL_INF);
 
 K_THREAD_STACK_DEFINE(command_rx_stack, COMMAND_RX_STACK_SIZE);
 static struct k_thread command_rx_thread;
+static struct periodic_task command_rx_task;
 
 K_THREAD_STACK_DEFINE(command_exec_stack, COMMAND_EXEC_STACK_SIZE);
 static struct k_thread command_exec_thread;
@@ -128,14 +130,17 @@ static void command_rx_thread_fn(void *p1, void *p2, void *p3)
     }
     LOG_INF("Command RX polling started");
 
+    periodic_task_init(&command_rx_task, "command_rx", COMMAND_RX_POLL_MS);
+
     while (1) {
         uint8_t payload[GNSS_SPI_MAX_COBS_SIZE];
         GroundCommand cmd;
 
+        periodic_task_wait(&command_rx_task);
+
         int ret = gnss_spi_radio_rx(payload);
         if (ret < 0) {
             LOG_ERR("Radio RX SPI read failed: %d", ret);
-            k_sleep(K_MSEC(COMMAND_RX_POLL_MS));
             continue;
         }
 
@@ -149,8 +154,6 @@ static void command_rx_thread_fn(void *p1, void *p2, void *p3)
                 have_last_command = true;
             }
         }
-
-        k_sleep(K_MSEC(COMMAND_RX_POLL_MS));
     }
 }
 
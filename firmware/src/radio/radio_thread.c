@@ -7,6 +7,7 @@
 #include <TelemetryPacket.pb.h>
 #include <zephyr/sys/atomic.h>
 #include "data.h"
+#include "periodic_task.h"
 #include "gnss_spi.h"
 #include "radio_thread.h"
 
@@ -26,6 +27,7 @@ NET_BUF_POOL_DEFINE(cobs_dst_pool, 1, MAX_COBS_SIZE, 0, NULL);
 
 K_THREAD_STACK_DEFINE(radio_stack, RADIO_THREAD_STACK_SIZE);
 static struct k_thread radio_thread;
+static struct periodic_task radio_task;
 
 /* Set while an RFD900x AT session needs serial silence toward the modem */
 static atomic_t radio_tx_suspended;
@@ -35,6 +37,20 @@ void radio_tx_suspend(bool suspend)
 	atomic_set(&radio_tx_suspended, suspend ? 1 : 0);
 }
 
+/* The radio's own view of the IMU and baro topics, read by the logger and shell */
+static struct k_spinlock seq_lock;
+static struct data_seq_stats imu_seq_stats;
+static struct data_seq_stats baro_seq_stats;
+
+void radio_get_seq_stats(struct data_seq_stats *imu, struct data_seq_stats *baro)
+{
+	k_spinlock_key_t key = k_spin_lock(&seq_lock);
+
+	*imu = imu_seq_stats;
+	*baro = baro_seq_stats;
+	k_spin_unlock(&seq_lock, key);
+}
+
 BUILD_ASSERT(MAX_FRAME_SIZE + MAX_FRAME_SIZE / 254 + 2 <= MAX_COBS_SIZE,
 	     "MAX_FRAME_SIZE too large for MAX_COBS_SIZE");
 
@@ -48,69 +64,70 @@ static void radio_thread_fn(void *p1, void *p2, void *p3)
 	}
 	LOG_INF("Radio SPI device ready");
 
+	periodic_task_init(&radio_task, "radio", RADIO_THREAD_PERIOD_MS);
+
 	while (1) {
+		periodic_task_wait(&radio_task);
+
 		if (atomic_get(&radio_tx_suspended)) {
-			k_sleep(K_MSEC(RADIO_THREAD_PERIOD_MS));
 			continue;
 		}
 
 		TelemetryPacket message = TelemetryPacket_init_zero;
 		uint8_t buffer[MAX_PAYLOAD_SIZE];
 
-		struct imu_data imu;
-		struct baro_data baro;
-		struct state_data state;
-		struct gps_data gps;
-		struct camera_data camera;
+		struct data_snapshot snap;
+
+		get_data_snapshot(&snap);
+
+		k_spinlock_key_t key = k_spin_lock(&seq_lock);
 
-		get_imu_data(&imu);
-		get_baro_data(&baro);
-		get_state_data(&state);
-		get_gps_data(&gps);
-		get_camera_data(&camera);
+		data_seq_track(&imu_seq_stats, snap.imu.seq);
+		data_seq_track(&baro_seq_stats, snap.baro.seq);
+		k_spin_unlock(&seq_lock, key);
 
 		message.counter = counter;
 		message.timestamp_ms = (uint32_t)k_uptime_get();
-		message.state = (FlightState)state.state;
-
-		message.accel_x = imu.accel[0];
-		message.accel_y = imu.accel[1];
-		message.accel_z = imu.accel[2];
-		message.gyro_x = imu.gyro[0];
-		message.gyro_y = imu.gyro[1];
-		message.gyro_z = imu.gyro[2];
-
-
-		message.kf_altitude = baro.altitude;
-		message.kf_velocity = baro.velocity;
-		message.kf_alt_variance = baro.alt_variance;
-		message.kf_vel_variance = baro.vel_variance;
-
-		message.baro0_healthy = baro.baro0.healthy;
-		message.baro0_pressure = baro.baro0.pressure;
-		message.baro0_temperature = baro.baro0.temperature;
-		message.baro0_altitude = baro.baro0.altitude;
-		message.baro0_nis = baro.baro0.nis;
-		message.baro0_faults = baro.baro0.faults;
-
-		message.baro1_healthy = baro.baro1.healthy;
-		message.baro1_pressure = baro.baro1.pressure;
-		message.baro1_temperature = baro.baro1.temperature;
-		message.baro1_altitude = baro.baro1.altitude;
-		message.baro1_nis = baro.baro1.nis;
-		message.baro1_faults = baro.baro1.faults;
-
-		message.ground_altitude = state.ground_altitude;
-
-		message.gps_latitude = gps.latitude;
-		message.gps_longitude = gps.longitude;
-		message.gps_altitude = gps.altitude;
-		message.gps_speed = gps.speed;
-		message.gps_sats = gps.sats;
-		message.gps_fix = gps.fix;
-
-		message.runcam_power = camera.vtx_power_on;
-		message.runcam_recording = camera.recording;
+		message.state = (FlightState)snap.state.state;
+
+		message.accel_x = snap.imu.accel[0];
+		message.accel_y = snap.imu.accel[1];
+		message.accel_z = snap.imu.accel[2];
+		message.gyro_x = snap.imu.gyro[0];
+		message.gyro_y = snap.imu.gyro[1];
+		message.gyro_z = snap.imu.gyro[2];
+
+
+		message.kf_altitude = snap.baro.altitude;
+		message.kf_velocity = snap.baro.velocity;
+		message.kf_alt_variance = snap.baro.alt_variance;
+		message.kf_vel_variance = snap.baro.vel_variance;
+
+		message.baro0_healthy = snap.baro.baro0.healthy;
+		message.baro0_pressure = snap.baro.baro0.pressure;
+		message.baro0_temperature = snap.baro.baro0.temperature;
+		message.baro0_altitude = snap.baro.baro0.altitude;
+		message.baro0_nis = snap.baro.baro0.nis;
+		message.baro0_faults = snap.baro.baro0.faults;
+
+		message.baro1_healthy = snap.baro.baro1.healthy;
+		message.baro1_pressure = snap.baro.baro1.pressure;
+		message.baro1_temperature = snap.baro.baro1.temperature;
+		message.baro1_altitude = snap.baro.baro1.altitude;
+		message.baro1_nis = snap.baro.baro1.nis;
+		message.baro1_faults = snap.baro.baro1.faults;
+
+		message.ground_altitude = snap.state.ground_altitude;
+
+		message.gps_latitude = snap.gps.latitude;
+		message.gps_longitude = snap.gps.longitude;
+		message.gps_altitude = snap.gps.altitude;
+		message.gps_speed = snap.gps.speed;
+		message.gps_sats = snap.gps.sats;
+		message.gps_fix = snap.gps.fix;
+
+		message.runcam_power = snap.camera.vtx_power_on;
+		message.runcam_recording = snap.camera.recording;
 
 		pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
 		bool status = pb_encode(&stream, TelemetryPacket_fields, &message);
@@ -120,7 +137,6 @@ static void radio_thread_fn(void *p1, void *p2, void *p3)
 			LOG_ERR("Failed to encode TelemetryPacket: %s",
 				PB_GET_ERROR(&stream));
 			counter++;
-			k_sleep(K_MSEC(RADIO_THREAD_PERIOD_MS));
 			continue;
 		}
 
@@ -140,7 +156,6 @@ static void radio_thread_fn(void *p1, void *p2, void *p3)
 				net_buf_unref(dst_buf);
 			}
 			counter++;
-			k_sleep(K_MSEC(RADIO_THREAD_PERIOD_MS));
 			continue;
 		}
 
@@ -171,7 +186,6 @@ static void radio_thread_fn(void *p1, void *p2, void *p3)
 		net_buf_unref(dst_buf);
 
 		counter++;
-		k_sleep(K_MSEC(RADIO_THREAD_PERIOD_MS));
 	}
 }
 
@@ -179,4 +193,5 @@ void start_radio_thread(void)
 {
 	k_thread_create(&radio_thread, radio_stack, K_THREAD_STACK_SIZEOF(radio_stack),
 			radio_thread_fn, NULL, NULL, NULL, RADIO_THREAD_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&radio_thread, "radio");
 }
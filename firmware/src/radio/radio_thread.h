@@ -2,6 +2,7 @@
 #define RADIO_THREAD_H
 
 #include <stdbool.h>
+#include "data.h"
 
 void start_radio_thread(void);
 
@@ -14,4 +15,10 @@ void start_radio_thread(void);
  */
 void radio_tx_suspend(bool suspend);
 
+/**
+ * @brief Copy the samples of the IMU and baro topics that the telemetry
+ * packets missed or repeated (see data_seq_track()).
+ */
+void radio_get_seq_stats(struct data_seq_stats *imu, struct data_seq_stats *baro);
+
 #endif
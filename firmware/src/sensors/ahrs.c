@@ -0,0 +1,188 @@
+#include <math.h>
+#include <string.h>
+#include "ahrs.h"
+
+void ahrs_init(struct ahrs *a)
+{
+    memset(a, 0, sizeof(*a));
+    a->q[0] = 1.0f;
+    a->nose = 2;
+    a->nose_sign = 1.0f;
+    a->on_pad = true;
+}
+
+void ahrs_set_on_pad(struct ahrs *a, bool on_pad)
+{
+    if (on_pad && !a->on_pad) {
+        a->pad_count = 0;
+    }
+    a->on_pad = on_pad;
+}
+
+/**
+ * @brief Up in body axes, as the attitude predicts it: the bottom row of
+ * the body to earth rotation.
+ */
+static void predicted_up(const float q[4], float up[3])
+{
+    up[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    up[1] = 2.0f * (q[2] * q[3] + q[0] * q[1]);
+    up[2] = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+}
+
+/**
+ * @brief The accelerometer reading as a unit vector, if it is close enough
+ * to 1 g to be taken as pointing up.
+ */
+static bool accel_up(const float accel[3], float up[3])
+{
+    float norm2 = accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2];
+    float lo = AHRS_G * (1.0f - AHRS_ACCEL_GATE);
+    float hi = AHRS_G * (1.0f + AHRS_ACCEL_GATE);
+
+    if (norm2 < lo * lo || norm2 > hi * hi) {
+        return false;
+    }
+
+    float inv = 1.0f / sqrtf(norm2);
+
+    for (int i = 0; i < 3; i++) {
+        up[i] = accel[i] * inv;
+    }
+    return true;
+}
+
+/**
+ * @brief Take tilt from a reading at rest: the shortest rotation carrying
+ * it onto earth z, so heading starts at zero. The nose is the axis
+ * closest to up.
+ */
+static void align(struct ahrs *a, const float up[3])
+{
+    float w = 1.0f + up[2];
+
+    if (w < 1.0e-6f) {
+        // Upside down: half a turn about x
+        a->q[0] = 0.0f;
+        a->q[1] = 1.0f;
+        a->q[2] = 0.0f;
+        a->q[3] = 0.0f;
+    } else {
+        float inv = 1.0f / sqrtf(w * w + up[0] * up[0] + up[1] * up[1]);
+
+        a->q[0] = w * inv;
+        a->q[1] = up[1] * inv;
+        a->q[2] = -up[0] * inv;
+        a->q[3] = 0.0f;
+    }
+
+    a->nose = 0;
+    for (int i = 1; i < 3; i++) {
+        if (fabsf(up[i]) > fabsf(up[a->nose])) {
+            a->nose = i;
+        }
+    }
+    a->nose_sign = (up[a->nose] < 0.0f) ? -1.0f : 1.0f;
+    a->aligned = true;
+}
+
+/**
+ * @brief Average in a sample at 1 g on the pad and re-align from the mean.
+ * The rocket is still, so the mean rate is the gyro bias.
+ */
+static void pad_average(struct ahrs *a, const float accel[3], const float gyro[3])
+{
+    if (a->pad_count < AHRS_PAD_WINDOW) {
+        a->pad_count++;
+    }
+    for (int i = 0; i < 3; i++) {
+        a->pad_accel[i] += (accel[i] - a->pad_accel[i]) / (float)a->pad_count;
+        a->bias[i] += (gyro[i] - a->bias[i]) / (float)a->pad_count;
+        a->bias[i] = fminf(fmaxf(a->bias[i], -AHRS_BIAS_MAX), AHRS_BIAS_MAX);
+    }
+
+    float norm = sqrtf(a->pad_accel[0] * a->pad_accel[0] + a->pad_accel[1] * a->pad_accel[1] +
+                       a->pad_accel[2] * a->pad_accel[2]);
+
+    if (norm > 0.0f) {
+        float up[3] = {a->pad_accel[0] / norm, a->pad_accel[1] / norm, a->pad_accel[2] / norm};
+
+        align(a, up);
+    }
+}
+
+void ahrs_update(struct ahrs *a, const float accel[3], const float gyro[3], int64_t timestamp_us)
+{
+    float measured[3];
+    bool at_1g = accel_up(accel, measured);
+    float dt = (float)(timestamp_us - a->last_us) * 1.0e-6f;
+
+    a->last_us = timestamp_us;
+    a->corrected = false;
+
+    if (a->on_pad && at_1g) {
+        pad_average(a, accel, gyro);
+    } else if (!a->aligned && at_1g) {
+        align(a, measured);
+    }
+    if (a->on_pad || !a->aligned) {
+        for (int i = 0; i < 3; i++) {
+            a->rate[i] = gyro[i] - a->bias[i];
+        }
+        return;
+    }
+
+    if (dt <= 0.0f) {
+        return;
+    }
+    dt = fminf(dt, AHRS_DT_MAX);
+
+    float e[3] = {0.0f, 0.0f, 0.0f};
+
+    if (at_1g) {
+        float up[3];
+
+        predicted_up(a->q, up);
+        e[0] = measured[1] * up[2] - measured[2] * up[1];
+        e[1] = measured[2] * up[0] - measured[0] * up[2];
+        e[2] = measured[0] * up[1] - measured[1] * up[0];
+
+        for (int i = 0; i < 3; i++) {
+            a->bias[i] = fminf(fmaxf(a->bias[i] - AHRS_KI * e[i] * dt, -AHRS_BIAS_MAX),
+                               AHRS_BIAS_MAX);
+        }
+        a->corrected = true;
+    }
+
+    float w[3];
+
+    for (int i = 0; i < 3; i++) {
+        a->rate[i] = gyro[i] - a->bias[i];
+        w[i] = (a->rate[i] + AHRS_KP * e[i]) * 0.5f * dt;
+    }
+
+    // q += q * (0, w), with w already scaled by dt / 2, then back onto the unit sphere
+    const float *q = a->q;
+    float n[4] = {
+        q[0] - q[1] * w[0] - q[2] * w[1] - q[3] * w[2],
+        q[1] + q[0] * w[0] + q[2] * w[2] - q[3] * w[1],
+        q[2] + q[0] * w[1] - q[1] * w[2] + q[3] * w[0],
+        q[3] + q[0] * w[2] + q[1] * w[1] - q[2] * w[0],
+    };
+    float inv = 1.0f / sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2] + n[3] * n[3]);
+
+    for (int i = 0; i < 4; i++) {
+        a->q[i] = n[i] * inv;
+    }
+}
+
+float ahrs_tilt(const struct ahrs *a)
+{
+    float up[3];
+
+    predicted_up(a->q, up);
+
+    float c = a->nose_sign * up[a->nose];
+
+    return acosf(fminf(fmaxf(c, -1.0f), 1.0f));
+}
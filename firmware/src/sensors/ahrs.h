@@ -0,0 +1,95 @@
+#ifndef AHRS_H
+#define AHRS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Attitude estimate from every calibrated IMU sample (Mahony filter).
+ *
+ * The attitude is a unit quaternion q = (w, x, y, z) rotating body vectors
+ * into an earth frame with z up. Each sample, the gyro rate less the
+ * estimated bias turns q; while the accelerometer reads 1 g within
+ * AHRS_ACCEL_GATE it is taken to point up, and the cross product of that
+ * with the up direction q predicts gives the attitude error. The error
+ * pulls the rate by AHRS_KP and, integrated with AHRS_KI, becomes the gyro
+ * bias estimate. Under thrust and in coast the accelerometer is far from
+ * 1 g, so the gyro alone carries the attitude through the flight.
+ *
+ * While the rocket is on the pad the filter re-aligns on every sample at
+ * 1 g: tilt from the running mean of the accelerometer, heading zero, and
+ * the gyro bias from the mean rate, since the rocket is still. Handling
+ * and raising the rail are forgotten within AHRS_PAD_WINDOW samples.
+ * ahrs_set_on_pad() freezes that alignment at launch, as imu_calib.h does
+ * its coefficients. There is no magnetometer, so heading (yaw about earth
+ * z) is unobserved and only the gyro moves it; tilt and roll rate do not
+ * depend on it.
+ *
+ * The nose is taken to be the body axis closest to up when the filter
+ * last aligned, with the avionics at rest on the rail, so rail
+ * inclination shows up as tilt. Tilt is the angle between the nose and earth z, roll
+ * rate the bias-corrected rate about the nose.
+ *
+ * The quaternion is integrated to first order, which holds at IMU rates
+ * (25 mrad per sample at 10 rad/s and 400 Hz) but not over long gaps, so
+ * a step is capped at AHRS_DT_MAX.
+ */
+
+/* Tuning knobs */
+#define AHRS_KP 1.0f          // rad/s per unit error: about a 1 s time constant on the pad
+#define AHRS_KI 0.05f         // Gyro bias integral gain: a bias settles in about 20 s
+#define AHRS_ACCEL_GATE 0.1f  // Trust the accelerometer within this fraction of 1 g
+#define AHRS_BIAS_MAX 0.1f    // rad/s, clamp on each axis of the bias estimate
+#define AHRS_DT_MAX 0.05f     // s, longest step integrated in one go
+#define AHRS_PAD_WINDOW 512   // Pad running mean length, then exponential
+#define AHRS_G 9.80665f
+
+struct ahrs {
+    float q[4];         // w, x, y, z, body to earth
+    float bias[3];      // Gyro bias estimate, rad/s
+    float rate[3];      // Last bias-corrected gyro rate, rad/s
+    uint8_t nose;       // Body axis of the nose: 0 x, 1 y, 2 z
+    float nose_sign;    // +1 or -1 along that axis
+    bool aligned;       // Tilt taken from the accelerometer
+    bool corrected;     // The last sample's accelerometer was used
+    bool on_pad;        // Re-aligning from the pad means, until launch
+    float pad_accel[3]; // Running mean of the accelerometer on the pad, m/s²
+    uint32_t pad_count; // Samples in the pad means
+    int64_t last_us;    // Time of the last sample
+};
+
+/**
+ * @brief Start over: unaligned, no bias estimate, on the pad.
+ */
+void ahrs_init(struct ahrs *a);
+
+/**
+ * @brief Re-align on every sample at 1 g while on_pad, or freeze the
+ * alignment and let the gyro carry it. Returning to the pad starts the
+ * means over.
+ */
+void ahrs_set_on_pad(struct ahrs *a, bool on_pad);
+
+/**
+ * @brief Add one IMU sample.
+ * @param accel Calibrated acceleration in m/s²
+ * @param gyro Calibrated angular rate in rad/s
+ * @param timestamp_us Sample time
+ */
+void ahrs_update(struct ahrs *a, const float accel[3], const float gyro[3], int64_t timestamp_us);
+
+/**
+ * @brief Angle between the nose and vertical, in radians.
+ */
+float ahrs_tilt(const struct ahrs *a);
+
+/**
+ * @brief Bias-corrected angular rate about the nose from the last sample,
+ * in rad/s, right-handed about the nose.
+ */
+static inline float ahrs_roll_rate(const struct ahrs *a)
+{
+    return a->nose_sign * a->rate[a->nose];
+}
+
+#endif
@@ -0,0 +1,274 @@
+#include <math.h>
+#include <string.h>
+#include "altitude_kf.h"
+
+#define STANDARD_GRAVITY 9.80665f
+#define VERTICAL_ACCEL_MIN_SAMPLES 64 // Pad samples before up is trusted
+#define VERTICAL_ACCEL_WINDOW 512     // Running mean length, then exponential
+#define VERTICAL_ACCEL_G_TOLERANCE 0.2f
+
+void kf_hv_predict(kalman_hv_t *kf, float dt_s, float sigma_a)
+{
+    /* State prediction:
+       h = h + v*dt
+       v = v
+    */
+    kf->h = kf->h + kf->v * dt_s;
+
+    // F = [1 dt; 0 1]
+    float F00 = 1.0f, F01 = dt_s;
+    float F10 = 0.0f, F11 = 1.0f;
+
+    // Q = sigma_a^2 * [dt^4/4 dt^3/2; dt^3/2 dt^2]
+    float dt2 = dt_s * dt_s;
+    float dt3 = dt2 * dt_s;
+    float dt4 = dt2 * dt2;
+
+    float sa2 = sigma_a * sigma_a;
+    float Q00 = sa2 * (dt4 * 0.25f);
+    float Q01 = sa2 * (dt3 * 0.50f);
+    float Q10 = Q01;
+    float Q11 = sa2 * (dt2);
+
+    // P = F P F^T + Q
+
+    /* First compute FP = F*P */
+    float FP00 = F00 * kf->P00 + F01 * kf->P10;
+    float FP01 = F00 * kf->P01 + F01 * kf->P11;
+    float FP10 = F10 * kf->P00 + F11 * kf->P10;
+    float FP11 = F10 * kf->P01 + F11 * kf->P11;
+
+    // Then Pnew = FP * F^T
+    float P00 = FP00 * F00 + FP01 * F01;
+    float P01 = FP00 * F10 + FP01 * F11;
+    float P10 = FP10 * F00 + FP11 * F01;
+    float P11 = FP10 * F10 + FP11 * F11;
+
+    kf->P00 = P00 + Q00;
+    kf->P01 = P01 + Q01;
+    kf->P10 = P10 + Q10;
+    kf->P11 = P11 + Q11;
+}
+
+void kf_hv_update_baro(kalman_hv_t *kf, float z_alt, float R)
+{
+    // H = [1 0]
+
+    float y = z_alt - kf->h;
+    float S = kf->P00 + R;
+
+    if (S < 1e-9f) {
+        return;
+    }
+
+    // K = P H^T / S = [P00; P10] / S
+    float K0 = kf->P00 / S;
+    float K1 = kf->P10 / S;
+
+    // State update
+    kf->h = kf->h + K0 * y;
+    kf->v = kf->v + K1 * y;
+
+    /* Cov update: Joseph form for numeric stability
+       P = (I - K H) P (I - K H)^T + K R K^T
+       With H = [1 0].
+    */
+    float a00 = 1.0f - K0;
+    float a01 = 0.0f;
+    float a10 = -K1;
+    float a11 = 1.0f;
+
+    float AP00 = a00 * kf->P00 + a01 * kf->P10;
+    float AP01 = a00 * kf->P01 + a01 * kf->P11;
+    float AP10 = a10 * kf->P00 + a11 * kf->P10;
+    float AP11 = a10 * kf->P01 + a11 * kf->P11;
+
+    float P00 = AP00 * a00 + AP01 * a01 + K0 * K0 * R;
+    float P01 = AP00 * a10 + AP01 * a11 + K0 * K1 * R;
+    float P10 = AP10 * a00 + AP11 * a01 + K1 * K0 * R;
+    float P11 = AP10 * a10 + AP11 * a11 + K1 * K1 * R;
+
+    kf->P00 = P00;
+    kf->P01 = P01;
+    kf->P10 = P10;
+    kf->P11 = P11;
+}
+
+float kf_hv_nis(const kalman_hv_t *kf_pred, float z_alt, float R, float *out_y, float *out_S)
+{
+    float y = z_alt - kf_pred->h;
+    float S = kf_pred->P00 + R;
+
+    if (out_y) {
+        *out_y = y;
+    }
+    if (out_S) {
+        *out_S = S;
+    }
+
+    if (S < 1e-9f) {
+        return INFINITY;
+    }
+
+    return (y * y) / S;
+}
+
+void kf_hvb_init(kalman_hvb_t *kf, float h, float var_h)
+{
+    memset(kf, 0, sizeof(*kf));
+    kf->h = h;
+    kf->P[0][0] = var_h;
+    kf->P[1][1] = 100.0f; // As kalman_hv_t starts
+    kf->P[2][2] = 1.0f;   // Bias of a calibrated accelerometer, well within 1 m/s^2
+}
+
+void kf_hvb_predict(kalman_hvb_t *kf, float accel_up, float dt_s, float sigma_a,
+                    float sigma_bias)
+{
+    float dt2 = dt_s * dt_s;
+    float a = accel_up - kf->bias;
+
+    /* State prediction, acceleration held over dt:
+       h = h + v*dt + a*dt^2/2
+       v = v + a*dt
+       bias = bias
+    */
+    kf->h += kf->v * dt_s + 0.5f * a * dt2;
+    kf->v += a * dt_s;
+
+    // F = [1 dt -dt^2/2; 0 1 -dt; 0 0 1]
+    const float F[3][3] = {{1.0f, dt_s, -0.5f * dt2}, {0.0f, 1.0f, -dt_s}, {0.0f, 0.0f, 1.0f}};
+    float FP[3][3];
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            FP[i][j] = F[i][0] * kf->P[0][j] + F[i][1] * kf->P[1][j] + F[i][2] * kf->P[2][j];
+        }
+    }
+
+    // Q = sigma_a^2 G G^T with G = [dt^2/2; dt; 0], plus the bias random walk
+    const float G[3] = {0.5f * dt2, dt_s, 0.0f};
+    float sa2 = sigma_a * sigma_a;
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            kf->P[i][j] = FP[i][0] * F[j][0] + FP[i][1] * F[j][1] + FP[i][2] * F[j][2] +
+                          sa2 * G[i] * G[j];
+        }
+    }
+    kf->P[2][2] += sigma_bias * sigma_bias * fabsf(dt_s);
+}
+
+void kf_hvb_view(const kalman_hvb_t *kf, float accel_up, float lead_s, float sigma_a,
+                 kalman_hv_t *out)
+{
+    kalman_hvb_t ahead = *kf;
+
+    kf_hvb_predict(&ahead, accel_up, lead_s, sigma_a, 0.0f);
+
+    out->h = ahead.h;
+    out->v = ahead.v;
+    out->P00 = ahead.P[0][0];
+    out->P01 = ahead.P[0][1];
+    out->P10 = ahead.P[1][0];
+    out->P11 = ahead.P[1][1];
+}
+
+void kf_hvb_update_baro(kalman_hvb_t *kf, float z_alt, float R, float accel_up, float lead_s,
+                        float sigma_a)
+{
+    // The altitude lead_s ahead: h + v*L + (accel_up - bias)*L^2/2
+    float L2 = lead_s * lead_s;
+    const float H[3] = {1.0f, lead_s, -0.5f * L2};
+    float y = z_alt - (kf->h + kf->v * lead_s + 0.5f * (accel_up - kf->bias) * L2);
+
+    // The acceleration noise over the lead counts as measurement noise
+    float R_eff = R + sigma_a * sigma_a * 0.25f * L2 * L2;
+    float PHt[3];
+    float S = R_eff;
+
+    for (int i = 0; i < 3; i++) {
+        PHt[i] = kf->P[i][0] * H[0] + kf->P[i][1] * H[1] + kf->P[i][2] * H[2];
+        S += H[i] * PHt[i];
+    }
+
+    if (S < 1e-9f) {
+        return;
+    }
+
+    float K[3] = {PHt[0] / S, PHt[1] / S, PHt[2] / S};
+
+    kf->h += K[0] * y;
+    kf->v += K[1] * y;
+    kf->bias += K[2] * y;
+
+    /* Cov update: Joseph form for numeric stability
+       P = (I - K H) P (I - K H)^T + K R K^T
+    */
+    float A[3][3];
+    float AP[3][3];
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            A[i][j] = (i == j ? 1.0f : 0.0f) - K[i] * H[j];
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            AP[i][j] = A[i][0] * kf->P[0][j] + A[i][1] * kf->P[1][j] + A[i][2] * kf->P[2][j];
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            kf->P[i][j] = AP[i][0] * A[j][0] + AP[i][1] * A[j][1] + AP[i][2] * A[j][2] +
+                          K[i] * K[j] * R_eff;
+        }
+    }
+}
+
+void vertical_accel_init(struct vertical_accel *va)
+{
+    memset(va, 0, sizeof(*va));
+}
+
+void vertical_accel_observe(struct vertical_accel *va, const float accel[3])
+{
+    float norm = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+
+    if (fabsf(norm - STANDARD_GRAVITY) > VERTICAL_ACCEL_G_TOLERANCE * STANDARD_GRAVITY) {
+        return;
+    }
+
+    if (va->count < VERTICAL_ACCEL_WINDOW) {
+        va->count++;
+    }
+    for (int i = 0; i < 3; i++) {
+        va->mean[i] += (accel[i] - va->mean[i]) / (float)va->count;
+    }
+
+    // At rest the accelerometer reads the reaction to gravity, which points up
+    va->g = sqrtf(va->mean[0] * va->mean[0] + va->mean[1] * va->mean[1] +
+                  va->mean[2] * va->mean[2]);
+    if (va->g > 0.0f) {
+        for (int i = 0; i < 3; i++) {
+            va->up[i] = va->mean[i] / va->g;
+        }
+    }
+    va->valid = va->count >= VERTICAL_ACCEL_MIN_SAMPLES;
+}
+
+bool vertical_accel_get(const struct vertical_accel *va, const float accel[3], float *accel_up)
+{
+    return vertical_accel_get_up(va, accel, va->up, accel_up);
+}
+
+bool vertical_accel_get_up(const struct vertical_accel *va, const float accel[3],
+                           const float up[3], float *accel_up)
+{
+    if (!va->valid) {
+        return false;
+    }
+
+    *accel_up = accel[0] * up[0] + accel[1] * up[1] + accel[2] * up[2] - va->g;
+    return true;
+}
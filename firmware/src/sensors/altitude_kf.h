@@ -0,0 +1,145 @@
+#ifndef ALTITUDE_KF_H
+#define ALTITUDE_KF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Vertical Kalman filters for the baro thread.
+ *
+ * kalman_hv_t tracks altitude and vertical velocity from the barometer
+ * alone. Its constant-velocity model knows nothing about thrust or drag,
+ * so a large acceleration process noise has to stand in for them, and the
+ * velocity it reports lags and rings with the barometer noise.
+ *
+ * kalman_hvb_t adds the accelerometer as a control input. It is predicted
+ * through every IMU sample with the measured vertical acceleration, less a
+ * third state, the bias of that acceleration, which the barometer
+ * corrections estimate. The barometer then only has to correct drift, so
+ * the process noise is that of the accelerometer, not of the trajectory.
+ *
+ * The IMU arrives in bursts, so when a barometer sample is taken the
+ * filter is usually some milliseconds behind or ahead of it. Rather than
+ * stepping the filter to the barometer's time and losing the IMU samples
+ * in between, the measurement is applied across that lead: the altitude
+ * it is compared with is the filter's own extrapolated with the latest
+ * acceleration, and the filter stays on the IMU's clock.
+ *
+ * The vertical acceleration is the specific force projected on up, less
+ * gravity, both learnt while the rocket stands on the rail. With an
+ * attitude estimate up follows it through the flight; without one the
+ * pad's up is taken as fixed. What a pitch-over then adds is slow, and the
+ * bias state soaks most of it up: through a gravity turn off a 10 degree
+ * rail the tests see up to 0.8 m/s^2 of error, and about a quarter of a
+ * m/s more velocity error than a vertical flight.
+ */
+
+/* Tuning knobs */
+#define KF_SIGMA_A 340.0f    // m/s^2, process noise standard deviation of acceleration, baro only
+#define KF_SIGMA_ACCEL 2.0f  // m/s^2, accelerometer noise, vibration and attitude error
+#define KF_SIGMA_BIAS 0.05f  // m/s^2 per sqrt(s), drift of the vertical accelerometer bias
+
+typedef struct {
+    float h; // altitude estimate (m)
+    float v; // vertical velocity estimate (m/s)
+
+    /* Covariance matrix P:
+       [ P00 P01 ]
+       [ P10 P11 ] */
+    float P00;
+    float P01;
+    float P10;
+    float P11;
+} kalman_hv_t;
+
+typedef struct {
+    float h;    // altitude estimate (m)
+    float v;    // vertical velocity estimate (m/s)
+    float bias; // vertical accelerometer bias estimate (m/s^2)
+
+    float P[3][3]; // Covariance of (h, v, bias)
+} kalman_hvb_t;
+
+// Up direction in the IMU frame and local gravity, averaged on the pad
+struct vertical_accel {
+    float mean[3];
+    float up[3];
+    float g;
+    uint32_t count;
+    bool valid;
+};
+
+/**
+ * @brief Predict the baro-only filter by dt_s under a constant-velocity model.
+ */
+void kf_hv_predict(kalman_hv_t *kf, float dt_s, float sigma_a);
+
+/**
+ * @brief Correct the baro-only filter with an altitude of variance R.
+ */
+void kf_hv_update_baro(kalman_hv_t *kf, float z_alt, float R);
+
+/**
+ * @brief Normalised innovation squared of an altitude against a predicted
+ * state, so several barometers are judged against the same prediction.
+ */
+float kf_hv_nis(const kalman_hv_t *kf_pred, float z_alt, float R, float *out_y, float *out_S);
+
+/**
+ * @brief Start the IMU-aided filter at an altitude of variance var_h, at
+ * rest and with no bias.
+ */
+void kf_hvb_init(kalman_hvb_t *kf, float h, float var_h);
+
+/**
+ * @brief Predict the IMU-aided filter by dt_s.
+ * @param accel_up Measured vertical acceleration, gravity removed (m/s^2)
+ * @param sigma_a Noise of accel_up (m/s^2)
+ * @param sigma_bias Random walk of the bias (m/s^2 per sqrt(s))
+ */
+void kf_hvb_predict(kalman_hvb_t *kf, float accel_up, float dt_s, float sigma_a,
+                    float sigma_bias);
+
+/**
+ * @brief Altitude and velocity lead_s seconds from the filter's time, with
+ * accel_up held, as a baro-only filter state for NIS checks and publishing.
+ */
+void kf_hvb_view(const kalman_hvb_t *kf, float accel_up, float lead_s, float sigma_a,
+                 kalman_hv_t *out);
+
+/**
+ * @brief Correct the IMU-aided filter with an altitude of variance R taken
+ * lead_s seconds from the filter's time (negative if before it).
+ */
+void kf_hvb_update_baro(kalman_hvb_t *kf, float z_alt, float R, float accel_up, float lead_s,
+                        float sigma_a);
+
+/**
+ * @brief Forget the pad's up direction.
+ */
+void vertical_accel_init(struct vertical_accel *va);
+
+/**
+ * @brief Average in an accelerometer sample taken while the rocket is on
+ * the pad. Samples far from 1 g (handling, a knock on the rail) are left out.
+ */
+void vertical_accel_observe(struct vertical_accel *va, const float accel[3]);
+
+/**
+ * @brief Vertical acceleration from an accelerometer sample.
+ * @param accel_up Acceleration along the pad's up direction, gravity removed
+ * @return false until enough pad samples have been seen
+ */
+bool vertical_accel_get(const struct vertical_accel *va, const float accel[3], float *accel_up);
+
+/**
+ * @brief Vertical acceleration from an accelerometer sample, projected on
+ * up as an attitude estimate has it rather than on the pad's.
+ * @param up Earth up in the IMU's axes, a unit vector
+ * @param accel_up Acceleration along up, the pad's gravity removed
+ * @return false until enough pad samples have been seen
+ */
+bool vertical_accel_get_up(const struct vertical_accel *va, const float accel[3],
+                           const float up[3], float *accel_up);
+
+#endif
@@ -0,0 +1,123 @@
+#include <string.h>
+#include "baro_fusion.h"
+
+void baro_fusion_init(struct baro_fusion *f, const bool ready[BARO_COUNT])
+{
+    memset(f, 0, sizeof(*f));
+
+    for (int i = 0; i < BARO_COUNT; i++) {
+        f->sensor[i].present = ready[i];
+        f->sensor[i].healthy = ready[i];
+    }
+}
+
+/**
+ * @brief Count one reading against a barometer.
+ * @return true if it was demoted or promoted
+ */
+static bool baro_health_count(baro_health_t *h, bool good)
+{
+    bool was_healthy = h->healthy;
+
+    if (good) {
+        if (h->faults > 0) {
+            h->faults--;
+        }
+    } else if (h->faults < BARO_FAULT_MAX) {
+        h->faults++;
+    }
+
+    if (h->healthy && h->faults >= BARO_FAULT_LIMIT) {
+        h->healthy = false;
+    } else if (!h->healthy && h->faults == 0) {
+        h->healthy = true;
+    }
+
+    return h->healthy != was_healthy;
+}
+
+uint8_t baro_fusion_step(struct baro_fusion *f, const bool valid[BARO_COUNT],
+                         const float altitude[BARO_COUNT], const float R[BARO_COUNT],
+                         const float nis[BARO_COUNT], bool pass[BARO_COUNT],
+                         bool fuse[BARO_COUNT])
+{
+    uint8_t changed = 0;
+    bool any_fused = false;
+
+    for (int i = 0; i < BARO_COUNT; i++) {
+        pass[i] = valid[i] && nis[i] < BARO_NIS_GATE;
+        fuse[i] = false;
+    }
+
+    // Both barometers agree and the filter agrees with neither: the filter is off
+    if (valid[0] && valid[1] && !pass[0] && !pass[1]) {
+        float d = altitude[0] - altitude[1];
+
+        if (d * d / (R[0] + R[1]) < BARO_NIS_GATE) {
+            pass[0] = true;
+            pass[1] = true;
+        }
+    }
+
+    for (int i = 0; i < BARO_COUNT; i++) {
+        baro_health_t *h = &f->sensor[i];
+
+        if (!h->present) {
+            continue;
+        }
+        if (valid[i] && !pass[i]) {
+            h->rejected++;
+        }
+        if (baro_health_count(h, pass[i])) {
+            changed |= (uint8_t)(1U << i);
+        }
+
+        fuse[i] = h->healthy && pass[i];
+        any_fused |= fuse[i];
+    }
+
+    if (any_fused) {
+        f->unfused = 0;
+        return changed;
+    }
+
+    if (f->unfused < BARO_UNFUSED_LIMIT) {
+        f->unfused++;
+        return changed;
+    }
+
+    // Coasted too long: take the healthy barometers, or failing that the least faulty one
+    int best = -1;
+
+    for (int i = 0; i < BARO_COUNT; i++) {
+        if (!valid[i]) {
+            continue;
+        }
+        if (f->sensor[i].healthy) {
+            fuse[i] = true;
+            any_fused = true;
+        } else if (best < 0 || f->sensor[i].faults < f->sensor[best].faults) {
+            best = i;
+        }
+    }
+    if (!any_fused && best >= 0) {
+        fuse[best] = true;
+        any_fused = true;
+    }
+    if (any_fused) {
+        f->unfused = 0;
+    }
+
+    return changed;
+}
+
+int baro_fusion_primary(const struct baro_fusion *f, const bool valid[BARO_COUNT])
+{
+    for (int i = 0; i < BARO_COUNT; i++) {
+        if (valid[i] && f->sensor[i].healthy) {
+            return i;
+        }
+    }
+
+    return -1;
+}
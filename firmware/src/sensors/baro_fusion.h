@@ -0,0 +1,75 @@
+#ifndef BARO_FUSION_H
+#define BARO_FUSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Which barometer readings the altitude filter takes.
+ *
+ * Every reading is checked against the filter's prediction: one whose
+ * normalised innovation squared is above the chi-square gate is rejected
+ * and does not update the filter. The readings that pass update it one
+ * after the other, so with both barometers healthy the altitude noise is
+ * about 1/sqrt(2) of one.
+ *
+ * Each barometer has a leaky fault counter: up one for a failed read or a
+ * rejected reading, down one for a good reading. At BARO_FAULT_LIMIT the
+ * barometer is demoted and its readings are no longer fused, only checked;
+ * once good readings have brought the counter back to zero it is promoted
+ * again.
+ *
+ * Two cases are not the barometers' fault. If both read the same and the
+ * filter disagrees with both, the filter is off (a transient it was not
+ * told about) and both readings are taken. If no reading has been taken
+ * for BARO_UNFUSED_LIMIT steps, the filter is not left to coast on: the
+ * best barometer it has is taken regardless of the gate.
+ */
+
+/* Tuning knobs */
+#define BARO_NIS_GATE 10.83f   // Chi-square, 1 degree of freedom: 0.1 % of good readings rejected
+#define BARO_FAULT_LIMIT 10    // Faults that demote a barometer
+#define BARO_FAULT_MAX 20      // Counter ceiling, so a recovered barometer comes back in time
+#define BARO_UNFUSED_LIMIT 20  // Steps without a fused reading before the gate is bypassed
+
+#define BARO_COUNT 2
+
+typedef struct {
+    bool present;      // Ready at boot; an absent barometer is never counted against
+    bool healthy;      // Readings that pass the gate are fused
+    uint8_t faults;    // Leaky fault counter
+    uint32_t rejected; // Readings that failed the gate since boot
+} baro_health_t;
+
+struct baro_fusion {
+    baro_health_t sensor[BARO_COUNT];
+    uint16_t unfused; // Consecutive steps in which no reading was fused
+};
+
+/**
+ * @brief Start with the barometers that came up at boot healthy.
+ */
+void baro_fusion_init(struct baro_fusion *f, const bool ready[BARO_COUNT]);
+
+/**
+ * @brief Gate one step's readings and count them against each barometer.
+ * @param valid The barometer returned a reading
+ * @param altitude Altitude of each valid reading (m)
+ * @param R Measurement variance of each barometer (m^2)
+ * @param nis Each valid reading's NIS against the filter's prediction
+ * @param pass Set for readings that passed the gate (or were excused from it)
+ * @param fuse Set for readings that should update the filter
+ * @return bitmask of barometers demoted or promoted by this step
+ */
+uint8_t baro_fusion_step(struct baro_fusion *f, const bool valid[BARO_COUNT],
+                         const float altitude[BARO_COUNT], const float R[BARO_COUNT],
+                         const float nis[BARO_COUNT], bool pass[BARO_COUNT],
+                         bool fuse[BARO_COUNT]);
+
+/**
+ * @brief Index of the barometer to start the filter from: the first healthy
+ * one with a valid reading, or -1.
+ */
+int baro_fusion_primary(const struct baro_fusion *f, const bool valid[BARO_COUNT]);
+
+#endif
@@ -7,50 +7,65 @@
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/logging/log.h>
+#include <drivers/sensor/baro_altitude.h>
+#include <drivers/sensor/ms5611.h>
 
 #include "../data.h"
+#include "../periodic_task.h"
+#include "altitude_kf.h"
+#include "baro_fusion.h"
+#include "baro_thread.h"
+#include "sensor_bus.h"
+#include "sensor_decode.h"
 
 LOG_MODULE_REGISTER(baro_thread, LOG_LEVEL_INF);
 
 #define BARO_THREAD_STACK_SIZE 2048
 #define BARO_THREAD_PRIORITY 1
 
-#define BARO_THREAD_PERIOD_MS 30
+#define BARO_THREAD_PERIOD_MS CONFIG_FALCON_BARO_PERIOD_MS
+#ifdef CONFIG_FALCON_BARO_ADAPTIVE
+#define BARO_FAST_PERIOD_MS CONFIG_FALCON_BARO_FAST_PERIOD_MS
+#define BARO_MAX_PERIOD_MS MAX(BARO_THREAD_PERIOD_MS, BARO_FAST_PERIOD_MS)
+#else
+#define BARO_MAX_PERIOD_MS BARO_THREAD_PERIOD_MS
+#endif
 
 // Debug logging
 #define BARO_LOG_ENABLE 0
 
-/* Altitude conversion */
-#define P0_PA 101325.0f
-#define GAS_CONSTANT_AIR 287.05f
-#define GRAVITY 9.80665f
-
 /* Tuning knobs */
-#define KF_SIGMA_A 340.0f  // m/s^2, process noise standard deviation of acceleration
 #define BARO0_SIGMA_Z 1.5f // m, measurement noise standard deviation of altitude
 #define BARO1_SIGMA_Z 1.5f // m
+#define BARO_MACH_LOCK_R_SCALE 100.0f // Variance scale in mach lock, without the IMU
+
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+// IMU samples reach the history in FIFO bursts, the oldest this late
+#define KF_IMU_BURST_US                                                                           \
+    ((int64_t)CONFIG_FALCON_IMU_FIFO_WATERMARK * USEC_PER_SEC / CONFIG_FALCON_IMU_ODR_HZ)
+// Without IMU samples this long, fall back to KF_SIGMA_A: two bursts late plus 20 ms, and at
+// least 100 ms so the IMU thread's 50 ms polling fallback never trips it
+#define KF_IMU_TIMEOUT_US MAX(2 * KF_IMU_BURST_US + 20000, 100000)
+#define KF_IMU_BATCH 8
+
+// kf_imu_advance() drains the IMU history once a period; it has to last that long
+BUILD_ASSERT(CONFIG_FALCON_HISTORY_IMU >=
+                 CONFIG_FALCON_IMU_ODR_HZ * BARO_MAX_PERIOD_MS / MSEC_PER_SEC +
+                     CONFIG_FALCON_IMU_FIFO_WATERMARK,
+             "FALCON_HISTORY_IMU is shorter than a baro period at FALCON_IMU_ODR_HZ");
+#ifdef CONFIG_FALCON_AHRS
+// And the attitude of each sample alongside it
+BUILD_ASSERT(CONFIG_FALCON_HISTORY_ATTITUDE >=
+                 CONFIG_FALCON_IMU_ODR_HZ * BARO_MAX_PERIOD_MS / MSEC_PER_SEC +
+                     CONFIG_FALCON_IMU_FIFO_WATERMARK,
+             "FALCON_HISTORY_ATTITUDE is shorter than a baro period at FALCON_IMU_ODR_HZ");
+#endif
+#endif
 
-/* Safety limits for dt */
-#define KF_DT_MIN_S 0.001f
+/* Safety limits for dt (sample times are in microseconds, so only guards against repeats) */
+#define KF_DT_MIN_S 0.0001f
 #define KF_DT_MAX_S 0.200f
 
-typedef struct {
-    float h; // altitude estimate (m)
-    float v; // vertical velocity estimate (m/s)
-
-    /* Covariance matrix P:
-       [ P00 P01 ]
-       [ P10 P11 ] */
-    float P00;
-    float P01;
-    float P10;
-    float P11;
-} kalman_hv_t;
-
-typedef struct {
-    bool healthy;
-} baro_health_t;
-
 typedef struct {
     float pressure_pa;
     float altitude;
@@ -60,337 +75,650 @@ typedef struct {
     bool accepted;
 } baro_measurement_t;
 
+// One barometer's raw reading, before the filter sees it
+typedef struct {
+    float pressure_pa;
+    float altitude;
+    float temperature_c;
+    int64_t sample_us;
+    uint32_t read_cycles; // k_cycle_get_32() when the conversion was read out
+    bool valid;
+} baro_reading_t;
+
+// How the barometers are run in one flight phase
+struct baro_schedule {
+    uint16_t pressure_osr;
+    uint16_t temperature_osr;
+    uint8_t temperature_every; // Convert temperature on one read in this many
+    uint16_t period_ms;
+};
+
+#ifdef CONFIG_FALCON_BARO_ADAPTIVE
+/*
+ * Fine resolution on the pad, where the state machine averages the ground
+ * altitude and nothing moves. From launch until the main chute is out the
+ * state machine's checks count samples, so conversions are kept short and
+ * temperature, which hardly moves between samples, is read one time in
+ * eight: a pressure read then takes about 3 ms instead of 10 ms. Under the
+ * main chute the rate drops back to the normal period at 2048x, with
+ * temperature converted on one read in four.
+ */
+static const struct baro_schedule baro_schedules[] = {
+    [FLIGHT_STATE_STANDBY] = {4096, 4096, 1, BARO_THREAD_PERIOD_MS},
+    [FLIGHT_STATE_ASCENT] = {1024, 256, 8, BARO_FAST_PERIOD_MS},
+    [FLIGHT_STATE_MACH_LOCK] = {1024, 256, 8, BARO_FAST_PERIOD_MS},
+    [FLIGHT_STATE_DROGUE_DESCENT] = {1024, 256, 8, BARO_FAST_PERIOD_MS},
+    [FLIGHT_STATE_MAIN_DESCENT] = {2048, 2048, 4, BARO_THREAD_PERIOD_MS},
+    [FLIGHT_STATE_LANDED] = {4096, 4096, 1, BARO_THREAD_PERIOD_MS},
+};
+#endif
+
 K_THREAD_STACK_DEFINE(baro_stack, BARO_THREAD_STACK_SIZE);
 static struct k_thread baro_thread;
+static struct periodic_task baro_task;
+
+/**
+ * @brief Fill in a reading from pressure and temperature measured between
+ * start_us and end_us; the conversions run back to back in that window, so
+ * its middle is taken as the sample time.
+ * @return false for a nonsense pressure
+ */
+static bool baro_reading_set(baro_reading_t *r, float pressure_pa, float temperature_c,
+                             int64_t start_us, int64_t end_us)
+{
+    r->pressure_pa = pressure_pa;
+    r->temperature_c = temperature_c;
+    r->sample_us = start_us + (end_us - start_us) / 2;
+    r->read_cycles = k_cycle_get_32();
+
+    // Guard against nonsense pressure
+    if (!(pressure_pa > 1000.0f && pressure_pa < 200000.0f)) {
+        return false;
+    }
+
+    r->altitude = baro_altitude_m(pressure_pa, temperature_c);
+    return true;
+}
 
-static float pressure_temp_to_altitude(float pressure_pa, float temp_c)
+/**
+ * @brief Fill in a measurement and its NIS against the filter predicted to
+ * its sample time. Whether it is accepted is up to baro_fusion_step().
+ */
+static void assess_baro_measurement(const kalman_hv_t *kf_pred, float pressure_pa, float altitude,
+                                    float temperature_c, float R,
+                                    baro_measurement_t *out)
 {
-    float temp_k = temp_c + 273.15f;
-    return (GAS_CONSTANT_AIR * temp_k / GRAVITY) * logf(P0_PA / pressure_pa);
+    out->pressure_pa = pressure_pa;
+    out->altitude = altitude;
+    out->temperature_c = temperature_c;
+    out->valid = true;
+    out->nis = kf_hv_nis(kf_pred, altitude, R, NULL, NULL);
+    out->accepted = false;
 }
 
-static void kf_predict(kalman_hv_t *kf, float dt_s, float sigma_a)
+static void log_baro(const char *name, const baro_measurement_t *m, const baro_health_t *h)
 {
-    /* State prediction:
-       h = h + v*dt
-       v = v
-    */
-    kf->h = kf->h + kf->v * dt_s;
-
-    // F = [1 dt; 0 1]
-    float F00 = 1.0f, F01 = dt_s;
-    float F10 = 0.0f, F11 = 1.0f;
-
-    // Q = sigma_a^2 * [dt^4/4 dt^3/2; dt^3/2 dt^2]
-    float dt2 = dt_s * dt_s;
-    float dt3 = dt2 * dt_s;
-    float dt4 = dt2 * dt2;
-
-    float sa2 = sigma_a * sigma_a;
-    float Q00 = sa2 * (dt4 * 0.25f);
-    float Q01 = sa2 * (dt3 * 0.50f);
-    float Q10 = Q01;
-    float Q11 = sa2 * (dt2);
-
-    // P = F P F^T + Q
-
-    /* First compute FP = F*P */
-    float FP00 = F00 * kf->P00 + F01 * kf->P10;
-    float FP01 = F00 * kf->P01 + F01 * kf->P11;
-    float FP10 = F10 * kf->P00 + F11 * kf->P10;
-    float FP11 = F10 * kf->P01 + F11 * kf->P11;
-
-    // Then Pnew = FP * F^T
-    float P00 = FP00 * F00 + FP01 * F01;
-    float P01 = FP00 * F10 + FP01 * F11;
-    float P10 = FP10 * F00 + FP11 * F01;
-    float P11 = FP10 * F10 + FP11 * F11;
-
-    kf->P00 = P00 + Q00;
-    kf->P01 = P01 + Q01;
-    kf->P10 = P10 + Q10;
-    kf->P11 = P11 + Q11;
+#if !BARO_LOG_ENABLE
+    return;
+#endif
+    if (!m->valid) {
+        LOG_ERR("%s read failed", name);
+        return;
+    }
+
+    LOG_INF("%s: p=%.1f Pa | alt=%.2f m | T=%.2f C | nis=%.2f | healthy=%d | %s", name,
+            (double)m->pressure_pa, (double)m->altitude, (double)m->temperature_c, (double)m->nis,
+        h->healthy ? 1 : 0, m->accepted ? "ACCEPTED" : "REJECTED");
 }
 
-static void kf_update_baro(kalman_hv_t *kf, float z_alt, float R)
+// Filter and sensor state, shared by the baro thread and the cyclic executive
+static struct {
+    const struct device *baro0;
+    const struct device *baro1;
+    bool baro0_ready;
+    bool baro1_ready;
+    kalman_hv_t kf;
+    struct baro_fusion fusion;
+    bool kf_initialized;
+    int64_t last_sample_us; // Time of the last published sample, and of kf without the IMU
+    const struct baro_schedule *schedule;
+    uint8_t temperature_countdown; // Reads left until the next temperature conversion
+    bool blocking_only[2];         // Barometer has no non-blocking measurement API
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+    kalman_hvb_t kf_imu; // IMU-aided filter; kf is its view at the baro sample time
+    struct vertical_accel up;
+    struct data_cursor imu_cursor;
+    int64_t imu_us; // Time kf_imu has been predicted to
+    float accel_up; // Latest vertical acceleration, held past imu_us
+#ifdef CONFIG_FALCON_AHRS
+    struct data_cursor attitude_cursor;
+    struct attitude_data attitude;      // Newest attitude at or before the sample predicted
+    struct attitude_data attitude_next; // Read ahead, not yet reached
+    bool attitude_pending;
+#endif
+#endif
+} baro;
+
+bool baro_init(void)
 {
-    // H = [1 0]
+    baro.baro0 = DEVICE_DT_GET(DT_ALIAS(baro0));
+    baro.baro1 = DEVICE_DT_GET(DT_ALIAS(baro1));
 
-    float y = z_alt - kf->h;
-    float S = kf->P00 + R;
+    baro.baro0_ready = device_is_ready(baro.baro0);
+    baro.baro1_ready = device_is_ready(baro.baro1);
 
-    if (S < 1e-9f) {
-        return;
+    if (!baro.baro0_ready && !baro.baro1_ready) {
+        LOG_ERR("No barometers ready");
+        return false;
     }
 
-    // K = P H^T / S = [P00; P10] / S
-    float K0 = kf->P00 / S;
-    float K1 = kf->P10 / S;
-
-    // State update
-    kf->h = kf->h + K0 * y;
-    kf->v = kf->v + K1 * y;
+    if (!baro.baro0_ready) {
+        LOG_WRN("BARO0 not ready at startup; using BARO1 alone");
+    } else if (!baro.baro1_ready) {
+        LOG_WRN("BARO1 not ready at startup; using BARO0 alone");
+    } else {
+        LOG_INF("Fusing BARO0 and BARO1");
+    }
 
-    /* Cov update: Joseph form for numeric stability
-       P = (I - K H) P (I - K H)^T + K R K^T
-       With H = [1 0].
+    /* Filter init:
+       Start with altitude 0 and velocity 0.
+       P00 is how uncertain you are about altitude at boot.
+       P11 is how uncertain you are about velocity at boot.
     */
-    float a00 = 1.0f - K0;
-    float a01 = 0.0f;
-    float a10 = -K1;
-    float a11 = 1.0f;
-
-    float AP00 = a00 * kf->P00 + a01 * kf->P10;
-    float AP01 = a00 * kf->P01 + a01 * kf->P11;
-    float AP10 = a10 * kf->P00 + a11 * kf->P10;
-    float AP11 = a10 * kf->P01 + a11 * kf->P11;
-
-    float P00 = AP00 * a00 + AP01 * a01 + K0 * K0 * R;
-    float P01 = AP00 * a10 + AP01 * a11 + K0 * K1 * R;
-    float P10 = AP10 * a00 + AP11 * a01 + K1 * K0 * R;
-    float P11 = AP10 * a10 + AP11 * a11 + K1 * K1 * R;
-
-    kf->P00 = P00;
-    kf->P01 = P01;
-    kf->P10 = P10;
-    kf->P11 = P11;
+    baro.kf = (kalman_hv_t){
+        .h = 0.0f, .v = 0.0f, .P00 = 25.0f, .P01 = 0.0f, .P10 = 0.0f, .P11 = 100.0f};
+
+    const bool ready[BARO_COUNT] = {baro.baro0_ready, baro.baro1_ready};
+
+    baro_fusion_init(&baro.fusion, ready);
+
+    baro.kf_initialized = false;
+    baro.last_sample_us = data_timestamp_us();
+    baro.schedule = NULL;
+    baro.temperature_countdown = 0;
+    baro.blocking_only[0] = false;
+    baro.blocking_only[1] = false;
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+    vertical_accel_init(&baro.up);
+    data_cursor_init(DATA_TOPIC_IMU, &baro.imu_cursor);
+    baro.imu_us = baro.last_sample_us;
+    baro.accel_up = 0.0f;
+#ifdef CONFIG_FALCON_AHRS
+    data_cursor_init(DATA_TOPIC_ATTITUDE, &baro.attitude_cursor);
+    baro.attitude = (struct attitude_data){0};
+    baro.attitude_pending = false;
+#endif
+#endif
+    return true;
 }
 
-// Compute NIS using a provided predicted state (so both sensors are judged fairly)
-static float kf_compute_nis(const kalman_hv_t *kf_pred, float z_alt, float R, float *out_y,
-                            float *out_S)
+uint32_t baro_period_ms(void)
 {
-    float y = z_alt - kf_pred->h;
-    float S = kf_pred->P00 + R;
+    return baro.schedule ? baro.schedule->period_ms : BARO_THREAD_PERIOD_MS;
+}
 
-    if (out_y) {
-        *out_y = y;
+static void baro_set_oversampling(const struct device *dev, const struct baro_schedule *s)
+{
+    const struct sensor_value pressure_osr = {.val1 = s->pressure_osr};
+    const struct sensor_value temperature_osr = {.val1 = s->temperature_osr};
+
+    // Not every driver can change it (the simulated baro can't); keep its fixed setting
+    if (sensor_attr_set(dev, SENSOR_CHAN_PRESS, SENSOR_ATTR_OVERSAMPLING, &pressure_osr) < 0 ||
+        sensor_attr_set(dev, SENSOR_CHAN_AMBIENT_TEMP, SENSOR_ATTR_OVERSAMPLING,
+                        &temperature_osr) < 0) {
+        LOG_DBG("%s: oversampling not changed", dev->name);
     }
-    if (out_S) {
-        *out_S = S;
+}
+
+/**
+ * @brief Switch to the schedule for the current flight phase and decide
+ * whether this read converts temperature.
+ * @return true if temperature should be converted on this read
+ */
+static bool baro_schedule_step(flight_state_id_t state)
+{
+#ifdef CONFIG_FALCON_BARO_ADAPTIVE
+    const struct baro_schedule *s =
+        &baro_schedules[(unsigned int)state < ARRAY_SIZE(baro_schedules) ? state
+                                                                         : FLIGHT_STATE_STANDBY];
+
+    if (s != baro.schedule) {
+        if (baro.baro0_ready) {
+            baro_set_oversampling(baro.baro0, s);
+        }
+        if (baro.baro1_ready) {
+            baro_set_oversampling(baro.baro1, s);
+        }
+
+        LOG_INF("Baro schedule: OSR %u/%u, temperature every %u, %u ms", s->pressure_osr,
+                s->temperature_osr, s->temperature_every, s->period_ms);
+        baro.schedule = s;
+        // The last temperature was read at the old setting
+        baro.temperature_countdown = 0;
     }
 
-    if (S < 1e-9f) {
-        return INFINITY;
+    if (baro.temperature_countdown > 0) {
+        baro.temperature_countdown--;
+        return false;
     }
 
-    return (y * y) / S;
+    baro.temperature_countdown = s->temperature_every - 1;
+#else
+    ARG_UNUSED(state);
+#endif
+    return true;
 }
 
-static bool read_baro(const struct device *dev, float *pressure_pa, float *altitude,
-                      float *temperature_c)
+/**
+ * @brief Read both barometers. Those on the MS5611 driver convert in the
+ * background: they are started first and collected after the blocking reads
+ * of the others, so with one of each both are read in the time of one, and
+ * two MS5611s convert side by side. Blocking reads on separate buses also
+ * run at the same time. Without temperature, the MS5611s only convert
+ * pressure and reuse their last temperature; other drivers always convert
+ * both.
+ */
+static void read_baros(baro_reading_t out[2], bool temperature)
 {
-    struct sensor_value pressure;
-    struct sensor_value temperature;
+    const struct device *const devs[2] = {baro.baro0, baro.baro1};
+    const bool ready[2] = {baro.baro0_ready, baro.baro1_ready};
+    bool pending[2] = {false, false};
+    bool blocking[2] = {false, false};
+    int64_t start_us[2] = {0, 0};
+
+    for (int i = 0; i < 2; i++) {
+        out[i].valid = false;
+        if (!ready[i]) {
+            continue;
+        }
+        if (baro.blocking_only[i]) {
+            blocking[i] = true;
+            continue;
+        }
 
-    if (sensor_sample_fetch(dev) != 0) {
-        return false;
+        start_us[i] = data_timestamp_us();
+        sensor_bus_lock(SENSOR_BUS_BARO0 + i);
+        int ret = ms5611_measure_start(devs[i], temperature);
+        sensor_bus_unlock(SENSOR_BUS_BARO0 + i);
+
+        pending[i] = (ret == 0);
+        blocking[i] = !pending[i];
+        // Not an MS5611 on our driver; don't take its bus to ask again
+        baro.blocking_only[i] = (ret == -ENOTSUP);
     }
 
-    if (sensor_channel_get(dev, SENSOR_CHAN_PRESS, &pressure) != 0 ||
-        sensor_channel_get(dev, SENSOR_CHAN_AMBIENT_TEMP, &temperature) != 0) {
-        return false;
+    if (blocking[0] || blocking[1]) {
+        float p_hpa[2];
+        float temperature_c[2];
+        bool ok[2];
+        int64_t blocking_start_us = data_timestamp_us();
+
+        sensor_decode_baros(blocking, p_hpa, temperature_c, ok);
+
+        int64_t blocking_end_us = data_timestamp_us();
+
+        for (int i = 0; i < 2; i++) {
+            if (blocking[i] && ok[i]) {
+                // converting from hPa (sensor output) to Pa
+                out[i].valid = baro_reading_set(&out[i], p_hpa[i] * 100.0f, temperature_c[i],
+                                                blocking_start_us, blocking_end_us);
+            }
+        }
     }
 
-    // converting from hPa (sensor output) to Pa
-    float p_hpa = (float)sensor_value_to_double(&pressure);
-    float p_pa = p_hpa * 100.0f;
-    if (pressure_pa) {
-        *pressure_pa = p_pa;
+    while (pending[0] || pending[1]) {
+        uint32_t wait_us = UINT32_MAX;
+
+        for (int i = 0; i < 2; i++) {
+            int32_t pressure_pa;
+            int32_t temperature_cdeg;
+            uint32_t step_us;
+
+            if (!pending[i]) {
+                continue;
+            }
+
+            sensor_bus_lock(SENSOR_BUS_BARO0 + i);
+            int ret = ms5611_measure_poll(devs[i], &pressure_pa, &temperature_cdeg, &step_us);
+            sensor_bus_unlock(SENSOR_BUS_BARO0 + i);
+
+            if (ret == -EINPROGRESS) {
+                wait_us = MIN(wait_us, step_us);
+                continue;
+            }
+
+            pending[i] = false;
+            if (ret == 0) {
+                out[i].valid = baro_reading_set(&out[i], (float)pressure_pa,
+                                                (float)temperature_cdeg / 100.0f, start_us[i],
+                                                data_timestamp_us());
+            }
+        }
+
+        if (pending[0] || pending[1]) {
+            k_usleep(wait_us);
+        }
     }
-    *temperature_c = (float)sensor_value_to_double(&temperature);
+}
 
-    // Guard against nonsense pressure
-    if (!(p_pa > 1000.0f && p_pa < 200000.0f)) {
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+#ifdef CONFIG_FALCON_AHRS
+/**
+ * @brief Earth up in the IMU's axes from the attitude at t_us, the newest
+ * estimate not after it. The IMU thread publishes a sample's attitude just
+ * after the sample, so the newest one may be a sample old.
+ * @return false until the attitude is aligned
+ */
+static bool kf_attitude_up(int64_t t_us, float up[3])
+{
+    while (true) {
+        if (!baro.attitude_pending) {
+            if (get_attitude_history(&baro.attitude_cursor, &baro.attitude_next, 1) == 0) {
+                break;
+            }
+            baro.attitude_pending = true;
+        }
+        if (baro.attitude_next.timestamp_us > t_us) {
+            break;
+        }
+        baro.attitude = baro.attitude_next;
+        baro.attitude_pending = false;
+    }
+
+    if (!baro.attitude.aligned) {
         return false;
     }
 
-    *altitude = pressure_temp_to_altitude(p_pa, *temperature_c);
+    // Earth z in body axes, as in ahrs.c
+    const float *q = baro.attitude.q;
+
+    up[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    up[1] = 2.0f * (q[2] * q[3] + q[0] * q[1]);
+    up[2] = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
     return true;
 }
+#endif
 
-static void assess_baro_measurement(const kalman_hv_t *kf_pred, float pressure_pa, float altitude,
-                                    float temperature_c, float R,
-                                    baro_measurement_t *out)
+/**
+ * @brief Predict the IMU-aided filter through every IMU sample published
+ * since the last call, learning which way is up while on the pad. If the
+ * IMU has gone quiet, coast to the baro sample on the baro-only model.
+ */
+static void kf_imu_advance(int64_t sample_us, flight_state_id_t state)
 {
-    out->pressure_pa = pressure_pa;
-    out->altitude = altitude;
-    out->temperature_c = temperature_c;
-    out->valid = true;
+    struct imu_data batch[KF_IMU_BATCH];
+    uint32_t dropped = baro.imu_cursor.dropped;
+    size_t n;
+
+    while ((n = get_imu_history(&baro.imu_cursor, batch, ARRAY_SIZE(batch))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (state == FLIGHT_STATE_STANDBY) {
+                vertical_accel_observe(&baro.up, batch[i].accel);
+            }
+#ifdef CONFIG_FALCON_AHRS
+            // Up as the attitude has it through the pitch-over, the pad's until it aligns
+            float up[3];
+            bool known = kf_attitude_up(batch[i].timestamp_us, up)
+                             ? vertical_accel_get_up(&baro.up, batch[i].accel, up, &baro.accel_up)
+                             : vertical_accel_get(&baro.up, batch[i].accel, &baro.accel_up);
+#else
+            bool known = vertical_accel_get(&baro.up, batch[i].accel, &baro.accel_up);
+#endif
+
+            // Not yet known which way is up, or already coasted past this sample
+            if (!known || batch[i].timestamp_us <= baro.imu_us) {
+                continue;
+            }
+
+            float dt_s = MIN((float)(batch[i].timestamp_us - baro.imu_us) * 1e-6f, KF_DT_MAX_S);
+
+            if (baro.kf_initialized) {
+                kf_hvb_predict(&baro.kf_imu, baro.accel_up, dt_s, KF_SIGMA_ACCEL, KF_SIGMA_BIAS);
+            }
+            baro.imu_us = batch[i].timestamp_us;
+        }
+    }
+
+    if (baro.imu_cursor.dropped != dropped) {
+        LOG_WRN("IMU history overran: %u samples not seen by the KF",
+                (unsigned int)(baro.imu_cursor.dropped - dropped));
+    }
 
-    float nis = kf_compute_nis(kf_pred, altitude, R, NULL, NULL);
-    out->nis = nis;
+    if (sample_us - baro.imu_us > KF_IMU_TIMEOUT_US) {
+        float dt_s = CLAMP((float)(sample_us - baro.imu_us) * 1e-6f, KF_DT_MIN_S, KF_DT_MAX_S);
 
-    /* Never reject a valid reading due to NIS. This is because we have no great way to test rejection thresholds on the ground. Perhaps after the first launch of this system we can analyze NIS values and set a threshold for future flights, but for now we will log NIS but accept all valid readings. Essentially, we are relying on successive measurements and the Kalman filter to smooth out any bad readings for state transitions. */
-    out->accepted = true;
+        // Zero acceleration, with the baro-only filter's allowance for what it doesn't know
+        baro.accel_up = baro.kf_imu.bias;
+        if (baro.kf_initialized) {
+            kf_hvb_predict(&baro.kf_imu, baro.accel_up, dt_s, KF_SIGMA_A, KF_SIGMA_BIAS);
+        }
+        baro.imu_us = sample_us;
+    }
 }
+#endif
 
-static void log_baro(const char *name, const baro_measurement_t *m, const baro_health_t *h)
+/**
+ * @brief Start the filter at a barometer's altitude, taken at t_us.
+ */
+static void kf_start(float altitude, float R, int64_t t_us)
 {
-#if !BARO_LOG_ENABLE
-    return;
+    baro.kf = (kalman_hv_t){.h = altitude, .v = 0.0f, .P00 = R, .P01 = 0.0f, .P10 = 0.0f,
+                            .P11 = 100.0f};
+    baro.last_sample_us = t_us;
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+    kf_hvb_init(&baro.kf_imu, altitude, R);
 #endif
-    if (!m->valid) {
-        LOG_ERR("%s read failed", name);
-        return;
-    }
+    baro.kf_initialized = true;
+}
 
-    LOG_INF("%s: p=%.1f Pa | alt=%.2f m | T=%.2f C | nis=%.2f | healthy=%d | %s", name,
-            (double)m->pressure_pa, (double)m->altitude, (double)m->temperature_c, (double)m->nis,
-        h->healthy ? 1 : 0, m->accepted ? "ACCEPTED" : "REJECTED");
+/**
+ * @brief The filter's altitude and velocity at t_us, without moving it.
+ */
+static void kf_at(int64_t t_us, kalman_hv_t *out)
+{
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+    kf_hvb_view(&baro.kf_imu, baro.accel_up, (float)(t_us - baro.imu_us) * 1e-6f, KF_SIGMA_ACCEL,
+                out);
+#else
+    // Both barometers can be sampled in the same microsecond: nothing to predict then
+    float dt_s = CLAMP((float)(t_us - baro.last_sample_us) * 1e-6f, 0.0f, KF_DT_MAX_S);
+
+    *out = baro.kf;
+    if (dt_s > 0.0f) {
+        kf_hv_predict(out, dt_s, KF_SIGMA_A);
+    }
+#endif
 }
 
-static void baro_thread_fn(void *p1, void *p2, void *p3)
+/**
+ * @brief Correct the filter with one barometer's altitude, taken at t_us.
+ * Called in time order, so without the IMU the filter is predicted forward
+ * from one barometer's sample to the other's.
+ */
+static void kf_correct(int64_t t_us, float altitude, float R)
 {
-    const struct device *baro0 = DEVICE_DT_GET(DT_ALIAS(baro0));
-    const struct device *baro1 = DEVICE_DT_GET(DT_ALIAS(baro1));
-    bool using_baro0 = false;
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+    float lead_s = (float)(t_us - baro.imu_us) * 1e-6f;
+
+    kf_hvb_update_baro(&baro.kf_imu, altitude, R, baro.accel_up, lead_s, KF_SIGMA_ACCEL);
+#else
+    kf_at(t_us, &baro.kf);
+    baro.last_sample_us = t_us;
+    kf_hv_update_baro(&baro.kf, altitude, R);
+#endif
+}
 
-    bool baro0_ready = device_is_ready(baro0);
-    bool baro1_ready = device_is_ready(baro1);
+/**
+ * @brief One barometer's part of the published baro sample.
+ */
+static void baro_sensor_publish(const baro_measurement_t *m, const baro_health_t *h,
+                                struct baro_sensor_data *out)
+{
+    *out = (struct baro_sensor_data){.pressure = m->pressure_pa,
+                                     .altitude = m->altitude,
+                                     .temperature = m->temperature_c,
+                                     .nis = m->nis,
+                                     .faults = h->faults,
+                                     .healthy = h->healthy,
+                                     .fused = m->accepted,
+                                     .rejected = h->rejected};
+}
 
-    if (!baro0_ready && !baro1_ready) {
-        LOG_ERR("No barometers ready");
-        return;
+void baro_step(void)
+{
+    float R[BARO_COUNT] = {BARO0_SIGMA_Z * BARO0_SIGMA_Z, BARO1_SIGMA_Z * BARO1_SIGMA_Z};
+    kalman_hv_t *kf = &baro.kf;
+
+    // Flight phase picks the schedule; ground altitude is used for AGL below
+    struct state_data st;
+    get_state_data(&st);
+
+    // Transonic pressure is wrong, and both barometers are wrong together, so their
+    // agreeing proves nothing
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+    // The IMU carries the filter through mach lock, as in the nav thread
+    bool predict_only = st.state == FLIGHT_STATE_MACH_LOCK;
+#else
+    // The barometers are all there is to see the rocket slow for mach unlock
+    bool predict_only = false;
+
+    if (st.state == FLIGHT_STATE_MACH_LOCK) {
+        for (int i = 0; i < BARO_COUNT; i++) {
+            R[i] *= BARO_MACH_LOCK_R_SCALE;
+        }
     }
+#endif
 
-    if (baro0_ready) {
-        using_baro0 = true;
-        LOG_INF("Using BARO0 as primary barometer");
-    } else {
-        using_baro0 = false;
-        LOG_WRN("BARO0 not ready at startup; falling back to BARO1");
-    }
+    // Read both sensors first, so the filter is predicted to the time of each sample it uses
+    baro_reading_t readings[BARO_COUNT];
 
-    /* Filter init:
-       Start with altitude 0 and velocity 0.
-       P00 is how uncertain you are about altitude at boot.
-       P11 is how uncertain you are about velocity at boot.
-    */
-    kalman_hv_t kf = {.h = 0.0f, .v = 0.0f, .P00 = 25.0f, .P01 = 0.0f, .P10 = 0.0f, .P11 = 100.0f};
+    read_baros(readings, baro_schedule_step(st.state));
 
-    baro_health_t health_0 = {.healthy = baro0_ready};
-    baro_health_t health_1 = {.healthy = baro1_ready};
+    // The filter is published at the latest sample
+    bool valid[BARO_COUNT];
+    float altitude[BARO_COUNT];
+    int64_t sample_us = INT64_MIN;
+    // Start of the sample-to-deployment latency measurement: when that sample was read out
+    uint32_t acquired_cycles = 0;
 
-    bool kf_initialized = false;
+    for (int i = 0; i < BARO_COUNT; i++) {
+        valid[i] = readings[i].valid;
+        altitude[i] = readings[i].altitude;
+        if (valid[i] && readings[i].sample_us > sample_us) {
+            sample_us = readings[i].sample_us;
+            acquired_cycles = readings[i].read_cycles;
+        }
+    }
+    if (sample_us == INT64_MIN) {
+        sample_us = data_timestamp_us();
+        acquired_cycles = k_cycle_get_32();
+    }
 
-    const float R0 = BARO0_SIGMA_Z * BARO0_SIGMA_Z;
-    const float R1 = BARO1_SIGMA_Z * BARO1_SIGMA_Z;
+    float dt_s = (float)(sample_us - baro.last_sample_us) * 1e-6f;
 
-    int64_t last_ts_ms = k_uptime_get();
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+    // Predict through the IMU samples; the barometers are judged at their own time
+    kf_imu_advance(sample_us, st.state);
+#endif
 
-    while (1) {
-        int64_t now_ms = k_uptime_get();
-        float dt_s = (float)(now_ms - last_ts_ms) / 1000.0f;
-        last_ts_ms = now_ms;
+    if (!baro.kf_initialized) {
+        int primary = baro_fusion_primary(&baro.fusion, valid);
 
-        if (dt_s < KF_DT_MIN_S) {
-            dt_s = KF_DT_MIN_S;
+        if (primary >= 0) {
+            kf_start(altitude[primary], R[primary], readings[primary].sample_us);
         }
-        if (dt_s > KF_DT_MAX_S) {
-            dt_s = KF_DT_MAX_S;
+    }
+
+    // NIS of each reading against the prediction, before either updates the filter
+    baro_measurement_t measurements[BARO_COUNT] = {0};
+    float nis[BARO_COUNT] = {0.0f, 0.0f};
+
+    for (int i = 0; i < BARO_COUNT; i++) {
+        if (!valid[i]) {
+            continue;
         }
 
-        // Predict
-        kf_predict(&kf, dt_s, KF_SIGMA_A);
+        kalman_hv_t kf_pred;
 
-        // Snapshot predicted state for fair NIS checks
-        kalman_hv_t kf_pred = kf;
+        kf_at(readings[i].sample_us, &kf_pred);
+        assess_baro_measurement(&kf_pred, readings[i].pressure_pa, altitude[i],
+                                readings[i].temperature_c, R[i], &measurements[i]);
+        nis[i] = measurements[i].nis;
+    }
 
-        baro_measurement_t measurement_0 = {0};
-        baro_measurement_t measurement_1 = {0};
+    bool pass[BARO_COUNT];
+    bool fuse[BARO_COUNT] = {false, false};
 
-        // Read both sensors for telemetry publication (if they initialized ready)
-        float p0 = 0.0f, a0 = 0.0f, t0 = 0.0f;
-        float p1 = 0.0f, a1 = 0.0f, t1 = 0.0f;
+    if (baro.kf_initialized && !predict_only) {
+        uint8_t changed = baro_fusion_step(&baro.fusion, valid, altitude, R, nis, pass, fuse);
 
-        if (baro0_ready) {
-            bool valid_reading_0 = read_baro(baro0, &p0, &a0, &t0);
-            if (valid_reading_0) {
-                assess_baro_measurement(&kf_pred, p0, a0, t0, R0, &measurement_0);
-            } else {
-                measurement_0.valid = false;
+        for (int i = 0; i < BARO_COUNT; i++) {
+            if (changed & BIT(i)) {
+                LOG_WRN("BARO%d %s", i, baro.fusion.sensor[i].healthy ? "promoted" : "demoted");
             }
-        } else {
-            measurement_0.valid = false;
         }
+    }
 
-        if (baro1_ready) {
-            bool valid_reading_1 = read_baro(baro1, &p1, &a1, &t1);
-            if (valid_reading_1) {
-                assess_baro_measurement(&kf_pred, p1, a1, t1, R1, &measurement_1);
-            } else {
-                measurement_1.valid = false;
-            }
-        } else {
-            measurement_1.valid = false;
-        }
+    // Sequential updates, oldest sample first
+    int first = (valid[1] && (!valid[0] || readings[1].sample_us < readings[0].sample_us)) ? 1 : 0;
 
-        if (!kf_initialized) {
-            if (using_baro0 && measurement_0.valid) {
-                kf.h = measurement_0.altitude;
-                kf.v = 0.0f;
-                kf.P00 = R0;
-                kf.P01 = 0.0f;
-                kf.P10 = 0.0f;
-                kf.P11 = 100.0f;
-                kf_initialized = true;
-            } else if (!using_baro0 && measurement_1.valid) {
-                kf.h = measurement_1.altitude;
-                kf.v = 0.0f;
-                kf.P00 = R1;
-                kf.P01 = 0.0f;
-                kf.P10 = 0.0f;
-                kf.P11 = 100.0f;
-                kf_initialized = true;
-            }
-        }
+    for (int n = 0; n < BARO_COUNT; n++) {
+        int i = (first + n) % BARO_COUNT;
 
-        // Apply measurement update from only the selected barometer
-        if (using_baro0) {
-            if (measurement_0.valid && measurement_0.accepted) {
-                kf_update_baro(&kf, measurement_0.altitude, R0);
-            }
-        } else {
-            if (measurement_1.valid && measurement_1.accepted) {
-                kf_update_baro(&kf, measurement_1.altitude, R1);
-            }
+        measurements[i].accepted = fuse[i];
+        if (fuse[i]) {
+            kf_correct(readings[i].sample_us, altitude[i], R[i]);
         }
+    }
+
+    kf_at(sample_us, kf);
+    baro.last_sample_us = sample_us;
+
+    log_baro("BARO0", &measurements[0], &baro.fusion.sensor[0]);
+    log_baro("BARO1", &measurements[1], &baro.fusion.sensor[1]);
+
+    struct baro_data data = {.altitude = kf->h,
+                             .altitude_agl = st.ground_calibrated ? kf->h - st.ground_altitude : 0.0f,
+                             .alt_variance = kf->P00,
+                             .velocity = kf->v,
+                             .vel_variance = kf->P11,
+#ifdef CONFIG_FALCON_BARO_IMU_KF
+                             .accel_bias = baro.kf_imu.bias,
+#endif
+                             .timestamp = sample_us / USEC_PER_MSEC,
+                             .timestamp_us = sample_us,
+                             .acquired_cycles = acquired_cycles};
 
-        log_baro("BARO0", &measurement_0, &health_0);
-        log_baro("BARO1", &measurement_1, &health_1);
-
-        // Read ground altitude from state machine for AGL computation
-        struct state_data st;
-        get_state_data(&st);
-
-        struct baro_data data = {.baro0 = {.pressure = measurement_0.pressure_pa,
-                                           .altitude = measurement_0.altitude,
-                                           .temperature = measurement_0.temperature_c,
-                                           .nis = measurement_0.nis,
-                                           .faults = 0,
-                                           .healthy = health_0.healthy},
-                                 .baro1 = {.pressure = measurement_1.pressure_pa,
-                                           .altitude = measurement_1.altitude,
-                                           .temperature = measurement_1.temperature_c,
-                                           .nis = measurement_1.nis,
-                                           .faults = 0,
-                                           .healthy = health_1.healthy},
-                                 .altitude = kf.h,
-                                 .altitude_agl = st.ground_calibrated ? kf.h - st.ground_altitude : 0.0f,
-                                 .alt_variance = kf.P00,
-                                 .velocity = kf.v,
-                                 .vel_variance = kf.P11,
-                                 .timestamp = now_ms};
-
-        set_baro_data(&data);
+    baro_sensor_publish(&measurements[0], &baro.fusion.sensor[0], &data.baro0);
+    baro_sensor_publish(&measurements[1], &baro.fusion.sensor[1], &data.baro1);
+    set_baro_data(&data);
 
 #if BARO_LOG_ENABLE
-        LOG_INF("KF: h=%.2f m | v=%.2f m/s | P_h=%.3f | P_v=%.3f | dt=%.3f", (double)kf.h,
-                (double)kf.v, (double)kf.P00, (double)kf.P11, (double)dt_s);
+    LOG_INF("KF: h=%.2f m | v=%.2f m/s | P_h=%.3f | P_v=%.3f | dt=%.3f", (double)kf->h,
+            (double)kf->v, (double)kf->P00, (double)kf->P11, (double)dt_s);
+#else
+    ARG_UNUSED(dt_s);
 #endif
+}
+
+static void baro_thread_fn(void *p1, void *p2, void *p3)
+{
+    if (!baro_init()) {
+        return;
+    }
 
-        k_sleep(K_MSEC(BARO_THREAD_PERIOD_MS));
+    uint32_t period_ms = BARO_THREAD_PERIOD_MS;
+
+    periodic_task_init(&baro_task, "baro", period_ms);
+
+    while (1) {
+        periodic_task_wait(&baro_task);
+        baro_step();
+
+        if (baro_period_ms() != period_ms) {
+            period_ms = baro_period_ms();
+            periodic_task_set_period(&baro_task, period_ms);
+        }
     }
 }
 
@@ -398,4 +726,5 @@ void start_baro_thread(void)
 {
     k_thread_create(&baro_thread, baro_stack, K_THREAD_STACK_SIZEOF(baro_stack), baro_thread_fn,
                     NULL, NULL, NULL, BARO_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&baro_thread, "baro");
 }
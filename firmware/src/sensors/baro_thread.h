@@ -1,8 +1,28 @@
 #ifndef BARO_THREAD_H
 #define BARO_THREAD_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 void start_baro_thread();
 
+/**
+ * @brief Check the barometers and reset the altitude filter.
+ * Called by start_baro_thread(); call directly when driving baro_step()
+ * from the cyclic executive instead.
+ * @return false if no barometer is ready
+ */
+bool baro_init(void);
+
+/**
+ * @brief Read both barometers, run one KF predict/update and publish baro_data.
+ */
+void baro_step(void);
+
+/**
+ * @brief Period the current flight phase wants baro_step() run at, in ms.
+ * The baro thread and the cyclic executive both follow it.
+ */
+uint32_t baro_period_ms(void);
+
 #endif
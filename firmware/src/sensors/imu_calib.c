@@ -0,0 +1,242 @@
+#include <math.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+#include "imu_calib.h"
+
+#if defined(CONFIG_CMSIS_DSP_BASICMATH) && defined(CONFIG_CMSIS_DSP_MATRIX)
+#include <arm_math.h>
+#define IMU_CALIB_CMSIS 1
+#endif
+
+static const float identity[9] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+
+void imu_calib_init(struct imu_calib *cal)
+{
+    memset(cal, 0, sizeof(*cal));
+    cal->pose = -1;
+    memcpy(cal->coef.accel_matrix, identity, sizeof(identity));
+}
+
+void imu_calib_drop_window(struct imu_calib *cal)
+{
+    cal->window.n = 0;
+}
+
+static void welford_add(struct imu_calib_welford *w, const float accel[3], const float gyro[3])
+{
+    float inv_n = 1.0f / (float)(++w->n);
+
+    for (int i = 0; i < 6; i++) {
+        float x = (i < 3) ? accel[i] : gyro[i - 3];
+        float delta = x - w->mean[i];
+
+        w->mean[i] += delta * inv_n;
+        w->m2[i] += delta * (x - w->mean[i]);
+    }
+}
+
+/**
+ * @brief Fold a window mean into a running mean of up to
+ * IMU_CALIB_MAX_WINDOWS windows.
+ */
+static void running_mean_add(float mean[3], uint32_t *count, const float x[3])
+{
+    if (*count < IMU_CALIB_MAX_WINDOWS) {
+        (*count)++;
+    }
+
+    float inv_n = 1.0f / (float)*count;
+
+    for (int i = 0; i < 3; i++) {
+        mean[i] += (x[i] - mean[i]) * inv_n;
+    }
+}
+
+static float norm_sq(const float v[3])
+{
+    return v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+}
+
+/**
+ * @brief Invert a row-major 3x3 matrix.
+ * @return false if it is too close to singular
+ */
+static bool invert3(const float m[9], float inv[9])
+{
+    float c00 = m[4] * m[8] - m[5] * m[7];
+    float c01 = m[5] * m[6] - m[3] * m[8];
+    float c02 = m[3] * m[7] - m[4] * m[6];
+    float det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+
+    if (fabsf(det) < 1e-3f) {
+        return false;
+    }
+
+    float inv_det = 1.0f / det;
+
+    inv[0] = c00 * inv_det;
+    inv[1] = (m[2] * m[7] - m[1] * m[8]) * inv_det;
+    inv[2] = (m[1] * m[5] - m[2] * m[4]) * inv_det;
+    inv[3] = c01 * inv_det;
+    inv[4] = (m[0] * m[8] - m[2] * m[6]) * inv_det;
+    inv[5] = (m[2] * m[3] - m[0] * m[5]) * inv_det;
+    inv[6] = c02 * inv_det;
+    inv[7] = (m[1] * m[6] - m[0] * m[7]) * inv_det;
+    inv[8] = (m[0] * m[4] - m[1] * m[3]) * inv_det;
+    return true;
+}
+
+/**
+ * @brief Accelerometer offset and correction matrix from the orientations
+ * seen so far (see imu_calib.h).
+ */
+static void solve_accel(struct imu_calib *cal)
+{
+    float sens[9] = {0};
+    float offset[3] = {0};
+    bool paired[3];
+    int pairs = 0;
+
+    for (int axis = 0; axis < 3; axis++) {
+        const float *up = cal->pose_mean[2 * axis];
+        const float *down = cal->pose_mean[2 * axis + 1];
+
+        paired[axis] = cal->pose_windows[2 * axis] > 0 && cal->pose_windows[2 * axis + 1] > 0;
+        if (!paired[axis]) {
+            continue;
+        }
+
+        for (int j = 0; j < 3; j++) {
+            offset[j] += 0.5f * (up[j] + down[j]);
+            sens[j * 3 + axis] = (up[j] - down[j]) * (0.5f / IMU_CALIB_G);
+        }
+        pairs++;
+    }
+
+    if (pairs > 0) {
+        for (int j = 0; j < 3; j++) {
+            offset[j] /= (float)pairs;
+        }
+    }
+
+    // Axes without a pair: nominal, at the scale that makes the current pose read 1 g
+    const float *rest = cal->pose_mean[cal->pose];
+    float centred[3] = {rest[0] - offset[0], rest[1] - offset[1], rest[2] - offset[2]};
+    float scale = sqrtf(norm_sq(centred)) / IMU_CALIB_G;
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (!paired[axis]) {
+            sens[axis * 3 + axis] = scale;
+        }
+    }
+
+    if (invert3(sens, cal->coef.accel_matrix)) {
+        memcpy(cal->coef.accel_offset, offset, sizeof(offset));
+    }
+}
+
+/**
+ * @brief Judge the finished window and, if the IMU was still, fold it in.
+ * @return true if the coefficients changed
+ */
+static bool close_window(struct imu_calib *cal, int64_t timestamp_us)
+{
+    const struct imu_calib_welford *w = &cal->window;
+    float var_scale = 1.0f / (float)(w->n - 1);
+    float accel_var = 0.0f;
+    float gyro_var = 0.0f;
+
+    for (int i = 0; i < 3; i++) {
+        accel_var = MAX(accel_var, w->m2[i] * var_scale);
+        gyro_var = MAX(gyro_var, w->m2[i + 3] * var_scale);
+    }
+
+    const float *accel = &w->mean[0];
+    const float *gyro = &w->mean[3];
+    float g_sq = norm_sq(accel);
+
+    if (accel_var > IMU_CALIB_ACCEL_STILL * IMU_CALIB_ACCEL_STILL ||
+        gyro_var > IMU_CALIB_GYRO_STILL * IMU_CALIB_GYRO_STILL ||
+        norm_sq(gyro) > IMU_CALIB_GYRO_MAX * IMU_CALIB_GYRO_MAX ||
+        g_sq < (1.0f - IMU_CALIB_GRAVITY_TOL) * (1.0f - IMU_CALIB_GRAVITY_TOL) * IMU_CALIB_G *
+                   IMU_CALIB_G ||
+        g_sq > (1.0f + IMU_CALIB_GRAVITY_TOL) * (1.0f + IMU_CALIB_GRAVITY_TOL) * IMU_CALIB_G *
+                   IMU_CALIB_G) {
+        return false;
+    }
+
+    running_mean_add(cal->gyro_mean, &cal->gyro_windows, gyro);
+
+    // Orientation: the axis gravity is mostly along, and which way
+    int axis = 0;
+
+    for (int i = 1; i < 3; i++) {
+        if (fabsf(accel[i]) > fabsf(accel[axis])) {
+            axis = i;
+        }
+    }
+
+    int pose = 2 * axis + (accel[axis] < 0.0f ? 1 : 0);
+    float *pose_mean = cal->pose_mean[pose];
+    float moved[3] = {accel[0] - pose_mean[0], accel[1] - pose_mean[1],
+                      accel[2] - pose_mean[2]};
+
+    // A pose revisited at a different tilt is a new pose, not more of the old one
+    if (norm_sq(moved) > IMU_CALIB_POSE_MOVED * IMU_CALIB_POSE_MOVED) {
+        cal->pose_windows[pose] = 0;
+        memset(pose_mean, 0, sizeof(cal->pose_mean[pose]));
+    }
+    running_mean_add(pose_mean, &cal->pose_windows[pose], accel);
+    cal->pose = pose;
+
+    struct imu_calib_data *coef = &cal->coef;
+
+    memcpy(coef->gyro_bias, cal->gyro_mean, sizeof(coef->gyro_bias));
+    solve_accel(cal);
+    coef->gyro_noise = sqrtf(gyro_var);
+    coef->accel_noise = sqrtf(accel_var);
+    coef->windows++;
+    coef->poses |= (uint8_t)BIT(pose);
+    coef->valid = coef->windows >= IMU_CALIB_MIN_WINDOWS;
+    coef->timestamp_us = timestamp_us;
+    coef->timestamp = timestamp_us / 1000;
+    return true;
+}
+
+bool imu_calib_add(struct imu_calib *cal, const float accel[3], const float gyro[3],
+                   int64_t timestamp_us)
+{
+    welford_add(&cal->window, accel, gyro);
+    if (cal->window.n < IMU_CALIB_WINDOW) {
+        return false;
+    }
+
+    bool changed = close_window(cal, timestamp_us);
+
+    memset(&cal->window, 0, sizeof(cal->window));
+    return changed;
+}
+
+void imu_calib_apply(const struct imu_calib_data *coef, float accel[3], float gyro[3])
+{
+    float centred[3];
+
+#ifdef IMU_CALIB_CMSIS
+    const arm_matrix_instance_f32 matrix = {
+        .numRows = 3, .numCols = 3, .pData = (float32_t *)coef->accel_matrix};
+
+    arm_sub_f32(accel, coef->accel_offset, centred, 3);
+    arm_mat_vec_mult_f32(&matrix, centred, accel);
+    arm_sub_f32(gyro, coef->gyro_bias, gyro, 3);
+#else
+    const float *m = coef->accel_matrix;
+
+    for (int i = 0; i < 3; i++) {
+        centred[i] = accel[i] - coef->accel_offset[i];
+        gyro[i] -= coef->gyro_bias[i];
+    }
+    for (int i = 0; i < 3; i++) {
+        accel[i] = m[i * 3] * centred[0] + m[i * 3 + 1] * centred[1] + m[i * 3 + 2] * centred[2];
+    }
+#endif
+}
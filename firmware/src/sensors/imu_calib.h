@@ -0,0 +1,90 @@
+#ifndef IMU_CALIB_H
+#define IMU_CALIB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../data.h"
+
+/*
+ * On-pad IMU calibration.
+ *
+ * Raw samples are taken in windows of IMU_CALIB_WINDOW. A window keeps a
+ * running mean and sum of squared deviations per axis (Welford), so it
+ * costs the same memory however long it is. A window in which both
+ * sensors were still (standard deviation under IMU_CALIB_GYRO_STILL and
+ * IMU_CALIB_ACCEL_STILL, no steady rotation, about 1 g) is folded into the
+ * estimate as one more sample of a running mean; any other window is
+ * dropped.
+ *
+ * - Gyro bias: the mean rate over the stationary windows
+ * - Accelerometer: a mean per orientation the IMU has rested in, told
+ *   apart by which axis points up. A pair of opposite orientations gives
+ *   the offset (half their sum) and one column of the sensitivity matrix,
+ *   scale and cross-axis terms (half their difference over g), as in a
+ *   six-position calibration. Axes without a pair keep a nominal column,
+ *   scaled so the current orientation reads 1 g. The correction matrix is
+ *   the inverse of the sensitivity matrix.
+ *
+ * On the pad the rocket rests in one orientation, so what is observable
+ * there is the gyro bias and one overall scale; offset and misalignment
+ * need the avionics turned through each face, a few seconds per face in
+ * STANDBY, and only last until the next power-up. The tilt of the rail is
+ * real attitude and is left in.
+ *
+ * After IMU_CALIB_MAX_WINDOWS stationary windows older ones fade out, so a
+ * gyro bias that drifts as the avionics warm up on the pad is followed.
+ */
+
+#define IMU_CALIB_WINDOW 128        // Samples per window
+#define IMU_CALIB_MIN_WINDOWS 8     // Stationary windows before the gyro bias is valid
+#define IMU_CALIB_MAX_WINDOWS 256   // Windows the running means average over at most
+#define IMU_CALIB_GYRO_STILL 0.02f  // rad/s, per-axis standard deviation
+#define IMU_CALIB_ACCEL_STILL 0.15f // m/s², per-axis standard deviation
+#define IMU_CALIB_GYRO_MAX 0.05f    // rad/s, a steadier mean rate than this is rotation
+#define IMU_CALIB_GRAVITY_TOL 0.2f  // Still windows read 1 g within this fraction
+#define IMU_CALIB_POSE_MOVED 0.5f   // m/s², a pose that moved this far starts over
+#define IMU_CALIB_G 9.80665f
+
+// Running mean and sum of squared deviations, accel x/y/z then gyro x/y/z
+struct imu_calib_welford {
+    uint32_t n;
+    float mean[6];
+    float m2[6];
+};
+
+struct imu_calib {
+    struct imu_calib_welford window;
+    float gyro_mean[3];
+    uint32_t gyro_windows; // Windows in gyro_mean, capped at IMU_CALIB_MAX_WINDOWS
+    float pose_mean[IMU_CALIB_POSE_COUNT][3];
+    uint32_t pose_windows[IMU_CALIB_POSE_COUNT];
+    int pose; // Orientation of the last stationary window, -1 before the first
+    struct imu_calib_data coef;
+};
+
+/**
+ * @brief Start over: no windows, identity correction.
+ */
+void imu_calib_init(struct imu_calib *cal);
+
+/**
+ * @brief Add one raw sample. At the end of each window that was stationary
+ * the coefficients in cal->coef are recomputed.
+ * @param timestamp_us Sample time, stamped on the coefficients
+ * @return true if cal->coef changed
+ */
+bool imu_calib_add(struct imu_calib *cal, const float accel[3], const float gyro[3],
+                   int64_t timestamp_us);
+
+/**
+ * @brief Throw away the window in progress, e.g. when sampling stops.
+ */
+void imu_calib_drop_window(struct imu_calib *cal);
+
+/**
+ * @brief Correct a sample in place: accel = M (accel - offset),
+ * gyro = gyro - bias. Uses CMSIS-DSP when it is enabled.
+ */
+void imu_calib_apply(const struct imu_calib_data *coef, float accel[3], float gyro[3]);
+
+#endif
@@ -0,0 +1,126 @@
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include "imu_decimate.h"
+
+// Time an output trails the newest input it covers
+#define IMU_DECIMATE_DELAY_US                                                                     \
+    ((int64_t)(IMU_DECIMATE_TAPS - 1) * USEC_PER_SEC / (2 * CONFIG_FALCON_IMU_ODR_HZ))
+
+static float taps[IMU_DECIMATE_TAPS];
+static bool taps_ready;
+
+/**
+ * @brief Hamming-windowed sinc, -6 dB at 0.4 / IMU_DECIMATE_FACTOR cycles per
+ * input sample, normalised to unity gain at DC.
+ */
+static void design_taps(void)
+{
+    const float cutoff = 0.4f / IMU_DECIMATE_FACTOR;
+    const float centre = 0.5f * (IMU_DECIMATE_TAPS - 1);
+    const float pi = 3.14159265f;
+    float sum = 0.0f;
+
+    for (int i = 0; i < IMU_DECIMATE_TAPS; i++) {
+        float t = (float)i - centre;
+        float sinc = (t == 0.0f) ? 2.0f * cutoff : sinf(2.0f * pi * cutoff * t) / (pi * t);
+        float window = 0.54f - 0.46f * cosf(2.0f * pi * (float)i / (IMU_DECIMATE_TAPS - 1));
+
+        taps[i] = sinc * window;
+        sum += taps[i];
+    }
+
+    for (int i = 0; i < IMU_DECIMATE_TAPS; i++) {
+        taps[i] /= sum;
+    }
+    taps_ready = true;
+}
+
+const float *imu_decimate_taps(void)
+{
+    if (!taps_ready) {
+        design_taps();
+    }
+    return taps;
+}
+
+void imu_decimate_init(struct imu_decimator *dec)
+{
+    imu_decimate_taps();
+    memset(dec, 0, sizeof(*dec));
+
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+    // CMSIS wants the taps time-reversed; they are symmetric, so these are
+    for (int ch = 0; ch < IMU_DECIMATE_CHANNELS; ch++) {
+        arm_fir_decimate_init_f32(&dec->fir[ch], IMU_DECIMATE_TAPS, IMU_DECIMATE_FACTOR, taps,
+                                  dec->state[ch], IMU_DECIMATE_BLOCK);
+    }
+#endif
+}
+
+/**
+ * @brief Filter and decimate one block of one channel.
+ */
+static void filter_block(struct imu_decimator *dec, int ch, float *out)
+{
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+    arm_fir_decimate_f32(&dec->fir[ch], dec->in[ch], out, IMU_DECIMATE_BLOCK);
+#else
+    float *x = dec->history[ch];
+
+    memcpy(&x[IMU_DECIMATE_TAPS - 1], dec->in[ch], sizeof(dec->in[ch]));
+
+    // Output j covers inputs up to block index (j + 1) * FACTOR - 1
+    for (int j = 0; j < IMU_DECIMATE_OUTPUTS; j++) {
+        const float *newest = &x[IMU_DECIMATE_TAPS - 1 + (j + 1) * IMU_DECIMATE_FACTOR - 1];
+        float acc = 0.0f;
+
+        for (int k = 0; k < IMU_DECIMATE_TAPS; k++) {
+            acc += taps[k] * newest[-k];
+        }
+        out[j] = acc;
+    }
+
+    memmove(x, &x[IMU_DECIMATE_BLOCK], (IMU_DECIMATE_TAPS - 1) * sizeof(x[0]));
+#endif
+}
+
+int imu_decimate_add(struct imu_decimator *dec, const float accel[3], const float gyro[3],
+                     int64_t timestamp_us, struct imu_data *out)
+{
+    uint32_t i = dec->fill;
+
+    for (int axis = 0; axis < 3; axis++) {
+        dec->in[axis][i] = accel[axis];
+        dec->in[axis + 3][i] = gyro[axis];
+    }
+    if ((i + 1) % IMU_DECIMATE_FACTOR == 0) {
+        dec->out_us[i / IMU_DECIMATE_FACTOR] = timestamp_us;
+    }
+
+    if (++dec->fill < IMU_DECIMATE_BLOCK) {
+        return 0;
+    }
+    dec->fill = 0;
+
+    float filtered[IMU_DECIMATE_OUTPUTS];
+
+    for (int ch = 0; ch < IMU_DECIMATE_CHANNELS; ch++) {
+        filter_block(dec, ch, filtered);
+        for (int j = 0; j < IMU_DECIMATE_OUTPUTS; j++) {
+            if (ch < 3) {
+                out[j].accel[ch] = filtered[j];
+            } else {
+                out[j].gyro[ch - 3] = filtered[j];
+            }
+        }
+    }
+
+    for (int j = 0; j < IMU_DECIMATE_OUTPUTS; j++) {
+        out[j].timestamp_us = dec->out_us[j] - IMU_DECIMATE_DELAY_US;
+        out[j].timestamp = out[j].timestamp_us / USEC_PER_MSEC;
+        out[j].seq = 0;
+    }
+
+    return IMU_DECIMATE_OUTPUTS;
+}
@@ -0,0 +1,73 @@
+#ifndef IMU_DECIMATE_H
+#define IMU_DECIMATE_H
+
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+#include "../data.h"
+
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+#include <arm_math.h>
+#endif
+
+/*
+ * Anti-alias filter and decimator for the IMU stream.
+ *
+ * The IMU is sampled at CONFIG_FALCON_IMU_ODR_HZ and every sample goes to
+ * the IMU topic for logging. For estimation the six channels are low-pass
+ * filtered and kept one sample in IMU_DECIMATE_FACTOR, so vibration above
+ * the output rate's Nyquist frequency is attenuated rather than folded into
+ * the band the estimators use.
+ *
+ * The filter is a linear-phase FIR of IMU_DECIMATE_TAPS taps, a Hamming
+ * windowed sinc with its -6 dB point at 80 % of the output Nyquist
+ * frequency and unity gain at DC. Samples are collected into blocks of
+ * IMU_DECIMATE_BLOCK (the FIFO watermark rounded up to a whole number of
+ * outputs) and each block is filtered in one call per channel, with
+ * CMSIS-DSP's arm_fir_decimate_f32 when it is enabled: only the kept
+ * outputs are computed, IMU_DECIMATE_TAPS multiply-adds per channel each.
+ *
+ * A filtered sample is stamped with the time it represents: the newest
+ * input it covers, less the filter's group delay of
+ * (IMU_DECIMATE_TAPS - 1) / 2 input periods.
+ */
+
+#define IMU_DECIMATE_FACTOR CONFIG_FALCON_IMU_DECIMATION
+#define IMU_DECIMATE_TAPS (16 * IMU_DECIMATE_FACTOR)
+#define IMU_DECIMATE_BLOCK                                                                        \
+    (IMU_DECIMATE_FACTOR * DIV_ROUND_UP(CONFIG_FALCON_IMU_FIFO_WATERMARK, IMU_DECIMATE_FACTOR))
+#define IMU_DECIMATE_OUTPUTS (IMU_DECIMATE_BLOCK / IMU_DECIMATE_FACTOR)
+#define IMU_DECIMATE_CHANNELS 6 // Accel x/y/z, gyro x/y/z
+
+struct imu_decimator {
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+    arm_fir_decimate_instance_f32 fir[IMU_DECIMATE_CHANNELS];
+    float state[IMU_DECIMATE_CHANNELS][IMU_DECIMATE_TAPS + IMU_DECIMATE_BLOCK - 1];
+#else
+    // The last IMU_DECIMATE_TAPS - 1 inputs of the previous block, then this one
+    float history[IMU_DECIMATE_CHANNELS][IMU_DECIMATE_TAPS - 1 + IMU_DECIMATE_BLOCK];
+#endif
+    float in[IMU_DECIMATE_CHANNELS][IMU_DECIMATE_BLOCK];
+    int64_t out_us[IMU_DECIMATE_OUTPUTS]; // Newest input time behind each output
+    uint32_t fill;                        // Samples in the current block
+};
+
+/**
+ * @brief Reset the filter to an empty block and zero history.
+ */
+void imu_decimate_init(struct imu_decimator *dec);
+
+/**
+ * @brief Add one full-rate sample. When it completes a block, the block is
+ * filtered and its IMU_DECIMATE_OUTPUTS decimated samples are written to out.
+ * @param out Room for IMU_DECIMATE_OUTPUTS samples; seq is left to data.c
+ * @return number of samples written to out: 0 or IMU_DECIMATE_OUTPUTS
+ */
+int imu_decimate_add(struct imu_decimator *dec, const float accel[3], const float gyro[3],
+                     int64_t timestamp_us, struct imu_data *out);
+
+/**
+ * @brief The IMU_DECIMATE_TAPS filter taps, designed on first use.
+ */
+const float *imu_decimate_taps(void);
+
+#endif
@@ -1,61 +1,355 @@
 #include <stdint.h>
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/logging/log.h>
+#include <drivers/sensor/imu_fifo.h>
 #include "../data.h"
+#include "../periodic_task.h"
+#include "ahrs.h"
+#include "imu_calib.h"
+#include "imu_decimate.h"
+#include "sensor_decode.h"
 
 LOG_MODULE_REGISTER(imu_thread, LOG_LEVEL_INF);
 
 #define IMU_THREAD_STACK 2048
 #define IMU_THREAD_PRIORITY 5
-#define IMU_THREAD_PERIOD_MS 50
+#define IMU_THREAD_PERIOD_MS 50 // Poll period, only used when the IMU has no interrupt
+
+#define IMU_ODR_HZ CONFIG_FALCON_IMU_ODR_HZ
+#define IMU_WATERMARK CONFIG_FALCON_IMU_FIFO_WATERMARK
+#define IMU_SAMPLE_PERIOD_US (USEC_PER_SEC / IMU_ODR_HZ)
+
+// A burst is late if no watermark arrived for this many burst periods
+#define IMU_BURST_TIMEOUT_US (4 * IMU_WATERMARK * IMU_SAMPLE_PERIOD_US)
+
+// Software FIFO filled by the data-ready handler when the driver has no FIFO
+#define IMU_SW_FIFO_DEPTH (4 * IMU_WATERMARK)
 
 K_THREAD_STACK_DEFINE(imu_stack, IMU_THREAD_STACK);
 static struct k_thread imu_thread;
+static struct periodic_task imu_task;
 
-static void imu_thread_fn(void *p1, void *p2, void *p3)
+static const struct device *const accel_dev = DEVICE_DT_GET(DT_ALIAS(accel0));
+static const struct device *const gyro_dev = DEVICE_DT_GET(DT_ALIAS(gyro0));
+
+enum imu_mode {
+    IMU_MODE_FIFO,       // Driver FIFO, drained on its watermark interrupt
+    IMU_MODE_DATA_READY, // One read per data-ready interrupt into a software FIFO
+    IMU_MODE_POLL,       // No interrupt support: poll at IMU_THREAD_PERIOD_MS
+};
+
+struct imu_frame {
+    float accel[3];
+    float gyro[3];
+    int64_t timestamp_us;
+};
+
+K_MSGQ_DEFINE(imu_sw_fifo, sizeof(struct imu_frame), IMU_SW_FIFO_DEPTH, 4);
+K_SEM_DEFINE(imu_burst_sem, 0, 1);
+static atomic_t imu_sw_fifo_overruns;
+
+static const struct sensor_trigger fifo_trigger = {
+    .type = SENSOR_TRIG_FIFO_WATERMARK,
+    .chan = SENSOR_CHAN_ACCEL_XYZ,
+};
+
+static const struct sensor_trigger drdy_trigger = {
+    .type = SENSOR_TRIG_DATA_READY,
+    .chan = SENSOR_CHAN_ACCEL_XYZ,
+};
+
+// Only touched by the IMU thread
+#ifdef CONFIG_FALCON_IMU_CALIB
+static struct imu_calib imu_cal;
+#endif
+#ifdef CONFIG_FALCON_AHRS
+static struct ahrs imu_ahrs;
+#endif
+
+#if defined(CONFIG_FALCON_IMU_CALIB) || defined(CONFIG_FALCON_AHRS)
+static bool imu_on_pad;
+
+/**
+ * @brief Calibrate and align the attitude while the state machine is in
+ * STANDBY, and freeze both once it leaves. Called once per burst.
+ */
+static void imu_check_state(void)
 {
-    const struct device *gyro_dev = DEVICE_DT_GET(DT_ALIAS(gyro0));
-    const struct device *accel_dev = DEVICE_DT_GET(DT_ALIAS(accel0));
+    struct state_data state;
 
-    if (!device_is_ready(accel_dev) || !device_is_ready(gyro_dev)) {
-        LOG_ERR("BMI088 not ready");
+    get_state_data(&state);
+
+    bool on_pad = (state.state == FLIGHT_STATE_STANDBY);
+
+    if (imu_on_pad && !on_pad) {
+#ifdef CONFIG_FALCON_IMU_CALIB
+        imu_calib_drop_window(&imu_cal);
+        LOG_INF("IMU calibration frozen after %u stationary windows, poses 0x%02x",
+                (unsigned int)imu_cal.coef.windows, imu_cal.coef.poses);
+#endif
+#ifdef CONFIG_FALCON_AHRS
+        LOG_INF("Attitude frozen at %.1f deg of tilt", (double)(ahrs_tilt(&imu_ahrs) * 57.29578f));
+#endif
+    }
+#ifdef CONFIG_FALCON_AHRS
+    ahrs_set_on_pad(&imu_ahrs, on_pad);
+#endif
+    imu_on_pad = on_pad;
+}
+#endif
+
+#ifdef CONFIG_FALCON_IMU_DECIMATE
+static struct imu_decimator imu_dec;
+static struct imu_data imu_filtered[IMU_DECIMATE_OUTPUTS];
+#endif
+
+#ifdef CONFIG_FALCON_AHRS
+/**
+ * @brief Turn the attitude estimate by one calibrated sample and publish it.
+ */
+static void imu_attitude_publish(const struct imu_data *imu)
+{
+    struct attitude_data att;
+
+    ahrs_update(&imu_ahrs, imu->accel, imu->gyro, imu->timestamp_us);
+
+    memcpy(att.q, imu_ahrs.q, sizeof(att.q));
+    memcpy(att.gyro_bias, imu_ahrs.bias, sizeof(att.gyro_bias));
+    att.tilt = ahrs_tilt(&imu_ahrs);
+    att.roll_rate = ahrs_roll_rate(&imu_ahrs);
+    att.aligned = imu_ahrs.aligned;
+    att.timestamp_us = imu->timestamp_us;
+    att.timestamp = imu->timestamp;
+
+    set_attitude_data(&att);
+}
+#endif
+
+static void imu_publish(const float accel[3], const float gyro[3], int64_t timestamp_us)
+{
+    struct imu_data imu_sample;
+
+    memcpy(imu_sample.accel, accel, sizeof(imu_sample.accel));
+    memcpy(imu_sample.gyro, gyro, sizeof(imu_sample.gyro));
+#ifdef CONFIG_FALCON_IMU_CALIB
+    // Learn from the raw sample, then correct it with what is known so far
+    if (imu_on_pad && imu_calib_add(&imu_cal, accel, gyro, timestamp_us)) {
+        set_imu_calib_data(&imu_cal.coef);
+    }
+    imu_calib_apply(&imu_cal.coef, imu_sample.accel, imu_sample.gyro);
+#endif
+    imu_sample.timestamp_us = timestamp_us;
+    imu_sample.timestamp = timestamp_us / USEC_PER_MSEC;
+
+    set_imu_data(&imu_sample);
+#ifdef CONFIG_FALCON_AHRS
+    imu_attitude_publish(&imu_sample);
+#endif
+
+#ifdef CONFIG_FALCON_IMU_DECIMATE
+    int n = imu_decimate_add(&imu_dec, imu_sample.accel, imu_sample.gyro, timestamp_us,
+                             imu_filtered);
+
+    for (int i = 0; i < n; i++) {
+        set_imu_filtered_data(&imu_filtered[i]);
+    }
+#endif
+}
+
+static void imu_fifo_handler(const struct device *dev, const struct sensor_trigger *trig)
+{
+    k_sem_give(&imu_burst_sem);
+}
+
+/**
+ * @brief Data-ready handler, run on the driver's trigger thread: read the new
+ * sample right away so its timestamp is close to the interrupt, and wake the
+ * IMU thread once a watermark's worth has built up.
+ */
+static void imu_drdy_handler(const struct device *dev, const struct sensor_trigger *trig)
+{
+    struct imu_frame frame;
+
+    frame.timestamp_us = data_timestamp_us();
+    if (sensor_decode_imu(frame.accel, frame.gyro) < 0) {
         return;
     }
 
+    if (k_msgq_put(&imu_sw_fifo, &frame, K_NO_WAIT) != 0) {
+        atomic_inc(&imu_sw_fifo_overruns);
+    }
+
+    if (k_msgq_num_used_get(&imu_sw_fifo) >= IMU_WATERMARK) {
+        k_sem_give(&imu_burst_sem);
+    }
+}
+
+/**
+ * @brief Set the ODR and pick the best acquisition mode the drivers support.
+ */
+static enum imu_mode imu_configure(void)
+{
+    struct sensor_value odr = {.val1 = IMU_ODR_HZ};
+    struct sensor_value watermark = {.val1 = IMU_WATERMARK};
+
+    if (sensor_attr_set(accel_dev, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY,
+                        &odr) < 0) {
+        LOG_WRN("Accel ODR %d Hz not supported, keeping the devicetree rate", IMU_ODR_HZ);
+    }
+    if (sensor_attr_set(gyro_dev, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY,
+                        &odr) < 0) {
+        LOG_WRN("Gyro ODR %d Hz not supported, keeping the devicetree rate", IMU_ODR_HZ);
+    }
+
+    if (sensor_attr_set(accel_dev, SENSOR_CHAN_ACCEL_XYZ,
+                        (enum sensor_attribute)SENSOR_ATTR_IMU_FIFO_WATERMARK, &watermark) == 0 &&
+        sensor_attr_set(gyro_dev, SENSOR_CHAN_GYRO_XYZ,
+                        (enum sensor_attribute)SENSOR_ATTR_IMU_FIFO_WATERMARK, &watermark) == 0 &&
+        sensor_trigger_set(accel_dev, &fifo_trigger, imu_fifo_handler) == 0) {
+        return IMU_MODE_FIFO;
+    }
+
+    if (sensor_trigger_set(accel_dev, &drdy_trigger, imu_drdy_handler) == 0) {
+        return IMU_MODE_DATA_READY;
+    }
+
+    return IMU_MODE_POLL;
+}
+
+static int imu_fifo_attr(const struct device *dev, enum sensor_channel chan,
+                         enum imu_fifo_attribute attr)
+{
+    struct sensor_value val;
+    int ret = sensor_attr_get(dev, chan, (enum sensor_attribute)attr, &val);
+
+    return (ret < 0) ? ret : val.val1;
+}
+
+/**
+ * @brief Drain every frame both driver FIFOs hold. Frames carry no timestamp:
+ * the newest was sampled about when the level was read, and the ones before
+ * it are one sample period apart.
+ */
+static void imu_drain_fifo(void)
+{
+    int accel_level = imu_fifo_attr(accel_dev, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_IMU_FIFO_LEVEL);
+    int gyro_level = imu_fifo_attr(gyro_dev, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_IMU_FIFO_LEVEL);
+    int64_t newest_us = data_timestamp_us();
+
+    if (accel_level < 0 || gyro_level < 0) {
+        LOG_ERR("Failed to read IMU FIFO level");
+        return;
+    }
+
+    int count = MIN(accel_level, gyro_level);
+
+    for (int i = 0; i < count; i++) {
+        float accel[3];
+        float gyro[3];
+
+        if (sensor_decode_imu(accel, gyro) < 0) {
+            LOG_ERR("Failed to read IMU FIFO frame %d of %d", i + 1, count);
+            return;
+        }
+
+        imu_publish(accel, gyro, newest_us - (int64_t)(count - 1 - i) * IMU_SAMPLE_PERIOD_US);
+    }
+}
+
+static void imu_drain_sw_fifo(void)
+{
+    struct imu_frame frame;
+
+    while (k_msgq_get(&imu_sw_fifo, &frame, K_NO_WAIT) == 0) {
+        imu_publish(frame.accel, frame.gyro, frame.timestamp_us);
+    }
+}
+
+static int imu_overruns(enum imu_mode mode)
+{
+    if (mode == IMU_MODE_DATA_READY) {
+        return (int)atomic_get(&imu_sw_fifo_overruns);
+    }
+
+    return imu_fifo_attr(accel_dev, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_IMU_FIFO_OVERRUNS);
+}
+
+static void imu_run_poll(void)
+{
+    periodic_task_init(&imu_task, "imu", IMU_THREAD_PERIOD_MS);
+
     while (1) {
-        struct sensor_value accel[3];
-        struct sensor_value gyro[3];
-        struct imu_data imu_sample;
+        periodic_task_wait(&imu_task);
+#if defined(CONFIG_FALCON_IMU_CALIB) || defined(CONFIG_FALCON_AHRS)
+        imu_check_state();
+#endif
+
+        float accel[3];
+        float gyro[3];
+        int64_t timestamp_us = data_timestamp_us(); // The BMI088 converts continuously
 
-        if (sensor_sample_fetch(accel_dev) < 0 || sensor_sample_fetch(gyro_dev) < 0) {
+        if (sensor_decode_imu(accel, gyro) < 0) {
             LOG_ERR("Failed to fetch samples from BMI088");
-            k_sleep(K_MSEC(IMU_THREAD_PERIOD_MS));
             continue;
         }
 
-        sensor_channel_get(accel_dev, SENSOR_CHAN_ACCEL_X, &accel[0]);
-        sensor_channel_get(accel_dev, SENSOR_CHAN_ACCEL_Y, &accel[1]);
-        sensor_channel_get(accel_dev, SENSOR_CHAN_ACCEL_Z, &accel[2]);
+        imu_publish(accel, gyro, timestamp_us);
+    }
+}
 
-        sensor_channel_get(gyro_dev, SENSOR_CHAN_GYRO_X, &gyro[0]);
-        sensor_channel_get(gyro_dev, SENSOR_CHAN_GYRO_Y, &gyro[1]);
-        sensor_channel_get(gyro_dev, SENSOR_CHAN_GYRO_Z, &gyro[2]);
+static void imu_thread_fn(void *p1, void *p2, void *p3)
+{
+    if (!device_is_ready(accel_dev) || !device_is_ready(gyro_dev)) {
+        LOG_ERR("BMI088 not ready");
+        return;
+    }
+
+#ifdef CONFIG_FALCON_IMU_CALIB
+    imu_calib_init(&imu_cal);
+#endif
+#ifdef CONFIG_FALCON_IMU_DECIMATE
+    imu_decimate_init(&imu_dec);
+#endif
+#ifdef CONFIG_FALCON_AHRS
+    ahrs_init(&imu_ahrs);
+#endif
+
+    enum imu_mode mode = imu_configure();
+
+    if (mode == IMU_MODE_POLL) {
+        LOG_WRN("No IMU interrupt support, polling every %d ms", IMU_THREAD_PERIOD_MS);
+        imu_run_poll();
+        return;
+    }
+
+    LOG_INF("IMU at %d Hz, bursts of %d from the %s", IMU_ODR_HZ, IMU_WATERMARK,
+            (mode == IMU_MODE_FIFO) ? "driver FIFO" : "data-ready interrupt");
 
-        imu_sample.accel[0] = sensor_value_to_double(&accel[0]);
-        imu_sample.accel[1] = sensor_value_to_double(&accel[1]);
-        imu_sample.accel[2] = sensor_value_to_double(&accel[2]);
+    int reported_overruns = 0;
 
-        imu_sample.gyro[0] = sensor_value_to_double(&gyro[0]);
-        imu_sample.gyro[1] = sensor_value_to_double(&gyro[1]);
-        imu_sample.gyro[2] = sensor_value_to_double(&gyro[2]);
+    while (1) {
+        if (k_sem_take(&imu_burst_sem, K_USEC(IMU_BURST_TIMEOUT_US)) != 0) {
+            LOG_WRN("No IMU burst for %d us", IMU_BURST_TIMEOUT_US);
+        }
+#if defined(CONFIG_FALCON_IMU_CALIB) || defined(CONFIG_FALCON_AHRS)
+        imu_check_state();
+#endif
 
-        imu_sample.timestamp = k_uptime_get();
+        if (mode == IMU_MODE_FIFO) {
+            imu_drain_fifo();
+        } else {
+            imu_drain_sw_fifo();
+        }
 
-        set_imu_data(&imu_sample);
+        int overruns = imu_overruns(mode);
 
-        k_sleep(K_MSEC(IMU_THREAD_PERIOD_MS));
+        if (overruns > reported_overruns) {
+            LOG_WRN("IMU FIFO overran: %d samples lost", overruns - reported_overruns);
+            reported_overruns = overruns;
+        }
     }
 }
 
@@ -63,4 +357,5 @@ void start_imu_thread(void)
 {
     k_thread_create(&imu_thread, imu_stack, K_THREAD_STACK_SIZEOF(imu_stack), imu_thread_fn, NULL,
                     NULL, NULL, IMU_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&imu_thread, "imu");
 }
@@ -0,0 +1,258 @@
+#include <math.h>
+#include <string.h>
+#include "nav_ekf.h"
+
+#define N NAV_STATES
+#define EARTH_RADIUS_M 6371000.0f
+#define DEG_TO_RAD (3.14159265f / 180.0f)
+
+void nav_ekf_init(struct nav_ekf *nav, float down_m, float var_down)
+{
+    memset(nav, 0, sizeof(*nav));
+    nav->x[NAV_PD] = down_m;
+    nav->P[NAV_PN][NAV_PN] = NAV_SIGMA_POS_START * NAV_SIGMA_POS_START;
+    nav->P[NAV_PE][NAV_PE] = NAV_SIGMA_POS_START * NAV_SIGMA_POS_START;
+    nav->P[NAV_PD][NAV_PD] = var_down;
+    for (int i = NAV_VN; i <= NAV_VD; i++) {
+        nav->P[i][i] = NAV_SIGMA_VEL_START * NAV_SIGMA_VEL_START;
+    }
+    nav->P[NAV_BD][NAV_BD] = 1.0f;
+    nav->sigma_down = NAV_SIGMA_ACCEL;
+    nav->q_h = NAV_Q_HORIZONTAL;
+}
+
+/**
+ * @brief Row dst of P += c * row src: one off-diagonal term of F applied
+ * on the left. add_col() is the same on the right, for F^T.
+ */
+static void add_row(float P[N][N], int dst, int src, float c)
+{
+    for (int k = 0; k < N; k++) {
+        P[dst][k] += c * P[src][k];
+    }
+}
+
+static void add_col(float P[N][N], int dst, int src, float c)
+{
+    for (int k = 0; k < N; k++) {
+        P[k][dst] += c * P[k][src];
+    }
+}
+
+void nav_ekf_predict(struct nav_ekf *nav, float accel_down, float accel_horizontal,
+                     float sigma_a, float dt_s)
+{
+    float dt2 = dt_s * dt_s;
+    float a = accel_down - nav->x[NAV_BD];
+
+    /* Acceleration held over dt: down as measured, north and east zero
+       p = p + v*dt + a*dt^2/2
+       v = v + a*dt
+    */
+    for (int i = 0; i < 3; i++) {
+        nav->x[NAV_PN + i] += nav->x[NAV_VN + i] * dt_s;
+    }
+    nav->x[NAV_PD] += 0.5f * a * dt2;
+    nav->x[NAV_VD] += a * dt_s;
+
+    /* F = I plus p += dt v on each axis, and on the down axis
+       pD += -dt^2/2 bias, vD += -dt bias. F P F^T as row then column
+       operations, the rows of p first so they see the old rows of v */
+    for (int i = 0; i < 3; i++) {
+        add_row(nav->P, NAV_PN + i, NAV_VN + i, dt_s);
+    }
+    add_row(nav->P, NAV_PD, NAV_BD, -0.5f * dt2);
+    add_row(nav->P, NAV_VD, NAV_BD, -dt_s);
+    for (int i = 0; i < 3; i++) {
+        add_col(nav->P, NAV_PN + i, NAV_VN + i, dt_s);
+    }
+    add_col(nav->P, NAV_PD, NAV_BD, -0.5f * dt2);
+    add_col(nav->P, NAV_VD, NAV_BD, -dt_s);
+
+    /* Down: Q = sigma^2 G G^T with G = [dt^2/2; dt], the measured
+       acceleration's noise held over the step */
+    float g0 = 0.5f * dt2;
+    float s2 = sigma_a * sigma_a;
+
+    nav->P[NAV_PD][NAV_PD] += s2 * g0 * g0;
+    nav->P[NAV_PD][NAV_VD] += s2 * g0 * dt_s;
+    nav->P[NAV_VD][NAV_PD] += s2 * g0 * dt_s;
+    nav->P[NAV_VD][NAV_VD] += s2 * dt2;
+
+    /* North and east: Q = q [dt^3/3 dt^2/2; dt^2/2 dt]. The horizontal
+       specific force has an unknown heading: half its square on each axis */
+    float q = NAV_Q_HORIZONTAL + 0.5f * accel_horizontal * accel_horizontal * NAV_ACCEL_TAU;
+    float dt = fabsf(dt_s);
+
+    for (int i = 0; i < 2; i++) {
+        int p = NAV_PN + i;
+        int v = NAV_VN + i;
+
+        nav->P[p][p] += q * dt2 * dt / 3.0f;
+        nav->P[p][v] += q * g0;
+        nav->P[v][p] += q * g0;
+        nav->P[v][v] += q * dt;
+    }
+    nav->P[NAV_BD][NAV_BD] += NAV_SIGMA_BIAS * NAV_SIGMA_BIAS * dt;
+
+    nav->accel_down = accel_down;
+    nav->sigma_down = sigma_a;
+    nav->q_h = q;
+}
+
+/**
+ * @brief Measurement row and prediction of one position axis lead_s from
+ * the filter's time, and the acceleration noise over the lead as variance.
+ */
+static float position_at(const struct nav_ekf *nav, int axis, float lead_s, float h[N],
+                         float *R_lead)
+{
+    float L2 = lead_s * lead_s;
+    float pred = nav->x[NAV_PN + axis] + nav->x[NAV_VN + axis] * lead_s;
+
+    memset(h, 0, sizeof(float) * N);
+    h[NAV_PN + axis] = 1.0f;
+    h[NAV_VN + axis] = lead_s;
+    if (axis == 2) {
+        h[NAV_BD] = -0.5f * L2;
+        pred += 0.5f * (nav->accel_down - nav->x[NAV_BD]) * L2;
+        *R_lead = nav->sigma_down * nav->sigma_down * 0.25f * L2 * L2;
+    } else {
+        *R_lead = nav->q_h * L2 * fabsf(lead_s) / 3.0f;
+    }
+
+    return pred;
+}
+
+/**
+ * @brief Innovation variance h P h^T + R, with P h^T in PHt.
+ */
+static float innovation_var(const struct nav_ekf *nav, const float h[N], float R, float PHt[N])
+{
+    float S = R;
+
+    for (int i = 0; i < N; i++) {
+        PHt[i] = 0.0f;
+        for (int j = 0; j < N; j++) {
+            PHt[i] += nav->P[i][j] * h[j];
+        }
+        S += h[i] * PHt[i];
+    }
+
+    return S;
+}
+
+/**
+ * @brief Scalar update with innovation y and innovation variance S.
+ */
+static void correct(struct nav_ekf *nav, const float PHt[N], float S, float y)
+{
+    if (S < 1e-9f) {
+        return;
+    }
+
+    float K[N];
+
+    for (int i = 0; i < N; i++) {
+        K[i] = PHt[i] / S;
+        nav->x[i] += K[i] * y;
+    }
+
+    /* Joseph form, (I - K h) P (I - K h)^T + K R K^T, expanded for a
+       scalar measurement: P - K PHt^T - PHt K^T + S K K^T */
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            nav->P[i][j] += -K[i] * PHt[j] - PHt[i] * K[j] + S * K[i] * K[j];
+        }
+    }
+}
+
+bool nav_ekf_update_baro(struct nav_ekf *nav, float height_m, float R, float lead_s, float *nis)
+{
+    float h[N];
+    float PHt[N];
+    float R_lead;
+    float y = -height_m - position_at(nav, 2, lead_s, h, &R_lead);
+    float S = innovation_var(nav, h, R + R_lead, PHt);
+    float n = y * y / S;
+
+    if (nis) {
+        *nis = n;
+    }
+    if (n > NAV_GATE) {
+        return false;
+    }
+
+    correct(nav, PHt, S, y);
+    return true;
+}
+
+/**
+ * @brief Forget the horizontal position: variance back to its start and
+ * no correlation with the other states.
+ */
+static void reset_horizontal(struct nav_ekf *nav)
+{
+    for (int axis = NAV_PN; axis <= NAV_PE; axis++) {
+        for (int k = 0; k < N; k++) {
+            nav->P[axis][k] = 0.0f;
+            nav->P[k][axis] = 0.0f;
+        }
+        nav->P[axis][axis] = NAV_SIGMA_POS_START * NAV_SIGMA_POS_START;
+    }
+}
+
+bool nav_ekf_update_gps(struct nav_ekf *nav, float north_m, float east_m, float R, float lead_s)
+{
+    const float z[2] = {north_m, east_m};
+    float h[N];
+    float PHt[N];
+    float R_lead;
+    bool pass = true;
+
+    // Both axes against the same prediction, before either updates it
+    for (int axis = 0; axis < 2; axis++) {
+        float y = z[axis] - position_at(nav, axis, lead_s, h, &R_lead);
+        float S = innovation_var(nav, h, R + R_lead, PHt);
+
+        pass = pass && (y * y / S <= NAV_GATE);
+    }
+
+    if (!pass) {
+        if (++nav->gps_reject_run <= NAV_GPS_REJECT_MAX) {
+            nav->gps_rejected++;
+            return false;
+        }
+        // The fixes agree with each other and not with the filter
+        reset_horizontal(nav);
+    }
+
+    for (int axis = 0; axis < 2; axis++) {
+        float y = z[axis] - position_at(nav, axis, lead_s, h, &R_lead);
+
+        correct(nav, PHt, innovation_var(nav, h, R + R_lead, PHt), y);
+    }
+
+    nav->gps_fused++;
+    nav->gps_reject_run = 0;
+    return true;
+}
+
+void nav_ekf_update_still(struct nav_ekf *nav, float R)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        float h[N] = {0};
+        float PHt[N];
+
+        h[NAV_VN + axis] = 1.0f;
+        correct(nav, PHt, innovation_var(nav, h, R, PHt), -nav->x[NAV_VN + axis]);
+    }
+}
+
+void nav_gps_offset(float origin_lat, float origin_lon, float lat, float lon, float *north_m,
+                    float *east_m)
+{
+    // Nearby floats subtract exactly, so the offsets are as good as the fixes
+    *north_m = (lat - origin_lat) * DEG_TO_RAD * EARTH_RADIUS_M;
+    *east_m = (lon - origin_lon) * DEG_TO_RAD * EARTH_RADIUS_M * cosf(origin_lat * DEG_TO_RAD);
+}
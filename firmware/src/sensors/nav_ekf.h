@@ -0,0 +1,122 @@
+#ifndef NAV_EKF_H
+#define NAV_EKF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Loosely-coupled navigation filter: position and velocity in NED from
+ * the IMU, corrected by GPS fixes and the barometers.
+ *
+ * The state is north, east and down position from an origin, the same
+ * three velocities, and the bias of the down acceleration, which soaks up
+ * attitude error and the difference between local and nominal gravity as
+ * in the vertical filter (altitude_kf.h). The covariance is a full 7x7
+ * matrix of fixed size.
+ *
+ * The filter is predicted through every filtered IMU sample. The specific
+ * force is split with the attitude estimate (ahrs.h) into its component
+ * along earth z and what is left over, horizontal. Down is propagated
+ * with the vertical part, so pitch-over is followed, unlike the vertical
+ * filter's fixed pad axis. With no magnetometer, the heading of the
+ * horizontal part is unknown, so it only widens the process noise of the
+ * north and east axes; between GPS fixes those are carried forward on
+ * their velocity, which the fixes estimate. Under a parachute, drifting
+ * with the wind, that is the whole of the motion.
+ *
+ * The down axis's process noise is that of the measured acceleration, per
+ * sample. North and east have nothing measured, so their velocity is a
+ * random walk in continuous time: NAV_Q_HORIZONTAL for gusts, plus the
+ * horizontal specific force taken as keeping its unknown direction for
+ * NAV_ACCEL_TAU.
+ *
+ * Measurements arrive some milliseconds off the filter's clock and are
+ * applied across that lead, as in the vertical filter: each is compared
+ * with the filter's own position extrapolated to its time.
+ *
+ * - GPS fix: north and east from the origin, gated together on NIS. After
+ *   NAV_GPS_REJECT_MAX rejections in a row the fix is taken anyway, so a
+ *   filter that has drifted off is pulled back rather than abandoned.
+ * - Barometer: down, gated on NIS.
+ * - Zero velocity: on the pad.
+ */
+
+/* Tuning knobs */
+#define NAV_SIGMA_ACCEL 2.0f       // m/s^2, accelerometer noise, vibration and attitude error
+#define NAV_SIGMA_NO_IMU 50.0f     // m/s^2, allowance when predicting without the IMU
+#define NAV_Q_HORIZONTAL 0.5f      // m^2/s^3, horizontal velocity random walk: wind gusts
+#define NAV_ACCEL_TAU 1.0f         // s, time the horizontal specific force keeps its heading
+#define NAV_SIGMA_BIAS 0.05f       // m/s^2 per sqrt(s), drift of the down acceleration bias
+#define NAV_SIGMA_GPS 3.0f         // m, horizontal position of one fix
+#define NAV_SIGMA_BARO 1.5f        // m, one barometer's altitude, as in the baro thread
+#define NAV_SIGMA_STILL 0.1f       // m/s, velocity on the pad
+#define NAV_SIGMA_VEL_START 1.0f   // m/s, velocity at the start
+#define NAV_SIGMA_POS_START 100.0f // m, horizontal position before the first fix
+#define NAV_GATE 10.83f            // NIS gate, chi-square 1 dof at 0.1 %
+#define NAV_GPS_REJECT_MAX 5       // Fixes rejected in a row before one is taken anyway
+
+enum nav_state {
+    NAV_PN, // North from the origin (m)
+    NAV_PE, // East (m)
+    NAV_PD, // Down, from the ground (m)
+    NAV_VN, // m/s
+    NAV_VE,
+    NAV_VD,
+    NAV_BD, // Down acceleration bias (m/s^2)
+    NAV_STATES,
+};
+
+struct nav_ekf {
+    float x[NAV_STATES];
+    float P[NAV_STATES][NAV_STATES];
+    float accel_down; // Last measured down acceleration, gravity removed (m/s^2)
+    float sigma_down; // Its noise (m/s^2)
+    float q_h;        // Spectral density of the horizontal acceleration (m^2/s^3)
+    uint32_t gps_fused;
+    uint32_t gps_rejected;
+    uint8_t gps_reject_run; // Fixes rejected since the last one taken
+};
+
+/**
+ * @brief Start at rest, down_m below the ground datum (negative when
+ * above it) with variance var_down, at the horizontal origin.
+ */
+void nav_ekf_init(struct nav_ekf *nav, float down_m, float var_down);
+
+/**
+ * @brief Predict by dt_s.
+ * @param accel_down Measured down acceleration, gravity removed (m/s^2)
+ * @param accel_horizontal Magnitude of the horizontal specific force (m/s^2)
+ * @param sigma_a Noise of the measured acceleration (m/s^2)
+ */
+void nav_ekf_predict(struct nav_ekf *nav, float accel_down, float accel_horizontal,
+                     float sigma_a, float dt_s);
+
+/**
+ * @brief Correct with a barometer's height of variance R above the ground
+ * datum, taken lead_s from the filter's time.
+ * @param nis If not NULL, the reading's NIS against the prediction
+ * @return true if it passed the gate and was applied
+ */
+bool nav_ekf_update_baro(struct nav_ekf *nav, float height_m, float R, float lead_s, float *nis);
+
+/**
+ * @brief Correct with a GPS fix, north and east of the origin, of variance
+ * R on each axis and taken lead_s from the filter's time.
+ * @return true if it was applied, false if it was rejected
+ */
+bool nav_ekf_update_gps(struct nav_ekf *nav, float north_m, float east_m, float R, float lead_s);
+
+/**
+ * @brief Correct with the knowledge that the rocket is standing still,
+ * velocity of variance R on each axis.
+ */
+void nav_ekf_update_still(struct nav_ekf *nav, float R);
+
+/**
+ * @brief North and east of an origin, on a flat earth, from GPS degrees.
+ */
+void nav_gps_offset(float origin_lat, float origin_lon, float lat, float lon, float *north_m,
+                    float *east_m);
+
+#endif
@@ -0,0 +1,269 @@
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "data.h"
+#include "ahrs.h"
+#include "imu_decimate.h"
+#include "nav_ekf.h"
+#include "nav_thread.h"
+
+LOG_MODULE_REGISTER(nav_thread, LOG_LEVEL_INF);
+
+#define NAV_THREAD_STACK_SIZE 2048
+#define NAV_THREAD_PRIORITY 9 // Below the logger and journal: nothing in flight waits on it
+#define NAV_WAIT_MS 100
+#define NAV_DRAIN_BATCH 8
+#define NAV_DT_MAX_S 0.05f         // Longest step through one filtered IMU sample
+// The filtered stream trails real time by up to a decimator block plus the filter's group delay
+#define NAV_IMU_LAG_US                                                                            \
+    ((int64_t)(2 * IMU_DECIMATE_BLOCK + IMU_DECIMATE_TAPS - 1) * USEC_PER_SEC /                   \
+     (2 * CONFIG_FALCON_IMU_ODR_HZ))
+// Predict without the IMU once it has been quiet this long: that lag plus 50 ms, at least 200 ms
+#define NAV_IMU_TIMEOUT_US MAX(NAV_IMU_LAG_US + 50000, 200000)
+#define NAV_GPS_MIN_SATS 4
+#define NAV_TOPICS                                                                                \
+    (DATA_TOPIC_BIT(DATA_TOPIC_IMU_FILTERED) | DATA_TOPIC_BIT(DATA_TOPIC_BARO) |                  \
+     DATA_TOPIC_BIT(DATA_TOPIC_GPS))
+
+K_THREAD_STACK_DEFINE(nav_stack, NAV_THREAD_STACK_SIZE);
+static struct k_thread nav_thread;
+
+struct nav_thread_state {
+    struct nav_ekf ekf;
+    struct data_subscriber sub;
+    struct data_cursor imu_cursor;
+    struct data_cursor attitude_cursor;
+    struct data_cursor baro_cursor;
+    struct data_cursor gps_cursor;
+    struct attitude_data attitude;      // Newest attitude at or before the filter's time
+    struct attitude_data attitude_next; // Read ahead, not yet reached
+    bool attitude_pending;
+    bool still;    // Last filtered sample read 1 g
+    int64_t t_us;  // Time the filter has been predicted to
+    bool started;
+    float origin_lat;
+    float origin_lon;
+    bool origin_valid;
+    float last_lat; // Last fix seen, as the GPS topic repeats it per sentence
+    float last_lon;
+};
+
+static struct nav_thread_state nav;
+
+/**
+ * @brief The attitude at t_us: the newest sample not after it.
+ */
+static const struct attitude_data *attitude_at(int64_t t_us)
+{
+    while (true) {
+        if (!nav.attitude_pending) {
+            if (get_attitude_history(&nav.attitude_cursor, &nav.attitude_next, 1) == 0) {
+                break;
+            }
+            nav.attitude_pending = true;
+        }
+        if (nav.attitude_next.timestamp_us > t_us) {
+            break;
+        }
+        nav.attitude = nav.attitude_next;
+        nav.attitude_pending = false;
+    }
+
+    return &nav.attitude;
+}
+
+/**
+ * @brief Predict through one filtered IMU sample, split into vertical and
+ * horizontal with the attitude at its time.
+ */
+static void predict_imu(const struct imu_data *imu)
+{
+    const struct attitude_data *att = attitude_at(imu->timestamp_us);
+    const float *a = imu->accel;
+    const float *q = att->q;
+    float dt = MIN((float)(imu->timestamp_us - nav.t_us) * 1.0e-6f, NAV_DT_MAX_S);
+    float norm2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+
+    nav.t_us = imu->timestamp_us;
+    nav.still = fabsf(sqrtf(norm2) - AHRS_G) < AHRS_ACCEL_GATE * AHRS_G;
+
+    if (!att->aligned) {
+        nav_ekf_predict(&nav.ekf, nav.ekf.x[NAV_BD], 0.0f, NAV_SIGMA_NO_IMU, dt);
+        return;
+    }
+
+    // Earth z in body axes, as in ahrs.c
+    float up[3] = {
+        2.0f * (q[1] * q[3] - q[0] * q[2]),
+        2.0f * (q[2] * q[3] + q[0] * q[1]),
+        1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]),
+    };
+    float f_up = up[0] * a[0] + up[1] * a[1] + up[2] * a[2];
+    float f_h = sqrtf(MAX(norm2 - f_up * f_up, 0.0f));
+
+    nav_ekf_predict(&nav.ekf, AHRS_G - f_up, f_h, NAV_SIGMA_ACCEL, dt);
+}
+
+static void advance_imu(void)
+{
+    struct imu_data batch[NAV_DRAIN_BATCH];
+    size_t n;
+
+    while ((n = get_imu_filtered_history(&nav.imu_cursor, batch, NAV_DRAIN_BATCH)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (batch[i].timestamp_us > nav.t_us) {
+                predict_imu(&batch[i]);
+            }
+        }
+    }
+
+    // The IMU has gone quiet: carry on without it so the corrections still land
+    int64_t now_us = data_timestamp_us();
+
+    if (now_us - nav.t_us > NAV_IMU_TIMEOUT_US) {
+        nav_ekf_predict(&nav.ekf, nav.ekf.x[NAV_BD], 0.0f, NAV_SIGMA_NO_IMU,
+                        (float)(now_us - nav.t_us) * 1.0e-6f);
+        nav.t_us = now_us;
+        nav.still = false;
+    }
+}
+
+static void correct_baro(const struct state_data *state)
+{
+    struct baro_data baro;
+
+    while (get_baro_history(&nav.baro_cursor, &baro, 1) > 0) {
+        float lead = (float)(baro.timestamp_us - nav.t_us) * 1.0e-6f;
+
+        if (state->state == FLIGHT_STATE_STANDBY && nav.still) {
+            nav_ekf_update_still(&nav.ekf, NAV_SIGMA_STILL * NAV_SIGMA_STILL);
+        }
+        // Transonic pressure is wrong, as in the state machine's mach lock
+        if (!state->ground_calibrated || state->state == FLIGHT_STATE_MACH_LOCK) {
+            continue;
+        }
+
+        const struct baro_sensor_data *sensors[] = {&baro.baro0, &baro.baro1};
+
+        for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+            if (sensors[i]->fused) {
+                nav_ekf_update_baro(&nav.ekf, sensors[i]->altitude - state->ground_altitude,
+                                    NAV_SIGMA_BARO * NAV_SIGMA_BARO, lead, NULL);
+            }
+        }
+    }
+}
+
+static void correct_gps(void)
+{
+    struct gps_data gps;
+
+    while (get_gps_history(&nav.gps_cursor, &gps, 1) > 0) {
+        if (gps.fix == 0 || gps.sats < NAV_GPS_MIN_SATS ||
+            (gps.latitude == nav.last_lat && gps.longitude == nav.last_lon)) {
+            continue;
+        }
+        nav.last_lat = gps.latitude;
+        nav.last_lon = gps.longitude;
+
+        if (!nav.origin_valid) {
+            nav.origin_lat = gps.latitude;
+            nav.origin_lon = gps.longitude;
+            nav.origin_valid = true;
+            LOG_INF("Navigation origin %.6f, %.6f", (double)nav.origin_lat,
+                    (double)nav.origin_lon);
+        }
+
+        float north;
+        float east;
+
+        nav_gps_offset(nav.origin_lat, nav.origin_lon, gps.latitude, gps.longitude, &north,
+                       &east);
+        nav_ekf_update_gps(&nav.ekf, north, east, NAV_SIGMA_GPS * NAV_SIGMA_GPS,
+                           (float)(gps.timestamp_us - nav.t_us) * 1.0e-6f);
+    }
+}
+
+static void publish(void)
+{
+    struct nav_data out;
+
+    for (int i = 0; i < 3; i++) {
+        int p = NAV_PN + i;
+        int v = NAV_VN + i;
+
+        out.position[i] = nav.ekf.x[p];
+        out.velocity[i] = nav.ekf.x[v];
+        out.position_var[i] = nav.ekf.P[p][p];
+        out.velocity_var[i] = nav.ekf.P[v][v];
+        out.pos_vel_cov[i] = nav.ekf.P[p][v];
+    }
+    out.accel_bias = nav.ekf.x[NAV_BD];
+    out.origin_lat = nav.origin_lat;
+    out.origin_lon = nav.origin_lon;
+    out.origin_valid = nav.origin_valid;
+    out.gps_fused = nav.ekf.gps_fused;
+    out.gps_rejected = nav.ekf.gps_rejected;
+    out.timestamp_us = nav.t_us;
+    out.timestamp = nav.t_us / USEC_PER_MSEC;
+
+    set_nav_data(&out);
+}
+
+/**
+ * @brief Start once the ground is known and there is a barometer sample to
+ * take the height from. Until then the cursors are kept at the newest sample.
+ */
+static bool try_start(const struct state_data *state)
+{
+    struct baro_data baro;
+
+    get_baro_data(&baro);
+    if (!state->ground_calibrated || baro.seq == 0) {
+        return false;
+    }
+
+    nav_ekf_init(&nav.ekf, -baro.altitude_agl, NAV_SIGMA_BARO * NAV_SIGMA_BARO);
+    nav.t_us = baro.timestamp_us;
+    data_cursor_init(DATA_TOPIC_IMU_FILTERED, &nav.imu_cursor);
+    data_cursor_init(DATA_TOPIC_ATTITUDE, &nav.attitude_cursor);
+    data_cursor_init(DATA_TOPIC_BARO, &nav.baro_cursor);
+    data_cursor_init(DATA_TOPIC_GPS, &nav.gps_cursor);
+    get_attitude_data(&nav.attitude);
+    nav.attitude_pending = false;
+    nav.started = true;
+
+    LOG_INF("Navigation started %.1f m above the ground", (double)baro.altitude_agl);
+    return true;
+}
+
+static void nav_thread_fn(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (true) {
+        data_wait(&nav.sub, NAV_TOPICS, K_MSEC(NAV_WAIT_MS));
+
+        struct state_data state;
+
+        get_state_data(&state);
+        if (!nav.started && !try_start(&state)) {
+            continue;
+        }
+
+        advance_imu();
+        correct_baro(&state);
+        correct_gps();
+        publish();
+    }
+}
+
+void start_nav_thread(void)
+{
+    data_subscribe(&nav.sub, NAV_TOPICS);
+    k_thread_create(&nav_thread, nav_stack, K_THREAD_STACK_SIZEOF(nav_stack), nav_thread_fn, NULL,
+                    NULL, NULL, NAV_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&nav_thread, "nav");
+}
@@ -0,0 +1,6 @@
+#ifndef NAV_THREAD_H
+#define NAV_THREAD_H
+
+void start_nav_thread(void);
+
+#endif
@@ -0,0 +1,235 @@
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/init.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/sys/util.h>
+#include "sensor_bus.h"
+
+// Bus controller of an aliased sensor, or NULL if it is not on a bus
+#define SENSOR_BUS_CONTROLLER(alias)                                                              \
+    COND_CODE_1(DT_NODE_EXISTS(DT_BUS(DT_ALIAS(alias))),                                          \
+                (DEVICE_DT_GET(DT_BUS(DT_ALIAS(alias)))), (NULL))
+
+static const struct device *const sensor_devs[SENSOR_BUS_DEV_COUNT] = {
+    [SENSOR_BUS_ACCEL] = DEVICE_DT_GET(DT_ALIAS(accel0)),
+    [SENSOR_BUS_GYRO] = DEVICE_DT_GET(DT_ALIAS(gyro0)),
+    [SENSOR_BUS_BARO0] = DEVICE_DT_GET(DT_ALIAS(baro0)),
+    [SENSOR_BUS_BARO1] = DEVICE_DT_GET(DT_ALIAS(baro1)),
+};
+
+static const struct device *const sensor_controllers[SENSOR_BUS_DEV_COUNT] = {
+    [SENSOR_BUS_ACCEL] = SENSOR_BUS_CONTROLLER(accel0),
+    [SENSOR_BUS_GYRO] = SENSOR_BUS_CONTROLLER(gyro0),
+    [SENSOR_BUS_BARO0] = SENSOR_BUS_CONTROLLER(baro0),
+    [SENSOR_BUS_BARO1] = SENSOR_BUS_CONTROLLER(baro1),
+};
+
+struct sensor_bus {
+    const char *name;
+    const struct device *controller;
+    struct k_mutex lock;
+    // Only touched by the thread holding the lock
+    uint32_t taken_cycles;
+    uint32_t window_start_cycles;
+    uint32_t window_busy_cycles;
+    // Guarded by stats_lock, so sensor_bus_get() sees a consistent copy
+    struct sensor_bus_stats stats;
+};
+
+static struct sensor_bus buses[SENSOR_BUS_DEV_COUNT];
+static uint8_t bus_of[SENSOR_BUS_DEV_COUNT];
+static int bus_count;
+static struct k_spinlock stats_lock;
+
+static void bus_take(struct sensor_bus *bus)
+{
+    uint32_t start = k_cycle_get_32();
+
+    k_mutex_lock(&bus->lock, K_FOREVER);
+    bus->taken_cycles = k_cycle_get_32();
+
+    uint32_t wait_us = k_cyc_to_us_floor32(bus->taken_cycles - start);
+
+    if (wait_us > bus->stats.wait_max_us) {
+        k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+        bus->stats.wait_max_us = wait_us;
+        k_spin_unlock(&stats_lock, key);
+    }
+}
+
+static void bus_give(struct sensor_bus *bus, uint32_t transfers)
+{
+    uint32_t now = k_cycle_get_32();
+    uint32_t window_cycles = now - bus->window_start_cycles;
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    bus->window_busy_cycles += now - bus->taken_cycles;
+    bus->stats.transfers += transfers;
+
+    if (window_cycles >= k_ms_to_cyc_floor32(SENSOR_BUS_WINDOW_MS)) {
+        bus->stats.busy_us = k_cyc_to_us_floor32(bus->window_busy_cycles);
+        bus->stats.utilization_permille =
+            (uint16_t)((uint64_t)bus->window_busy_cycles * 1000U / window_cycles);
+        bus->window_start_cycles = now;
+        bus->window_busy_cycles = 0;
+    }
+
+    k_spin_unlock(&stats_lock, key);
+    k_mutex_unlock(&bus->lock);
+}
+
+static int sensor_bus_init(void)
+{
+    uint32_t now = k_cycle_get_32();
+
+    for (int d = 0; d < SENSOR_BUS_DEV_COUNT; d++) {
+        int b = 0;
+
+        // A sensor on no bus gets one of its own
+        while (b < bus_count &&
+               (sensor_controllers[d] == NULL || buses[b].controller != sensor_controllers[d])) {
+            b++;
+        }
+
+        if (b == bus_count) {
+            buses[b].controller = sensor_controllers[d];
+            buses[b].name =
+                sensor_controllers[d] ? sensor_controllers[d]->name : sensor_devs[d]->name;
+            buses[b].window_start_cycles = now;
+            k_mutex_init(&buses[b].lock);
+            bus_count++;
+        }
+
+        buses[b].stats.devices |= BIT(d);
+        bus_of[d] = b;
+    }
+
+    return 0;
+}
+
+SYS_INIT(sensor_bus_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+/**
+ * @brief Submit the first transfer of the batch on a bus that has not been
+ * started yet. Transfers that fail to submit are completed with the error.
+ * @return true if one is now in flight
+ */
+static bool bus_start_next(struct rtio *ctx, struct sensor_bus_xfer *xfers, size_t n,
+                           uint32_t *started, int bus)
+{
+    for (size_t i = 0; i < n; i++) {
+        if ((*started & BIT(i)) || bus_of[xfers[i].dev] != bus) {
+            continue;
+        }
+
+        *started |= BIT(i);
+
+        struct rtio_sqe *sqe = rtio_sqe_acquire(ctx);
+
+        if (sqe == NULL) {
+            xfers[i].result = -ENOMEM;
+            continue;
+        }
+
+        rtio_sqe_prep_read(sqe, xfers[i].iodev, RTIO_PRIO_NORM, xfers[i].buf, xfers[i].len,
+                           &xfers[i]);
+        rtio_submit(ctx, 0);
+        return true;
+    }
+
+    return false;
+}
+
+int sensor_bus_read(struct rtio *ctx, struct sensor_bus_xfer *xfers, size_t n)
+{
+    uint32_t started = 0;
+    uint32_t transfers[SENSOR_BUS_DEV_COUNT] = {0};
+    uint8_t used = 0;
+    int in_flight = 0;
+    int ret = 0;
+
+    __ASSERT_NO_MSG(n <= 32);
+
+    for (size_t i = 0; i < n; i++) {
+        xfers[i].result = 0;
+        used |= BIT(bus_of[xfers[i].dev]);
+    }
+
+    // Take every bus up front, in index order, so two batches cannot deadlock
+    for (int b = 0; b < bus_count; b++) {
+        if (used & BIT(b)) {
+            bus_take(&buses[b]);
+        }
+    }
+
+    for (int b = 0; b < bus_count; b++) {
+        if (!(used & BIT(b))) {
+            continue;
+        }
+        if (bus_start_next(ctx, xfers, n, &started, b)) {
+            in_flight++;
+        } else {
+            bus_give(&buses[b], 0);
+        }
+    }
+
+    while (in_flight > 0) {
+        struct rtio_cqe *cqe = rtio_cqe_consume_block(ctx);
+        struct sensor_bus_xfer *xfer = cqe->userdata;
+        int bus = bus_of[xfer->dev];
+
+        xfer->result = cqe->result;
+        rtio_cqe_release(ctx, cqe);
+        in_flight--;
+        transfers[bus]++;
+
+        // Keep the bus for the next transfer on it, if there is one
+        if (bus_start_next(ctx, xfers, n, &started, bus)) {
+            in_flight++;
+        } else {
+            bus_give(&buses[bus], transfers[bus]);
+        }
+    }
+
+    for (size_t i = 0; i < n && ret == 0; i++) {
+        ret = xfers[i].result;
+    }
+    return ret;
+}
+
+void sensor_bus_lock(enum sensor_bus_dev dev)
+{
+    bus_take(&buses[bus_of[dev]]);
+}
+
+void sensor_bus_unlock(enum sensor_bus_dev dev)
+{
+    bus_give(&buses[bus_of[dev]], 1);
+}
+
+int sensor_bus_of(enum sensor_bus_dev dev)
+{
+    return bus_of[dev];
+}
+
+int sensor_bus_count(void)
+{
+    return bus_count;
+}
+
+int sensor_bus_get(int idx, const char **name, struct sensor_bus_stats *stats)
+{
+    if (idx < 0 || idx >= bus_count) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    *name = buses[idx].name;
+    *stats = buses[idx].stats;
+    k_spin_unlock(&stats_lock, key);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef SENSOR_BUS_H
+#define SENSOR_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/rtio/rtio.h>
+
+/*
+ * Bus-aware acquisition for the flight sensors.
+ *
+ * Sensors are grouped by the bus they sit on in the devicetree. On
+ * ubcrocket_polarity the accelerometer, gyroscope and baro0 share spi2 and
+ * baro1 has spi4 to itself; the simulated sensors on native_sim are on no
+ * bus and each count as a bus of their own.
+ *
+ * Each bus has a lock, held by whichever thread is transferring on it, so
+ * a batch of reads runs one transfer per bus at a time: reads on different
+ * buses are in flight together (each on its own RTIO work queue thread),
+ * reads that share a bus follow one another. The time a bus is held counts
+ * as busy time; a blocking driver that sleeps through a conversion holds
+ * its bus for it.
+ */
+
+enum sensor_bus_dev {
+    SENSOR_BUS_ACCEL,
+    SENSOR_BUS_GYRO,
+    SENSOR_BUS_BARO0,
+    SENSOR_BUS_BARO1,
+    SENSOR_BUS_DEV_COUNT,
+};
+
+// Utilization is measured over windows of this length
+#define SENSOR_BUS_WINDOW_MS 1000
+
+struct sensor_bus_stats {
+    uint32_t transfers;             // Transfers run on the bus
+    uint32_t busy_us;               // Time the bus was held, last window
+    uint16_t utilization_permille;  // Share of the last window the bus was held
+    uint32_t wait_max_us;           // Longest a transfer waited for the bus
+    uint8_t devices;                // Sensors on the bus, one bit per enum sensor_bus_dev
+};
+
+// One read in a sensor_bus_read() batch
+struct sensor_bus_xfer {
+    enum sensor_bus_dev dev;
+    struct rtio_iodev *iodev;
+    uint8_t *buf;
+    size_t len;
+    int result; // Set by sensor_bus_read(): 0 or negative errno
+};
+
+/**
+ * @brief Run a batch of sensor reads, concurrently across buses and in
+ * order within one. Returns when all of them have completed.
+ * @param ctx RTIO context of the calling thread, with room for n submissions
+ * @return 0 if every read succeeded, otherwise the first failure's errno
+ */
+int sensor_bus_read(struct rtio *ctx, struct sensor_bus_xfer *xfers, size_t n);
+
+/**
+ * @brief Take the bus of a sensor for driver calls outside
+ * sensor_bus_read() (the MS5611 measurement steps).
+ */
+void sensor_bus_lock(enum sensor_bus_dev dev);
+
+/**
+ * @brief Release a bus taken with sensor_bus_lock().
+ */
+void sensor_bus_unlock(enum sensor_bus_dev dev);
+
+/**
+ * @brief Index of the bus a sensor is on, for sensor_bus_get().
+ */
+int sensor_bus_of(enum sensor_bus_dev dev);
+
+/**
+ * @brief Number of distinct buses the flight sensors are on.
+ */
+int sensor_bus_count(void);
+
+/**
+ * @brief Copy the name and statistics of bus idx.
+ * @return 0 on success, -EINVAL if idx is out of range
+ */
+int sensor_bus_get(int idx, const char **name, struct sensor_bus_stats *stats);
+
+#endif
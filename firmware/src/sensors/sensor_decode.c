@@ -0,0 +1,167 @@
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/rtio/rtio.h>
+#include "sensor_bus.h"
+#include "sensor_decode.h"
+
+SENSOR_DT_READ_IODEV(accel_iodev, DT_ALIAS(accel0), {SENSOR_CHAN_ACCEL_XYZ, 0});
+SENSOR_DT_READ_IODEV(gyro_iodev, DT_ALIAS(gyro0), {SENSOR_CHAN_GYRO_XYZ, 0});
+SENSOR_DT_READ_IODEV(baro0_iodev, DT_ALIAS(baro0), {SENSOR_CHAN_PRESS, 0},
+                     {SENSOR_CHAN_AMBIENT_TEMP, 0});
+SENSOR_DT_READ_IODEV(baro1_iodev, DT_ALIAS(baro1), {SENSOR_CHAN_PRESS, 0},
+                     {SENSOR_CHAN_AMBIENT_TEMP, 0});
+
+// One context per reading thread: the IMU path and the baro path run concurrently.
+// Each has room for one read per sensor, for reads on separate buses in flight together.
+RTIO_DEFINE(imu_rtio, 2, 2);
+RTIO_DEFINE(baro_rtio, SENSOR_DECODE_BARO_COUNT, SENSOR_DECODE_BARO_COUNT);
+
+static const struct device *const accel_dev = DEVICE_DT_GET(DT_ALIAS(accel0));
+static const struct device *const gyro_dev = DEVICE_DT_GET(DT_ALIAS(gyro0));
+
+static const struct device *const baro_devs[] = {
+    [SENSOR_DECODE_BARO0] = DEVICE_DT_GET(DT_ALIAS(baro0)),
+    [SENSOR_DECODE_BARO1] = DEVICE_DT_GET(DT_ALIAS(baro1)),
+};
+
+static struct rtio_iodev *const baro_iodevs[] = {
+    [SENSOR_DECODE_BARO0] = &baro0_iodev,
+    [SENSOR_DECODE_BARO1] = &baro1_iodev,
+};
+
+static inline float q31_to_float(q31_t value, int8_t shift)
+{
+    // value * 2^(shift - 31), in single precision
+    return ldexpf((float)value, shift - 31);
+}
+
+int sensor_decode_xyz(const struct device *dev, const uint8_t *buf, enum sensor_channel chan,
+                      float out[3])
+{
+    const struct sensor_decoder_api *decoder;
+    struct sensor_three_axis_data data;
+    uint32_t fit = 0;
+    int ret = sensor_get_decoder(dev, &decoder);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = decoder->decode(buf, (struct sensor_chan_spec){chan, 0}, &fit, 1, &data);
+    if (ret <= 0) {
+        return (ret < 0) ? ret : -ENODATA;
+    }
+
+    out[0] = q31_to_float(data.readings[0].x, data.shift);
+    out[1] = q31_to_float(data.readings[0].y, data.shift);
+    out[2] = q31_to_float(data.readings[0].z, data.shift);
+    return 0;
+}
+
+int sensor_decode_scalar(const struct device *dev, const uint8_t *buf, enum sensor_channel chan,
+                         float *out)
+{
+    const struct sensor_decoder_api *decoder;
+    struct sensor_q31_data data;
+    uint32_t fit = 0;
+    int ret = sensor_get_decoder(dev, &decoder);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = decoder->decode(buf, (struct sensor_chan_spec){chan, 0}, &fit, 1, &data);
+    if (ret <= 0) {
+        return (ret < 0) ? ret : -ENODATA;
+    }
+
+    *out = q31_to_float(data.readings[0].value, data.shift);
+    return 0;
+}
+
+int sensor_decode_imu(float accel[3], float gyro[3])
+{
+    uint8_t accel_buf[SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    uint8_t gyro_buf[SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    struct sensor_bus_xfer xfers[] = {
+        {.dev = SENSOR_BUS_ACCEL, .iodev = &accel_iodev, .buf = accel_buf,
+         .len = sizeof(accel_buf)},
+        {.dev = SENSOR_BUS_GYRO, .iodev = &gyro_iodev, .buf = gyro_buf, .len = sizeof(gyro_buf)},
+    };
+    int ret;
+
+    // Both reads first, so the two dies are sampled as close together as possible
+    ret = sensor_bus_read(&imu_rtio, xfers, ARRAY_SIZE(xfers));
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = sensor_decode_xyz(accel_dev, accel_buf, SENSOR_CHAN_ACCEL_XYZ, accel);
+    if (ret < 0) {
+        return ret;
+    }
+    return sensor_decode_xyz(gyro_dev, gyro_buf, SENSOR_CHAN_GYRO_XYZ, gyro);
+}
+
+static int decode_baro(enum sensor_decode_baro baro, const uint8_t *buf, float *pressure_hpa,
+                       float *temperature_c)
+{
+    int ret = sensor_decode_scalar(baro_devs[baro], buf, SENSOR_CHAN_PRESS, pressure_hpa);
+    if (ret < 0) {
+        return ret;
+    }
+    return sensor_decode_scalar(baro_devs[baro], buf, SENSOR_CHAN_AMBIENT_TEMP, temperature_c);
+}
+
+int sensor_decode_baro(enum sensor_decode_baro baro, float *pressure_hpa, float *temperature_c)
+{
+    uint8_t buf[SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    int ret;
+
+    if (baro >= SENSOR_DECODE_BARO_COUNT) {
+        return -EINVAL;
+    }
+
+    struct sensor_bus_xfer xfer = {
+        .dev = SENSOR_BUS_BARO0 + baro, .iodev = baro_iodevs[baro], .buf = buf, .len = sizeof(buf)};
+
+    ret = sensor_bus_read(&baro_rtio, &xfer, 1);
+    if (ret < 0) {
+        return ret;
+    }
+    return decode_baro(baro, buf, pressure_hpa, temperature_c);
+}
+
+void sensor_decode_baros(const bool read[SENSOR_DECODE_BARO_COUNT], float pressure_hpa[],
+                         float temperature_c[], bool ok[])
+{
+    uint8_t bufs[SENSOR_DECODE_BARO_COUNT][SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    struct sensor_bus_xfer xfers[SENSOR_DECODE_BARO_COUNT];
+    size_t n = 0;
+
+    for (int i = 0; i < SENSOR_DECODE_BARO_COUNT; i++) {
+        ok[i] = false;
+        if (read[i]) {
+            xfers[n++] = (struct sensor_bus_xfer){.dev = SENSOR_BUS_BARO0 + i,
+                                                  .iodev = baro_iodevs[i],
+                                                  .buf = bufs[i],
+                                                  .len = sizeof(bufs[i])};
+        }
+    }
+
+    if (n == 0) {
+        return;
+    }
+
+    // Each read's result is checked on its own, so one failing barometer keeps the other
+    (void)sensor_bus_read(&baro_rtio, xfers, n);
+
+    for (size_t k = 0; k < n; k++) {
+        int i = xfers[k].dev - SENSOR_BUS_BARO0;
+
+        ok[i] = xfers[k].result == 0 &&
+                decode_baro(i, bufs[i], &pressure_hpa[i], &temperature_c[i]) == 0;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef SENSOR_DECODE_H
+#define SENSOR_DECODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+
+/*
+ * Float decode path for the flight sensors.
+ *
+ * Samples are read with the sensor async API (sensor_read() on an RTIO
+ * iodev) and unpacked with the driver's decoder into q31 fixed point, which
+ * is scaled straight to float. No struct sensor_value or double math is
+ * involved, and one read returns every channel of a device. Reads go
+ * through sensor_bus.h, so sensors on separate buses are read at once.
+ */
+
+// Large enough for the encoded frame of any of the flight sensors
+#define SENSOR_DECODE_BUF_SIZE 128
+
+enum sensor_decode_baro {
+    SENSOR_DECODE_BARO0,
+    SENSOR_DECODE_BARO1,
+    SENSOR_DECODE_BARO_COUNT,
+};
+
+/**
+ * @brief Read one accel and one gyro sample (or FIFO frame)
+ * @param accel Acceleration in m/s², X/Y/Z
+ * @param gyro Angular velocity in rad/s, X/Y/Z
+ * @return 0 on success, negative errno if either die has nothing to read
+ */
+int sensor_decode_imu(float accel[3], float gyro[3]);
+
+/**
+ * @brief Read pressure and temperature from one barometer
+ * @param pressure_hpa Pressure in hPa
+ * @param temperature_c Temperature in °C
+ * @return 0 on success, negative errno on failure
+ */
+int sensor_decode_baro(enum sensor_decode_baro baro, float *pressure_hpa, float *temperature_c);
+
+/**
+ * @brief Read several barometers at once; those on separate buses are read
+ * concurrently, those sharing one in turn
+ * @param read Which barometers to read
+ * @param pressure_hpa Pressure in hPa, per barometer
+ * @param temperature_c Temperature in °C, per barometer
+ * @param ok Set for each barometer read and decoded successfully
+ */
+void sensor_decode_baros(const bool read[SENSOR_DECODE_BARO_COUNT], float pressure_hpa[],
+                         float temperature_c[], bool ok[]);
+
+/**
+ * @brief Decode a three-axis channel from a sensor_read() buffer
+ * @return 0 on success, negative errno if the buffer has no such channel
+ */
+int sensor_decode_xyz(const struct device *dev, const uint8_t *buf, enum sensor_channel chan,
+                      float out[3]);
+
+/**
+ * @brief Decode a single-value channel from a sensor_read() buffer
+ * @return 0 on success, negative errno if the buffer has no such channel
+ */
+int sensor_decode_scalar(const struct device *dev, const uint8_t *buf, enum sensor_channel chan,
+                         float *out);
+
+#endif
@@ -0,0 +1,173 @@
+#include <math.h>
+#include <string.h>
+#include "apogee_predict.h"
+
+#define G 9.80665f
+#define HALF (APOGEE_WINDOW / 2)
+#define REBASE_S 100.0f // Move the epoch up before float seconds lose precision
+
+void apogee_predictor_reset(struct apogee_predictor *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+/**
+ * @brief Ring index of the n-th oldest sample in a full window.
+ */
+static inline int slot(const struct apogee_predictor *p, int n)
+{
+    return (p->head + n) % APOGEE_WINDOW;
+}
+
+/**
+ * @brief Mean acceleration over the window, from pairs half a window apart.
+ */
+static float window_accel(const struct apogee_predictor *p)
+{
+    float sum = 0.0f;
+
+    for (int n = 0; n < HALF; n++) {
+        int a = slot(p, n);
+        int b = slot(p, n + HALF);
+
+        sum += (p->v[b] - p->v[a]) / (p->t[b] - p->t[a]);
+    }
+
+    return sum / HALF;
+}
+
+/**
+ * @brief Add the newest pair to the drag fit and refit k once there is
+ * enough of it.
+ */
+static void drag_fit(struct apogee_predictor *p)
+{
+    int a = slot(p, HALF - 1);
+    int b = slot(p, APOGEE_WINDOW - 1);
+    float x = 0.5f * (p->v[a] * fabsf(p->v[a]) + p->v[b] * fabsf(p->v[b]));
+    float y = (p->v[b] - p->v[a]) / (p->t[b] - p->t[a]) + G;
+
+    p->sxx += x * x;
+    p->sxy += x * y;
+    if (p->sxx > APOGEE_FIT_MIN) {
+        p->drag_k = fminf(fmaxf(-p->sxy / p->sxx, 0.0f), APOGEE_DRAG_MAX);
+    }
+}
+
+/**
+ * @brief Time to apogee and height still to climb, from velocity v (m/s)
+ * under gravity and drag k.
+ */
+static void ballistic(float v, float k, float *t_s, float *dh_m)
+{
+    float kv2g = k * v * v / G;
+
+    // Past apogee, or too slow for drag to matter
+    if (v <= 0.0f || kv2g < 1.0e-4f) {
+        *t_s = v / G;
+        *dh_m = v * v / (2.0f * G);
+    } else {
+        *t_s = atanf(v * sqrtf(k / G)) / sqrtf(G * k);
+        *dh_m = log1pf(kv2g) / (2.0f * k);
+    }
+}
+
+void apogee_predictor_update(struct apogee_predictor *p, int64_t t_us, float altitude,
+                             float velocity, struct apogee_prediction *out)
+{
+    if (p->count == 0) {
+        p->epoch_us = t_us;
+    }
+
+    float t = (float)(t_us - p->epoch_us) * 1.0e-6f;
+
+    if (t > REBASE_S) {
+        for (int i = 0; i < APOGEE_WINDOW; i++) {
+            p->t[i] -= REBASE_S;
+        }
+        p->apogee_t -= REBASE_S;
+        p->epoch_us += (int64_t)(REBASE_S * 1.0e6f);
+        t -= REBASE_S;
+    }
+
+    p->t[p->head] = t;
+    p->h[p->head] = altitude;
+    p->v[p->head] = velocity;
+    p->head = (p->head + 1) % APOGEE_WINDOW;
+    if (p->count < APOGEE_WINDOW) {
+        p->count++;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->velocity = velocity;
+    out->drag_k = p->drag_k;
+
+    if (p->count < APOGEE_WINDOW) {
+        return;
+    }
+
+    // Thrusting, or a window straddling burnout: the fit starts again after it
+    if (window_accel(p) > -APOGEE_COAST_DECEL) {
+        p->coast = 0;
+        p->sxx = 0.0f;
+        p->sxy = 0.0f;
+        p->stable = 0;
+        return;
+    }
+    if (p->coast < UINT8_MAX) {
+        p->coast++;
+    }
+    if (p->coast < HALF) {
+        return;
+    }
+    drag_fit(p);
+
+    // Carry every sample forward to the newest with the model, and average
+    float k = p->drag_k;
+    int newest = slot(p, APOGEE_WINDOW - 1);
+    float t_end = p->t[newest];
+    float drag_end = k * p->v[newest] * fabsf(p->v[newest]);
+    float v_sum = 0.0f;
+    float h_sum = 0.0f;
+    float v_end[APOGEE_WINDOW];
+
+    for (int i = 0; i < APOGEE_WINDOW; i++) {
+        float tau = t_end - p->t[i];
+        float decel = G + 0.5f * (k * p->v[i] * fabsf(p->v[i]) + drag_end);
+
+        v_end[i] = p->v[i] - decel * tau;
+        v_sum += v_end[i];
+        h_sum += p->h[i] + (p->v[i] - 0.5f * decel * tau) * tau;
+    }
+
+    float v = v_sum / APOGEE_WINDOW;
+    float h = h_sum / APOGEE_WINDOW;
+    float sq = 0.0f;
+
+    for (int i = 0; i < APOGEE_WINDOW; i++) {
+        sq += (v_end[i] - v) * (v_end[i] - v);
+    }
+
+    float t_a;
+    float dh;
+
+    ballistic(v, k, &t_a, &dh);
+
+    // The predicted time of apogee should hold still from one sample to the next
+    float apogee_t = t_end + t_a;
+
+    if (fabsf(apogee_t - p->apogee_t) < APOGEE_STABLE_S) {
+        if (p->stable < UINT8_MAX) {
+            p->stable++;
+        }
+    } else {
+        p->stable = 0;
+    }
+    p->apogee_t = apogee_t;
+
+    out->time_to_apogee = t_a;
+    out->apogee_altitude = h + dh;
+    out->velocity = v;
+    out->residual = sqrtf(sq / APOGEE_WINDOW);
+    out->valid = out->residual < APOGEE_RESIDUAL_MAX && p->stable >= APOGEE_STABLE_CHECKS;
+}
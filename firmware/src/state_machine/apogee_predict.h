@@ -0,0 +1,94 @@
+#ifndef APOGEE_PREDICT_H
+#define APOGEE_PREDICT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Ballistic apogee prediction from the altitude filter's output.
+ *
+ * In coast the rocket decelerates at g + k v|v|, with k the drag per unit
+ * mass per v^2. k is fitted by least squares over the whole coast, from
+ * pairs of filter samples half a window apart: each pair's mean
+ * deceleration less g against its mean v|v|. The fit is weighted to the
+ * fast part of the coast, where drag dominates, so it is settled well
+ * before apogee and held as the rocket slows.
+ *
+ * Each sample in the window is then carried forward to the newest one with
+ * the fitted model and the results averaged, which smooths the filter's
+ * velocity noise without delaying it. From that altitude and velocity,
+ * apogee is
+ *
+ *   t = atan(v sqrt(k/g)) / sqrt(g k),  dh = ln(1 + k v^2 / g) / (2 k)
+ *
+ * which tends to v/g and v^2/(2g) without drag.
+ *
+ * A prediction is valid once the window has been coasting for half a
+ * window, the samples fit the model and the predicted time of apogee has
+ * held still for APOGEE_STABLE_CHECKS samples.
+ */
+
+/* Tuning knobs */
+#define APOGEE_WINDOW 32              // Samples: about 0.5 s at the 15 ms baro period
+#define APOGEE_COAST_DECEL 4.9f       // m/s^2: a window decelerating less than g/2 is thrusting
+#define APOGEE_DRAG_MAX 0.01f         // 1/m, far above any airframe
+#define APOGEE_FIT_MIN 1.0e7f         // Sum of (v|v|)^2 before k is trusted: four pairs at 40 m/s
+#define APOGEE_RESIDUAL_MAX 3.0f      // m/s RMS of the samples about the model
+#define APOGEE_STABLE_S 0.25f         // Predicted apogee time moving by less than this...
+#define APOGEE_STABLE_CHECKS 5        // ...for this many samples
+#define APOGEE_ARM_VELOCITY_MPS 20.0f // Never fire on a prediction faster than this
+
+struct apogee_predictor {
+    int64_t epoch_us; // Sample times are kept as float s from here
+    float t[APOGEE_WINDOW];
+    float h[APOGEE_WINDOW];
+    float v[APOGEE_WINDOW];
+    uint8_t head;  // Next slot written
+    uint8_t count; // Samples in the window
+    uint8_t coast; // Consecutive full windows decelerating like a coast
+
+    float sxx;      // Drag fit sums over the coast so far
+    float sxy;
+    float drag_k;   // 1/m, 0 until APOGEE_FIT_MIN
+    float apogee_t; // Last predicted apogee time, s from epoch_us
+    uint8_t stable; // Consecutive predictions within APOGEE_STABLE_S of the last
+};
+
+struct apogee_prediction {
+    float time_to_apogee;  // s from the newest sample, negative once past
+    float apogee_altitude; // m, on the altitude filter's datum
+    float velocity;        // Smoothed velocity at the newest sample (m/s)
+    float drag_k;          // 1/m
+    float residual;        // m/s RMS of the samples about the model
+    bool valid;
+};
+
+/**
+ * @brief Forget the window and the drag fit. Call whenever the samples
+ * stop being fed, so a later coast starts clean.
+ */
+void apogee_predictor_reset(struct apogee_predictor *p);
+
+/**
+ * @brief Add one altitude filter sample and predict apogee from the window.
+ * @param t_us Sample time in microseconds
+ * @param altitude Filtered altitude (m)
+ * @param velocity Filtered vertical velocity (m/s)
+ * @param out Prediction; valid is false until the window is full and coasting
+ */
+void apogee_predictor_update(struct apogee_predictor *p, int64_t t_us, float altitude,
+                             float velocity, struct apogee_prediction *out);
+
+/**
+ * @brief Whether to deploy on this sample: the prediction is valid, apogee
+ * is due within lead_s and the altitude filter's own velocity agrees the
+ * rocket is nearly there.
+ * @param velocity The altitude filter's velocity (m/s), not the prediction's
+ */
+static inline bool apogee_prediction_due(const struct apogee_prediction *pred, float velocity,
+                                         float lead_s)
+{
+    return pred->valid && pred->time_to_apogee <= lead_s && velocity < APOGEE_ARM_VELOCITY_MPS;
+}
+
+#endif
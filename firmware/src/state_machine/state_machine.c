@@ -4,6 +4,7 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/smf.h>
 
+#include "deploy_latency.h"
 #include "state_machine.h"
 #include "state_machine_internal.h"
 #include "state_machine_states.h"
@@ -12,11 +13,13 @@ LOG_MODULE_REGISTER(state_machine, LOG_LEVEL_INF);
 
 #define STATE_THREAD_STACK_SIZE 2048
 #define STATE_THREAD_PRIORITY 5
-#define STATE_THREAD_PERIOD_MS 20
+#define STATE_BARO_TIMEOUT_MS 500 // Warn if the baro thread stops publishing
 
 static K_THREAD_STACK_DEFINE(state_stack, STATE_THREAD_STACK_SIZE);
 static struct k_thread state_thread;
 static struct flight_sm state_machine;
+static struct data_subscriber baro_subscriber;
+static struct data_seq_stats baro_stats;
 
 static const struct smf_state flight_states[];
 static void state_machine_reset(int64_t start_ms);
@@ -50,45 +53,116 @@ static const struct smf_state flight_states[] = {
         SMF_CREATE_STATE(state_landed_entry, state_landed_run, NULL, NULL, NULL),
 };
 
+#ifdef CONFIG_FALCON_APOGEE_PREDICT
+/**
+ * @brief Feed the apogee predictor with the current sample and publish its
+ * prediction. It only runs in ascent: in mach lock the barometers read
+ * wrong, and elsewhere apogee is either behind or not yet in sight.
+ */
+static void apogee_predict_step(struct flight_sm *sm, int64_t now_us)
+{
+    if (sm->current_id != FLIGHT_STATE_ASCENT) {
+        if (sm->apogee.count == 0) {
+            return;
+        }
+        // Publish once more so consumers see the prediction go invalid
+        apogee_predictor_reset(&sm->apogee);
+        memset(&sm->prediction, 0, sizeof(sm->prediction));
+    } else {
+        apogee_predictor_update(&sm->apogee, now_us, sm->sample.altitude_m,
+                                sm->sample.velocity_mps, &sm->prediction);
+    }
+
+    const struct apogee_prediction *pred = &sm->prediction;
+    struct apogee_data data = {
+        .time_to_apogee = pred->time_to_apogee,
+        .apogee_altitude = pred->apogee_altitude,
+        .apogee_agl = get_relative_altitude(sm, pred->apogee_altitude),
+        .velocity = pred->velocity,
+        .drag = pred->drag_k,
+        .residual = pred->residual,
+        .valid = pred->valid,
+        .timestamp = now_us / USEC_PER_MSEC,
+        .timestamp_us = now_us,
+    };
+    set_apogee_data(&data);
+}
+#endif
+
+void state_machine_step(const struct baro_data *baro)
+{
+    // A publish racing the previous read re-arms the wakeup; skip the repeat
+    if (!data_seq_track(&baro_stats, baro->seq)) {
+        return;
+    }
+
+    int64_t now_ms = (baro->timestamp > 0) ? baro->timestamp : k_uptime_get();
+    int64_t now_us = (baro->timestamp_us > 0) ? baro->timestamp_us : now_ms * USEC_PER_MSEC;
+
+    state_machine.sample.altitude_m = baro->altitude;
+    state_machine.sample.velocity_mps = baro->velocity;
+    state_machine.sample.timestamp_ms = now_ms;
+
+    deploy_latency_mark_sample(baro->acquired_cycles);
+#ifdef CONFIG_FALCON_APOGEE_PREDICT
+    apogee_predict_step(&state_machine, now_us);
+#endif
+    smf_run_state(SMF_CTX(&state_machine));
+    deploy_latency_record(DEPLOY_LATENCY_DECISION);
+
+    flight_state_id_t current = state_machine.current_id;
+
+    struct state_data data = {
+        .state = current,
+        .ground_altitude = state_machine.ground_altitude_m,
+        .ground_calibrated = state_machine.ground_ready,
+        .timestamp = now_ms,
+        .timestamp_us = now_us,
+        .baro_missed = baro_stats.missed,
+        .baro_duplicate = baro_stats.duplicate,
+    };
+    set_state_data(&data);
+}
+
 /**
  * @brief State machine thread loop that drives SMF with baro samples.
+ *
+ * Blocks until the baro thread publishes, so each filtered sample is
+ * evaluated exactly once and as soon as it is available.
  */
 static void state_machine_thread_fn(void *p1, void *p2, void *p3)
 {
     struct baro_data baro;
 
     while (1) {
-        get_baro_data(&baro);
-        int64_t now_ms = (baro.timestamp > 0) ? baro.timestamp : k_uptime_get();
-
-        state_machine.sample.altitude_m = baro.altitude;
-        state_machine.sample.velocity_mps = baro.velocity;
-        state_machine.sample.timestamp_ms = now_ms;
+        if (!data_wait(&baro_subscriber, DATA_TOPIC_BIT(DATA_TOPIC_BARO),
+                       K_MSEC(STATE_BARO_TIMEOUT_MS))) {
+            LOG_WRN("No baro sample for %d ms", STATE_BARO_TIMEOUT_MS);
+            continue;
+        }
 
-        smf_run_state(SMF_CTX(&state_machine));
-        flight_state_id_t current = state_machine.current_id;
-
-        struct state_data data = {
-            .state = current,
-            .ground_altitude = state_machine.ground_altitude_m,
-            .ground_calibrated = state_machine.ground_ready,
-            .timestamp = now_ms,
-        };
-        set_state_data(&data);
-
-        k_sleep(K_MSEC(STATE_THREAD_PERIOD_MS));
+        get_baro_data(&baro);
+        state_machine_step(&baro);
     }
 }
 
 /**
  * @brief Start the state machine thread and initialize SMF.
  */
-void start_state_machine_thread(void)
+void state_machine_init(void)
 {
     state_machine_reset(k_uptime_get());
+    memset(&baro_stats, 0, sizeof(baro_stats));
+}
+
+void start_state_machine_thread(void)
+{
+    state_machine_init();
+    data_subscribe(&baro_subscriber, DATA_TOPIC_BIT(DATA_TOPIC_BARO));
 
     k_thread_create(&state_thread, state_stack, K_THREAD_STACK_SIZEOF(state_stack),
                     state_machine_thread_fn, NULL, NULL, NULL, STATE_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&state_thread, "state");
 }
 
 #if defined(CONFIG_ZTEST)
@@ -102,6 +176,9 @@ void state_machine_test_step(float altitude_m, float velocity_mps, int64_t times
     state_machine.sample.altitude_m = altitude_m;
     state_machine.sample.velocity_mps = velocity_mps;
     state_machine.sample.timestamp_ms = timestamp_ms;
+#ifdef CONFIG_FALCON_APOGEE_PREDICT
+    apogee_predict_step(&state_machine, timestamp_ms * USEC_PER_MSEC);
+#endif
     smf_run_state(SMF_CTX(&state_machine));
 
     struct state_data data = {
@@ -109,6 +186,7 @@ void state_machine_test_step(float altitude_m, float velocity_mps, int64_t times
         .ground_altitude = state_machine.ground_altitude_m,
         .ground_calibrated = state_machine.ground_ready,
         .timestamp = timestamp_ms,
+        .timestamp_us = timestamp_ms * USEC_PER_MSEC,
     };
     set_state_data(&data);
 }
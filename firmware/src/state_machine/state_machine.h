@@ -4,6 +4,19 @@
 #include "data.h"
 
 void start_state_machine_thread(void);
+
+/**
+ * @brief Reset the flight state machine to STANDBY.
+ * Called by start_state_machine_thread(); call directly when driving
+ * state_machine_step() from the cyclic executive instead.
+ */
+void state_machine_init(void);
+
+/**
+ * @brief Run the state machine on one baro sample and publish state_data.
+ * Samples already seen (same seq) are ignored.
+ */
+void state_machine_step(const struct baro_data *baro);
 const char *flight_state_to_string(flight_state_id_t state);
 
 #endif
@@ -1,6 +1,7 @@
 #include <zephyr/logging/log.h>
 
 #include "state_machine_internal.h"
+#include "../deploy_latency.h"
 #include "../pyro/pyro_thread.h"
 #include "../camera/vtx_power.h"
 
@@ -56,6 +57,7 @@ float get_relative_altitude(const struct flight_sm *sm, float altitude_m)
 void state_action_fire_drogue(void)
 {
     LOG_INF("Drogue deployment triggered");
+    deploy_latency_trace_start(DEPLOY_LATENCY_DROGUE);
     int ret = pyro_fire_drogue();
     if (ret != 0) {
         LOG_ERR("Failed to fire drogue: %d", ret);
@@ -68,6 +70,7 @@ void state_action_fire_drogue(void)
 void state_action_fire_main(void)
 {
     LOG_INF("Main deployment triggered");
+    deploy_latency_trace_start(DEPLOY_LATENCY_MAIN);
     int ret = pyro_fire_main();
     if (ret != 0) {
         LOG_ERR("Failed to fire main: %d", ret);
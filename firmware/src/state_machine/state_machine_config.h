@@ -3,7 +3,7 @@
 
 // Standby baseline
 #define GROUND_WARMUP_MS 2000     // Ignore baro samples for first 2s to let KF converge
-#define GROUND_AVERAGE_SAMPLES 50 // At 50Hz = 1 second of data
+#define GROUND_AVERAGE_SAMPLES 50 // One per baro sample: 1.5 s of data at 33 Hz
 
 // Ascent detection
 #define ASCENT_ALTITUDE_THRESHOLD_M 25.0f
@@ -20,6 +20,7 @@
 #define DROGUE_DEPLOY_VELOCITY_THRESHOLD_MPS 0.0f
 #define DROGUE_DEPLOY_CHECKS 5
 #define DROGUE_DEPLOY_DELAY_MS 1000
+#define APOGEE_PREDICT_LEAD_MS 8 // Deploy on the predicted apogee within half a baro period
 
 // Main deployment
 #define MAIN_DEPLOY_ALTITUDE_M 457.0f //1500 ft
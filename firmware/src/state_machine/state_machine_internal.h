@@ -6,6 +6,7 @@
 
 #include <zephyr/smf.h>
 
+#include "apogee_predict.h"
 #include "data.h"
 #include "state_machine_config.h"
 
@@ -36,6 +37,8 @@ struct flight_sm {
     repeated_check_t landed_check;
     int64_t last_landed_check_ms;
     bool drogue_fire_triggered;
+    struct apogee_predictor apogee;
+    struct apogee_prediction prediction; // From the current sample, invalid outside ascent
 };
 
 bool repeated_check_update(repeated_check_t *check, bool condition, uint8_t required);
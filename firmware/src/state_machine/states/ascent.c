@@ -20,6 +20,17 @@ static flight_state_id_t update_ascent(struct flight_sm *sm, const state_sample_
                 MACH_LOCK_CHECKS);
     }
 
+#ifdef CONFIG_FALCON_APOGEE_PREDICT_DEPLOY
+    // The velocity check below stays armed in case the prediction never settles
+    const struct apogee_prediction *pred = &sm->prediction;
+
+    if (apogee_prediction_due(pred, sample->velocity_mps, APOGEE_PREDICT_LEAD_MS * 1.0e-3f)) {
+        LOG_INF("Apogee predicted in %d ms at %.1f m AGL", (int)(pred->time_to_apogee * 1000.0f),
+                (double)get_relative_altitude(sm, pred->apogee_altitude));
+        return FLIGHT_STATE_DROGUE_DESCENT;
+    }
+#endif
+
     bool drogue = sample->velocity_mps < DROGUE_DEPLOY_VELOCITY_THRESHOLD_MPS;
     if (repeated_check_update(&sm->drogue_main_check, drogue, DROGUE_DEPLOY_CHECKS)) {
         return FLIGHT_STATE_DROGUE_DESCENT;
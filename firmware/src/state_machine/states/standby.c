@@ -22,8 +22,9 @@ static flight_state_id_t update_standby(struct flight_sm *sm, const state_sample
         if (sm->ground_samples >= GROUND_AVERAGE_SAMPLES) {
             sm->ground_altitude_m = sm->ground_sum_m / (float)sm->ground_samples;
             sm->ground_ready = true;
-            LOG_INF("Ground calibration complete: %.2f m (%d samples @ 50Hz = %d ms)",
-                    sm->ground_altitude_m, sm->ground_samples, sm->ground_samples * 20);
+            LOG_INF("Ground calibration complete: %.2f m (%d samples over %lld ms)",
+                    sm->ground_altitude_m, sm->ground_samples,
+                    sample->timestamp_ms - sm->ground_warmup_start_ms - GROUND_WARMUP_MS);
         }
         return FLIGHT_STATE_STANDBY;
     }
@@ -0,0 +1,155 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "data.h"
+#include "periodic_task.h"
+#include "vibration.h"
+
+LOG_MODULE_REGISTER(vibration, LOG_LEVEL_INF);
+
+#define VIBRATION_THREAD_STACK_SIZE 2048
+#define VIBRATION_THREAD_PRIORITY 11 // Below health: nothing waits on this thread
+#define VIBRATION_PERIOD_MS 1000
+// Drain the IMU history twice per lap so no sample is lost while collecting
+#define VIBRATION_POLL_MS                                                                         \
+    MAX(1, CONFIG_FALCON_HISTORY_IMU * MSEC_PER_SEC / CONFIG_FALCON_IMU_ODR_HZ / 2)
+#define VIBRATION_CHANNELS 6 // Accel x/y/z, gyro x/y/z
+#define VIBRATION_DRAIN_BATCH 8
+
+K_THREAD_STACK_DEFINE(vibration_stack, VIBRATION_THREAD_STACK_SIZE);
+static struct k_thread vibration_thread;
+static struct periodic_task vibration_task;
+
+static struct vibration_spectrum spectrum;
+static float samples[VIBRATION_CHANNELS][VIBRATION_FFT_SIZE];
+
+struct vibration_window {
+    struct data_cursor cursor;
+    bool collecting;
+    uint32_t fill;
+    int64_t first_us;
+    int64_t last_us;
+    int64_t start_ms;
+};
+
+/**
+ * @brief Copy new IMU samples into the window.
+ * @return false if the IMU history lapped the window and it must be restarted
+ */
+static bool collect(struct vibration_window *win)
+{
+    struct imu_data batch[VIBRATION_DRAIN_BATCH];
+    size_t n;
+
+    while (win->fill < VIBRATION_FFT_SIZE &&
+           (n = get_imu_history(&win->cursor, batch,
+                                MIN(VIBRATION_DRAIN_BATCH, VIBRATION_FFT_SIZE - win->fill))) > 0) {
+        if (win->cursor.dropped) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            for (int axis = 0; axis < 3; axis++) {
+                samples[axis][win->fill] = batch[i].accel[axis];
+                samples[axis + 3][win->fill] = batch[i].gyro[axis];
+            }
+            if (win->fill == 0) {
+                win->first_us = batch[i].timestamp_us;
+            }
+            win->last_us = batch[i].timestamp_us;
+            win->fill++;
+        }
+    }
+
+    return win->cursor.dropped == 0;
+}
+
+/**
+ * @brief Analyse a full window and publish it.
+ * @return time the analysis took, in microseconds
+ */
+static uint32_t analyze(const struct vibration_window *win, uint32_t windows_dropped)
+{
+    static struct vibration_data vib;
+    uint32_t start = k_cycle_get_32();
+
+    // The IMU stamps are the sample times, so this follows the sensor's real rate
+    vib.sample_rate_hz = (win->last_us > win->first_us)
+                             ? (float)(VIBRATION_FFT_SIZE - 1) * USEC_PER_SEC /
+                                   (float)(win->last_us - win->first_us)
+                             : (float)CONFIG_FALCON_IMU_ODR_HZ;
+
+    for (int axis = 0; axis < 3; axis++) {
+        vibration_spectrum_analyze(&spectrum, samples[axis], vib.sample_rate_hz,
+                                   &vib.accel[axis]);
+        vibration_spectrum_analyze(&spectrum, samples[axis + 3], vib.sample_rate_hz,
+                                   &vib.gyro[axis]);
+    }
+
+    uint32_t analysis_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    vib.fft_size = VIBRATION_FFT_SIZE;
+    vib.analysis_us = analysis_us;
+    vib.windows_dropped = windows_dropped;
+    vib.timestamp_us = win->last_us;
+    vib.timestamp = win->last_us / USEC_PER_MSEC;
+    set_vibration_data(&vib);
+
+    return analysis_us;
+}
+
+static void vibration_thread_fn(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    struct vibration_window win = {0};
+    uint32_t windows_dropped = 0;
+
+    if (vibration_spectrum_init(&spectrum) != 0) {
+        LOG_ERR("No %d-point FFT, vibration analysis disabled", VIBRATION_FFT_SIZE);
+        return;
+    }
+
+    periodic_task_init(&vibration_task, "vibration", VIBRATION_POLL_MS);
+    win.start_ms = k_uptime_get();
+
+    while (1) {
+        periodic_task_wait(&vibration_task);
+
+        if (!win.collecting) {
+            if (k_uptime_get() < win.start_ms) {
+                continue;
+            }
+            data_cursor_init(DATA_TOPIC_IMU, &win.cursor);
+            win.collecting = true;
+            win.fill = 0;
+        }
+
+        if (!collect(&win)) {
+            // Fell behind the IMU: a window with a gap in it would smear the spectrum
+            windows_dropped++;
+            win.collecting = false;
+            continue;
+        }
+        if (win.fill < VIBRATION_FFT_SIZE) {
+            continue;
+        }
+
+        uint32_t analysis_us = analyze(&win, windows_dropped);
+
+        // Hold the average below the budget however long the analysis took
+        uint32_t interval_ms =
+            MAX(VIBRATION_PERIOD_MS, analysis_us / CONFIG_FALCON_VIBRATION_CPU_PERMILLE);
+        win.start_ms += interval_ms;
+        win.start_ms = MAX(win.start_ms, k_uptime_get());
+        win.collecting = false;
+    }
+}
+
+void start_vibration_thread(void)
+{
+    k_thread_create(&vibration_thread, vibration_stack, K_THREAD_STACK_SIZEOF(vibration_stack),
+                    vibration_thread_fn, NULL, NULL, NULL, VIBRATION_THREAD_PRIORITY, 0,
+                    K_NO_WAIT);
+    k_thread_name_set(&vibration_thread, "vibration");
+}
@@ -0,0 +1,60 @@
+#ifndef VIBRATION_H
+#define VIBRATION_H
+
+#include <arm_math.h>
+#include "data.h"
+
+/*
+ * Vibration spectrum of the IMU stream.
+ *
+ * A low-priority thread copies CONFIG_FALCON_VIBRATION_FFT_SIZE consecutive
+ * full-rate samples of each accelerometer and gyro axis out of the IMU
+ * history, then for each axis removes the mean (gravity, bias), applies the
+ * configured window and takes a CMSIS-DSP real FFT. From the one-sided
+ * power spectrum, scaled so that summing bins gives mean square (Parseval,
+ * corrected for the window's power), it reports per axis:
+ *
+ * - the RMS in each band of vibration_band_edges_hz and in all of them
+ * - the strongest component: its frequency (interpolated between bins) and
+ *   its RMS (the bins of its main lobe)
+ *
+ * A window starts about once a second. It is abandoned if the thread falls
+ * so far behind that the IMU history laps it, since a gap would smear the
+ * spectrum. The thread sits below every flight thread, so the IMU thread
+ * always preempts it; on top of that the analysis of one window is timed
+ * and the next window is put off until the thread has used no more than
+ * CONFIG_FALCON_VIBRATION_CPU_PERMILLE of the CPU on average.
+ */
+
+#define VIBRATION_FFT_SIZE CONFIG_FALCON_VIBRATION_FFT_SIZE
+#define VIBRATION_PEAK_BINS 2 // Bins either side of the peak that count towards it
+
+// Band edges in Hz; the last band runs to the Nyquist frequency
+extern const float vibration_band_edges_hz[VIBRATION_BANDS + 1];
+
+struct vibration_spectrum {
+    arm_rfft_fast_instance_f32 fft;
+    float window[VIBRATION_FFT_SIZE];
+    float window_power; // Sum of the squared window
+    float buf[VIBRATION_FFT_SIZE];
+    float out[VIBRATION_FFT_SIZE];
+};
+
+/**
+ * @brief Set up the FFT and the configured window.
+ * @return 0 on success, -EINVAL if CMSIS-DSP has no FFT of this size
+ */
+int vibration_spectrum_init(struct vibration_spectrum *spec);
+
+/**
+ * @brief Analyse VIBRATION_FFT_SIZE consecutive samples of one axis.
+ */
+void vibration_spectrum_analyze(struct vibration_spectrum *spec, const float *samples,
+                                float sample_rate_hz, struct vibration_axis *out);
+
+/**
+ * @brief Start the vibration analysis thread.
+ */
+void start_vibration_thread(void);
+
+#endif
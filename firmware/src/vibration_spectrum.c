@@ -0,0 +1,110 @@
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+#include "vibration.h"
+
+// Above 1600 Hz / 2, the highest IMU rate's Nyquist frequency, so the last band is open
+const float vibration_band_edges_hz[VIBRATION_BANDS + 1] = {2.0f, 20.0f, 50.0f, 100.0f,
+                                                            1000.0f};
+
+int vibration_spectrum_init(struct vibration_spectrum *spec)
+{
+    const float pi = 3.14159265f;
+
+    if (arm_rfft_fast_init_f32(&spec->fft, VIBRATION_FFT_SIZE) != ARM_MATH_SUCCESS) {
+        return -EINVAL;
+    }
+
+    spec->window_power = 0.0f;
+    for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+        float phase = 2.0f * pi * (float)i / (float)VIBRATION_FFT_SIZE;
+
+#if defined(CONFIG_FALCON_VIBRATION_WINDOW_HANN)
+        spec->window[i] = 0.5f - 0.5f * cosf(phase);
+#elif defined(CONFIG_FALCON_VIBRATION_WINDOW_HAMMING)
+        spec->window[i] = 0.54f - 0.46f * cosf(phase);
+#else
+        ARG_UNUSED(phase);
+        spec->window[i] = 1.0f;
+#endif
+        spec->window_power += spec->window[i] * spec->window[i];
+    }
+
+    return 0;
+}
+
+void vibration_spectrum_analyze(struct vibration_spectrum *spec, const float *samples,
+                                float sample_rate_hz, struct vibration_axis *out)
+{
+    const int bins = VIBRATION_FFT_SIZE / 2;
+    const float bin_hz = sample_rate_hz / VIBRATION_FFT_SIZE;
+    // One-sided bin power to mean square
+    const float scale = 2.0f / ((float)VIBRATION_FFT_SIZE * spec->window_power);
+    float *power = spec->buf; // Free again once the FFT has run
+    float mean;
+
+    arm_mean_f32(samples, VIBRATION_FFT_SIZE, &mean);
+    arm_offset_f32(samples, -mean, spec->buf, VIBRATION_FFT_SIZE);
+    arm_mult_f32(spec->buf, spec->window, spec->buf, VIBRATION_FFT_SIZE);
+    arm_rfft_fast_f32(&spec->fft, spec->buf, spec->out, 0);
+
+    // out[0] and out[1] are the real DC and Nyquist terms, then bin k at out[2k]
+    power[0] = 0.0f;
+    arm_cmplx_mag_squared_f32(&spec->out[2], &power[1], bins - 1);
+
+    memset(out, 0, sizeof(*out));
+
+    int band = 0;
+    int peak = 0;
+    float total = 0.0f;
+
+    for (int k = 1; k < bins; k++) {
+        float f = (float)k * bin_hz;
+
+        if (f < vibration_band_edges_hz[0]) {
+            continue;
+        }
+        while (band < VIBRATION_BANDS - 1 && f >= vibration_band_edges_hz[band + 1]) {
+            band++;
+        }
+
+        out->band_rms[band] += power[k];
+        total += power[k];
+        if (peak == 0 || power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+
+    for (int b = 0; b < VIBRATION_BANDS; b++) {
+        out->band_rms[b] = sqrtf(out->band_rms[b] * scale);
+    }
+    out->rms = sqrtf(total * scale);
+
+    if (peak == 0) {
+        return;
+    }
+
+    // Parabola through the magnitudes either side of the peak bin
+    float offset = 0.0f;
+
+    if (peak > 1 && peak < bins - 1) {
+        float a = sqrtf(power[peak - 1]);
+        float b = sqrtf(power[peak]);
+        float c = sqrtf(power[peak + 1]);
+        float denom = a - 2.0f * b + c;
+
+        if (denom < 0.0f) {
+            offset = 0.5f * (a - c) / denom;
+        }
+    }
+    out->peak_hz = ((float)peak + offset) * bin_hz;
+
+    float lobe = 0.0f;
+
+    for (int k = MAX(1, peak - VIBRATION_PEAK_BINS); k <= MIN(bins - 1, peak + VIBRATION_PEAK_BINS);
+         k++) {
+        lobe += power[k];
+    }
+    out->peak_rms = sqrtf(lobe * scale);
+}
@@ -0,0 +1,321 @@
+/*
+ * Attitude estimator (ahrs.h), against a simulated IMU on a rocket whose
+ * true attitude is integrated exactly alongside it.
+ *
+ * Checks alignment on the rail, re-alignment after the rocket is raised
+ * onto it, gyro-only tracking of a pitch-over with the accelerometer out
+ * of its gate, convergence of the gyro bias on the pad, and roll rate and
+ * tilt while spinning about the nose. Then times one update as the IMU
+ * thread runs it in flight.
+ */
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include "ahrs.h"
+#include "bench.h"
+
+LOG_MODULE_REGISTER(ahrs_test, LOG_LEVEL_INF);
+
+#define ODR_HZ CONFIG_FALCON_IMU_ODR_HZ
+#define PERIOD_US (USEC_PER_SEC / ODR_HZ)
+#define DT_S (1.0f / ODR_HZ)
+
+#define BENCH_ITERATIONS 1000
+
+#define ACCEL_NOISE 0.02f  // m/s², about the BMI088 at 400 Hz
+#define GYRO_NOISE 0.003f  // rad/s
+#define DEG (3.14159265f / 180.0f)
+
+/* Deterministic inputs, so a failure reproduces */
+static uint32_t rand_state = 12345;
+
+static float test_rand_unit(void)
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return (float)(rand_state >> 8) / (float)(1U << 24);
+}
+
+// Roughly normal, from the sum of four uniforms
+static float test_noise(float sigma)
+{
+    float sum = test_rand_unit() + test_rand_unit() + test_rand_unit() + test_rand_unit();
+
+    return (sum - 2.0f) * 1.7320508f * sigma;
+}
+
+struct sim {
+    struct ahrs ahrs;
+    float q[4];       // True body to earth attitude
+    float gyro_bias[3];
+    int64_t t_us;
+};
+
+static void quat_mul(const float a[4], const float b[4], float out[4])
+{
+    float r[4] = {
+        a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3],
+        a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2],
+        a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1],
+        a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0],
+    };
+
+    memcpy(out, r, sizeof(r));
+}
+
+static void quat_axis_angle(float x, float y, float z, float angle, float out[4])
+{
+    float s = sinf(0.5f * angle);
+
+    out[0] = cosf(0.5f * angle);
+    out[1] = x * s;
+    out[2] = y * s;
+    out[3] = z * s;
+}
+
+/**
+ * @brief Earth z in body axes.
+ */
+static void body_up(const float q[4], float up[3])
+{
+    up[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    up[1] = 2.0f * (q[2] * q[3] + q[0] * q[1]);
+    up[2] = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+}
+
+/**
+ * @brief On the rail as native_sim has it, body -z up, inclined by
+ * rail_deg about earth x.
+ */
+static void sim_init(struct sim *s, float rail_deg)
+{
+    const float nose_up[4] = {0.0f, 1.0f, 0.0f, 0.0f};
+    float incline[4];
+
+    quat_axis_angle(1.0f, 0.0f, 0.0f, rail_deg * DEG, incline);
+    quat_mul(incline, nose_up, s->q);
+    memset(s->gyro_bias, 0, sizeof(s->gyro_bias));
+    s->t_us = 0;
+    ahrs_init(&s->ahrs);
+}
+
+/**
+ * @brief One IMU sample: turn the true attitude by the body rate over one
+ * period, then feed the filter what the IMU would read.
+ * @param specific Specific force in earth axes (m/s²): (0, 0, g) at rest
+ */
+static void sim_step(struct sim *s, const float rate[3], const float specific[3], float noise)
+{
+    float norm = sqrtf(rate[0] * rate[0] + rate[1] * rate[1] + rate[2] * rate[2]);
+
+    if (norm > 0.0f) {
+        float turn[4];
+
+        quat_axis_angle(rate[0] / norm, rate[1] / norm, rate[2] / norm, norm * DT_S, turn);
+        quat_mul(s->q, turn, s->q);
+    }
+
+    // Earth to body is the conjugate rotation
+    const float conj[4] = {s->q[0], -s->q[1], -s->q[2], -s->q[3]};
+    const float f[4] = {0.0f, specific[0], specific[1], specific[2]};
+    float tmp[4];
+    float body[4];
+
+    quat_mul(conj, f, tmp);
+    quat_mul(tmp, s->q, body);
+
+    float accel[3];
+    float gyro[3];
+
+    for (int i = 0; i < 3; i++) {
+        accel[i] = body[i + 1] + test_noise(ACCEL_NOISE * noise);
+        gyro[i] = rate[i] + s->gyro_bias[i] + test_noise(GYRO_NOISE * noise);
+    }
+
+    s->t_us += PERIOD_US;
+    ahrs_update(&s->ahrs, accel, gyro, s->t_us);
+}
+
+/**
+ * @brief Angle between the filter's up and the true up, in radians.
+ */
+static float up_error(const struct sim *s)
+{
+    float est[3];
+    float truth[3];
+
+    body_up(s->ahrs.q, est);
+    body_up(s->q, truth);
+
+    float c = est[0] * truth[0] + est[1] * truth[1] + est[2] * truth[2];
+
+    return acosf(fminf(c, 1.0f));
+}
+
+static const float at_rest[3] = {0.0f, 0.0f, AHRS_G};
+static const float still[3] = {0.0f, 0.0f, 0.0f};
+
+ZTEST(ahrs, test_align_on_rail)
+{
+    struct sim s;
+
+    sim_init(&s, 5.0f);
+    zassert_false(s.ahrs.aligned, "aligned before the first sample");
+
+    for (int n = 0; n < ODR_HZ; n++) {
+        sim_step(&s, still, at_rest, 1.0f);
+    }
+
+    zassert_true(s.ahrs.aligned, "should align at rest");
+    zassert_equal(s.ahrs.nose, 2, "nose on axis %d, not z", s.ahrs.nose);
+    zassert_equal(s.ahrs.nose_sign, -1.0f, "the nose is -z on native_sim");
+    zassert_within(ahrs_tilt(&s.ahrs), 5.0f * DEG, 0.2f * DEG, "tilt %f deg",
+                   (double)(ahrs_tilt(&s.ahrs) / DEG));
+    zassert_true(up_error(&s) < 0.2f * DEG, "up off by %f deg", (double)(up_error(&s) / DEG));
+}
+
+ZTEST(ahrs, test_realign_on_pad)
+{
+    struct sim s;
+    // Carried lying on its side, then raised onto the rail about earth x
+    const float raise[3] = {0.5f * 3.14159265f, 0.0f, 0.0f};
+
+    sim_init(&s, 0.0f);
+    quat_axis_angle(1.0f, 0.0f, 0.0f, 0.5f * 3.14159265f, s.q);
+    for (int n = 0; n < ODR_HZ; n++) {
+        sim_step(&s, still, at_rest, 1.0f);
+    }
+    zassert_equal(s.ahrs.nose, 1, "lying down, nose on axis %d, not y", s.ahrs.nose);
+
+    for (int n = 0; n < ODR_HZ; n++) {
+        sim_step(&s, raise, at_rest, 1.0f);
+    }
+    for (int n = 0; n < 8 * AHRS_PAD_WINDOW; n++) {
+        sim_step(&s, still, at_rest, 1.0f);
+    }
+
+    LOG_INF("Raised onto the rail: nose %d, tilt %.3f deg, up error %.3f deg", s.ahrs.nose,
+            (double)(ahrs_tilt(&s.ahrs) / DEG), (double)(up_error(&s) / DEG));
+    zassert_equal(s.ahrs.nose, 2, "on the rail, nose on axis %d, not z", s.ahrs.nose);
+    zassert_equal(s.ahrs.nose_sign, -1.0f, "the nose is -z on native_sim");
+    zassert_true(up_error(&s) < 0.2f * DEG, "up off by %f deg", (double)(up_error(&s) / DEG));
+
+    // Launch freezes the alignment: laid down again, the nose stays where it was
+    ahrs_set_on_pad(&s.ahrs, false);
+    for (int n = 0; n < ODR_HZ; n++) {
+        sim_step(&s, raise, at_rest, 1.0f);
+    }
+    for (int n = 0; n < 8 * AHRS_PAD_WINDOW; n++) {
+        sim_step(&s, still, at_rest, 1.0f);
+    }
+    zassert_equal(s.ahrs.nose, 2, "nose moved to axis %d after launch", s.ahrs.nose);
+}
+
+ZTEST(ahrs, test_pitch_over_on_gyro)
+{
+    struct sim s;
+    const float pitch[3] = {0.5f, 0.0f, 0.0f};
+    // Coasting: drag only, well outside the accelerometer gate
+    const float coast[3] = {0.0f, 0.0f, -3.0f};
+
+    sim_init(&s, 0.0f);
+    sim_step(&s, still, at_rest, 0.0f);
+    ahrs_set_on_pad(&s.ahrs, false);
+
+    for (int n = 0; n < ODR_HZ; n++) {
+        sim_step(&s, pitch, coast, 0.0f);
+        zassert_false(s.ahrs.corrected, "step %d: accelerometer used in coast", n);
+    }
+
+    LOG_INF("Pitch-over to %.2f deg, up error %.4f deg", (double)(ahrs_tilt(&s.ahrs) / DEG),
+            (double)(up_error(&s) / DEG));
+    zassert_within(ahrs_tilt(&s.ahrs), 0.5f, 1.0e-3f, "tilt %f rad",
+                   (double)ahrs_tilt(&s.ahrs));
+    zassert_true(up_error(&s) < 0.1f * DEG, "up off by %f deg", (double)(up_error(&s) / DEG));
+}
+
+ZTEST(ahrs, test_bias_converges_on_pad)
+{
+    struct sim s;
+    const float bias[3] = {0.01f, -0.008f, 0.005f};
+    float worst = 0.0f;
+
+    sim_init(&s, 2.0f);
+    memcpy(s.gyro_bias, bias, sizeof(bias));
+
+    for (int n = 0; n < 120 * ODR_HZ; n++) {
+        sim_step(&s, still, at_rest, 1.0f);
+        worst = fmaxf(worst, up_error(&s));
+    }
+
+    LOG_INF("Gyro bias estimate %.5f %.5f %.5f rad/s, worst up error %.3f deg",
+            (double)s.ahrs.bias[0], (double)s.ahrs.bias[1], (double)s.ahrs.bias[2],
+            (double)(worst / DEG));
+
+    // The rocket is still, so the mean rate gives the bias on every axis
+    for (int i = 0; i < 3; i++) {
+        zassert_within(s.ahrs.bias[i], bias[i], 1.0e-3f, "axis %d bias %f", i,
+                       (double)s.ahrs.bias[i]);
+    }
+    zassert_true(worst < 1.0f * DEG, "up off by %f deg with a biased gyro",
+                 (double)(worst / DEG));
+    zassert_true(up_error(&s) < 0.2f * DEG, "up still off by %f deg once settled",
+                 (double)(up_error(&s) / DEG));
+}
+
+ZTEST(ahrs, test_roll_about_nose)
+{
+    struct sim s;
+    // 5 rad/s about the nose, body -z
+    const float roll[3] = {0.0f, 0.0f, -5.0f};
+    // Boost at 5 g along the rail
+    const float boost[3] = {0.0f, 0.0f, 6.0f * AHRS_G};
+
+    sim_init(&s, 0.0f);
+    sim_step(&s, still, at_rest, 0.0f);
+    ahrs_set_on_pad(&s.ahrs, false);
+
+    for (int n = 0; n < 2 * ODR_HZ; n++) {
+        sim_step(&s, roll, boost, 1.0f);
+    }
+
+    zassert_within(ahrs_roll_rate(&s.ahrs), 5.0f, 0.05f, "roll rate %f rad/s",
+                   (double)ahrs_roll_rate(&s.ahrs));
+    zassert_true(ahrs_tilt(&s.ahrs) < 0.5f * DEG, "rolling tilted the nose by %f deg",
+                 (double)(ahrs_tilt(&s.ahrs) / DEG));
+}
+
+ZTEST(ahrs, test_update_cycles)
+{
+    struct ahrs a;
+    struct bench_stat stat = {0};
+    int64_t t_us = 0;
+    volatile float sink;
+
+    // As in flight, off the pad
+    ahrs_init(&a);
+    ahrs_set_on_pad(&a, false);
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        // Alternate at rest and in flight, so both branches are timed
+        float g = (i & 1) ? 3.0f : AHRS_G;
+        float accel[3] = {test_noise(0.1f), test_noise(0.1f), -g};
+        float gyro[3] = {test_noise(1.0f), test_noise(1.0f), test_noise(1.0f)};
+
+        t_us += PERIOD_US;
+        uint32_t start = bench_stamp();
+
+        ahrs_update(&a, accel, gyro, t_us);
+        sink = ahrs_tilt(&a) + ahrs_roll_rate(&a);
+        bench_record(&stat, start);
+    }
+
+    ARG_UNUSED(sink);
+
+    LOG_INF("AHRS update, %d samples: mean=%u max=%u %s", BENCH_ITERATIONS, bench_mean(&stat),
+            stat.max, BENCH_UNIT);
+    zassert_true(a.aligned, "the filter should align on the first sample at rest");
+}
+
+ZTEST_SUITE(ahrs, NULL, NULL, NULL, NULL, NULL);
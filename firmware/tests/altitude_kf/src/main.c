@@ -0,0 +1,660 @@
+/*
+ * IMU-aided altitude filter (altitude_kf.h), against the baro-only filter.
+ *
+ * Flies both through the same trajectory, the way the baro thread runs
+ * them: a barometer sample every 15 ms with 1.5 m of noise, and a 400 Hz
+ * accelerometer, tilted on the rail, with scale error, offset and
+ * vibration, that arrives in FIFO bursts lagging the barometer. Measures
+ * the velocity error up to apogee and how long after the true apogee the
+ * state machine's drogue check would fire, and how long after it the
+ * ballistic apogee predictor (apogee_predict.h) fed from the same filter
+ * would. Flies a gravity turn off a tilted rail against a vertical flight,
+ * for the cost of taking the pad's up direction as the attitude, and with
+ * the attitude. Then times one IMU-rate predict.
+ *
+ * The trajectory is a built-in boost and coast. On native_sim, build with
+ * -DDATA_FILE=<path> to fly an OpenRocket export instead, the same file the
+ * sim_baro driver replays.
+ */
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include "altitude_kf.h"
+#include "apogee_predict.h"
+#include "bench.h"
+#include "state_machine_config.h"
+
+#if defined(CONFIG_BOARD_NATIVE_SIM) && defined(DATA_FILE)
+#include <stdio.h>
+#include <stdlib.h>
+#define FLIGHT_CSV 1
+#endif
+
+LOG_MODULE_REGISTER(altitude_kf_test, LOG_LEVEL_INF);
+
+#define BENCH_ITERATIONS 1000
+
+#define G 9.80665f
+#define IMU_HZ 400
+#define IMU_BURST 16           // FIFO watermark: samples per delivery
+#define BARO_PERIOD_S 0.015f   // CONFIG_FALCON_BARO_FAST_PERIOD_MS
+#define BARO_SIGMA 1.5f        // m, as BARO0_SIGMA_Z
+#define ACCEL_NOISE 1.0f       // m/s^2, mostly motor vibration
+#define ACCEL_SCALE 1.02f
+#define PAD_S 2.0f             // On the rail before ignition
+#define AFTER_APOGEE_S 4.0f
+
+// Built-in flight: constant thrust, then quadratic drag
+#define BURN_S 3.0f
+#define THRUST_ACCEL 80.0f     // m/s^2, specific thrust
+#define DRAG_PER_V2 0.0008f    // 1/m
+
+// The filter must see apogee within this of the truth, and never before it
+#define APOGEE_LATENCY_MAX_S 0.3f
+// The predictor, fed from the aided filter, must deploy within this of it
+#define APOGEE_PREDICT_ERROR_MAX_S 0.1f
+#define APOGEE_ALTITUDE_ERROR_MAX_M 5.0f
+
+// Pitch-over flight: the rail's tilt from vertical, and the speed that clears the rail
+#define RAIL_TILT_DEG 10.0f
+#define RAIL_EXIT_V 20.0f
+// Through a gravity turn the aided filter may lose no more than this against a
+// vertical flight with the pad's up direction standing in for the attitude, and
+// no more than the second with the attitude
+#define PITCH_VEL_RMS_EXTRA_MAX 0.3f
+#define PITCH_VEL_RMS_EXTRA_ATTITUDE_MAX 0.05f
+
+// The IMU's up in its own frame: mounted -z up, a few degrees off the rail
+static const float sim_up[3] = {0.0697f, -0.0349f, -0.9970f};
+static const float sim_offset[3] = {0.15f, -0.10f, 0.20f};
+
+struct truth {
+    float t; // s from ignition
+    float h; // m
+    float v; // m/s
+    float a; // m/s^2, gravity excluded
+};
+
+struct filter_result {
+    float vel_rms;    // m/s, from ignition to apogee, at the baro samples
+    float detect_s;   // Drogue check firing, s from ignition
+    float apogee_s;   // The same, s after the true apogee
+    bool detected;
+
+    struct apogee_predictor predictor;
+    float predict_s;      // Predictor deploying, s from ignition
+    float predict_alt_m;  // Apogee it predicted then
+    float predict_late_s; // The same, s after the true apogee
+    bool predicted;
+};
+
+static struct filter_result baro_only;
+static struct filter_result aided;
+static float true_apogee_s;
+static float true_apogee_m;
+static float bias_final;
+
+/* Deterministic inputs, so a failure reproduces */
+static uint32_t rand_state = 12345;
+
+static float test_rand_unit(void)
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return (float)(rand_state >> 8) / (float)(1U << 24);
+}
+
+// Roughly normal, from the sum of four uniforms
+static float test_noise(float sigma)
+{
+    float sum = test_rand_unit() + test_rand_unit() + test_rand_unit() + test_rand_unit();
+
+    return (sum - 2.0f) * 1.7320508f * sigma;
+}
+
+#ifdef FLIGHT_CSV
+#define CSV_MAX_ROWS 20000
+
+// Time (s), altitude (m), vertical velocity (m/s), vertical acceleration (m/s^2)
+static float (*csv)[4];
+static int csv_rows;
+
+/**
+ * @brief Load the first four columns of an OpenRocket export.
+ */
+static void csv_load(void)
+{
+    FILE *fp = fopen(DATA_FILE, "r");
+    char line[512];
+
+    zassert_not_null(fp, "cannot open %s", DATA_FILE);
+    csv = malloc(sizeof(*csv) * CSV_MAX_ROWS);
+    zassert_not_null(csv, "no memory for the flight");
+
+    while (csv_rows < CSV_MAX_ROWS && fgets(line, sizeof(line), fp)) {
+        char *p = line;
+        int col;
+
+        for (col = 0; col < 4; col++) {
+            char *end;
+
+            csv[csv_rows][col] = strtof(p, &end);
+            if (end == p || (*end != ',' && col < 3)) {
+                break;
+            }
+            p = end + 1;
+        }
+        // The header and comment lines don't parse
+        if (col == 4) {
+            csv_rows++;
+        }
+    }
+    fclose(fp);
+    zassert_true(csv_rows > 1, "no flight in %s", DATA_FILE);
+}
+#endif
+
+/**
+ * @brief Step the true trajectory by dt_s. Before ignition (t < 0) the
+ * rocket sits on the pad.
+ */
+static void flight_step(struct truth *s, float dt_s)
+{
+    s->t += dt_s;
+    if (s->t < 0.0f) {
+        return;
+    }
+
+#ifdef FLIGHT_CSV
+    int i = 0;
+
+    while (i < csv_rows - 2 && csv[i + 1][0] <= s->t) {
+        i++;
+    }
+
+    float span = csv[i + 1][0] - csv[i][0];
+    float alpha = (span > 0.0f) ? CLAMP((s->t - csv[i][0]) / span, 0.0f, 1.0f) : 0.0f;
+
+    s->h = csv[i][1] + alpha * (csv[i + 1][1] - csv[i][1]);
+    s->v = csv[i][2] + alpha * (csv[i + 1][2] - csv[i][2]);
+    s->a = csv[i][3] + alpha * (csv[i + 1][3] - csv[i][3]);
+#else
+    s->a = ((s->t < BURN_S) ? THRUST_ACCEL : 0.0f) - G - DRAG_PER_V2 * s->v * fabsf(s->v);
+    s->v += s->a * dt_s;
+    s->h += s->v * dt_s;
+#endif
+}
+
+/**
+ * @brief What the accelerometer reads while the rocket accelerates at a
+ * (m/s^2, gravity excluded) along the rail.
+ */
+static void sim_accel(float a, float accel[3])
+{
+    float specific_force = ACCEL_SCALE * (a + G);
+
+    for (int i = 0; i < 3; i++) {
+        accel[i] = specific_force * sim_up[i] + sim_offset[i] + test_noise(ACCEL_NOISE);
+    }
+}
+
+/**
+ * @brief Count baro samples with the velocity below the drogue threshold,
+ * as the state machine does from burnout, and note when the check would fire.
+ */
+static void apogee_check(struct filter_result *r, int *checks, float v, float t)
+{
+    if (r->detected) {
+        return;
+    }
+
+    *checks = (v < DROGUE_DEPLOY_VELOCITY_THRESHOLD_MPS) ? *checks + 1 : 0;
+    if (*checks >= DROGUE_DEPLOY_CHECKS) {
+        r->detected = true;
+        r->detect_s = t;
+    }
+}
+
+/**
+ * @brief Feed the predictor from ignition, as the state machine does in
+ * ascent, and note when apogee_prediction_due() would deploy.
+ */
+static void apogee_predict_check(struct filter_result *r, const kalman_hv_t *kf, float t)
+{
+    struct apogee_prediction pred;
+
+    if (r->predicted) {
+        return;
+    }
+
+    apogee_predictor_update(&r->predictor, (int64_t)(t * 1.0e6f), kf->h, kf->v, &pred);
+    if (apogee_prediction_due(&pred, kf->v, APOGEE_PREDICT_LEAD_MS * 1.0e-3f)) {
+        r->predicted = true;
+        r->predict_s = t;
+        r->predict_alt_m = pred.apogee_altitude;
+    }
+}
+
+static void log_prediction(const char *name, const struct filter_result *r)
+{
+    if (!r->predicted) {
+        LOG_INF("%s:  apogee predictor never valid, the velocity check deploys", name);
+        return;
+    }
+
+    LOG_INF("%s:  predicted apogee due %+.3f s, %.0f m, %.3f s sooner than the velocity check",
+            name, (double)r->predict_late_s, (double)r->predict_alt_m,
+            (double)(r->apogee_s - r->predict_late_s));
+}
+
+/**
+ * @brief Fly both filters through the trajectory.
+ */
+static void *altitude_kf_setup(void)
+{
+    struct truth truth = {.t = -PAD_S};
+    kalman_hv_t hv = {0};
+    kalman_hvb_t hvb;
+    struct vertical_accel up;
+    const float R = BARO_SIGMA * BARO_SIGMA;
+    const float imu_dt = 1.0f / IMU_HZ;
+
+    // Delivered but not yet consumed IMU samples, and their times
+    float fifo[2 * IMU_BURST];
+    float fifo_t[2 * IMU_BURST];
+    int pending = 0;
+    int delivered = 0;
+
+    float accel_up = 0.0f;
+    float imu_t = -PAD_S;
+    float next_baro_t = -PAD_S + BARO_PERIOD_S;
+    bool initialized = false;
+    float apogee_m = 0.0f;
+    bool launched = false;
+    bool coasting = false;
+    double vel_sq[2] = {0.0, 0.0};
+    int vel_n = 0;
+    int checks[2] = {0, 0};
+
+#ifdef FLIGHT_CSV
+    csv_load();
+#endif
+
+    vertical_accel_init(&up);
+    apogee_predictor_reset(&baro_only.predictor);
+    apogee_predictor_reset(&aided.predictor);
+    true_apogee_s = INFINITY;
+
+    for (int k = 0;; k++) {
+        float prev_v = truth.v;
+
+        flight_step(&truth, imu_dt);
+        if (truth.t >= 0.0f && truth.v > 0.0f) {
+            launched = true;
+        }
+        if (launched && truth.a < 0.0f) {
+            coasting = true;
+        }
+        if (launched && prev_v > 0.0f && truth.v <= 0.0f && isinf(true_apogee_s)) {
+            true_apogee_s = truth.t;
+            apogee_m = truth.h;
+        }
+        if (truth.t > true_apogee_s + AFTER_APOGEE_S) {
+            break;
+        }
+#ifdef FLIGHT_CSV
+        zassert_true(truth.t < csv[csv_rows - 1][0], "the flight ends before apogee");
+#endif
+
+        // The IMU thread gets a whole FIFO burst at once
+        float accel[3];
+
+        sim_accel(truth.a, accel);
+        if (truth.t < 0.0f) {
+            vertical_accel_observe(&up, accel);
+        }
+        if (vertical_accel_get(&up, accel, &fifo[pending])) {
+            fifo_t[pending++] = truth.t;
+        }
+        if ((k + 1) % IMU_BURST == 0) {
+            delivered = pending;
+        }
+
+        if (truth.t < next_baro_t) {
+            continue;
+        }
+        next_baro_t += BARO_PERIOD_S;
+
+        float z = truth.h + test_noise(BARO_SIGMA);
+
+        if (!initialized) {
+            hv = (kalman_hv_t){.h = z, .P00 = R, .P11 = 100.0f};
+            kf_hvb_init(&hvb, z, R);
+            initialized = true;
+            continue;
+        }
+
+        // As kf_imu_advance() in the baro thread
+        for (int i = 0; i < delivered; i++) {
+            accel_up = fifo[i];
+            kf_hvb_predict(&hvb, accel_up, fifo_t[i] - imu_t, KF_SIGMA_ACCEL, KF_SIGMA_BIAS);
+            imu_t = fifo_t[i];
+        }
+        for (int i = delivered; i < pending; i++) {
+            fifo[i - delivered] = fifo[i];
+            fifo_t[i - delivered] = fifo_t[i];
+        }
+        pending -= delivered;
+        delivered = 0;
+
+        float lead_s = truth.t - imu_t;
+        kalman_hv_t view;
+
+        kf_hvb_update_baro(&hvb, z, R, accel_up, lead_s, KF_SIGMA_ACCEL);
+        kf_hvb_view(&hvb, accel_up, lead_s, KF_SIGMA_ACCEL, &view);
+
+        kf_hv_predict(&hv, BARO_PERIOD_S, KF_SIGMA_A);
+        kf_hv_update_baro(&hv, z, R);
+
+        if (truth.t >= 0.0f && isinf(true_apogee_s)) {
+            vel_sq[0] += (double)((hv.v - truth.v) * (hv.v - truth.v));
+            vel_sq[1] += (double)((view.v - truth.v) * (view.v - truth.v));
+            vel_n++;
+        }
+        if (coasting) {
+            apogee_check(&baro_only, &checks[0], hv.v, truth.t);
+            apogee_check(&aided, &checks[1], view.v, truth.t);
+        }
+        if (truth.t >= 0.0f) {
+            apogee_predict_check(&baro_only, &hv, truth.t);
+            apogee_predict_check(&aided, &view, truth.t);
+        }
+    }
+
+    zassert_true(vel_n > 0, "no baro samples in flight");
+    baro_only.vel_rms = (float)sqrt(vel_sq[0] / vel_n);
+    aided.vel_rms = (float)sqrt(vel_sq[1] / vel_n);
+    baro_only.apogee_s = baro_only.detect_s - true_apogee_s;
+    aided.apogee_s = aided.detect_s - true_apogee_s;
+    baro_only.predict_late_s = baro_only.predict_s - true_apogee_s;
+    aided.predict_late_s = aided.predict_s - true_apogee_s;
+    true_apogee_m = apogee_m;
+    bias_final = hvb.bias;
+
+    LOG_INF("Apogee at %.2f s, %.0f m", (double)true_apogee_s, (double)apogee_m);
+    LOG_INF("Baro only:  velocity RMS error %.2f m/s, apogee seen %+.3f s",
+            (double)baro_only.vel_rms, (double)baro_only.apogee_s);
+    LOG_INF("IMU aided:  velocity RMS error %.2f m/s, apogee seen %+.3f s, bias %.3f m/s^2",
+            (double)aided.vel_rms, (double)aided.apogee_s, (double)bias_final);
+    log_prediction("Baro only", &baro_only);
+    log_prediction("IMU aided", &aided);
+
+    return NULL;
+}
+
+ZTEST(altitude_kf, test_velocity_error)
+{
+    zassert_true(aided.vel_rms < 0.5f * baro_only.vel_rms,
+                 "aided velocity RMS error %f m/s, baro only %f", (double)aided.vel_rms,
+                 (double)baro_only.vel_rms);
+}
+
+ZTEST(altitude_kf, test_apogee_latency)
+{
+    zassert_true(baro_only.detected, "the baro-only filter never saw apogee");
+    zassert_true(aided.detected, "the aided filter never saw apogee");
+    zassert_true(aided.apogee_s >= 0.0f, "aided apogee %f s early", (double)-aided.apogee_s);
+    zassert_true(aided.apogee_s < APOGEE_LATENCY_MAX_S, "aided apogee %f s late",
+                 (double)aided.apogee_s);
+}
+
+ZTEST(altitude_kf, test_apogee_prediction)
+{
+    zassert_true(aided.predicted, "the predictor never deployed on the aided filter");
+    zassert_true(fabsf(aided.predict_late_s) < APOGEE_PREDICT_ERROR_MAX_S,
+                 "predicted deployment %+f s from apogee", (double)aided.predict_late_s);
+    zassert_true(aided.predict_late_s < aided.apogee_s,
+                 "predicted deployment %+f s, velocity check %+f s",
+                 (double)aided.predict_late_s, (double)aided.apogee_s);
+    zassert_within(aided.predict_alt_m, true_apogee_m, APOGEE_ALTITUDE_ERROR_MAX_M,
+                   "predicted apogee %f m, true %f m", (double)aided.predict_alt_m,
+                   (double)true_apogee_m);
+}
+
+ZTEST(altitude_kf, test_vertical_accel)
+{
+    struct vertical_accel up;
+    float accel[3];
+    float a;
+
+    vertical_accel_init(&up);
+    sim_accel(0.0f, accel);
+    zassert_false(vertical_accel_get(&up, accel, &a), "up is not known before the pad");
+
+    for (int i = 0; i < 300; i++) {
+        sim_accel(0.0f, accel);
+        vertical_accel_observe(&up, accel);
+    }
+
+    // A knock on the rail is left out
+    uint32_t count = up.count;
+
+    sim_accel(3.0f * G, accel);
+    vertical_accel_observe(&up, accel);
+    zassert_equal(up.count, count, "a 4 g sample should not count as the pad");
+
+    // Noise-free reads along the rail, at rest and under thrust
+    for (int i = 0; i < 3; i++) {
+        accel[i] = ACCEL_SCALE * G * sim_up[i] + sim_offset[i];
+    }
+    zassert_true(vertical_accel_get(&up, accel, &a), "up should be known");
+    zassert_within(a, 0.0f, 0.25f, "at rest read %f m/s^2", (double)a);
+
+    for (int i = 0; i < 3; i++) {
+        accel[i] = ACCEL_SCALE * (THRUST_ACCEL + G) * sim_up[i] + sim_offset[i];
+    }
+    vertical_accel_get(&up, accel, &a);
+    zassert_within(a, ACCEL_SCALE * THRUST_ACCEL, 0.3f, "under thrust read %f m/s^2",
+                   (double)a);
+}
+
+struct pitch_result {
+    float vel_rms;   // m/s, from ignition to apogee
+    float apogee_s;  // Drogue check firing, s after the true apogee
+    bool detected;
+    float max_pitch; // rad, at apogee
+    float max_error; // m/s^2, of the projection on the pad's up direction
+    float downrange; // m, at apogee
+};
+
+/**
+ * @brief Fly the aided filter through a gravity turn off a rail tilted by
+ * tilt_deg. The rocket noses over to horizontal at apogee. Projecting on
+ * the pad's up direction, thrust and drag read too large by
+ * f (cos(tilt) - cos(pitch)); with attitude set the filter projects on the
+ * true up, as the baro thread does with the AHRS. Each flight starts from
+ * the same noise.
+ */
+static void pitch_over_fly(float tilt_deg, bool attitude, struct pitch_result *out)
+{
+    const float tilt = tilt_deg * 3.1415927f / 180.0f;
+    const float imu_dt = 1.0f / IMU_HZ;
+    const float R = BARO_SIGMA * BARO_SIGMA;
+    // The pitch plane in the IMU's frame: the body axis and its normal
+    float side[3] = {0.0f, sim_up[2], -sim_up[1]};
+    float side_norm = sqrtf(side[1] * side[1] + side[2] * side[2]);
+    struct vertical_accel up;
+    kalman_hvb_t kf;
+    struct filter_result r = {0};
+    float t = -PAD_S;
+    float downrange = 0.0f;
+    float x = 0.0f;
+    float h = 0.0f;
+    float vx = 0.0f;
+    float vh = 0.0f;
+    float pitch = tilt;
+    float next_baro_t = t + BARO_PERIOD_S;
+    float apogee_s = INFINITY;
+    float accel_up = 0.0f;
+    float imu_t = t;
+    float max_pitch = 0.0f;
+    float max_error = 0.0f;
+    double vel_sq = 0.0;
+    int vel_n = 0;
+    int checks = 0;
+    bool initialized = false;
+
+    for (int i = 0; i < 3; i++) {
+        side[i] /= side_norm;
+    }
+    vertical_accel_init(&up);
+    rand_state = 54321;
+
+    while (t < apogee_s + AFTER_APOGEE_S) {
+        float speed = sqrtf(vx * vx + vh * vh);
+        float f = ((t >= 0.0f && t < BURN_S) ? THRUST_ACCEL : 0.0f) - DRAG_PER_V2 * speed * speed;
+        float ax;
+        float ah;
+
+        if (speed < RAIL_EXIT_V && h < 10.0f) {
+            // On the rail only the push along it counts
+            float along = MAX(f - G * cosf(tilt), 0.0f);
+
+            ax = along * sinf(tilt);
+            ah = along * cosf(tilt);
+        } else {
+            pitch = atan2f(vx, vh);
+            ax = f * sinf(pitch);
+            ah = f * cosf(pitch) - G;
+        }
+
+        // Specific force along the body axis and its normal, toward up
+        float f_axis = ax * sinf(pitch) + (ah + G) * cosf(pitch);
+        float f_side = -ax * cosf(pitch) + (ah + G) * sinf(pitch);
+        float accel[3];
+
+        for (int i = 0; i < 3; i++) {
+            accel[i] = ACCEL_SCALE * (f_axis * sim_up[i] + f_side * side[i]) + sim_offset[i] +
+                       test_noise(ACCEL_NOISE);
+        }
+
+        float prev_vh = vh;
+
+        vx += ax * imu_dt;
+        vh += ah * imu_dt;
+        x += vx * imu_dt;
+        h += vh * imu_dt;
+        t += imu_dt;
+        if (t >= 0.0f && prev_vh > 0.0f && vh <= 0.0f && isinf(apogee_s)) {
+            apogee_s = t;
+            downrange = x;
+        }
+
+        if (t < 0.0f) {
+            vertical_accel_observe(&up, accel);
+            continue;
+        }
+        if (attitude) {
+            float att_up[3];
+
+            for (int i = 0; i < 3; i++) {
+                att_up[i] = cosf(pitch) * sim_up[i] + sinf(pitch) * side[i];
+            }
+            zassert_true(vertical_accel_get_up(&up, accel, att_up, &accel_up),
+                         "gravity should be known by ignition");
+        } else {
+            zassert_true(vertical_accel_get(&up, accel, &accel_up),
+                         "up should be known by ignition");
+        }
+        if (isinf(apogee_s)) {
+            max_pitch = MAX(max_pitch, pitch);
+            if (!attitude) {
+                max_error = MAX(max_error, fabsf(f * (cosf(tilt) - cosf(pitch))));
+            }
+        }
+        if (initialized) {
+            kf_hvb_predict(&kf, accel_up, t - imu_t, KF_SIGMA_ACCEL, KF_SIGMA_BIAS);
+        }
+        imu_t = t;
+
+        if (t < next_baro_t) {
+            continue;
+        }
+        next_baro_t += BARO_PERIOD_S;
+
+        float z = h + test_noise(BARO_SIGMA);
+
+        if (!initialized) {
+            kf_hvb_init(&kf, z, R);
+            initialized = true;
+            continue;
+        }
+        kf_hvb_update_baro(&kf, z, R, accel_up, 0.0f, KF_SIGMA_ACCEL);
+
+        if (isinf(apogee_s)) {
+            vel_sq += (double)((kf.v - vh) * (kf.v - vh));
+            vel_n++;
+        }
+        if (t >= BURN_S) {
+            apogee_check(&r, &checks, kf.v, t);
+        }
+    }
+
+    out->vel_rms = (float)sqrt(vel_sq / MAX(vel_n, 1));
+    out->apogee_s = r.detect_s - apogee_s;
+    out->detected = r.detected;
+    out->max_pitch = max_pitch;
+    out->max_error = max_error;
+    out->downrange = downrange;
+}
+
+ZTEST(altitude_kf, test_pitch_over)
+{
+    struct pitch_result vertical;
+    struct pitch_result turn;
+    struct pitch_result turn_att;
+
+    pitch_over_fly(0.0f, false, &vertical);
+    pitch_over_fly(RAIL_TILT_DEG, false, &turn);
+    pitch_over_fly(RAIL_TILT_DEG, true, &turn_att);
+
+    LOG_INF("Pitch-over:  %.0f deg at apogee, %.0f m downrange, projection error up to "
+            "%.2f m/s^2",
+            (double)(turn.max_pitch * 180.0f / 3.1415927f), (double)turn.downrange,
+            (double)turn.max_error);
+    LOG_INF("Pitch-over:  velocity RMS error %.2f m/s, %.2f vertical, apogee seen %+.3f s",
+            (double)turn.vel_rms, (double)vertical.vel_rms, (double)turn.apogee_s);
+    LOG_INF("Pitch-over:  with the attitude, velocity RMS error %.2f m/s, apogee seen %+.3f s",
+            (double)turn_att.vel_rms, (double)turn_att.apogee_s);
+
+    zassert_true(turn.vel_rms - vertical.vel_rms < PITCH_VEL_RMS_EXTRA_MAX,
+                 "velocity RMS error %f m/s through the turn, %f vertical", (double)turn.vel_rms,
+                 (double)vertical.vel_rms);
+    zassert_true(turn.detected, "apogee never seen through the turn");
+    zassert_true(turn.apogee_s >= 0.0f && turn.apogee_s < APOGEE_LATENCY_MAX_S,
+                 "apogee seen %f s from the truth through the turn", (double)turn.apogee_s);
+    zassert_true(turn_att.vel_rms - vertical.vel_rms < PITCH_VEL_RMS_EXTRA_ATTITUDE_MAX,
+                 "velocity RMS error %f m/s through the turn with the attitude, %f vertical",
+                 (double)turn_att.vel_rms, (double)vertical.vel_rms);
+}
+
+ZTEST(altitude_kf, test_predict_cycles)
+{
+    kalman_hvb_t kf;
+    struct bench_stat stat = {0};
+
+    kf_hvb_init(&kf, 0.0f, 2.25f);
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        float accel_up = test_noise(ACCEL_NOISE);
+        uint32_t start = bench_stamp();
+
+        kf_hvb_predict(&kf, accel_up, 1.0f / IMU_HZ, KF_SIGMA_ACCEL, KF_SIGMA_BIAS);
+        bench_record(&stat, start);
+    }
+
+    LOG_INF("IMU-aided predict: mean=%u max=%u %s", bench_mean(&stat), stat.max, BENCH_UNIT);
+    zassert_true(isfinite(kf.h) && kf.P[0][0] > 0.0f, "the filter should stay finite");
+}
+
+ZTEST_SUITE(altitude_kf, NULL, altitude_kf_setup, NULL, NULL, NULL);
@@ -0,0 +1,228 @@
+/*
+ * Barometer fusion (baro_fusion.h) with the baro-only altitude filter, run
+ * the way the baro thread runs them: predict, NIS of each reading against
+ * the prediction, gate, then the fused readings one after the other.
+ *
+ * Checks that two barometers cut the altitude noise, that a barometer
+ * that jumps or stops reading is demoted without the altitude following
+ * it and promoted again once it reads true, and that a filter knocked off
+ * by a transient, or left with one barometer it disagrees with, is pulled
+ * back rather than left coasting.
+ */
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include "altitude_kf.h"
+#include "baro_fusion.h"
+
+LOG_MODULE_REGISTER(baro_fusion_test, LOG_LEVEL_INF);
+
+#define DT_S 0.015f      // CONFIG_FALCON_BARO_FAST_PERIOD_MS
+#define SIGMA_Z 1.5f     // m, as BARO0_SIGMA_Z
+#define TRUE_ALT 100.0f  // m
+#define NOISE_STEPS 4000
+#define SETTLE_STEPS 200
+
+struct sim {
+    kalman_hv_t kf;
+    struct baro_fusion fusion;
+    bool fuse[BARO_COUNT];
+    uint8_t changed;
+};
+
+/* Deterministic inputs, so a failure reproduces */
+static uint32_t rand_state = 12345;
+
+static float test_rand_unit(void)
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return (float)(rand_state >> 8) / (float)(1U << 24);
+}
+
+// Roughly normal, from the sum of four uniforms
+static float test_noise(float sigma)
+{
+    float sum = test_rand_unit() + test_rand_unit() + test_rand_unit() + test_rand_unit();
+
+    return (sum - 2.0f) * 1.7320508f * sigma;
+}
+
+static void sim_init(struct sim *s, bool ready0, bool ready1)
+{
+    const bool ready[BARO_COUNT] = {ready0, ready1};
+
+    s->kf = (kalman_hv_t){.h = TRUE_ALT, .P00 = SIGMA_Z * SIGMA_Z, .P11 = 100.0f};
+    baro_fusion_init(&s->fusion, ready);
+}
+
+/**
+ * @brief One baro step with the given readings; NAN for a failed read.
+ */
+static void sim_step(struct sim *s, float z0, float z1)
+{
+    const float R[BARO_COUNT] = {SIGMA_Z * SIGMA_Z, SIGMA_Z * SIGMA_Z};
+    const float z[BARO_COUNT] = {z0, z1};
+    bool valid[BARO_COUNT];
+    float nis[BARO_COUNT] = {0.0f, 0.0f};
+    bool pass[BARO_COUNT];
+
+    kf_hv_predict(&s->kf, DT_S, KF_SIGMA_A);
+
+    for (int i = 0; i < BARO_COUNT; i++) {
+        valid[i] = s->fusion.sensor[i].present && !isnan(z[i]);
+        if (valid[i]) {
+            nis[i] = kf_hv_nis(&s->kf, z[i], R[i], NULL, NULL);
+        }
+    }
+
+    s->changed = baro_fusion_step(&s->fusion, valid, z, R, nis, pass, s->fuse);
+
+    for (int i = 0; i < BARO_COUNT; i++) {
+        if (s->fuse[i]) {
+            kf_hv_update_baro(&s->kf, z[i], R[i]);
+        }
+    }
+}
+
+/**
+ * @brief Altitude RMS error over still readings with barometer 1 present or not.
+ */
+static float still_rms(bool two)
+{
+    struct sim s;
+    double sq = 0.0;
+
+    sim_init(&s, true, two);
+    for (int n = 0; n < SETTLE_STEPS + NOISE_STEPS; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + test_noise(SIGMA_Z));
+        if (n >= SETTLE_STEPS) {
+            sq += (double)((s.kf.h - TRUE_ALT) * (s.kf.h - TRUE_ALT));
+        }
+    }
+
+    zassert_true(s.fusion.sensor[0].healthy, "a good barometer should stay healthy");
+    zassert_true(s.fusion.sensor[0].rejected < NOISE_STEPS / 100,
+                 "%u of good readings rejected", s.fusion.sensor[0].rejected);
+
+    return (float)sqrt(sq / NOISE_STEPS);
+}
+
+ZTEST(baro_fusion, test_two_cut_noise)
+{
+    float one = still_rms(false);
+    float two = still_rms(true);
+
+    LOG_INF("Altitude RMS error: one barometer %.3f m, two %.3f m", (double)one, (double)two);
+    zassert_true(two < 0.8f * one, "two barometers %f m, one %f m", (double)two, (double)one);
+}
+
+ZTEST(baro_fusion, test_jump_demoted_and_promoted)
+{
+    struct sim s;
+    int demoted_at = -1;
+    int promoted_at = -1;
+
+    sim_init(&s, true, true);
+    for (int n = 0; n < SETTLE_STEPS; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + test_noise(SIGMA_Z));
+    }
+
+    // Barometer 1 reads 40 m high, as with a blocked static port
+    for (int n = 0; n < 100; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + 40.0f + test_noise(SIGMA_Z));
+        zassert_false(s.fuse[1], "step %d: the jumped reading was fused", n);
+        zassert_within(s.kf.h, TRUE_ALT, 3.0f, "step %d: altitude %f", n, (double)s.kf.h);
+        if ((s.changed & 2) && demoted_at < 0) {
+            demoted_at = n;
+        }
+    }
+    zassert_equal(demoted_at, BARO_FAULT_LIMIT - 1, "demoted after %d faults", demoted_at + 1);
+    zassert_false(s.fusion.sensor[1].healthy, "barometer 1 should stay demoted");
+    zassert_true(s.fusion.sensor[0].healthy, "barometer 0 should stay healthy");
+    zassert_true(s.fusion.sensor[1].rejected >= 100, "rejections not counted");
+
+    // It reads true again
+    for (int n = 0; n < 100; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + test_noise(SIGMA_Z));
+        if ((s.changed & 2) && promoted_at < 0) {
+            promoted_at = n;
+        }
+    }
+    zassert_true(promoted_at >= BARO_FAULT_LIMIT - 1 && promoted_at < BARO_FAULT_MAX + 5,
+                 "promoted after %d good readings", promoted_at + 1);
+    zassert_true(s.fusion.sensor[1].healthy && s.fuse[1], "barometer 1 should be fused again");
+}
+
+ZTEST(baro_fusion, test_read_failures)
+{
+    struct sim s;
+
+    sim_init(&s, true, true);
+    for (int n = 0; n < SETTLE_STEPS; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + test_noise(SIGMA_Z));
+    }
+
+    for (int n = 0; n < 50; n++) {
+        sim_step(&s, NAN, TRUE_ALT + test_noise(SIGMA_Z));
+        zassert_true(s.fuse[1], "step %d: barometer 1 should carry the filter", n);
+    }
+    zassert_false(s.fusion.sensor[0].healthy, "a barometer that fails to read is demoted");
+    zassert_equal(s.fusion.sensor[0].rejected, 0, "failed reads are not rejections");
+    zassert_within(s.kf.h, TRUE_ALT, 3.0f, "altitude %f", (double)s.kf.h);
+}
+
+ZTEST(baro_fusion, test_filter_off)
+{
+    struct sim s;
+
+    sim_init(&s, true, true);
+    for (int n = 0; n < SETTLE_STEPS; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + test_noise(SIGMA_Z));
+    }
+
+    // Both barometers agree; it is the filter that is 30 m out
+    s.kf.h += 30.0f;
+    sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + test_noise(SIGMA_Z));
+
+    zassert_true(s.fuse[0] && s.fuse[1], "agreeing barometers should both be taken");
+    zassert_equal(s.fusion.sensor[0].faults + s.fusion.sensor[1].faults, 0,
+                  "the filter's error is not the barometers' fault");
+
+    for (int n = 0; n < 20; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), TRUE_ALT + test_noise(SIGMA_Z));
+    }
+    zassert_within(s.kf.h, TRUE_ALT, 3.0f, "altitude %f", (double)s.kf.h);
+}
+
+ZTEST(baro_fusion, test_single_barometer_not_abandoned)
+{
+    struct sim s;
+    int back = -1;
+
+    sim_init(&s, true, false);
+    for (int n = 0; n < SETTLE_STEPS; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), NAN);
+    }
+
+    // The one barometer is right and the filter is wrong
+    s.kf.h += 30.0f;
+    for (int n = 0; n < 200 && back < 0; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), NAN);
+        if (fabsf(s.kf.h - TRUE_ALT) < 3.0f) {
+            back = n;
+        }
+    }
+
+    zassert_true(back >= 0 && back <= BARO_UNFUSED_LIMIT + 5, "altitude back after %d steps",
+                 back + 1);
+    zassert_false(s.fusion.sensor[1].healthy || s.fusion.sensor[1].faults,
+                  "an absent barometer is never counted");
+
+    for (int n = 0; n < 50; n++) {
+        sim_step(&s, TRUE_ALT + test_noise(SIGMA_Z), NAN);
+    }
+    zassert_true(s.fusion.sensor[0].healthy, "barometer 0 should be promoted again");
+}
+
+ZTEST_SUITE(baro_fusion, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,288 @@
+/*
+ * Accuracy and cost of the barometer math: the MS5611's integer
+ * compensation (ms5611_compensate.h) and the libm-free pressure altitude
+ * (baro_altitude.h).
+ *
+ * Both are checked against their reference formulas in double precision:
+ * the datasheet compensation evaluated without rounding, and the
+ * hypsometric equation with log(). Then each is timed against what it
+ * replaced: the compensation with 64-bit divisions the driver used to do,
+ * and logf().
+ */
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include <drivers/sensor/baro_altitude.h>
+#include <drivers/sensor/ms5611_compensate.h>
+
+#include "bench.h"
+
+LOG_MODULE_REGISTER(baro_math_test, LOG_LEVEL_INF);
+
+#define BENCH_ITERATIONS 1000
+#define COMPENSATE_CASES 20000
+
+// Tolerances, as documented in the headers
+#define COMPENSATE_PRESSURE_TOL_PA 0.6
+#define COMPENSATE_TEMPERATURE_TOL_CDEG 0.6
+#define ALTITUDE_TOL_M 0.001
+#define ALTITUDE_TOL_REL 1e-6
+
+static void bench_report(const char *what, const char *old_name, const struct bench_stat *old_path,
+                         const struct bench_stat *new_path)
+{
+    LOG_INF("%-12s %-8s mean=%6u max=%6u %s | new: mean=%6u max=%6u %s", what, old_name,
+            bench_mean(old_path), old_path->max, BENCH_UNIT, bench_mean(new_path), new_path->max,
+            BENCH_UNIT);
+}
+
+/* Deterministic inputs, so a failure reproduces */
+static uint32_t rand_state = 12345;
+
+static uint32_t test_rand(uint32_t range)
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return (rand_state >> 8) % range;
+}
+
+// The datasheet's example calibration and conversions
+static const struct ms5611_prom datasheet_prom = {40127, 36924, 23317, 23282, 33464, 28312};
+#define DATASHEET_D1 9085466U
+#define DATASHEET_D2 8569150U
+
+/* ---- Reference formulas ---- */
+
+static void reference_compensate(const struct ms5611_prom *c, uint32_t d2, uint32_t d1,
+                                 double *temperature_cdeg, double *pressure_pa)
+{
+    double dT = (double)d2 - c->t_ref * 256.0;
+    double temp = 2000.0 + dT * c->tempsens / 8388608.0;
+    double off = c->off_t1 * 65536.0 + c->tco * dT / 128.0;
+    double sens = c->sens_t1 * 32768.0 + c->tcs * dT / 256.0;
+
+    if (temp < 2000.0) {
+        double below_20 = (temp - 2000.0) * (temp - 2000.0);
+        double t2 = dT * dT / 2147483648.0;
+
+        off -= 5.0 * below_20 / 2.0;
+        sens -= 5.0 * below_20 / 4.0;
+        if (temp < -1500.0) {
+            double below_m15 = (temp + 1500.0) * (temp + 1500.0);
+
+            off -= 7.0 * below_m15;
+            sens -= 11.0 * below_m15 / 2.0;
+        }
+        temp -= t2;
+    }
+
+    *temperature_cdeg = temp;
+    *pressure_pa = (d1 * sens / 2097152.0 - off) / 32768.0;
+}
+
+static double reference_altitude(double pressure_pa, double temperature_c)
+{
+    return (287.05 / 9.80665) * (temperature_c + 273.15) * log(101325.0 / pressure_pa);
+}
+
+/* ---- What the new code replaced ---- */
+
+// The driver's compensation before ms5611_compensate_int(), with 64-bit divisions
+static void legacy_compensate(const struct ms5611_prom *c, int32_t adc_temperature,
+                              int32_t adc_pressure, int32_t *temperature, int32_t *pressure)
+{
+    int64_t dT;
+    int64_t OFF;
+    int64_t SENS;
+    int64_t temp_sq;
+    int64_t Ti;
+    int64_t OFFi;
+    int64_t SENSi;
+
+    dT = adc_temperature - ((int32_t)(c->t_ref) << 8);
+    *temperature = 2000 + (dT * c->tempsens) / (1ll << 23);
+    OFF = ((int64_t)(c->off_t1) << 16) + (dT * c->tco) / (1ll << 7);
+    SENS = ((int64_t)(c->sens_t1) << 15) + (dT * c->tcs) / (1ll << 8);
+
+    temp_sq = (int64_t)(*temperature - 2000) * (int64_t)(*temperature - 2000);
+    if (*temperature < 2000) {
+        Ti = (dT * dT) / (1ll << 31);
+        OFFi = (5ll * temp_sq) / (1ll << 1);
+        SENSi = (5ll * temp_sq) / (1ll << 2);
+        if (*temperature < -1500) {
+            temp_sq = (int64_t)(*temperature + 1500) * (int64_t)(*temperature + 1500);
+            OFFi += 7ll * temp_sq;
+            SENSi += (11ll * temp_sq) / (1ll << 1);
+        }
+    } else {
+        SENSi = 0;
+        OFFi = 0;
+        Ti = 0;
+    }
+
+    OFF -= OFFi;
+    SENS -= SENSi;
+
+    *temperature -= Ti;
+    *pressure = (SENS * (int64_t)adc_pressure / (1ll << 21) - OFF) / (1ll << 15);
+}
+
+static float legacy_altitude(float pressure_pa, float temperature_c)
+{
+    return (287.05f * (temperature_c + 273.15f) / 9.80665f) * logf(101325.0f / pressure_pa);
+}
+
+/**
+ * @brief A plausible sensor: calibration around the datasheet's, conversions
+ * for -40 to +85 °C and 10 to 1200 mbar
+ */
+static void random_case(struct ms5611_prom *c, uint32_t *d2, uint32_t *d1)
+{
+    *c = datasheet_prom;
+    c->sens_t1 += test_rand(8000) - 4000;
+    c->off_t1 += test_rand(8000) - 4000;
+    c->tcs += test_rand(4000) - 2000;
+    c->tco += test_rand(4000) - 2000;
+    c->t_ref += test_rand(4000) - 2000;
+    c->tempsens += test_rand(4000) - 2000;
+
+    double temp = -4000.0 + test_rand(12500);
+    double dT = (temp - 2000.0) * 8388608.0 / c->tempsens;
+
+    *d2 = (uint32_t)(c->t_ref * 256.0 + dT);
+    *d1 = 1000000U + test_rand(14000000U);
+}
+
+/* ---- Tests ---- */
+
+ZTEST(baro_math, test_compensate_datasheet_example)
+{
+    double ref_temperature;
+    double ref_pressure;
+    int32_t temperature;
+    int32_t pressure;
+
+    reference_compensate(&datasheet_prom, DATASHEET_D2, DATASHEET_D1, &ref_temperature,
+                         &ref_pressure);
+    ms5611_compensate_int(&datasheet_prom, DATASHEET_D2, DATASHEET_D1, &temperature, &pressure);
+
+    // The datasheet truncates to 2007 and 100009; the exact values are 2007.82 and 100009.4
+    zassert_within(temperature, ref_temperature, COMPENSATE_TEMPERATURE_TOL_CDEG,
+                   "temperature %d, reference %f", temperature, ref_temperature);
+    zassert_within(pressure, ref_pressure, COMPENSATE_PRESSURE_TOL_PA, "pressure %d, reference %f",
+                   pressure, ref_pressure);
+}
+
+ZTEST(baro_math, test_compensate_matches_reference)
+{
+    double worst_temperature = 0.0;
+    double worst_pressure = 0.0;
+
+    for (int i = 0; i < COMPENSATE_CASES; i++) {
+        struct ms5611_prom prom;
+        uint32_t d2;
+        uint32_t d1;
+        double ref_temperature;
+        double ref_pressure;
+        int32_t temperature;
+        int32_t pressure;
+
+        random_case(&prom, &d2, &d1);
+        reference_compensate(&prom, d2, d1, &ref_temperature, &ref_pressure);
+        ms5611_compensate_int(&prom, d2, d1, &temperature, &pressure);
+
+        worst_temperature = MAX(worst_temperature, fabs(temperature - ref_temperature));
+        worst_pressure = MAX(worst_pressure, fabs(pressure - ref_pressure));
+    }
+
+    LOG_INF("Compensation, %d cases: worst %.3f Pa, %.3f x 0.01 C", COMPENSATE_CASES,
+            worst_pressure, worst_temperature);
+
+    zassert_true(worst_pressure <= COMPENSATE_PRESSURE_TOL_PA, "pressure off by %f Pa",
+                 worst_pressure);
+    zassert_true(worst_temperature <= COMPENSATE_TEMPERATURE_TOL_CDEG,
+                 "temperature off by %f x 0.01 C", worst_temperature);
+}
+
+ZTEST(baro_math, test_altitude_matches_reference)
+{
+    double worst = 0.0;
+    double worst_pressure = 0.0;
+
+    // 1 to 1100 hPa in 0.1 % steps, -40 to +60 °C
+    for (double p = 100.0; p <= 110000.0; p *= 1.001) {
+        for (int t = -40; t <= 60; t += 10) {
+            double ref = reference_altitude(p, t);
+            float h = baro_altitude_m((float)p, (float)t);
+            double excess = fabs(h - ref) - ALTITUDE_TOL_REL * fabs(ref);
+
+            if (excess > worst) {
+                worst = excess;
+                worst_pressure = p;
+            }
+        }
+    }
+
+    LOG_INF("Altitude: worst error %.4f m beyond %g of the altitude (at %.0f Pa)", worst,
+            ALTITUDE_TOL_REL, worst_pressure);
+
+    zassert_true(worst <= ALTITUDE_TOL_M, "altitude off by %f m + %g relative at %f Pa", worst,
+                 ALTITUDE_TOL_REL, worst_pressure);
+}
+
+ZTEST(baro_math, test_compensate_cycles)
+{
+    struct bench_stat old_path = {0}, new_path = {0};
+    volatile int32_t sink;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        struct ms5611_prom prom;
+        uint32_t d2;
+        uint32_t d1;
+        int32_t temperature;
+        int32_t pressure;
+
+        random_case(&prom, &d2, &d1);
+
+        uint32_t start = bench_stamp();
+
+        legacy_compensate(&prom, (int32_t)d2, (int32_t)d1, &temperature, &pressure);
+        bench_record(&old_path, start);
+        sink = pressure;
+
+        start = bench_stamp();
+        ms5611_compensate_int(&prom, d2, d1, &temperature, &pressure);
+        bench_record(&new_path, start);
+        sink = pressure;
+    }
+
+    ARG_UNUSED(sink);
+    LOG_INF("MS5611 compensation, %d samples:", BENCH_ITERATIONS);
+    bench_report("compensate", "divide:", &old_path, &new_path);
+}
+
+ZTEST(baro_math, test_altitude_cycles)
+{
+    struct bench_stat old_path = {0}, new_path = {0};
+    volatile float sink;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        float p = 100.0f + (float)test_rand(110000);
+        float t = -40.0f + (float)test_rand(100);
+
+        uint32_t start = bench_stamp();
+
+        sink = legacy_altitude(p, t);
+        bench_record(&old_path, start);
+
+        start = bench_stamp();
+        sink = baro_altitude_m(p, t);
+        bench_record(&new_path, start);
+    }
+
+    ARG_UNUSED(sink);
+    LOG_INF("Pressure altitude, %d samples:", BENCH_ITERATIONS);
+    bench_report("altitude", "logf:", &old_path, &new_path);
+}
+
+ZTEST_SUITE(baro_math, NULL, NULL, NULL, NULL, NULL);
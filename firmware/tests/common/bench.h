@@ -0,0 +1,61 @@
+#ifndef FALCON_TEST_BENCH_H
+#define FALCON_TEST_BENCH_H
+
+/*
+ * Timing for the benchmark tests. On native_sim, times are host nanoseconds:
+ * they follow the host's load and say nothing about the flight computer, so
+ * tests only log them. Run on ubcrocket_polarity for CPU cycles.
+ */
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#ifdef CONFIG_BOARD_NATIVE_SIM
+#include <native_rtc.h>
+#define BENCH_UNIT "ns"
+#else
+#define BENCH_UNIT "cycles"
+#endif
+
+struct bench_stat {
+    uint64_t total;
+    uint32_t max;
+    uint32_t count;
+};
+
+/**
+ * @brief Free-running 32-bit timestamp: host nanoseconds on native_sim, cycles
+ * on hardware.
+ */
+static inline uint32_t bench_stamp(void)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    uint32_t nsec;
+    uint64_t sec;
+
+    native_rtc_gettime(RTC_CLOCK_REALTIME, &nsec, &sec);
+    return (uint32_t)(sec * NSEC_PER_SEC + nsec);
+#else
+    return k_cycle_get_32();
+#endif
+}
+
+/**
+ * @brief Add the time since start, a bench_stamp(), to s.
+ */
+static inline void bench_record(struct bench_stat *s, uint32_t start)
+{
+    uint32_t elapsed = bench_stamp() - start;
+
+    s->total += elapsed;
+    s->max = MAX(s->max, elapsed);
+    s->count++;
+}
+
+static inline uint32_t bench_mean(const struct bench_stat *s)
+{
+    return s->count ? (uint32_t)(s->total / s->count) : 0;
+}
+
+#endif
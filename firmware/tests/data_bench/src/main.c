@@ -0,0 +1,491 @@
+/*
+ * Stress benchmark for the shared telemetry topics in data.c.
+ *
+ * A set of threads mirroring the flight threads (priorities and read/write
+ * mix) hammer every topic at once, first through data.c's topic rings and
+ * then through a copy of the previous k_mutex implementation. Every call is
+ * timed and the reader/writer latency percentiles are printed side by side.
+ *
+ * On native_sim, threads only interleave at their sleep points and the times
+ * are the host's (see bench.h), so the two columns cannot show which design
+ * is faster under preemption; only a ubcrocket_polarity run can.
+ */
+#include <stdlib.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/ztest.h>
+
+#include "bench.h"
+#include "data.h"
+#include "event_journal.h"
+
+LOG_MODULE_REGISTER(data_bench, LOG_LEVEL_INF);
+
+#define BENCH_DURATION_MS 2000
+#define BENCH_MAX_SAMPLES 8192
+#define BENCH_STACK_SIZE 2048
+
+enum bench_topic {
+    TOPIC_IMU,
+    TOPIC_BARO,
+    TOPIC_STATE,
+    TOPIC_PYRO,
+    TOPIC_GPS,
+    TOPIC_CAMERA,
+    TOPIC_COUNT,
+};
+
+#define T(topic) BIT(TOPIC_##topic)
+#define ALL_TOPICS (BIT(TOPIC_COUNT) - 1)
+
+/* Largest topic struct, so one buffer fits any of them */
+union topic_buf {
+    struct imu_data imu;
+    struct baro_data baro;
+    struct state_data state;
+    struct pyro_data pyro;
+    struct gps_data gps;
+    struct camera_data camera;
+};
+
+struct bench_backend {
+    const char *name;
+    void (*write)(enum bench_topic topic, const union topic_buf *buf);
+    void (*read)(enum bench_topic topic, union topic_buf *buf);
+};
+
+/* One entry per flight thread that touches data.c. Every topic has one
+ * writer, as in flight: cmd_exec stands in for the system workqueue that
+ * publishes the camera topic. */
+struct bench_role {
+    const char *name;
+    int priority;
+    uint32_t period_us;
+    uint32_t write_mask;
+    uint32_t read_mask;
+};
+
+static const struct bench_role roles[] = {
+    {"pyro", 0, 700, T(PYRO), T(PYRO)},
+    {"baro", 1, 1100, T(BARO), T(STATE)},
+    {"imu", 5, 500, T(IMU), 0},
+    {"state", 5, 900, T(STATE), T(BARO) | T(PYRO)},
+    {"radio", 5, 3000, 0, T(IMU) | T(BARO) | T(STATE) | T(GPS) | T(CAMERA)},
+    {"gps", 6, 5000, T(GPS), 0},
+    {"logger", 7, 1300, 0, ALL_TOPICS & ~T(CAMERA)},
+    {"cmd_exec", 7, 4000, T(CAMERA), T(CAMERA)},
+};
+
+#define ROLE_COUNT ARRAY_SIZE(roles)
+
+K_THREAD_STACK_ARRAY_DEFINE(bench_stacks, ROLE_COUNT, BENCH_STACK_SIZE);
+static struct k_thread bench_threads[ROLE_COUNT];
+
+static const struct bench_backend *active_backend;
+static atomic_t bench_stop;
+
+struct latency_samples {
+    atomic_t count;
+    uint32_t ns[BENCH_MAX_SAMPLES];
+};
+
+static struct latency_samples read_samples;
+static struct latency_samples write_samples;
+
+/* ---- Timing ---- */
+
+static void record_sample(struct latency_samples *s, uint32_t start)
+{
+    uint32_t elapsed = bench_stamp() - start;
+    atomic_val_t idx = atomic_inc(&s->count);
+
+#ifndef CONFIG_BOARD_NATIVE_SIM
+    elapsed = (uint32_t)k_cyc_to_ns_floor64(elapsed);
+#endif
+    if (idx < BENCH_MAX_SAMPLES) {
+        s->ns[idx] = elapsed;
+    }
+}
+
+/* ---- Backend: data.c topic rings ---- */
+
+static void ring_write(enum bench_topic topic, const union topic_buf *buf)
+{
+    switch (topic) {
+    case TOPIC_IMU:
+        set_imu_data(&buf->imu);
+        break;
+    case TOPIC_BARO:
+        set_baro_data(&buf->baro);
+        break;
+    case TOPIC_STATE:
+        set_state_data(&buf->state);
+        break;
+    case TOPIC_PYRO:
+        set_pyro_data(&buf->pyro);
+        break;
+    case TOPIC_GPS:
+        set_gps_data(&buf->gps);
+        break;
+    case TOPIC_CAMERA:
+        set_camera_data(&buf->camera);
+        break;
+    default:
+        break;
+    }
+}
+
+static void ring_read(enum bench_topic topic, union topic_buf *buf)
+{
+    switch (topic) {
+    case TOPIC_IMU:
+        get_imu_data(&buf->imu);
+        break;
+    case TOPIC_BARO:
+        get_baro_data(&buf->baro);
+        break;
+    case TOPIC_STATE:
+        get_state_data(&buf->state);
+        break;
+    case TOPIC_PYRO:
+        get_pyro_data(&buf->pyro);
+        break;
+    case TOPIC_GPS:
+        get_gps_data(&buf->gps);
+        break;
+    case TOPIC_CAMERA:
+        get_camera_data(&buf->camera);
+        break;
+    default:
+        break;
+    }
+}
+
+static const struct bench_backend ring_backend = {
+    .name = "ring",
+    .write = ring_write,
+    .read = ring_read,
+};
+
+/* ---- Backend: previous k_mutex implementation, kept here as the baseline ---- */
+
+static union topic_buf mutex_storage[TOPIC_COUNT];
+static struct k_mutex mutex_locks[TOPIC_COUNT];
+
+static size_t topic_size(enum bench_topic topic)
+{
+    static const size_t sizes[TOPIC_COUNT] = {
+        [TOPIC_IMU] = sizeof(struct imu_data),   [TOPIC_BARO] = sizeof(struct baro_data),
+        [TOPIC_STATE] = sizeof(struct state_data), [TOPIC_PYRO] = sizeof(struct pyro_data),
+        [TOPIC_GPS] = sizeof(struct gps_data),   [TOPIC_CAMERA] = sizeof(struct camera_data),
+    };
+
+    return sizes[topic];
+}
+
+static void mutex_write(enum bench_topic topic, const union topic_buf *buf)
+{
+    k_mutex_lock(&mutex_locks[topic], K_FOREVER);
+    memcpy(&mutex_storage[topic], buf, topic_size(topic));
+    k_mutex_unlock(&mutex_locks[topic]);
+}
+
+static void mutex_read(enum bench_topic topic, union topic_buf *buf)
+{
+    k_mutex_lock(&mutex_locks[topic], K_FOREVER);
+    memcpy(buf, &mutex_storage[topic], topic_size(topic));
+    k_mutex_unlock(&mutex_locks[topic]);
+}
+
+static const struct bench_backend mutex_backend = {
+    .name = "mutex",
+    .write = mutex_write,
+    .read = mutex_read,
+};
+
+/* ---- Workload ---- */
+
+static void bench_thread_fn(void *p1, void *p2, void *p3)
+{
+    const struct bench_role *role = p1;
+    /* Writes publish a constant payload so set_pyro_data/set_camera_data
+     * see no flag changes and stay silent */
+    static const union topic_buf write_buf;
+    union topic_buf read_buf;
+
+    while (!atomic_get(&bench_stop)) {
+        for (int topic = 0; topic < TOPIC_COUNT; topic++) {
+            if (role->write_mask & BIT(topic)) {
+                uint32_t start = bench_stamp();
+                active_backend->write(topic, &write_buf);
+                record_sample(&write_samples, start);
+            }
+
+            if (role->read_mask & BIT(topic)) {
+                uint32_t start = bench_stamp();
+                active_backend->read(topic, &read_buf);
+                record_sample(&read_samples, start);
+            }
+        }
+
+        k_usleep(role->period_us);
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+struct latency_report {
+    size_t count;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+};
+
+static uint32_t percentile(const uint32_t *sorted, size_t count, uint32_t permille)
+{
+    size_t idx = ((count - 1) * permille) / 1000;
+
+    return sorted[idx];
+}
+
+static struct latency_report summarize(struct latency_samples *s)
+{
+    struct latency_report r = {0};
+
+    r.count = MIN((size_t)atomic_get(&s->count), (size_t)BENCH_MAX_SAMPLES);
+    if (r.count == 0) {
+        return r;
+    }
+
+    qsort(s->ns, r.count, sizeof(s->ns[0]), compare_u32);
+    r.p50 = percentile(s->ns, r.count, 500);
+    r.p90 = percentile(s->ns, r.count, 900);
+    r.p99 = percentile(s->ns, r.count, 990);
+    r.p999 = percentile(s->ns, r.count, 999);
+    r.max = s->ns[r.count - 1];
+    return r;
+}
+
+static void print_report(const char *backend, const char *kind, const struct latency_report *r)
+{
+    LOG_INF("%-8s %-6s n=%-6zu p50=%6u ns  p90=%6u ns  p99=%6u ns  p99.9=%6u ns  max=%6u ns",
+            backend, kind, r->count, r->p50, r->p90, r->p99, r->p999, r->max);
+}
+
+static void run_backend(const struct bench_backend *backend, struct latency_report *reads,
+                        struct latency_report *writes)
+{
+    active_backend = backend;
+    atomic_set(&bench_stop, 0);
+    atomic_set(&read_samples.count, 0);
+    atomic_set(&write_samples.count, 0);
+
+    for (size_t i = 0; i < ROLE_COUNT; i++) {
+        k_thread_create(&bench_threads[i], bench_stacks[i], K_THREAD_STACK_SIZEOF(bench_stacks[i]),
+                        bench_thread_fn, (void *)&roles[i], NULL, NULL, roles[i].priority, 0,
+                        K_NO_WAIT);
+        k_thread_name_set(&bench_threads[i], roles[i].name);
+    }
+
+    k_sleep(K_MSEC(BENCH_DURATION_MS));
+    atomic_set(&bench_stop, 1);
+
+    for (size_t i = 0; i < ROLE_COUNT; i++) {
+        k_thread_join(&bench_threads[i], K_FOREVER);
+    }
+
+    *reads = summarize(&read_samples);
+    *writes = summarize(&write_samples);
+}
+
+ZTEST(data_bench, test_ring_vs_mutex)
+{
+    struct latency_report ring_reads, ring_writes;
+    struct latency_report mtx_reads, mtx_writes;
+
+    for (int i = 0; i < TOPIC_COUNT; i++) {
+        k_mutex_init(&mutex_locks[i]);
+    }
+
+    run_backend(&ring_backend, &ring_reads, &ring_writes);
+    run_backend(&mutex_backend, &mtx_reads, &mtx_writes);
+
+    LOG_INF("Topic access latency over %d ms, %zu threads:", BENCH_DURATION_MS, ROLE_COUNT);
+    print_report("ring", "read", &ring_reads);
+    print_report("mutex", "read", &mtx_reads);
+    print_report("ring", "write", &ring_writes);
+    print_report("mutex", "write", &mtx_writes);
+
+    zassert_true(ring_reads.count > 0 && ring_writes.count > 0, "ring run recorded no samples");
+    zassert_true(mtx_reads.count > 0 && mtx_writes.count > 0, "mutex run recorded no samples");
+}
+
+ZTEST(data_bench, test_round_trip)
+{
+    struct baro_data in = {
+        .altitude = 123.0f, .velocity = -4.5f, .timestamp = 42, .timestamp_us = 42123};
+    struct baro_data out;
+
+    set_baro_data(&in);
+    get_baro_data(&out);
+
+    zassert_within(out.altitude, in.altitude, 0.0001f, "altitude should round-trip");
+    zassert_within(out.velocity, in.velocity, 0.0001f, "velocity should round-trip");
+    zassert_equal(out.timestamp, in.timestamp, "timestamp should round-trip");
+    zassert_equal(out.timestamp_us, in.timestamp_us, "timestamp_us should round-trip");
+}
+
+ZTEST(data_bench, test_timestamp_us_matches_uptime)
+{
+    int64_t before_ms = k_uptime_get();
+    int64_t now_us = data_timestamp_us();
+    int64_t after_ms = k_uptime_get();
+
+    // Same epoch as k_uptime_get(), so the millisecond fields can be derived from it
+    zassert_true(now_us / USEC_PER_MSEC >= before_ms - 1, "timestamp_us behind uptime");
+    zassert_true(now_us / USEC_PER_MSEC <= after_ms + 1, "timestamp_us ahead of uptime");
+    zassert_true(data_timestamp_us() >= now_us, "timestamp_us should not go backwards");
+}
+
+ZTEST(data_bench, test_snapshot_generation)
+{
+    struct data_snapshot before, after;
+    struct state_data state = {.state = 3, .timestamp = 7};
+    struct baro_data baro = {.altitude = 55.0f, .timestamp = 8};
+
+    get_data_snapshot(&before);
+    set_state_data(&state);
+    set_baro_data(&baro);
+    get_data_snapshot(&after);
+
+    zassert_equal(after.generation, before.generation + 2, "one generation per publish");
+    zassert_equal(after.state.timestamp, state.timestamp, "snapshot should see state publish");
+    zassert_equal(after.baro.timestamp, baro.timestamp, "snapshot should see baro publish");
+}
+
+ZTEST(data_bench, test_history_cursor)
+{
+    struct data_cursor cursor;
+    // Scales with the ODR; keep it off the ztest stack
+    static struct imu_data out[CONFIG_FALCON_HISTORY_IMU];
+    size_t n;
+
+    data_cursor_init(DATA_TOPIC_IMU, &cursor);
+    zassert_equal(get_imu_history(&cursor, out, ARRAY_SIZE(out)), 0, "nothing published yet");
+
+    for (int i = 0; i < 5; i++) {
+        struct imu_data in = {.timestamp = i};
+
+        set_imu_data(&in);
+    }
+
+    // Partial read leaves the rest for the next call
+    n = get_imu_history(&cursor, out, 3);
+    zassert_equal(n, 3, "should return max samples");
+    zassert_equal(out[0].timestamp, 0, "oldest sample first");
+    zassert_equal(out[2].timestamp, 2, "samples in publish order");
+
+    n = get_imu_history(&cursor, out, ARRAY_SIZE(out));
+    zassert_equal(n, 2, "should return the remaining samples");
+    zassert_equal(out[1].timestamp, 4, "last sample should be the newest");
+    zassert_equal(cursor.dropped, 0, "nothing should be dropped");
+
+    // Lap the reader: only the configured depth survives
+    for (int i = 0; i < CONFIG_FALCON_HISTORY_IMU + 10; i++) {
+        struct imu_data in = {.timestamp = 100 + i};
+
+        set_imu_data(&in);
+    }
+
+    n = get_imu_history(&cursor, out, ARRAY_SIZE(out));
+    zassert_equal(n, CONFIG_FALCON_HISTORY_IMU, "full history should be readable");
+    zassert_equal(cursor.dropped, 10, "overwritten samples should be counted");
+    zassert_equal(out[0].timestamp, 110, "oldest retained sample first");
+    zassert_equal(out[n - 1].timestamp, 100 + CONFIG_FALCON_HISTORY_IMU + 9,
+                  "newest sample last");
+}
+
+ZTEST(data_bench, test_seq_accounting)
+{
+    struct data_seq_stats stats = {0};
+    struct gps_data in = {.seq = 999}; // Setters stamp their own sequence
+    struct gps_data out;
+    uint32_t base;
+
+    // Other tests may already have published GPS samples
+    get_gps_data(&out);
+    base = out.seq;
+
+    set_gps_data(&in);
+    get_gps_data(&out);
+    zassert_equal(out.seq, base + 1, "each publish should bump seq by one");
+    zassert_true(data_seq_track(&stats, out.seq), "first sample is new");
+
+    // Read the same sample twice
+    zassert_false(data_seq_track(&stats, out.seq), "re-read is not new");
+    zassert_equal(stats.duplicate, 1, "re-read should count as duplicate");
+
+    // Three publishes, only the last one read
+    for (int i = 0; i < 3; i++) {
+        set_gps_data(&in);
+    }
+    get_gps_data(&out);
+    zassert_equal(out.seq, base + 4, "seq should count every publish");
+    zassert_true(data_seq_track(&stats, out.seq), "latest sample is new");
+    zassert_equal(stats.missed, 2, "skipped samples should count as missed");
+    zassert_false(data_seq_track(&stats, 0), "seq 0 is never a sample");
+}
+
+ZTEST(data_bench, test_journal_records_flag_changes)
+{
+    struct journal_cursor cursor;
+    struct journal_event events[4];
+    struct pyro_data pyro;
+
+    get_pyro_data(&pyro);
+    journal_cursor_init(&cursor);
+
+    // Re-publishing the same flags records nothing
+    set_pyro_data(&pyro);
+    zassert_equal(journal_read(&cursor, events, ARRAY_SIZE(events)), 0, "no change, no event");
+
+    pyro.drogue_fired = !pyro.drogue_fired;
+    pyro.main_fail = !pyro.main_fail;
+    set_pyro_data(&pyro);
+
+    zassert_equal(journal_read(&cursor, events, ARRAY_SIZE(events)), 2, "one event per flag");
+    zassert_equal(events[0].id, JOURNAL_PYRO_DROGUE_FIRED, "drogue_fired recorded");
+    zassert_equal(events[0].value, pyro.drogue_fired, "new value recorded");
+    zassert_equal(events[1].id, JOURNAL_PYRO_MAIN_FAIL, "main_fail recorded");
+    zassert_true(journal_event_is_error(events[1].id), "fail flags are errors");
+    zassert_equal(events[1].seq, events[0].seq + 1, "journal seq is gap-free");
+}
+
+ZTEST(data_bench, test_journal_overrun)
+{
+    struct journal_cursor cursor;
+    struct journal_event events[CONFIG_FALCON_JOURNAL_SIZE];
+    size_t n;
+
+    journal_cursor_init(&cursor);
+    for (int i = 0; i < CONFIG_FALCON_JOURNAL_SIZE + 5; i++) {
+        journal_record(JOURNAL_CAMERA_RECORDING, i);
+    }
+
+    n = journal_read(&cursor, events, ARRAY_SIZE(events));
+    zassert_equal(n, CONFIG_FALCON_JOURNAL_SIZE, "whole journal should be readable");
+    zassert_equal(cursor.dropped, 5, "overwritten events should be counted");
+    zassert_equal(events[0].value, 5, "oldest surviving event first");
+    zassert_equal(events[n - 1].value, CONFIG_FALCON_JOURNAL_SIZE + 4, "newest event last");
+}
+
+ZTEST_SUITE(data_bench, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,210 @@
+/*
+ * On-pad IMU calibration (imu_calib.h), against a simulated BMI088 with a
+ * known gyro bias and accelerometer offset, scale and cross-axis error.
+ *
+ * Checks what each setup can recover: the gyro bias and a 1 g reading from
+ * one orientation, the full accelerometer model from all six, and nothing
+ * at all from a moving IMU. Then times the per-sample correction.
+ */
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include "bench.h"
+#include "imu_calib.h"
+
+LOG_MODULE_REGISTER(imu_calib_test, LOG_LEVEL_INF);
+
+#define BENCH_ITERATIONS 1000
+#define WINDOWS_PER_POSE 16
+
+#define ACCEL_NOISE 0.02f  // m/s², about the BMI088 at 400 Hz
+#define GYRO_NOISE 0.003f  // rad/s
+#define GYRO_BIAS_TOL 1e-3f
+#define ACCEL_TOL 0.02f
+
+// The simulated sensor: raw = S a + offset, raw gyro = w + bias
+static const float sim_sens[9] = {1.02f, 0.004f, -0.006f, 0.003f, 0.98f, 0.005f,
+                                  -0.002f, 0.007f, 1.01f};
+static const float sim_offset[3] = {0.20f, -0.15f, 0.10f};
+static const float sim_gyro_bias[3] = {0.010f, -0.005f, 0.003f};
+
+/* Deterministic inputs, so a failure reproduces */
+static uint32_t rand_state = 12345;
+
+static float test_rand_unit(void)
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return (float)(rand_state >> 8) / (float)(1U << 24);
+}
+
+// Roughly normal, from the sum of four uniforms
+static float test_noise(float sigma)
+{
+    float sum = test_rand_unit() + test_rand_unit() + test_rand_unit() + test_rand_unit();
+
+    return (sum - 2.0f) * 1.7320508f * sigma;
+}
+
+static void sim_sample(const float accel_true[3], const float gyro_true[3], float accel[3],
+                       float gyro[3])
+{
+    for (int i = 0; i < 3; i++) {
+        accel[i] = sim_sens[i * 3] * accel_true[0] + sim_sens[i * 3 + 1] * accel_true[1] +
+                   sim_sens[i * 3 + 2] * accel_true[2] + sim_offset[i] + test_noise(ACCEL_NOISE);
+        gyro[i] = gyro_true[i] + sim_gyro_bias[i] + test_noise(GYRO_NOISE);
+    }
+}
+
+/**
+ * @brief Feed whole windows of a still IMU with gravity along +/- axis.
+ * @return how many of them updated the coefficients
+ */
+static int feed_pose(struct imu_calib *cal, int axis, float sign, int windows)
+{
+    static int64_t now_us;
+    float accel_true[3] = {0};
+    const float still[3] = {0};
+    int updates = 0;
+
+    accel_true[axis] = sign * IMU_CALIB_G;
+    for (int i = 0; i < windows * IMU_CALIB_WINDOW; i++) {
+        float accel[3], gyro[3];
+
+        sim_sample(accel_true, still, accel, gyro);
+        now_us += 2500;
+        updates += imu_calib_add(cal, accel, gyro, now_us) ? 1 : 0;
+    }
+
+    return updates;
+}
+
+// Corrected reading of a still IMU in a pose, without noise
+static void corrected_pose(const struct imu_calib_data *coef, int axis, float sign,
+                           float accel[3])
+{
+    float accel_true[3] = {0};
+    float gyro[3] = {0};
+
+    accel_true[axis] = sign * IMU_CALIB_G;
+    for (int i = 0; i < 3; i++) {
+        accel[i] = sim_sens[i * 3] * accel_true[0] + sim_sens[i * 3 + 1] * accel_true[1] +
+                   sim_sens[i * 3 + 2] * accel_true[2] + sim_offset[i];
+    }
+    imu_calib_apply(coef, accel, gyro);
+}
+
+ZTEST(imu_calib, test_single_pose)
+{
+    struct imu_calib cal;
+    float accel[3];
+
+    imu_calib_init(&cal);
+    zassert_equal(feed_pose(&cal, 0, 1.0f, WINDOWS_PER_POSE), WINDOWS_PER_POSE,
+                  "every still window should be used");
+
+    const struct imu_calib_data *coef = &cal.coef;
+
+    zassert_true(coef->valid, "gyro bias should be valid after %d windows", WINDOWS_PER_POSE);
+    zassert_equal(coef->poses, BIT(0), "only +x up should have been seen");
+    for (int i = 0; i < 3; i++) {
+        zassert_within(coef->gyro_bias[i], sim_gyro_bias[i], GYRO_BIAS_TOL,
+                       "gyro bias %d: %f", i, (double)coef->gyro_bias[i]);
+        zassert_within(coef->accel_offset[i], 0.0f, 1e-6f, "no offset from one pose");
+    }
+
+    corrected_pose(coef, 0, 1.0f, accel);
+    zassert_within(sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]),
+                   IMU_CALIB_G, ACCEL_TOL, "the resting pose should read 1 g");
+}
+
+ZTEST(imu_calib, test_six_positions)
+{
+    struct imu_calib cal;
+    float accel[3];
+
+    imu_calib_init(&cal);
+    for (int axis = 0; axis < 3; axis++) {
+        feed_pose(&cal, axis, 1.0f, WINDOWS_PER_POSE);
+        feed_pose(&cal, axis, -1.0f, WINDOWS_PER_POSE);
+    }
+
+    const struct imu_calib_data *coef = &cal.coef;
+
+    zassert_equal(coef->poses, 0x3f, "all six poses should have been seen");
+    for (int i = 0; i < 3; i++) {
+        zassert_within(coef->accel_offset[i], sim_offset[i], ACCEL_TOL, "offset %d: %f", i,
+                       (double)coef->accel_offset[i]);
+    }
+
+    // Every face, misalignment included, reads exactly +/- 1 g along its axis
+    for (int axis = 0; axis < 3; axis++) {
+        for (float sign = -1.0f; sign <= 1.0f; sign += 2.0f) {
+            corrected_pose(coef, axis, sign, accel);
+            for (int i = 0; i < 3; i++) {
+                zassert_within(accel[i], (i == axis) ? sign * IMU_CALIB_G : 0.0f, ACCEL_TOL,
+                               "pose %+d axis %d reads %f on %d", (int)sign, axis,
+                               (double)accel[i], i);
+            }
+        }
+    }
+}
+
+ZTEST(imu_calib, test_motion_rejected)
+{
+    struct imu_calib cal;
+    const float accel_true[3] = {IMU_CALIB_G, 0.0f, 0.0f};
+    const float turning[3] = {0.0f, 0.2f, 0.0f}; // Raising the rail, slowly and steadily
+    int updates = 0;
+
+    imu_calib_init(&cal);
+    for (int i = 0; i < WINDOWS_PER_POSE * IMU_CALIB_WINDOW; i++) {
+        float accel[3], gyro[3];
+
+        sim_sample(accel_true, turning, accel, gyro);
+        updates += imu_calib_add(&cal, accel, gyro, 0) ? 1 : 0;
+    }
+
+    // Vibration: still on average, far too noisy
+    for (int i = 0; i < WINDOWS_PER_POSE * IMU_CALIB_WINDOW; i++) {
+        float accel[3], gyro[3];
+        const float still[3] = {0};
+
+        sim_sample(accel_true, still, accel, gyro);
+        accel[i % 3] += (i & 1) ? 2.0f : -2.0f;
+        updates += imu_calib_add(&cal, accel, gyro, 0) ? 1 : 0;
+    }
+
+    zassert_equal(updates, 0, "moving windows should be rejected");
+    zassert_false(cal.coef.valid, "no calibration from a moving IMU");
+    zassert_within(cal.coef.accel_matrix[0], 1.0f, 0.0f, "the correction should stay identity");
+}
+
+ZTEST(imu_calib, test_apply_cycles)
+{
+    struct imu_calib cal;
+    struct bench_stat stat = {0};
+    volatile float sink;
+
+    imu_calib_init(&cal);
+    for (int axis = 0; axis < 3; axis++) {
+        feed_pose(&cal, axis, 1.0f, 2);
+        feed_pose(&cal, axis, -1.0f, 2);
+    }
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        float accel[3] = {test_noise(10.0f), test_noise(10.0f), test_noise(10.0f)};
+        float gyro[3] = {test_noise(1.0f), test_noise(1.0f), test_noise(1.0f)};
+        uint32_t start = bench_stamp();
+
+        imu_calib_apply(&cal.coef, accel, gyro);
+        bench_record(&stat, start);
+        sink = accel[0] + gyro[0];
+    }
+
+    ARG_UNUSED(sink);
+    LOG_INF("IMU correction, %d samples: mean=%u max=%u %s", BENCH_ITERATIONS,
+            bench_mean(&stat), stat.max, BENCH_UNIT);
+}
+
+ZTEST_SUITE(imu_calib, NULL, NULL, NULL, NULL, NULL);
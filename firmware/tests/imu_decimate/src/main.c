@@ -0,0 +1,155 @@
+/*
+ * IMU anti-alias filter and decimator (imu_decimate.h).
+ *
+ * Feeds synthetic full-rate streams through the decimator and checks the
+ * filtered topic's contract: unity gain at DC, in-band motion kept,
+ * vibration above the output Nyquist frequency attenuated instead of
+ * aliased, and timestamps that line up with the signal once the group
+ * delay is taken out. Then times the block filter per input sample.
+ */
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include "bench.h"
+#include "imu_decimate.h"
+
+LOG_MODULE_REGISTER(imu_decimate_test, LOG_LEVEL_INF);
+
+#define ODR_HZ CONFIG_FALCON_IMU_ODR_HZ
+#define PERIOD_US (USEC_PER_SEC / ODR_HZ)
+#define OUTPUT_NYQUIST_HZ (0.5f * ODR_HZ / IMU_DECIMATE_FACTOR)
+#define SETTLE_BLOCKS (IMU_DECIMATE_TAPS / IMU_DECIMATE_BLOCK + 2)
+#define MEASURE_BLOCKS 64
+#define BENCH_BLOCKS 256
+
+static struct imu_decimator dec;
+static struct imu_data out[IMU_DECIMATE_OUTPUTS];
+
+typedef float (*signal_fn)(int64_t t_us, float param);
+
+static float signal_dc(int64_t t_us, float level)
+{
+    ARG_UNUSED(t_us);
+    return level;
+}
+
+static float signal_sine(int64_t t_us, float freq_hz)
+{
+    return sinf(2.0f * 3.14159265f * freq_hz * (float)t_us * 1e-6f);
+}
+
+static float signal_ramp(int64_t t_us, float slope_per_s)
+{
+    return slope_per_s * (float)t_us * 1e-6f;
+}
+
+/**
+ * @brief Run a signal on every channel through the decimator.
+ * @param peak Largest |output| once the filter has settled
+ * @param worst_error Largest |output - signal at the output's timestamp|
+ */
+static void run_signal(signal_fn fn, float param, float *peak, float *worst_error)
+{
+    int64_t t_us = 0;
+
+    imu_decimate_init(&dec);
+    *peak = 0.0f;
+    *worst_error = 0.0f;
+
+    for (int block = 0; block < SETTLE_BLOCKS + MEASURE_BLOCKS; block++) {
+        for (int i = 0; i < IMU_DECIMATE_BLOCK; i++) {
+            float v = fn(t_us, param);
+            const float accel[3] = {v, v, v};
+            const float gyro[3] = {v, v, v};
+            int n = imu_decimate_add(&dec, accel, gyro, t_us, out);
+
+            t_us += PERIOD_US;
+            if (n == 0 || block < SETTLE_BLOCKS) {
+                continue;
+            }
+
+            zassert_equal(n, IMU_DECIMATE_OUTPUTS, "a full block should yield every output");
+            for (int j = 0; j < n; j++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    zassert_within(out[j].gyro[axis], out[j].accel[axis], 1e-6f,
+                                   "every channel should be filtered the same");
+                }
+                *peak = MAX(*peak, fabsf(out[j].accel[0]));
+                *worst_error =
+                    MAX(*worst_error, fabsf(out[j].accel[0] - fn(out[j].timestamp_us, param)));
+            }
+        }
+    }
+}
+
+ZTEST(imu_decimate, test_dc_gain)
+{
+    float peak, error;
+
+    run_signal(signal_dc, 9.80665f, &peak, &error);
+    zassert_within(peak, 9.80665f, 1e-4f, "gravity should pass unchanged, got %f",
+                   (double)peak);
+}
+
+ZTEST(imu_decimate, test_passband)
+{
+    float peak, error;
+    float freq = 0.1f * OUTPUT_NYQUIST_HZ; // 5 Hz at 400 Hz / 4: airframe motion
+
+    run_signal(signal_sine, freq, &peak, &error);
+    zassert_within(peak, 1.0f, 0.02f, "%.1f Hz should pass, gain %f", (double)freq,
+                   (double)peak);
+}
+
+ZTEST(imu_decimate, test_alias_rejected)
+{
+    float peak, error;
+
+    // Everything from 1.2x the output Nyquist frequency up to the input's
+    // would otherwise fold into the output band
+    for (float f = 1.2f * OUTPUT_NYQUIST_HZ; f < 0.5f * ODR_HZ; f += 0.1f * OUTPUT_NYQUIST_HZ) {
+        run_signal(signal_sine, f, &peak, &error);
+        zassert_true(peak < 0.01f, "%.1f Hz should be attenuated 40 dB, gain %f", (double)f,
+                     (double)peak);
+    }
+}
+
+ZTEST(imu_decimate, test_timestamps)
+{
+    float peak, error;
+
+    // A linear-phase filter passes a ramp delayed by exactly its group delay
+    run_signal(signal_ramp, 10.0f, &peak, &error);
+    zassert_true(error < 1e-3f, "ramp off by %f at the stamped times", (double)error);
+}
+
+ZTEST(imu_decimate, test_block_cycles)
+{
+    struct bench_stat stat = {0};
+    float v = 0.0f;
+
+    imu_decimate_init(&dec);
+    for (int block = 0; block < BENCH_BLOCKS; block++) {
+        // Only the sample that completes a block runs the filter
+        for (int i = 0; i < IMU_DECIMATE_BLOCK - 1; i++) {
+            const float s[3] = {v, v, v};
+
+            imu_decimate_add(&dec, s, s, 0, out);
+            v += 0.01f;
+        }
+
+        const float s[3] = {v, v, v};
+        uint32_t start = bench_stamp();
+
+        imu_decimate_add(&dec, s, s, 0, out);
+        bench_record(&stat, start);
+    }
+
+    LOG_INF("IMU decimation, %d taps, /%d, blocks of %d: mean=%u max=%u %s per block, "
+            "%u per input sample",
+            IMU_DECIMATE_TAPS, IMU_DECIMATE_FACTOR, IMU_DECIMATE_BLOCK,
+            bench_mean(&stat), stat.max, BENCH_UNIT, bench_mean(&stat) / IMU_DECIMATE_BLOCK);
+}
+
+ZTEST_SUITE(imu_decimate, NULL, NULL, NULL, NULL, NULL);
@@ -6,6 +6,9 @@
 #include "state_machine/state_machine_internal.h"
 #include "state_machine/state_machine_config.h"
 #include "pyro/pyro_thread.h"
+#include "cyclic_executive.h"
+#include "deploy_latency.h"
+#include "sensors/baro_thread.h"
 #include "data.h"
 
 LOG_MODULE_REGISTER(integration_test, LOG_LEVEL_INF);
@@ -18,13 +21,19 @@ static struct {
     flight_state_id_t target_state;
 } test_scenario;
 
-static void inject_test_data(float altitude, float velocity, bool log)
+static struct k_spinlock scenario_lock;
+
+/**
+ * @brief Publish the current scenario as a baro sample, as the baro thread would.
+ */
+static void publish_scenario(void)
 {
-    test_scenario.altitude_m = altitude;
-    test_scenario.velocity_mps = velocity;
-    test_scenario.timestamp_ms = k_uptime_get();
+    k_spinlock_key_t key = k_spin_lock(&scenario_lock);
+    float altitude = test_scenario.altitude_m;
+    float velocity = test_scenario.velocity_mps;
+    k_spin_unlock(&scenario_lock, key);
 
-    /* Update the global baro data that state machine reads */
+    int64_t now_us = data_timestamp_us();
     struct baro_data baro_update = {
         .baro0 = {
             .altitude = altitude,
@@ -44,18 +53,91 @@ static void inject_test_data(float altitude, float velocity, bool log)
         },
         .altitude = altitude,
         .velocity = velocity,
-        .timestamp = test_scenario.timestamp_ms,
+        .timestamp = now_us / USEC_PER_MSEC,
+        .timestamp_us = now_us,
+        .acquired_cycles = k_cycle_get_32(),
         .alt_variance = 1.0f,  // Small variance for confident estimates
         .vel_variance = 1.0f,
     };
     set_baro_data(&baro_update);
-    
+}
+
+#ifdef CONFIG_FALCON_CYCLIC_EXECUTIVE
+/* The cyclic executive acquires its own baro sample every frame; these
+ * stand in for the baro thread's and publish the scenario instead, so the
+ * executive stays the baro topic's only writer. */
+bool baro_init(void)
+{
+    return true;
+}
+
+void baro_step(void)
+{
+    publish_scenario();
+}
+
+uint32_t baro_period_ms(void)
+{
+    return CONFIG_FALCON_BARO_PERIOD_MS;
+}
+#endif
+
+static void inject_test_data(float altitude, float velocity, bool log)
+{
+    k_spinlock_key_t key = k_spin_lock(&scenario_lock);
+    test_scenario.altitude_m = altitude;
+    test_scenario.velocity_mps = velocity;
+    test_scenario.timestamp_ms = k_uptime_get();
+    k_spin_unlock(&scenario_lock, key);
+
+#ifndef CONFIG_FALCON_CYCLIC_EXECUTIVE
+    /* Update the global baro data that state machine reads */
+    publish_scenario();
+#endif
+
     if (log) {
         LOG_INF("Injected: alt=%.2f m, vel=%.2f m/s", altitude, velocity);
     }
 }
 
-/* Continuously inject test data with live timestamps for a duration */
+/**
+ * @brief Check the latency trace: one decision per evaluated sample, and one
+ * fire and one enqueue per charge fired so far.
+ */
+static bool check_latency_counts(uint32_t fired)
+{
+    struct deploy_latency_stat decision, fire, enqueue;
+    struct state_data state;
+    bool ok = true;
+
+    get_state_data(&state);
+    deploy_latency_get(DEPLOY_LATENCY_DECISION, &decision);
+    deploy_latency_get(DEPLOY_LATENCY_FIRE, &fire);
+    deploy_latency_get(DEPLOY_LATENCY_ENQUEUE, &enqueue);
+
+    LOG_INF("Latency: %u decisions (last %u us, max %u us), %u fires, %u enqueues "
+            "(last %u us)", decision.count, decision.last_us, decision.max_us, fire.count,
+            enqueue.count, enqueue.last_us);
+
+    /* The state machine publishes state_data once per sample it decides on,
+     * just after recording the decision; a step may land between the reads */
+    if (decision.count == 0 || decision.count < state.seq || decision.count > state.seq + 1) {
+        LOG_ERR("Expected one decision per state publish (%u), got %u", state.seq,
+                decision.count);
+        ok = false;
+    }
+    if (fire.count != fired || enqueue.count != fired) {
+        LOG_ERR("Expected %u fires and enqueues, got %u and %u", fired, fire.count,
+                enqueue.count);
+        ok = false;
+    }
+
+    return ok;
+}
+
+/* Continuously inject test data with live timestamps for a duration.
+ * The state machine wakes once per published baro sample, so every phase
+ * has to keep publishing for its repeated checks to accumulate. */
 static void inject_and_wait(float altitude, float velocity, int duration_ms)
 {
     int64_t end_time = k_uptime_get() + duration_ms;
@@ -84,37 +166,38 @@ ZTEST(integration, test_full_flight_sequence)
     LOG_INF("========================================");
 
     /* Start threads */
+#ifdef CONFIG_FALCON_CYCLIC_EXECUTIVE
+    LOG_INF("\nStarting cyclic executive...");
+    start_cyclic_executive();
+#else
     LOG_INF("\nStarting state machine and pyro threads...");
     start_state_machine_thread();
     start_pyro_thread();
+#endif
     
     /* Wait for initialization */
     k_sleep(K_SECONDS(2));
 
     // Standby
     LOG_INF("\n=== PHASE 1: STANDBY ===");
-    inject_test_data(0.0, 0.0, true);
-    k_sleep(K_SECONDS(5));
+    inject_and_wait(0.0, 0.0, 5000);
 
     // Ascent
     LOG_INF("\n=== PHASE 2: ASCENT ===");
     LOG_INF("Injecting altitude > %.2f m and velocity > %.2f m/s", 
             ASCENT_ALTITUDE_THRESHOLD_M, ASCENT_VELOCITY_THRESHOLD_MPS);
-    inject_test_data(ASCENT_ALTITUDE_THRESHOLD_M + 1.0, 
-                     ASCENT_VELOCITY_THRESHOLD_MPS + 1.0, true);
-    k_sleep(K_SECONDS(5));
+    inject_and_wait(ASCENT_ALTITUDE_THRESHOLD_M + 1.0,
+                    ASCENT_VELOCITY_THRESHOLD_MPS + 1.0, 5000);
 
     // Mach lock
     LOG_INF("\n=== PHASE 3: MACH LOCK ===");
     LOG_INF("Injecting velocity > %.2f m/s", MACH_LOCK_VELOCITY_THRESHOLD_MPS);
-    inject_test_data(500.0, MACH_LOCK_VELOCITY_THRESHOLD_MPS + 1.0, true);
-    k_sleep(K_SECONDS(5));
+    inject_and_wait(500.0, MACH_LOCK_VELOCITY_THRESHOLD_MPS + 1.0, 5000);
 
     // Mach unlock
     LOG_INF("\n=== PHASE 4: MACH UNLOCK ===");
     LOG_INF("Injecting velocity < %.2f m/s", MACH_LOCK_VELOCITY_THRESHOLD_MPS);
-    inject_test_data(1000.0, MACH_LOCK_VELOCITY_THRESHOLD_MPS - 1.0, true);
-    k_sleep(K_SECONDS(5));
+    inject_and_wait(1000.0, MACH_LOCK_VELOCITY_THRESHOLD_MPS - 1.0, 5000);
 
     // Drogue descent
     LOG_INF("\n=== PHASE 5: DROGUE DESCENT ===");
@@ -140,13 +223,15 @@ ZTEST(integration, test_full_flight_sequence)
         }
         test_failed = true;
     }
+    if (!check_latency_counts(1)) {
+        test_failed = true;
+    }
 
     // Main descent
     LOG_INF("\n=== PHASE 6: MAIN DESCENT ===");
     LOG_INF("Injecting altitude < %.2f m AGL", MAIN_DEPLOY_ALTITUDE_M);
     LOG_INF("Main should fire immediately...");
-    inject_test_data(MAIN_DEPLOY_ALTITUDE_M - 1.0, -8.0, true);
-    k_sleep(K_SECONDS(5));
+    inject_and_wait(MAIN_DEPLOY_ALTITUDE_M - 1.0, -8.0, 5000);
     
     /* Check main pyro status */
     k_sleep(K_SECONDS(2));  /* Give more time for pyro to react and send acknowledgment */
@@ -163,6 +248,9 @@ ZTEST(integration, test_full_flight_sequence)
         }
         test_failed = true;
     }
+    if (!check_latency_counts(2)) {
+        test_failed = true;
+    }
 
     // Landed
     LOG_INF("\n=== PHASE 7: LANDED ===");
@@ -0,0 +1,291 @@
+/*
+ * MS5611 driver, non-blocking measurement (drivers/sensor/ms5611.h).
+ *
+ * The driver runs on a device whose transfer function is faked: the fake
+ * returns the datasheet's example PROM and conversions, fails on request,
+ * and logs every conversion command it is sent. The tests walk a
+ * measurement through each step, check that a bus error abandons it, that
+ * sample_fetch stays out while one is in flight, and that a measurement
+ * without temperature reuses the last temperature conversion.
+ */
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+// Built in here for its device API, see CMakeLists.txt
+#include "ms5611.c"
+
+// Datasheet example: 20.07 °C, 1000.09 mbar
+#define FAKE_D1 9085466U
+#define FAKE_D2 8569150U
+
+#define FAKE_CMD_MAX 8
+
+static const struct ms5611_prom fake_prom = {
+    .sens_t1 = 40127,
+    .off_t1 = 36924,
+    .tcs = 23317,
+    .tco = 23282,
+    .t_ref = 33464,
+    .tempsens = 28312,
+};
+
+static struct {
+    uint32_t d1;
+    uint32_t d2;
+    int start_err;
+    int read_err;             // Fails every ADC read
+    int temperature_read_err; // Fails temperature reads only
+    uint8_t cmds[FAKE_CMD_MAX];
+    int cmd_count;
+    int reads;
+} fake;
+
+static int fake_bus_check(const struct ms5611_config *cfg)
+{
+    ARG_UNUSED(cfg);
+    return 0;
+}
+
+static int fake_reset(const struct ms5611_config *cfg)
+{
+    ARG_UNUSED(cfg);
+    return 0;
+}
+
+static int fake_read_prom(const struct ms5611_config *cfg, uint8_t cmd, uint16_t *val)
+{
+    ARG_UNUSED(cfg);
+
+    switch (cmd) {
+    case MS5611_CMD_CONV_READ_SENSE_T1:
+        *val = fake_prom.sens_t1;
+        return 0;
+    case MS5611_CMD_CONV_READ_OFF_T1:
+        *val = fake_prom.off_t1;
+        return 0;
+    case MS5611_CMD_CONV_READ_TCS:
+        *val = fake_prom.tcs;
+        return 0;
+    case MS5611_CMD_CONV_READ_TCO:
+        *val = fake_prom.tco;
+        return 0;
+    case MS5611_CMD_CONV_READ_T_REF:
+        *val = fake_prom.t_ref;
+        return 0;
+    case MS5611_CMD_CONV_READ_TEMPSENS:
+        *val = fake_prom.tempsens;
+        return 0;
+    default:
+        return -EIO;
+    }
+}
+
+static int fake_start_conversion(const struct ms5611_config *cfg, uint8_t cmd)
+{
+    ARG_UNUSED(cfg);
+
+    if (fake.start_err) {
+        return fake.start_err;
+    }
+
+    if (fake.cmd_count < FAKE_CMD_MAX) {
+        fake.cmds[fake.cmd_count] = cmd;
+    }
+    fake.cmd_count++;
+    return 0;
+}
+
+static int fake_read_adc(const struct ms5611_config *cfg, uint32_t *val)
+{
+    bool temperature;
+
+    ARG_UNUSED(cfg);
+
+    // The conversion last started is the one read out
+    zassert_true(fake.cmd_count > 0 && fake.cmd_count <= FAKE_CMD_MAX, "no conversion to read");
+    temperature = (fake.cmds[fake.cmd_count - 1] & 0xF0) == 0x50;
+
+    fake.reads++;
+    if (fake.read_err) {
+        return fake.read_err;
+    }
+    if (temperature && fake.temperature_read_err) {
+        return fake.temperature_read_err;
+    }
+
+    *val = temperature ? fake.d2 : fake.d1;
+    return 0;
+}
+
+static const struct ms5611_transfer_function fake_tf = {
+    .bus_check = fake_bus_check,
+    .reset = fake_reset,
+    .read_prom = fake_read_prom,
+    .start_conversion = fake_start_conversion,
+    .read_adc = fake_read_adc,
+};
+
+static const struct ms5611_config fake_config = {
+    .tf = &fake_tf,
+};
+
+static struct ms5611_data fake_data;
+
+DEVICE_DEFINE(fake_ms5611, "fake_ms5611", ms5611_init, NULL, &fake_data, &fake_config, POST_KERNEL,
+              CONFIG_SENSOR_INIT_PRIORITY, &ms5611_api_funcs);
+
+static const struct device *const dev = DEVICE_GET(fake_ms5611);
+
+static void expected(uint32_t d1, uint32_t d2, int32_t *pressure_pa, int32_t *temperature_cdeg)
+{
+    ms5611_compensate_int(&fake_prom, d2, d1, temperature_cdeg, pressure_pa);
+}
+
+/**
+ * @brief Poll until the measurement completes or fails, sleeping as told
+ */
+static int finish(int32_t *pressure_pa, int32_t *temperature_cdeg)
+{
+    uint32_t wait_us = 0;
+    int err;
+
+    while ((err = ms5611_measure_poll(dev, pressure_pa, temperature_cdeg, &wait_us)) ==
+           -EINPROGRESS) {
+        k_usleep(wait_us);
+    }
+
+    return err;
+}
+
+static void *ms5611_setup(void)
+{
+    zassert_true(device_is_ready(dev), "driver init should pass on the fake bus");
+    return NULL;
+}
+
+static void ms5611_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    memset(&fake, 0, sizeof(fake));
+    fake.d1 = FAKE_D1;
+    fake.d2 = FAKE_D2;
+}
+
+ZTEST(ms5611, test_measure_steps)
+{
+    const struct ms5611_data *data = dev->data;
+    int32_t pressure = 0, temperature = 0;
+    int32_t want_pressure, want_temperature;
+    uint32_t wait_us = 0;
+    struct sensor_value val;
+
+    zassert_ok(ms5611_measure_start(dev, true));
+    zassert_equal(fake.cmd_count, 1, "only the pressure conversion should start");
+    zassert_equal(fake.cmds[0], data->pressure_conv_cmd);
+
+    // Straight away the pressure conversion is still running
+    zassert_equal(ms5611_measure_poll(dev, &pressure, &temperature, &wait_us), -EINPROGRESS);
+    zassert_equal(fake.reads, 0, "nothing should be read before the conversion is done");
+    zassert_true(wait_us > 0, "should wait for the conversion");
+    zassert_true(wait_us <= data->pressure_conv_delay * USEC_PER_MSEC + k_ticks_to_us_ceil32(1),
+                 "wait %u us is longer than the conversion", wait_us);
+
+    // Pressure read out, temperature conversion started
+    k_usleep(wait_us);
+    zassert_equal(ms5611_measure_poll(dev, &pressure, &temperature, &wait_us), -EINPROGRESS);
+    zassert_equal(fake.reads, 1);
+    zassert_equal(fake.cmd_count, 2);
+    zassert_equal(fake.cmds[1], data->temperature_conv_cmd);
+    zassert_equal(wait_us, data->temperature_conv_delay * USEC_PER_MSEC);
+
+    // Temperature read out and compensated
+    k_usleep(wait_us);
+    zassert_ok(ms5611_measure_poll(dev, &pressure, &temperature, &wait_us));
+    zassert_equal(fake.reads, 2);
+
+    expected(FAKE_D1, FAKE_D2, &want_pressure, &want_temperature);
+    zassert_equal(pressure, want_pressure);
+    zassert_equal(temperature, want_temperature);
+    zassert_within(pressure, 100009, 1, "datasheet example is 1000.09 mbar");
+    zassert_within(temperature, 2007, 1, "datasheet example is 20.07 °C");
+
+    // Done: channel_get has it, and there is nothing left to poll
+    zassert_ok(sensor_channel_get(dev, SENSOR_CHAN_PRESS, &val));
+    zassert_equal(val.val1, want_pressure / 100);
+    zassert_equal(ms5611_measure_poll(dev, &pressure, &temperature, &wait_us), -EINVAL);
+}
+
+ZTEST(ms5611, test_bus_error_abandons)
+{
+    int32_t pressure, temperature;
+    uint32_t wait_us = 0;
+
+    // Failing to start leaves nothing in flight
+    fake.start_err = -EIO;
+    zassert_equal(ms5611_measure_start(dev, true), -EIO);
+    zassert_equal(finish(&pressure, &temperature), -EINVAL, "nothing should be in flight");
+
+    // Failing to read abandons the measurement, and the next one starts afresh
+    fake.start_err = 0;
+    fake.read_err = -EIO;
+    zassert_ok(ms5611_measure_start(dev, true));
+    zassert_equal(finish(&pressure, &temperature), -EIO);
+    zassert_equal(fake.reads, 1, "the measurement should stop at the failed read");
+    zassert_equal(ms5611_measure_poll(dev, &pressure, &temperature, &wait_us), -EINVAL);
+
+    fake.read_err = 0;
+    zassert_ok(ms5611_measure_start(dev, true));
+    zassert_ok(finish(&pressure, &temperature));
+}
+
+ZTEST(ms5611, test_fetch_busy_in_flight)
+{
+    int32_t pressure, temperature;
+
+    zassert_ok(ms5611_measure_start(dev, true));
+    zassert_equal(ms5611_measure_start(dev, true), -EBUSY);
+    zassert_equal(sensor_sample_fetch(dev), -EBUSY);
+    zassert_equal(fake.cmd_count, 1, "the fetch should not touch the bus");
+
+    zassert_ok(finish(&pressure, &temperature));
+    zassert_ok(sensor_sample_fetch(dev), "fetch should work again once collected");
+}
+
+ZTEST(ms5611, test_temperature_skip)
+{
+    const struct ms5611_data *data = dev->data;
+    int32_t pressure, temperature;
+    int32_t want_pressure, want_temperature;
+
+    zassert_ok(ms5611_measure_start(dev, true));
+    zassert_ok(finish(&pressure, &temperature));
+
+    // New pressure and temperature on the sensor, but only pressure is converted
+    fake.cmd_count = 0;
+    fake.d1 = FAKE_D1 - 100000;
+    fake.d2 = FAKE_D2 + 100000;
+    zassert_ok(ms5611_measure_start(dev, false));
+    zassert_ok(finish(&pressure, &temperature));
+    zassert_equal(fake.cmd_count, 1, "only the pressure conversion should run");
+    zassert_equal(fake.cmds[0], data->pressure_conv_cmd);
+
+    expected(FAKE_D1 - 100000, FAKE_D2, &want_pressure, &want_temperature);
+    zassert_equal(pressure, want_pressure, "should compensate with the last temperature");
+    zassert_equal(temperature, want_temperature);
+
+    // A failed temperature read leaves none to reuse, so the next one converts it
+    fake.temperature_read_err = -EIO;
+    zassert_ok(ms5611_measure_start(dev, true));
+    zassert_equal(finish(&pressure, &temperature), -EIO);
+
+    fake.temperature_read_err = 0;
+    fake.cmd_count = 0;
+    zassert_ok(ms5611_measure_start(dev, false));
+    zassert_ok(finish(&pressure, &temperature));
+    zassert_equal(fake.cmd_count, 2, "with no temperature to reuse it should be converted");
+    zassert_equal(fake.cmds[1], data->temperature_conv_cmd);
+}
+
+ZTEST_SUITE(ms5611, NULL, ms5611_setup, ms5611_before, NULL, NULL);
@@ -0,0 +1,311 @@
+/*
+ * Navigation filter (nav_ekf.h), against a simulated flight whose true
+ * position and velocity are integrated exactly alongside it.
+ *
+ * Flies a descent drifting in a gusting wind with GPS at 1 Hz, and checks
+ * that between fixes the filter is closer to the truth than the last fix
+ * held, and that its covariance matches its errors. Flies a boost and coast
+ * on the barometer alone, checks that a GPS outlier is rejected and that a
+ * run of them is taken in the end. Then times one step as the nav thread
+ * runs it.
+ */
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include "bench.h"
+#include "nav_ekf.h"
+
+LOG_MODULE_REGISTER(nav_ekf_test, LOG_LEVEL_INF);
+
+#define RATE_HZ 100 // Filtered IMU stream
+#define DT_S (1.0f / RATE_HZ)
+#define BARO_EVERY 5  // Steps per barometer reading: 20 Hz
+#define GPS_EVERY 100 // Steps per fix: 1 Hz
+#define GPS_LAG 20    // Steps between a fix's time and its arrival
+
+#define BENCH_ITERATIONS 1000
+
+#define ACCEL_NOISE 0.3f // m/s², filtered IMU with vibration
+#define G 9.80665f
+
+/* Deterministic inputs, so a failure reproduces */
+static uint32_t rand_state = 12345;
+
+static float test_rand_unit(void)
+{
+    rand_state = rand_state * 1664525U + 1013904223U;
+    return (float)(rand_state >> 8) / (float)(1U << 24);
+}
+
+// Roughly normal, from the sum of four uniforms
+static float test_noise(float sigma)
+{
+    float sum = test_rand_unit() + test_rand_unit() + test_rand_unit() + test_rand_unit();
+
+    return (sum - 2.0f) * 1.7320508f * sigma;
+}
+
+struct sim {
+    struct nav_ekf nav;
+    float p[3]; // True north, east, down (m)
+    float v[3]; // True velocity (m/s)
+    float accel_bias;
+    float t;
+    int step;
+};
+
+static void sim_init(struct sim *s, const float p[3], const float v[3])
+{
+    memcpy(s->p, p, sizeof(s->p));
+    memcpy(s->v, v, sizeof(s->v));
+    s->accel_bias = 0.0f;
+    s->t = 0.0f;
+    s->step = 0;
+    nav_ekf_init(&s->nav, p[2] + test_noise(NAV_SIGMA_BARO), NAV_SIGMA_BARO * NAV_SIGMA_BARO);
+}
+
+/**
+ * @brief One filtered IMU sample: move the truth under a constant
+ * acceleration over one period, then predict the filter with what the IMU
+ * would read, and correct it with the barometer when one is due.
+ * @param accel True acceleration in NED (m/s²), gravity removed
+ */
+static void sim_step(struct sim *s, const float accel[3])
+{
+    for (int i = 0; i < 3; i++) {
+        s->p[i] += s->v[i] * DT_S + 0.5f * accel[i] * DT_S * DT_S;
+        s->v[i] += accel[i] * DT_S;
+    }
+    s->t += DT_S;
+    s->step++;
+
+    float f_h = sqrtf(accel[0] * accel[0] + accel[1] * accel[1]);
+
+    nav_ekf_predict(&s->nav, accel[2] + s->accel_bias + test_noise(ACCEL_NOISE), f_h,
+                    NAV_SIGMA_ACCEL, DT_S);
+
+    if (s->step % BARO_EVERY == 0) {
+        nav_ekf_update_baro(&s->nav, -s->p[2] + test_noise(NAV_SIGMA_BARO),
+                            NAV_SIGMA_BARO * NAV_SIGMA_BARO, 0.0f, NULL);
+    }
+}
+
+/**
+ * @brief Wind under the parachute: steady east, gusting north, falling at
+ * a steady 6 m/s. Velocity and acceleration at time t.
+ */
+static void descent(float t, float v[3], float a[3])
+{
+    float w = 2.0f * 3.14159265f / 20.0f;
+
+    v[0] = 5.0f + 1.5f * sinf(w * t);
+    v[1] = -3.0f;
+    v[2] = 6.0f;
+    a[0] = 1.5f * w * cosf(w * t);
+    a[1] = 0.0f;
+    a[2] = 0.0f;
+}
+
+ZTEST(nav_ekf, test_descent_between_fixes)
+{
+    struct sim s;
+    const float start[3] = {0.0f, 0.0f, -1000.0f};
+    float v[3];
+    float a[3];
+    float fix[2] = {0.0f, 0.0f};      // Last fix taken, as a receiver alone would report
+    float pending[2] = {0.0f, 0.0f};  // Fix measured, not yet arrived
+    double nav_sq = 0.0;
+    double held_sq = 0.0;
+    double vel_sq = 0.0;
+    double nees_pos = 0.0;
+    double nees_vel = 0.0;
+    int n = 0;
+
+    descent(0.0f, v, a);
+    sim_init(&s, start, v);
+    // Started under the parachute rather than on the pad: the velocity is unknown
+    for (int i = 0; i < 3; i++) {
+        s.nav.P[NAV_VN + i][NAV_VN + i] = 10.0f * 10.0f;
+    }
+
+    for (int k = 0; k < 60 * RATE_HZ; k++) {
+        descent(s.t, v, a);
+        sim_step(&s, a);
+
+        if (s.step % GPS_EVERY == 0) {
+            pending[0] = s.p[0] + test_noise(NAV_SIGMA_GPS);
+            pending[1] = s.p[1] + test_noise(NAV_SIGMA_GPS);
+        }
+        if (s.step % GPS_EVERY == GPS_LAG) {
+            zassert_true(nav_ekf_update_gps(&s.nav, pending[0], pending[1],
+                                            NAV_SIGMA_GPS * NAV_SIGMA_GPS,
+                                            -(float)GPS_LAG * DT_S),
+                         "fix at %.1f s rejected", (double)s.t);
+            fix[0] = pending[0];
+            fix[1] = pending[1];
+        }
+
+        if (s.t < 20.0f) {
+            continue;
+        }
+        for (int i = 0; i < 2; i++) {
+            float e_p = s.nav.x[NAV_PN + i] - s.p[i];
+            float e_v = s.nav.x[NAV_VN + i] - s.v[i];
+
+            nav_sq += e_p * e_p;
+            held_sq += (fix[i] - s.p[i]) * (fix[i] - s.p[i]);
+            vel_sq += e_v * e_v;
+            nees_pos += e_p * e_p / s.nav.P[NAV_PN + i][NAV_PN + i];
+            nees_vel += e_v * e_v / s.nav.P[NAV_VN + i][NAV_VN + i];
+            n++;
+        }
+    }
+
+    float nav_rms = sqrtf(nav_sq / n);
+    float held_rms = sqrtf(held_sq / n);
+    float vel_rms = sqrtf(vel_sq / n);
+
+    LOG_INF("Descent: horizontal RMS %.2f m filtered, %.2f m last fix held, velocity %.2f m/s",
+            (double)nav_rms, (double)held_rms, (double)vel_rms);
+    LOG_INF("Normalized error squared: position %.2f, velocity %.2f", nees_pos / n,
+            nees_vel / n);
+
+    zassert_true(nav_rms < 0.7f * held_rms, "filter %f m against %f m from the last fix",
+                 (double)nav_rms, (double)held_rms);
+    zassert_true(vel_rms < 1.5f, "velocity off by %f m/s RMS", (double)vel_rms);
+    zassert_within(s.nav.x[NAV_PD], s.p[2], 3.0f, "down %f, truth %f", (double)s.nav.x[NAV_PD],
+                   (double)s.p[2]);
+    zassert_equal(s.nav.gps_rejected, 0, "%u fixes rejected", s.nav.gps_rejected);
+
+    // The filter's variance should describe its errors, not flatter them or hide them
+    zassert_true(nees_pos / n > 0.2 && nees_pos / n < 3.0, "position NEES %f", nees_pos / n);
+    zassert_true(nees_vel / n > 0.2 && nees_vel / n < 3.0, "velocity NEES %f", nees_vel / n);
+}
+
+ZTEST(nav_ekf, test_boost_and_coast)
+{
+    struct sim s;
+    const float pad[3] = {0.0f, 0.0f, 0.0f};
+    float worst_p = 0.0f;
+    float worst_v = 0.0f;
+
+    sim_init(&s, pad, pad);
+    s.accel_bias = 0.3f;
+
+    // On the pad: still, which also shows the filter the accelerometer's bias
+    for (int k = 0; k < 10 * RATE_HZ; k++) {
+        const float rest[3] = {0.0f, 0.0f, 0.0f};
+
+        sim_step(&s, rest);
+        nav_ekf_update_still(&s.nav, NAV_SIGMA_STILL * NAV_SIGMA_STILL);
+    }
+
+    // 3 s at 5 g, then coast with drag until past apogee
+    for (int k = 0; k < 25 * RATE_HZ; k++) {
+        float up = (k < 3 * RATE_HZ) ? 50.0f : -G + 0.0005f * s.v[2] * fabsf(s.v[2]);
+        const float accel[3] = {0.0f, 0.0f, -up};
+
+        sim_step(&s, accel);
+        worst_p = fmaxf(worst_p, fabsf(s.nav.x[NAV_PD] - s.p[2]));
+        worst_v = fmaxf(worst_v, fabsf(s.nav.x[NAV_VD] - s.v[2]));
+    }
+
+    LOG_INF("Boost and coast to %.0f m: worst error %.2f m, %.2f m/s, bias %.3f m/s²",
+            (double)-s.p[2], (double)worst_p, (double)worst_v, (double)s.nav.x[NAV_BD]);
+    zassert_true(s.v[2] > 0.0f, "the flight should be past apogee");
+    zassert_true(worst_p < 5.0f, "down off by %f m", (double)worst_p);
+    zassert_true(worst_v < 2.0f, "down velocity off by %f m/s", (double)worst_v);
+    zassert_within(s.nav.x[NAV_BD], s.accel_bias, 0.15f, "bias %f", (double)s.nav.x[NAV_BD]);
+    zassert_within(s.nav.x[NAV_PN], 0.0f, 1.0e-3f, "moved north without a horizontal force");
+}
+
+ZTEST(nav_ekf, test_gps_outliers)
+{
+    struct sim s;
+    const float pad[3] = {0.0f, 0.0f, 0.0f};
+    const float rest[3] = {0.0f, 0.0f, 0.0f};
+
+    sim_init(&s, pad, pad);
+
+    for (int k = 0; k < 30 * RATE_HZ; k++) {
+        sim_step(&s, rest);
+        nav_ekf_update_still(&s.nav, NAV_SIGMA_STILL * NAV_SIGMA_STILL);
+        if (s.step % GPS_EVERY == 0) {
+            nav_ekf_update_gps(&s.nav, test_noise(NAV_SIGMA_GPS), test_noise(NAV_SIGMA_GPS),
+                               NAV_SIGMA_GPS * NAV_SIGMA_GPS, 0.0f);
+        }
+    }
+
+    uint32_t fused = s.nav.gps_fused;
+
+    // One wild fix among good ones is dropped
+    zassert_false(nav_ekf_update_gps(&s.nav, 200.0f, 0.0f, NAV_SIGMA_GPS * NAV_SIGMA_GPS, 0.0f),
+                  "200 m jump taken");
+    zassert_equal(s.nav.gps_rejected, 1, "rejection not counted");
+    zassert_true(nav_ekf_update_gps(&s.nav, 0.0f, 0.0f, NAV_SIGMA_GPS * NAV_SIGMA_GPS, 0.0f),
+                 "good fix after the outlier rejected");
+    zassert_true(fabsf(s.nav.x[NAV_PN]) < 3.0f, "outlier moved the filter");
+
+    // Fixes that keep agreeing with each other and not the filter win in the end
+    for (int i = 0; i < NAV_GPS_REJECT_MAX; i++) {
+        zassert_false(nav_ekf_update_gps(&s.nav, 200.0f, 0.0f, NAV_SIGMA_GPS * NAV_SIGMA_GPS,
+                                         0.0f),
+                      "fix %d of the run taken too soon", i);
+    }
+    zassert_true(nav_ekf_update_gps(&s.nav, 200.0f, 0.0f, NAV_SIGMA_GPS * NAV_SIGMA_GPS, 0.0f),
+                 "run of fixes never taken");
+    zassert_within(s.nav.x[NAV_PN], 200.0f, 3.0f, "north %f after the reset",
+                   (double)s.nav.x[NAV_PN]);
+    zassert_equal(s.nav.gps_fused, fused + 2, "fused count");
+    zassert_equal(s.nav.gps_rejected, 1 + NAV_GPS_REJECT_MAX, "rejected count");
+}
+
+ZTEST(nav_ekf, test_gps_offset)
+{
+    float north;
+    float east;
+
+    // A thousandth of a degree is about 111 m north, and less east away from the equator.
+    // The fixes are floats, good to a metre or so at these longitudes
+    nav_gps_offset(49.26f, -123.25f, 49.261f, -123.249f, &north, &east);
+    zassert_within(north, 111.2f, 1.0f, "north %f m", (double)north);
+    zassert_within(east, 72.6f, 1.0f, "east %f m", (double)east);
+}
+
+ZTEST(nav_ekf, test_step_cycles)
+{
+    struct nav_ekf nav;
+    struct bench_stat stat = {0};
+    volatile float sink;
+
+    nav_ekf_init(&nav, -100.0f, 1.0f);
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        float accel = test_noise(1.0f);
+        float height = 100.0f + test_noise(NAV_SIGMA_BARO);
+        float north = test_noise(NAV_SIGMA_GPS);
+        float east = test_noise(NAV_SIGMA_GPS);
+
+        // A predict and a barometer every step, a fix every tenth: worse than flight
+        uint32_t start = bench_stamp();
+
+        nav_ekf_predict(&nav, accel, 1.0f, NAV_SIGMA_ACCEL, DT_S);
+        nav_ekf_update_baro(&nav, height, NAV_SIGMA_BARO * NAV_SIGMA_BARO, -0.01f, NULL);
+        if (i % 10 == 0) {
+            nav_ekf_update_gps(&nav, north, east, NAV_SIGMA_GPS * NAV_SIGMA_GPS, -0.2f);
+        }
+        sink = nav.x[NAV_PN];
+        bench_record(&stat, start);
+    }
+
+    ARG_UNUSED(sink);
+
+    LOG_INF("Nav step, %d steps: mean=%u max=%u %s", BENCH_ITERATIONS, bench_mean(&stat),
+            stat.max, BENCH_UNIT);
+    zassert_true(isfinite(nav.x[NAV_PN]) && nav.P[NAV_PN][NAV_PN] > 0.0f,
+                 "the filter should stay finite");
+}
+
+ZTEST_SUITE(nav_ekf, NULL, NULL, NULL, NULL, NULL);
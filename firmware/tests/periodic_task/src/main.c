@@ -0,0 +1,94 @@
+/*
+ * Periodic task helper (periodic_task.h).
+ *
+ * Runs tasks on the test thread with busy-waits standing in for their work
+ * and checks the release arithmetic: an overrun drops the missed releases,
+ * counts once and stays on the original grid, and a new period takes
+ * effect from the next release.
+ */
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "periodic_task.h"
+
+#define PERIOD_MS 10
+
+static k_ticks_t ticks_of(uint32_t ms)
+{
+    return (k_ticks_t)k_ms_to_ticks_ceil64(ms);
+}
+
+/**
+ * @brief Look a task up in the registry by name, as the shell and logger do.
+ */
+static bool find_task(const char *name, struct periodic_task_stats *stats)
+{
+    for (int i = 0; i < periodic_task_count(); i++) {
+        const char *task_name;
+
+        if (periodic_task_get(i, &task_name, stats) == 0 && strcmp(task_name, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+ZTEST(periodic_task, test_overrun_stays_phase_locked)
+{
+    static struct periodic_task task;
+    struct periodic_task_stats stats;
+    k_ticks_t period = ticks_of(PERIOD_MS);
+
+    zassert_ok(periodic_task_init(&task, "overrun", PERIOD_MS), "registry full");
+
+    // The first release is immediate
+    periodic_task_wait(&task);
+    k_ticks_t first = task.next_release;
+
+    // 2.5 periods of work: the releases at +1 and +2 periods are both missed
+    k_busy_wait(PERIOD_MS * USEC_PER_MSEC * 5 / 2);
+    periodic_task_wait(&task);
+
+    zassert_equal(task.stats.overruns, 1, "one overrun however many releases were missed");
+    zassert_equal(task.next_release, first + 2 * period,
+                  "the latest missed release should run, the older one dropped");
+    zassert_true(task.stats.exec_last_us >= PERIOD_MS * USEC_PER_MSEC * 2,
+                 "execution time should cover the busy-wait");
+
+    // Back on the grid of the first release, and on time
+    periodic_task_wait(&task);
+    zassert_equal(task.next_release, first + 3 * period, "should stay phase-locked");
+    zassert_true(k_uptime_ticks() >= task.next_release, "woke before the release");
+    zassert_equal(task.stats.overruns, 1, "an on-time cycle is not an overrun");
+    zassert_equal(task.stats.releases, 3, "every wait is one release");
+
+    zassert_true(find_task("overrun", &stats), "task should be registered");
+    zassert_equal(stats.overruns, 1, "registry copy should match the task");
+    zassert_equal(stats.releases, 3, "registry copy should match the task");
+}
+
+ZTEST(periodic_task, test_set_period_applies_to_next_release)
+{
+    static struct periodic_task task;
+
+    zassert_ok(periodic_task_init(&task, "set_period", PERIOD_MS), "registry full");
+
+    periodic_task_wait(&task);
+    k_ticks_t first = task.next_release;
+
+    // Changed mid-cycle: the next release is already one new period away
+    periodic_task_set_period(&task, 2 * PERIOD_MS);
+    periodic_task_wait(&task);
+
+    zassert_equal(task.next_release, first + ticks_of(2 * PERIOD_MS),
+                  "new period should apply to the next release");
+    zassert_true(k_uptime_ticks() >= task.next_release, "woke before the release");
+
+    periodic_task_wait(&task);
+    zassert_equal(task.next_release, first + 2 * ticks_of(2 * PERIOD_MS),
+                  "new period should stick");
+    zassert_equal(task.stats.overruns, 0, "nothing ran late");
+}
+
+ZTEST_SUITE(periodic_task, NULL, NULL, NULL, NULL, NULL);
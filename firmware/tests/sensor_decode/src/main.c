@@ -0,0 +1,301 @@
+/*
+ * Checks and benchmarks the float decode path in sensor_decode.c against the
+ * sensor_value path it replaced in the IMU and baro threads.
+ *
+ * The old path fetches a sample, reads each channel with its own
+ * sensor_channel_get() and converts it with sensor_value_to_double(). The new
+ * one reads every channel with sensor_read() and scales the decoder's q31
+ * values to float. Both are timed end to end (read and convert) and for the
+ * conversion alone, from a sample that is already in memory.
+ *
+ * The simulated sensors cost next to nothing, so on native_sim only the
+ * conversion numbers mean anything, and only relative to each other (see
+ * bench.h); run on ubcrocket_polarity for the single-precision FPU.
+ *
+ * The bus tests check the devicetree bus grouping of sensor_bus.c and time
+ * reading both barometers one after the other against one batch, which
+ * reads them at the same time when they are on separate buses.
+ */
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/ztest.h>
+
+#include "bench.h"
+#include "sensor_bus.h"
+#include "sensor_decode.h"
+
+LOG_MODULE_REGISTER(sensor_decode_test, LOG_LEVEL_INF);
+
+#define BENCH_ITERATIONS 1000
+#define BENCH_BARO_ITERATIONS 200 // Each MS5611 read waits for two conversions
+
+static const struct device *const accel_dev = DEVICE_DT_GET(DT_ALIAS(accel0));
+static const struct device *const gyro_dev = DEVICE_DT_GET(DT_ALIAS(gyro0));
+static const struct device *const baro_dev = DEVICE_DT_GET(DT_ALIAS(baro0));
+
+// Separate from sensor_decode.c's own iodevs, so a buffer can be kept and decoded repeatedly
+SENSOR_DT_READ_IODEV(test_accel_iodev, DT_ALIAS(accel0), {SENSOR_CHAN_ACCEL_XYZ, 0});
+SENSOR_DT_READ_IODEV(test_baro_iodev, DT_ALIAS(baro0), {SENSOR_CHAN_PRESS, 0},
+                     {SENSOR_CHAN_AMBIENT_TEMP, 0});
+RTIO_DEFINE(test_rtio, 1, 1);
+
+static void bench_report(const char *what, const struct bench_stat *old_path,
+                         const struct bench_stat *new_path)
+{
+    LOG_INF("%-18s sensor_value: mean=%6u max=%6u %s | decode: mean=%6u max=%6u %s", what,
+            bench_mean(old_path), old_path->max, BENCH_UNIT, bench_mean(new_path), new_path->max,
+            BENCH_UNIT);
+}
+
+/* ---- The sensor_value path, as the IMU and baro threads used to do it ---- */
+
+static void legacy_imu_convert(float accel[3], float gyro[3])
+{
+    struct sensor_value val[6];
+
+    sensor_channel_get(accel_dev, SENSOR_CHAN_ACCEL_X, &val[0]);
+    sensor_channel_get(accel_dev, SENSOR_CHAN_ACCEL_Y, &val[1]);
+    sensor_channel_get(accel_dev, SENSOR_CHAN_ACCEL_Z, &val[2]);
+    sensor_channel_get(gyro_dev, SENSOR_CHAN_GYRO_X, &val[3]);
+    sensor_channel_get(gyro_dev, SENSOR_CHAN_GYRO_Y, &val[4]);
+    sensor_channel_get(gyro_dev, SENSOR_CHAN_GYRO_Z, &val[5]);
+
+    for (int i = 0; i < 3; i++) {
+        accel[i] = (float)sensor_value_to_double(&val[i]);
+        gyro[i] = (float)sensor_value_to_double(&val[3 + i]);
+    }
+}
+
+static int legacy_imu_read(float accel[3], float gyro[3])
+{
+    if (sensor_sample_fetch(accel_dev) < 0 || sensor_sample_fetch(gyro_dev) < 0) {
+        return -EIO;
+    }
+
+    legacy_imu_convert(accel, gyro);
+    return 0;
+}
+
+static void legacy_baro_convert(float *pressure_hpa, float *temperature_c)
+{
+    struct sensor_value pressure;
+    struct sensor_value temperature;
+
+    sensor_channel_get(baro_dev, SENSOR_CHAN_PRESS, &pressure);
+    sensor_channel_get(baro_dev, SENSOR_CHAN_AMBIENT_TEMP, &temperature);
+
+    *pressure_hpa = (float)sensor_value_to_double(&pressure);
+    *temperature_c = (float)sensor_value_to_double(&temperature);
+}
+
+static int legacy_baro_read(float *pressure_hpa, float *temperature_c)
+{
+    if (sensor_sample_fetch(baro_dev) < 0) {
+        return -EIO;
+    }
+
+    legacy_baro_convert(pressure_hpa, temperature_c);
+    return 0;
+}
+
+/* ---- Tests ---- */
+
+static void *sensor_decode_setup(void)
+{
+    zassert_true(device_is_ready(accel_dev), "accel not ready");
+    zassert_true(device_is_ready(gyro_dev), "gyro not ready");
+    zassert_true(device_is_ready(baro_dev), "baro not ready");
+    return NULL;
+}
+
+ZTEST(sensor_decode, test_decode_matches_sensor_value)
+{
+    uint8_t buf[SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    struct sensor_value val[3];
+    float decoded[3];
+
+    // sensor_read() leaves the sample in the driver, so both paths see the same one
+    zassert_ok(sensor_read(&test_accel_iodev, &test_rtio, buf, sizeof(buf)));
+    zassert_ok(sensor_decode_xyz(accel_dev, buf, SENSOR_CHAN_ACCEL_XYZ, decoded));
+    zassert_ok(sensor_channel_get(accel_dev, SENSOR_CHAN_ACCEL_XYZ, val));
+
+    for (int i = 0; i < 3; i++) {
+        float expected = (float)sensor_value_to_double(&val[i]);
+
+        zassert_within(decoded[i], expected, 1e-4f + fabsf(expected) * 1e-6f,
+                       "accel axis %d: decoded %f, sensor_value %f", i, (double)decoded[i],
+                       (double)expected);
+    }
+
+    zassert_ok(sensor_read(&test_baro_iodev, &test_rtio, buf, sizeof(buf)));
+    zassert_ok(sensor_decode_scalar(baro_dev, buf, SENSOR_CHAN_PRESS, &decoded[0]));
+    zassert_ok(sensor_decode_scalar(baro_dev, buf, SENSOR_CHAN_AMBIENT_TEMP, &decoded[1]));
+    zassert_ok(sensor_channel_get(baro_dev, SENSOR_CHAN_PRESS, &val[0]));
+    zassert_ok(sensor_channel_get(baro_dev, SENSOR_CHAN_AMBIENT_TEMP, &val[1]));
+
+    // A float holds a pressure in hPa to about 0.1 Pa
+    zassert_within(decoded[0], (float)sensor_value_to_double(&val[0]), 1e-3f,
+                   "pressure should match");
+    zassert_within(decoded[1], (float)sensor_value_to_double(&val[1]), 1e-4f,
+                   "temperature should match");
+
+    zassert_true(sensor_decode_scalar(baro_dev, buf, SENSOR_CHAN_ALTITUDE, &decoded[2]) < 0,
+                 "a channel that was not read should not decode");
+}
+
+ZTEST(sensor_decode, test_imu_cycles)
+{
+    uint8_t accel_buf[SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    uint8_t gyro_buf[SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    struct bench_stat old_read = {0}, new_read = {0};
+    struct bench_stat old_convert = {0}, new_convert = {0};
+    float accel[3];
+    float gyro[3];
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        uint32_t start = bench_stamp();
+
+        zassert_ok(legacy_imu_read(accel, gyro));
+        bench_record(&old_read, start);
+
+        start = bench_stamp();
+        zassert_ok(sensor_decode_imu(accel, gyro));
+        bench_record(&new_read, start);
+
+        // Conversion only: the sample from the read above is still in the driver
+        start = bench_stamp();
+        legacy_imu_convert(accel, gyro);
+        bench_record(&old_convert, start);
+    }
+
+    zassert_ok(sensor_read(&test_accel_iodev, &test_rtio, accel_buf, sizeof(accel_buf)));
+    memcpy(gyro_buf, accel_buf, sizeof(gyro_buf));
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        uint32_t start = bench_stamp();
+
+        // Same work as the gyro half of sensor_decode_imu(), on the accel frame
+        zassert_ok(sensor_decode_xyz(accel_dev, accel_buf, SENSOR_CHAN_ACCEL_XYZ, accel));
+        zassert_ok(sensor_decode_xyz(accel_dev, gyro_buf, SENSOR_CHAN_ACCEL_XYZ, gyro));
+        bench_record(&new_convert, start);
+    }
+
+    LOG_INF("IMU, 6 axes, %d samples:", BENCH_ITERATIONS);
+    bench_report("read + convert", &old_read, &new_read);
+    bench_report("convert only", &old_convert, &new_convert);
+}
+
+ZTEST(sensor_decode, test_baro_cycles)
+{
+    uint8_t buf[SENSOR_DECODE_BUF_SIZE] __aligned(8);
+    struct bench_stat old_read = {0}, new_read = {0};
+    struct bench_stat old_convert = {0}, new_convert = {0};
+    float pressure;
+    float temperature;
+
+    for (int i = 0; i < BENCH_BARO_ITERATIONS; i++) {
+        uint32_t start = bench_stamp();
+
+        zassert_ok(legacy_baro_read(&pressure, &temperature));
+        bench_record(&old_read, start);
+
+        start = bench_stamp();
+        zassert_ok(sensor_decode_baro(SENSOR_DECODE_BARO0, &pressure, &temperature));
+        bench_record(&new_read, start);
+
+        start = bench_stamp();
+        legacy_baro_convert(&pressure, &temperature);
+        bench_record(&old_convert, start);
+    }
+
+    zassert_ok(sensor_read(&test_baro_iodev, &test_rtio, buf, sizeof(buf)));
+
+    for (int i = 0; i < BENCH_BARO_ITERATIONS; i++) {
+        uint32_t start = bench_stamp();
+
+        zassert_ok(sensor_decode_scalar(baro_dev, buf, SENSOR_CHAN_PRESS, &pressure));
+        zassert_ok(sensor_decode_scalar(baro_dev, buf, SENSOR_CHAN_AMBIENT_TEMP, &temperature));
+        bench_record(&new_convert, start);
+    }
+
+    LOG_INF("Baro, pressure and temperature, %d samples:", BENCH_BARO_ITERATIONS);
+    bench_report("read + convert", &old_read, &new_read);
+    bench_report("convert only", &old_convert, &new_convert);
+}
+
+ZTEST(sensor_decode, test_bus_grouping)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    // The simulated sensors are on no bus, so each is its own
+    zassert_equal(sensor_bus_count(), SENSOR_BUS_DEV_COUNT, "one bus per simulated sensor");
+    for (int i = 0; i < SENSOR_BUS_DEV_COUNT; i++) {
+        for (int j = i + 1; j < SENSOR_BUS_DEV_COUNT; j++) {
+            zassert_not_equal(sensor_bus_of(i), sensor_bus_of(j), "sensors %d and %d", i, j);
+        }
+    }
+#else
+    // spi2: accel, gyro, baro0; spi4: baro1
+    zassert_equal(sensor_bus_count(), 2, "sensors should be on two buses");
+    zassert_equal(sensor_bus_of(SENSOR_BUS_ACCEL), sensor_bus_of(SENSOR_BUS_GYRO));
+    zassert_equal(sensor_bus_of(SENSOR_BUS_ACCEL), sensor_bus_of(SENSOR_BUS_BARO0));
+    zassert_not_equal(sensor_bus_of(SENSOR_BUS_BARO0), sensor_bus_of(SENSOR_BUS_BARO1));
+#endif
+
+    for (int d = 0; d < SENSOR_BUS_DEV_COUNT; d++) {
+        const char *name;
+        struct sensor_bus_stats stats;
+
+        zassert_ok(sensor_bus_get(sensor_bus_of(d), &name, &stats));
+        zassert_true(stats.devices & BIT(d), "bus %s should list sensor %d", name, d);
+    }
+    zassert_equal(sensor_bus_get(sensor_bus_count(), NULL, NULL), -EINVAL);
+}
+
+ZTEST(sensor_decode, test_baro_bus_cycles)
+{
+    struct bench_stat sequential = {0}, batched = {0};
+    const bool both[SENSOR_DECODE_BARO_COUNT] = {true, true};
+    float pressure[SENSOR_DECODE_BARO_COUNT];
+    float temperature[SENSOR_DECODE_BARO_COUNT];
+    bool ok[SENSOR_DECODE_BARO_COUNT];
+    struct sensor_bus_stats before;
+    struct sensor_bus_stats after;
+    const char *name;
+    int bus = sensor_bus_of(SENSOR_BUS_BARO1);
+
+    zassert_ok(sensor_bus_get(bus, &name, &before));
+
+    for (int i = 0; i < BENCH_BARO_ITERATIONS; i++) {
+        uint32_t start = bench_stamp();
+
+        zassert_ok(sensor_decode_baro(SENSOR_DECODE_BARO0, &pressure[0], &temperature[0]));
+        zassert_ok(sensor_decode_baro(SENSOR_DECODE_BARO1, &pressure[1], &temperature[1]));
+        bench_record(&sequential, start);
+
+        start = bench_stamp();
+        sensor_decode_baros(both, pressure, temperature, ok);
+        bench_record(&batched, start);
+
+        zassert_true(ok[0] && ok[1], "both barometers should read");
+    }
+
+    zassert_ok(sensor_bus_get(bus, &name, &after));
+
+    LOG_INF("Both baros, %d samples:", BENCH_BARO_ITERATIONS);
+    LOG_INF("%-18s mean=%6u max=%6u %s", "one after another", bench_mean(&sequential),
+            sequential.max, BENCH_UNIT);
+    LOG_INF("%-18s mean=%6u max=%6u %s", "one batch", bench_mean(&batched), batched.max,
+            BENCH_UNIT);
+    LOG_INF("%s: %u.%u %% busy over the last window", name, after.utilization_permille / 10,
+            after.utilization_permille % 10);
+
+    zassert_equal(after.transfers - before.transfers, 2 * BENCH_BARO_ITERATIONS,
+                  "every baro1 read should be counted on its bus");
+}
+
+ZTEST_SUITE(sensor_decode, NULL, sensor_decode_setup, NULL, NULL, NULL);
@@ -1,7 +1,9 @@
+#include <math.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/ztest.h>
 
 #include "data.h"
+#include "deploy_latency.h"
 #include "state_machine_config.h"
 #include "state_machine_test.h"
 #include "stubs.h"
@@ -285,6 +287,67 @@ ZTEST(state_machine, test_ascent_to_drogue_descent)
     transition_to_drogue_descent(ground_altitude, t);
 }
 
+ZTEST(state_machine, test_apogee_prediction)
+{
+    const float ground_altitude = 100.0f;
+    const float g = 9.80665f;
+    const float k = 0.0005f; // Drag per unit mass per v^2, 1/m
+    const int64_t period_ms = 15;
+    float h = ground_altitude + 500.0f;
+    float v = 90.0f;
+    float apogee_m = h + logf(1.0f + k * v * v / g) / (2.0f * k);
+    int64_t t = 0;
+    int64_t apogee_ms = -1;
+    int64_t drogue_ms = -1;
+    bool seen_valid = false;
+    struct apogee_data apogee;
+
+    state_machine_test_setup_state(FLIGHT_STATE_ASCENT, ground_altitude, t);
+
+    // A drag-limited coast through apogee, one sample per baro period
+    while (t < 20000 && drogue_ms < 0) {
+        state_machine_test_step(h, v, t);
+        get_apogee_data(&apogee);
+
+        if (apogee.valid && !seen_valid) {
+            seen_valid = true;
+            zassert_within(apogee.apogee_agl, apogee_m - ground_altitude, 2.0f,
+                           "predicted apogee %f m AGL, true %f m", (double)apogee.apogee_agl,
+                           (double)(apogee_m - ground_altitude));
+        }
+        if (state_machine_test_get_state() == FLIGHT_STATE_DROGUE_DESCENT) {
+            drogue_ms = t;
+        }
+
+        for (int i = 0; i < period_ms; i++) {
+            float prev_v = v;
+
+            v -= (g + k * v * fabsf(v)) * 0.001f;
+            h += 0.5f * (prev_v + v) * 0.001f;
+            if (prev_v > 0.0f && v <= 0.0f) {
+                apogee_ms = t + i + 1;
+            }
+        }
+        t += period_ms;
+    }
+
+    zassert_true(seen_valid, "the prediction never became valid");
+    zassert_true(apogee_ms > 0 && drogue_ms > 0, "no apogee or no drogue descent");
+
+#ifdef CONFIG_FALCON_APOGEE_PREDICT_DEPLOY
+    zassert_true(llabs(drogue_ms - apogee_ms) <= period_ms,
+                 "deployed %lld ms from apogee on the prediction", drogue_ms - apogee_ms);
+#else
+    zassert_true(drogue_ms - apogee_ms >= (DROGUE_DEPLOY_CHECKS - 1) * period_ms,
+                 "deployed %lld ms after apogee without the prediction", drogue_ms - apogee_ms);
+#endif
+
+    // The first sample out of ascent publishes the prediction as invalid
+    state_machine_test_step(h, v, t);
+    get_apogee_data(&apogee);
+    zassert_false(apogee.valid, "prediction still valid out of ascent");
+}
+
 ZTEST(state_machine, test_drogue_delay)
 {
     float ground_altitude = 100.0f;
@@ -305,6 +368,44 @@ ZTEST(state_machine, test_drogue_delay)
     zassert_true(state_machine_test_get_drogue_fire_triggered(), "drogue should fire after delay");
 }
 
+ZTEST(state_machine, test_deploy_latency_trace)
+{
+    float ground_altitude = 100.0f;
+    int64_t drogue_entry_time = 0;
+    struct deploy_latency_stat fire_before, enqueue_before, ack_before;
+    struct deploy_latency_stat fire, enqueue, ack;
+
+    deploy_latency_get(DEPLOY_LATENCY_FIRE, &fire_before);
+    deploy_latency_get(DEPLOY_LATENCY_ENQUEUE, &enqueue_before);
+    deploy_latency_get(DEPLOY_LATENCY_ACK, &ack_before);
+
+    state_machine_test_setup_state(FLIGHT_STATE_DROGUE_DESCENT, ground_altitude, drogue_entry_time);
+    state_machine_test_step(ground_altitude + 1.0f, 0.0f, DROGUE_DEPLOY_DELAY_MS);
+    zassert_true(state_machine_test_get_drogue_fire_triggered(), "drogue should fire after delay");
+
+    // Retries reach the same stage again; only the first counts
+    deploy_latency_trace(DEPLOY_LATENCY_DROGUE, DEPLOY_LATENCY_ENQUEUE);
+    deploy_latency_trace(DEPLOY_LATENCY_DROGUE, DEPLOY_LATENCY_ENQUEUE);
+    deploy_latency_trace(DEPLOY_LATENCY_DROGUE, DEPLOY_LATENCY_ACK);
+
+    // The ACK ended the trace
+    deploy_latency_trace(DEPLOY_LATENCY_DROGUE, DEPLOY_LATENCY_ACK);
+
+    deploy_latency_get(DEPLOY_LATENCY_FIRE, &fire);
+    deploy_latency_get(DEPLOY_LATENCY_ENQUEUE, &enqueue);
+    deploy_latency_get(DEPLOY_LATENCY_ACK, &ack);
+    zassert_equal(fire.count, fire_before.count + 1, "fire action should start one trace");
+    zassert_equal(enqueue.count, enqueue_before.count + 1, "enqueue should be recorded once");
+    zassert_equal(ack.count, ack_before.count + 1, "ack should be recorded once");
+
+    uint32_t histogram_total = 0;
+
+    for (int i = 0; i < DEPLOY_LATENCY_BUCKETS; i++) {
+        histogram_total += ack.histogram[i];
+    }
+    zassert_equal(histogram_total, ack.count, "every ack latency should land in a bucket");
+}
+
 ZTEST(state_machine, test_drogue_to_main_descent)
 {
     float ground_altitude = 100.0f;
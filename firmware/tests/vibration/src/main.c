@@ -0,0 +1,131 @@
+/*
+ * Vibration spectrum (vibration.h).
+ *
+ * Analyses synthetic windows and checks what the vibration topic reports:
+ * the frequency and RMS of a tone on and between bins, RMS split across
+ * the bands, and gravity and sensor bias left out. Then times the analysis
+ * of the six axes of one window.
+ */
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+#include "bench.h"
+#include "vibration.h"
+
+LOG_MODULE_REGISTER(vibration_test, LOG_LEVEL_INF);
+
+#define FS_HZ ((float)CONFIG_FALCON_IMU_ODR_HZ)
+#define BIN_HZ (FS_HZ / VIBRATION_FFT_SIZE)
+#define BENCH_WINDOWS 16
+
+static struct vibration_spectrum spec;
+static float x[VIBRATION_FFT_SIZE];
+
+/**
+ * @brief Fill the window with an offset and up to two tones.
+ */
+static void make_signal(float offset, float f1, float a1, float f2, float a2)
+{
+    for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+        float t = (float)i / FS_HZ;
+
+        x[i] = offset + a1 * sinf(2.0f * 3.14159265f * f1 * t) +
+               a2 * sinf(2.0f * 3.14159265f * f2 * t + 1.0f);
+    }
+}
+
+static void *vibration_setup(void)
+{
+    zassert_equal(vibration_spectrum_init(&spec), 0, "FFT of %d points should exist",
+                  VIBRATION_FFT_SIZE);
+    return NULL;
+}
+
+ZTEST(vibration, test_tone_on_bin)
+{
+    struct vibration_axis out;
+    float f = 24.0f * BIN_HZ;
+
+    make_signal(0.0f, f, 2.0f, 0.0f, 0.0f);
+    vibration_spectrum_analyze(&spec, x, FS_HZ, &out);
+
+    zassert_within(out.peak_hz, f, 0.1f * BIN_HZ, "peak at %f Hz, expected %f",
+                   (double)out.peak_hz, (double)f);
+    zassert_within(out.peak_rms, 2.0f / sqrtf(2.0f), 0.02f, "peak RMS %f",
+                   (double)out.peak_rms);
+    zassert_within(out.rms, 2.0f / sqrtf(2.0f), 0.02f, "total RMS %f", (double)out.rms);
+}
+
+ZTEST(vibration, test_tone_between_bins)
+{
+    struct vibration_axis out;
+
+    // The worst case for both the frequency estimate and the window's scalloping
+    for (float f = 30.5f * BIN_HZ; f < 0.45f * FS_HZ; f *= 1.7f) {
+        make_signal(0.0f, f, 1.0f, 0.0f, 0.0f);
+        vibration_spectrum_analyze(&spec, x, FS_HZ, &out);
+
+        zassert_within(out.peak_hz, f, 0.25f * BIN_HZ, "peak at %f Hz, expected %f",
+                       (double)out.peak_hz, (double)f);
+        zassert_within(out.peak_rms, 1.0f / sqrtf(2.0f), 0.05f, "%f Hz: peak RMS %f",
+                       (double)f, (double)out.peak_rms);
+    }
+}
+
+ZTEST(vibration, test_bands)
+{
+    struct vibration_axis out;
+    // Well inside bands 0 and 2
+    float f1 = 0.5f * (vibration_band_edges_hz[0] + vibration_band_edges_hz[1]);
+    float f2 = 0.5f * (vibration_band_edges_hz[2] + vibration_band_edges_hz[3]);
+
+    make_signal(0.0f, f1, 1.0f, f2, 0.5f);
+    vibration_spectrum_analyze(&spec, x, FS_HZ, &out);
+
+    zassert_within(out.band_rms[0], 1.0f / sqrtf(2.0f), 0.03f, "band 0 RMS %f",
+                   (double)out.band_rms[0]);
+    zassert_within(out.band_rms[2], 0.5f / sqrtf(2.0f), 0.03f, "band 2 RMS %f",
+                   (double)out.band_rms[2]);
+    zassert_true(out.band_rms[1] < 0.05f, "band 1 RMS %f", (double)out.band_rms[1]);
+    zassert_true(out.band_rms[3] < 0.05f, "band 3 RMS %f", (double)out.band_rms[3]);
+    zassert_within(out.rms, sqrtf(0.5f + 0.125f), 0.03f, "total RMS %f", (double)out.rms);
+    zassert_within(out.peak_hz, f1, BIN_HZ, "the stronger tone should be the peak");
+}
+
+ZTEST(vibration, test_gravity_ignored)
+{
+    struct vibration_axis with, without;
+    float f = 40.0f;
+
+    make_signal(0.0f, f, 0.3f, 0.0f, 0.0f);
+    vibration_spectrum_analyze(&spec, x, FS_HZ, &without);
+    make_signal(9.80665f, f, 0.3f, 0.0f, 0.0f);
+    vibration_spectrum_analyze(&spec, x, FS_HZ, &with);
+
+    zassert_within(with.rms, without.rms, 1e-3f, "an offset should not add vibration");
+    zassert_within(with.peak_hz, without.peak_hz, 1e-3f, "nor move the peak");
+}
+
+ZTEST(vibration, test_window_cycles)
+{
+    struct vibration_axis out;
+    struct bench_stat stat = {0};
+
+    make_signal(9.80665f, 37.0f, 0.5f, 120.0f, 0.2f);
+
+    for (int w = 0; w < BENCH_WINDOWS; w++) {
+        uint32_t start = bench_stamp();
+
+        // One window is six axes
+        for (int axis = 0; axis < 6; axis++) {
+            vibration_spectrum_analyze(&spec, x, FS_HZ, &out);
+        }
+        bench_record(&stat, start);
+    }
+
+    LOG_INF("Vibration analysis, %d points, 6 axes: mean=%u max=%u %s per window",
+            VIBRATION_FFT_SIZE, bench_mean(&stat), stat.max, BENCH_UNIT);
+}
+
+ZTEST_SUITE(vibration, NULL, vibration_setup, NULL, NULL, NULL);
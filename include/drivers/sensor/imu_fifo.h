@@ -0,0 +1,25 @@
+#ifndef FALCON_DRIVERS_SENSOR_IMU_FIFO_H
+#define FALCON_DRIVERS_SENSOR_IMU_FIFO_H
+
+#include <zephyr/drivers/sensor.h>
+
+/*
+ * Private sensor attributes for IMU drivers that expose a sample FIFO
+ * through the classic fetch/get API (the simulated BMI088 dies).
+ *
+ * Setting a non-zero watermark resets and enables the FIFO. From then on
+ * every sensor_sample_fetch() pops the oldest frame (-ENODATA when empty)
+ * and SENSOR_TRIG_FIFO_WATERMARK fires each time another watermark's worth
+ * of frames has been produced. Frames carry no timestamp; they are one
+ * sample period apart, the newest having been taken when the level was read.
+ */
+enum imu_fifo_attribute {
+    // Frames per SENSOR_TRIG_FIFO_WATERMARK; 0 disables the FIFO
+    SENSOR_ATTR_IMU_FIFO_WATERMARK = SENSOR_ATTR_PRIV_START,
+    // Frames waiting to be read (read-only)
+    SENSOR_ATTR_IMU_FIFO_LEVEL,
+    // Frames lost because the FIFO was full when they were produced (read-only)
+    SENSOR_ATTR_IMU_FIFO_OVERRUNS,
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef FALCON_DRIVERS_SENSOR_MS5611_H
+#define FALCON_DRIVERS_SENSOR_MS5611_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+/*
+ * Non-blocking measurements on the in-tree MS5611 driver.
+ *
+ * sensor_sample_fetch() sleeps through both ADC conversions (pressure, then
+ * temperature). ms5611_measure_start() only starts the first one; each
+ * ms5611_measure_poll() after that moves the measurement on as far as the
+ * elapsed time allows and never sleeps. Several barometers can so convert
+ * at the same time, or while the caller does other work.
+ *
+ * Temperature changes far more slowly than pressure, so a measurement can
+ * skip the temperature conversion and compensate with the last one taken,
+ * which roughly halves its duration.
+ *
+ * A device has one measurement in flight at a time, and
+ * sensor_sample_fetch() returns -EBUSY until it is collected.
+ */
+
+#ifdef CONFIG_MS5611
+
+/**
+ * @brief Start a pressure and temperature measurement without waiting
+ * @param temperature Convert temperature too; if false, the last temperature
+ * conversion is reused (one is still made if there is none yet)
+ * @return 0 on success, -ENOTSUP if dev is not an MS5611 on this driver,
+ * -EBUSY if a measurement is already in flight, other negative errno on bus error
+ */
+int ms5611_measure_start(const struct device *dev, bool temperature);
+
+/**
+ * @brief Advance a measurement started with ms5611_measure_start()
+ * @param pressure_pa Compensated pressure in Pa, set when the measurement completes
+ * @param temperature_cdeg Compensated temperature in 0.01 °C, set when it completes
+ * @param wait_us Set while converting to the time until the next step can run
+ * @return 0 when the measurement completed (channel_get also returns it),
+ * -EINPROGRESS while a conversion is running, -EINVAL if none was started,
+ * other negative errno on bus error (the measurement is abandoned)
+ */
+int ms5611_measure_poll(const struct device *dev, int32_t *pressure_pa, int32_t *temperature_cdeg,
+                        uint32_t *wait_us);
+
+#else
+
+static inline int ms5611_measure_start(const struct device *dev, bool temperature)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(temperature);
+    return -ENOTSUP;
+}
+
+static inline int ms5611_measure_poll(const struct device *dev, int32_t *pressure_pa,
+                                      int32_t *temperature_cdeg, uint32_t *wait_us)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(pressure_pa);
+    ARG_UNUSED(temperature_cdeg);
+    ARG_UNUSED(wait_us);
+    return -ENOTSUP;
+}
+
+#endif
+
+#endif
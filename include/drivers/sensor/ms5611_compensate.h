@@ -0,0 +1,67 @@
+#ifndef FALCON_DRIVERS_SENSOR_MS5611_COMPENSATE_H
+#define FALCON_DRIVERS_SENSOR_MS5611_COMPENSATE_H
+
+#include <stdint.h>
+
+/*
+ * MS5611 first and second order compensation, in integers only.
+ *
+ * The datasheet scales by powers of two throughout; they are done here as
+ * shifts instead of 64-bit divisions, which are library calls on a 32-bit
+ * core. Each shift rounds to nearest where the datasheet's integer
+ * divisions truncate, so the results are within 0.6 Pa and 0.006 °C of the
+ * datasheet formulas evaluated exactly, over -40 to +85 °C (the
+ * truncating version is within 1 Pa and 0.01 °C); see
+ * firmware/tests/baro_math. Right shifts of negative values are arithmetic
+ * on every compiler Zephyr supports.
+ */
+
+// Factory calibration coefficients C1..C6 from the PROM
+struct ms5611_prom {
+    uint16_t sens_t1;  // C1, pressure sensitivity
+    uint16_t off_t1;   // C2, pressure offset
+    uint16_t tcs;      // C3, temperature coefficient of pressure sensitivity
+    uint16_t tco;      // C4, temperature coefficient of pressure offset
+    uint16_t t_ref;    // C5, reference temperature
+    uint16_t tempsens; // C6, temperature coefficient of the temperature
+};
+
+/**
+ * @brief Compensate a pair of raw conversions
+ * @param adc_temperature D2
+ * @param adc_pressure D1
+ * @param temperature_cdeg Temperature in 0.01 °C
+ * @param pressure_pa Pressure in Pa
+ */
+static inline void ms5611_compensate_int(const struct ms5611_prom *prom, uint32_t adc_temperature,
+                                         uint32_t adc_pressure, int32_t *temperature_cdeg,
+                                         int32_t *pressure_pa)
+{
+    int64_t dT = (int64_t)adc_temperature - ((int64_t)prom->t_ref << 8);
+    int32_t temp = 2000 + (int32_t)((dT * prom->tempsens + (1 << 22)) >> 23);
+    int64_t off = ((int64_t)prom->off_t1 << 16) + ((dT * prom->tco + (1 << 6)) >> 7);
+    int64_t sens = ((int64_t)prom->sens_t1 << 15) + ((dT * prom->tcs + (1 << 7)) >> 8);
+
+    // Second order, below 20 °C
+    if (temp < 2000) {
+        int64_t below_20 = (int64_t)(temp - 2000) * (temp - 2000);
+        int32_t t2 = (int32_t)((dT * dT + (1ll << 30)) >> 31);
+
+        off -= (5 * below_20) >> 1;
+        sens -= (5 * below_20) >> 2;
+
+        if (temp < -1500) {
+            int64_t below_m15 = (int64_t)(temp + 1500) * (temp + 1500);
+
+            off -= 7 * below_m15;
+            sens -= (11 * below_m15) >> 1;
+        }
+
+        temp -= t2;
+    }
+
+    *temperature_cdeg = temp;
+    *pressure_pa = (int32_t)((((sens * adc_pressure + (1 << 20)) >> 21) - off + (1 << 14)) >> 15);
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef FALCON_DRIVERS_SENSOR_SIM_BARO_H
+#define FALCON_DRIVERS_SENSOR_SIM_BARO_H
+
+/*
+ * The simulated barometer replays a flight: an OpenRocket CSV, or a slow
+ * synthetic climb without one. The simulated accelerometer follows the
+ * same flight through this, so IMU-aided estimators see a consistent
+ * trajectory.
+ */
+
+/**
+ * @brief Vertical acceleration of the replayed flight at the current time.
+ * @param accel_mps2 Acceleration in m/s^2, positive up, gravity not included
+ * @return 0 on success, -ENODATA before the first barometer sample
+ */
+int sim_baro_vertical_accel(float *accel_mps2);
+
+#endif